@@ -0,0 +1,277 @@
+//  Copyright (c) 2013, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "db/blob_file.h"
+
+#include "db/dbformat.h"
+#include "db/filename.h"
+#include "rocksdb/statistics.h"
+#include "util/coding.h"
+#include "util/crc32c.h"
+#include "util/stop_watch.h"
+
+namespace rocksdb {
+
+namespace {
+
+const uint64_t kBlobFileMagicNumber = 0x8d3c4e21b10b5f37ull;
+const size_t kBlobFileHeaderSize = 8;
+const size_t kBlobCacheKeySize = 1 + sizeof(uint64_t);
+
+// The table readers are cached under the 8 bytes of their file number, so
+// the longer key of a blob file never collides with them.
+Slice GetBlobCacheKey(uint64_t file_number, char* buf) {
+  buf[0] = 'b';
+  EncodeFixed64(buf + 1, file_number);
+  return Slice(buf, kBlobCacheKeySize);
+}
+
+void DeleteBlobFileEntry(const Slice& key, void* value) {
+  RandomAccessFile* file = reinterpret_cast<RandomAccessFile*>(value);
+  delete file;
+}
+
+}  // namespace
+
+void BlobIndex::EncodeTo(std::string* dst) const {
+  PutVarint64(dst, file_number);
+  PutVarint64(dst, offset);
+  PutVarint64(dst, size);
+}
+
+Status BlobIndex::DecodeFrom(Slice src) {
+  if (GetVarint64(&src, &file_number) && GetVarint64(&src, &offset) &&
+      GetVarint64(&src, &size) && src.empty()) {
+    return Status::OK();
+  }
+  return Status::Corruption("bad blob index");
+}
+
+BlobFileBuilder::BlobFileBuilder(const ImmutableCFOptions& ioptions,
+                                 const EnvOptions& env_options,
+                                 uint64_t file_number,
+                                 Env::IOPriority io_priority)
+    : ioptions_(ioptions),
+      env_options_(env_options),
+      file_number_(file_number),
+      io_priority_(io_priority),
+      num_blobs_(0),
+      blob_bytes_(0),
+      file_size_(0) {}
+
+BlobFileBuilder::~BlobFileBuilder() {}
+
+Status BlobFileBuilder::SeparateValue(Slice* key, Slice* value) {
+  if (ioptions_.min_blob_size == 0 || value->size() < ioptions_.min_blob_size) {
+    return Status::OK();
+  }
+  ParsedInternalKey ikey;
+  if (!ParseInternalKey(*key, &ikey) || ikey.type != kTypeValue) {
+    return Status::OK();
+  }
+  Status s = AddBlob(ikey.user_key, *value, &blob_index_);
+  if (s.ok()) {
+    blob_key_.assign(key->data(), key->size());
+    UpdateInternalKey(&blob_key_[0], blob_key_.size(), ikey.sequence,
+                      kTypeBlobIndex);
+    *key = blob_key_;
+    *value = blob_index_;
+  }
+  return s;
+}
+
+Status BlobFileBuilder::AddBlob(const Slice& user_key, const Slice& value,
+                                std::string* blob_index) {
+  Status s;
+  if (!file_) {
+    s = ioptions_.env->NewWritableFile(
+        BlobFileName(ioptions_.db_paths[0].path, file_number_), &file_,
+        env_options_);
+    if (!s.ok()) {
+      return s;
+    }
+    file_->SetIOPriority(io_priority_);
+    std::string header;
+    PutFixed64(&header, kBlobFileMagicNumber);
+    s = file_->Append(header);
+    if (!s.ok()) {
+      return s;
+    }
+    file_size_ = kBlobFileHeaderSize;
+  }
+
+  record_header_.clear();
+  PutFixed32(&record_header_, 0);
+  PutFixed32(&record_header_, static_cast<uint32_t>(user_key.size()));
+  PutFixed64(&record_header_, value.size());
+  uint32_t crc = crc32c::Value(record_header_.data() + 4,
+                               kBlobRecordHeaderSize - 4);
+  crc = crc32c::Extend(crc, user_key.data(), user_key.size());
+  crc = crc32c::Extend(crc, value.data(), value.size());
+  EncodeFixed32(&record_header_[0], crc32c::Mask(crc));
+
+  s = file_->Append(record_header_);
+  if (s.ok()) {
+    s = file_->Append(user_key);
+  }
+  if (s.ok()) {
+    s = file_->Append(value);
+  }
+  if (!s.ok()) {
+    return s;
+  }
+
+  BlobIndex index;
+  index.file_number = file_number_;
+  index.offset = file_size_;
+  index.size = kBlobRecordHeaderSize + user_key.size() + value.size();
+  file_size_ += index.size;
+  blob_bytes_ += index.size;
+  num_blobs_++;
+  blob_index->clear();
+  index.EncodeTo(blob_index);
+  return s;
+}
+
+Status BlobFileBuilder::Finish() {
+  if (!file_) {
+    return Status::OK();
+  }
+  Status s;
+  if (!ioptions_.disable_data_sync) {
+    StopWatch sw(ioptions_.env, ioptions_.statistics, TABLE_SYNC_MICROS);
+    s = ioptions_.use_fsync ? file_->Fsync() : file_->Sync();
+  }
+  if (s.ok()) {
+    s = file_->Close();
+  }
+  file_.reset();
+  return s;
+}
+
+void BlobFileBuilder::Abandon() {
+  if (!file_) {
+    return;
+  }
+  file_->Close();
+  file_.reset();
+  ioptions_.env->DeleteFile(
+      BlobFileName(ioptions_.db_paths[0].path, file_number_));
+}
+
+BlobFileCache::BlobFileCache(const ImmutableCFOptions& ioptions,
+                             const EnvOptions& env_options, Cache* const cache)
+    : ioptions_(ioptions), env_options_(env_options), cache_(cache) {}
+
+Status BlobFileCache::FindBlobFile(uint64_t file_number, bool no_io,
+                                   Cache::Handle** handle) {
+  char buf[kBlobCacheKeySize];
+  Slice key = GetBlobCacheKey(file_number, buf);
+  *handle = cache_->Lookup(key);
+  if (*handle != nullptr) {
+    return Status::OK();
+  }
+  if (no_io) {
+    return Status::Incomplete(
+        "Blob file not found in table_cache, no_io is set");
+  }
+
+  unique_ptr<RandomAccessFile> file;
+  Status s = ioptions_.env->NewRandomAccessFile(
+      BlobFileName(ioptions_.db_paths[0].path, file_number), &file,
+      env_options_);
+  RecordTick(ioptions_.statistics, NO_FILE_OPENS);
+  if (s.ok()) {
+    if (ioptions_.advise_random_on_open) {
+      file->Hint(RandomAccessFile::RANDOM);
+    }
+    char scratch[kBlobFileHeaderSize];
+    Slice header;
+    s = file->Read(0, kBlobFileHeaderSize, &header, scratch);
+    if (s.ok() && (header.size() != kBlobFileHeaderSize ||
+                   DecodeFixed64(header.data()) != kBlobFileMagicNumber)) {
+      s = Status::Corruption("not a blob file");
+    }
+  }
+  if (!s.ok()) {
+    RecordTick(ioptions_.statistics, NO_FILE_ERRORS);
+    // As for the table readers, errors are not cached
+    return s;
+  }
+  *handle = cache_->Insert(key, file.release(), 1, &DeleteBlobFileEntry);
+  return s;
+}
+
+Status BlobFileCache::GetBlob(const ReadOptions& options,
+                              const Slice& user_key,
+                              const BlobIndex& blob_index,
+                              std::string* value) {
+  if (blob_index.size < kBlobRecordHeaderSize + user_key.size()) {
+    return Status::Corruption("bad blob index for key", user_key);
+  }
+  Cache::Handle* handle = nullptr;
+  Status s = FindBlobFile(blob_index.file_number,
+                          options.read_tier == kBlockCacheTier, &handle);
+  if (!s.ok()) {
+    return s;
+  }
+  RandomAccessFile* file =
+      reinterpret_cast<RandomAccessFile*>(cache_->Value(handle));
+
+  // Read the whole record into *value, then strip the header and key
+  const size_t size = static_cast<size_t>(blob_index.size);
+  value->resize(size);
+  Slice record;
+  s = file->Read(blob_index.offset, size, &record, &(*value)[0]);
+  cache_->Release(handle);
+  if (!s.ok()) {
+    return s;
+  }
+  if (record.size() != size) {
+    return Status::Corruption("truncated blob record for key", user_key);
+  }
+  if (record.data() != value->data()) {
+    // mmap reads do not use the scratch buffer
+    memcpy(&(*value)[0], record.data(), size);
+  }
+
+  const char* p = value->data();
+  const uint32_t key_size = DecodeFixed32(p + 4);
+  const uint64_t value_size = DecodeFixed64(p + 8);
+  if (kBlobRecordHeaderSize + key_size + value_size != size ||
+      Slice(p + kBlobRecordHeaderSize, key_size) != user_key) {
+    return Status::Corruption("blob record does not match key", user_key);
+  }
+  if (options.verify_checksums) {
+    const uint32_t expected = crc32c::Unmask(DecodeFixed32(p));
+    const uint32_t actual = crc32c::Value(p + 4, size - 4);
+    if (actual != expected) {
+      return Status::Corruption("blob record checksum mismatch for key",
+                                user_key);
+    }
+  }
+  value->erase(0, kBlobRecordHeaderSize + key_size);
+  return s;
+}
+
+void BlobFileCache::Evict(Cache* cache, uint64_t file_number) {
+  char buf[kBlobCacheKeySize];
+  cache->Erase(GetBlobCacheKey(file_number, buf));
+}
+
+Status BlobFetcher::FetchBlob(const Slice& user_key, const Slice& blob_index,
+                              std::string* value) const {
+  if (blob_file_cache_ == nullptr) {
+    return Status::NotSupported("blob references cannot be resolved here");
+  }
+  BlobIndex index;
+  Status s = index.DecodeFrom(blob_index);
+  if (s.ok()) {
+    s = blob_file_cache_->GetBlob(read_options_, user_key, index, value);
+  }
+  return s;
+}
+
+}  // namespace rocksdb
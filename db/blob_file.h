@@ -0,0 +1,144 @@
+//  Copyright (c) 2013, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+//
+// Key-value separation. When ColumnFamilyOptions::min_blob_size is set,
+// flushes and compactions append large values to a blob file and store a
+// kTypeBlobIndex entry holding an encoded BlobIndex in the table instead.
+// A blob file is written once and never modified:
+//
+//    blob_file := magic (fixed64) record*
+//    record    := checksum (fixed32)   masked crc32c of the rest of the record
+//                 key_size (fixed32)
+//                 value_size (fixed64)
+//                 key (char[key_size])  the user key, to validate lookups
+//                 value (char[value_size])
+//
+// The MANIFEST keeps for each blob file the number and size of the records
+// written to it and of the records that are no longer referenced by any
+// table (see BlobFileMetaData). A blob file is dropped from the version once
+// all of its records are garbage.
+
+#pragma once
+#include <memory>
+#include <string>
+
+#include "rocksdb/cache.h"
+#include "rocksdb/env.h"
+#include "rocksdb/immutable_options.h"
+#include "rocksdb/options.h"
+#include "rocksdb/slice.h"
+#include "rocksdb/status.h"
+
+namespace rocksdb {
+
+// Size of the fixed part of a blob record
+const size_t kBlobRecordHeaderSize = 16;
+
+// The location of a value in a blob file
+struct BlobIndex {
+  uint64_t file_number;
+  uint64_t offset;  // offset of the record in the file
+  uint64_t size;    // size of the record, including its header
+
+  BlobIndex() : file_number(0), offset(0), size(0) {}
+
+  void EncodeTo(std::string* dst) const;
+  Status DecodeFrom(Slice src);
+};
+
+// Writes the blob file of a flush or a compaction. The file is only created
+// when the first blob is added.
+class BlobFileBuilder {
+ public:
+  BlobFileBuilder(const ImmutableCFOptions& ioptions,
+                  const EnvOptions& env_options, uint64_t file_number,
+                  Env::IOPriority io_priority);
+  ~BlobFileBuilder();
+
+  // Prepare the entry with internal key *key and *value for adding to a
+  // table. If it is a kTypeValue entry whose value has at least
+  // min_blob_size bytes, the value is appended to the blob file and *key and
+  // *value are changed to the kTypeBlobIndex entry referring to it. They
+  // then stay valid until the next call.
+  Status SeparateValue(Slice* key, Slice* value);
+
+  // Append a blob for "user_key" to the file and store its encoded BlobIndex
+  // in *blob_index.
+  Status AddBlob(const Slice& user_key, const Slice& value,
+                 std::string* blob_index);
+
+  // Sync and close the blob file. Does nothing if no blob was added.
+  Status Finish();
+
+  // Close and delete the blob file, if it was created.
+  void Abandon();
+
+  uint64_t file_number() const { return file_number_; }
+  // Number of blobs added so far
+  uint64_t num_blobs() const { return num_blobs_; }
+  // Total size of the records of those blobs
+  uint64_t blob_bytes() const { return blob_bytes_; }
+  // Size of the file, 0 if no blob was added
+  uint64_t file_size() const { return file_size_; }
+
+ private:
+  const ImmutableCFOptions& ioptions_;
+  const EnvOptions& env_options_;
+  const uint64_t file_number_;
+  const Env::IOPriority io_priority_;
+  std::unique_ptr<WritableFile> file_;
+  uint64_t num_blobs_;
+  uint64_t blob_bytes_;
+  uint64_t file_size_;
+  std::string record_header_;
+  std::string blob_key_;
+  std::string blob_index_;
+
+  // No copying allowed
+  BlobFileBuilder(const BlobFileBuilder&);
+  void operator=(const BlobFileBuilder&);
+};
+
+// Keeps the open blob files in the table cache, next to the table readers.
+class BlobFileCache {
+ public:
+  BlobFileCache(const ImmutableCFOptions& ioptions,
+                const EnvOptions& env_options, Cache* cache);
+
+  // Read the value referred to by "blob_index" into *value. "user_key" is
+  // the key of the entry the index was read from. Returns Incomplete if the
+  // blob file is not open and options.read_tier is kBlockCacheTier.
+  Status GetBlob(const ReadOptions& options, const Slice& user_key,
+                 const BlobIndex& blob_index, std::string* value);
+
+  // Evict any entry for the specified blob file number
+  static void Evict(Cache* cache, uint64_t file_number);
+
+ private:
+  Status FindBlobFile(uint64_t file_number, bool no_io,
+                      Cache::Handle** handle);
+
+  const ImmutableCFOptions& ioptions_;
+  const EnvOptions& env_options_;
+  Cache* const cache_;
+};
+
+// Resolves the kTypeBlobIndex entries found by a read
+class BlobFetcher {
+ public:
+  BlobFetcher(BlobFileCache* blob_file_cache, const ReadOptions& read_options)
+      : blob_file_cache_(blob_file_cache), read_options_(read_options) {}
+
+  // Read the value of the entry for "user_key" whose value is the encoded
+  // BlobIndex "blob_index" into *value.
+  Status FetchBlob(const Slice& user_key, const Slice& blob_index,
+                   std::string* value) const;
+
+ private:
+  BlobFileCache* blob_file_cache_;
+  ReadOptions read_options_;
+};
+
+}  // namespace rocksdb
@@ -9,6 +9,9 @@
 
 #include "db/builder.h"
 
+#include <algorithm>
+
+#include "db/blob_file.h"
 #include "db/dbformat.h"
 #include "db/filename.h"
 #include "db/merge_helper.h"
@@ -31,13 +34,47 @@ TableBuilder* NewTableBuilder(const ImmutableCFOptions& ioptions,
                               WritableFile* file,
                               const CompressionType compression_type,
                               const CompressionOptions& compression_opts,
-                              const bool skip_filters) {
-  return ioptions.table_factory->NewTableBuilder(ioptions, internal_comparator,
-                                                 file, compression_type,
-                                                 compression_opts,
-                                                 skip_filters);
+                              const bool skip_filters, const int level) {
+  return GetTableFactoryForLevel(ioptions, level)->NewTableBuilder(
+      ioptions, internal_comparator, file, compression_type, compression_opts,
+      skip_filters);
+}
+
+TableFactory* GetTableFactoryForLevel(const ImmutableCFOptions& ioptions,
+                                      int level) {
+  if (!ioptions.table_factory_per_level.empty()) {
+    const int n = static_cast<int>(ioptions.table_factory_per_level.size()) - 1;
+    TableFactory* level_table_factory =
+        ioptions.table_factory_per_level[std::max(0, std::min(level, n))];
+    if (level_table_factory != nullptr) {
+      return level_table_factory;
+    }
+  }
+  return ioptions.table_factory;
+}
+
+namespace {
+
+// Add an entry to the table, moving its value to the blob file if it is large
+// enough, and extend the key range of *meta to cover it.
+Status AddToTable(TableBuilder* builder, BlobFileBuilder* blob_builder,
+                  Slice key, Slice value, FileMetaData* meta) {
+  if (blob_builder != nullptr) {
+    Status s = blob_builder->SeparateValue(&key, &value);
+    if (!s.ok()) {
+      return s;
+    }
+  }
+  if (builder->NumEntries() == 0) {
+    meta->smallest.DecodeFrom(key);
+  }
+  meta->largest.DecodeFrom(key);
+  builder->Add(key, value);
+  return Status::OK();
 }
 
+}  // namespace
+
 Status BuildTable(const std::string& dbname, Env* env,
                   const ImmutableCFOptions& ioptions,
                   const EnvOptions& env_options, TableCache* table_cache,
@@ -47,9 +84,16 @@ Status BuildTable(const std::string& dbname, Env* env,
                   const SequenceNumber earliest_seqno_in_memtable,
                   const CompressionType compression,
                   const CompressionOptions& compression_opts,
-                  const Env::IOPriority io_priority) {
+                  const Env::IOPriority io_priority,
+                  const uint64_t blob_file_number,
+                  BlobFileMetaData* blob_file) {
   Status s;
   meta->fd.file_size = 0;
+  if (blob_file != nullptr) {
+    blob_file->file_number = blob_file_number;
+    blob_file->file_size = 0;
+    blob_file->total_count = 0;
+  }
   meta->smallest_seqno = meta->largest_seqno = 0;
   iter->SeekToFirst();
 
@@ -75,10 +119,15 @@ Status BuildTable(const std::string& dbname, Env* env,
         ioptions, internal_comparator, file.get(),
         compression, compression_opts);
 
+    std::unique_ptr<BlobFileBuilder> blob_builder;
+    if (ioptions.min_blob_size > 0 && blob_file != nullptr) {
+      blob_builder.reset(new BlobFileBuilder(ioptions, env_options,
+                                             blob_file_number, io_priority));
+    }
+
     {
       // the first key is the smallest key
       Slice key = iter->key();
-      meta->smallest.DecodeFrom(key);
       meta->smallest_seqno = GetInternalKeySeqno(key);
       meta->largest_seqno = meta->smallest_seqno;
     }
@@ -97,7 +146,7 @@ Status BuildTable(const std::string& dbname, Env* env,
       std::string prev_key;
       bool is_first_key = true;    // Also write if this is the very first key
 
-      while (iter->Valid()) {
+      while (s.ok() && iter->Valid()) {
         bool iterator_at_next = false;
 
         // Get current key
@@ -136,7 +185,8 @@ Status BuildTable(const std::string& dbname, Env* env,
             if (merge.IsSuccess()) {
               // Merge completed correctly.
               // Add the resulting merge key/value and continue to next
-              builder->Add(merge.key(), merge.value());
+              s = AddToTable(builder, blob_builder.get(), merge.key(),
+                             merge.value(), meta);
               prev_key.assign(merge.key().data(), merge.key().size());
               ok = ParseInternalKey(Slice(prev_key), &prev_ikey);
               assert(ok);
@@ -150,14 +200,17 @@ Status BuildTable(const std::string& dbname, Env* env,
               std::deque<std::string>::const_reverse_iterator key_iter;
               std::deque<std::string>::const_reverse_iterator value_iter;
               for (key_iter=keys.rbegin(), value_iter = values.rbegin();
-                   key_iter != keys.rend() && value_iter != values.rend();
+                   s.ok() && key_iter != keys.rend() &&
+                   value_iter != values.rend();
                    ++key_iter, ++value_iter) {
 
-                builder->Add(Slice(*key_iter), Slice(*value_iter));
+                s = AddToTable(builder, blob_builder.get(), Slice(*key_iter),
+                               Slice(*value_iter), meta);
               }
 
               // Sanity check. Both iterators should end at the same time
-              assert(key_iter == keys.rend() && value_iter == values.rend());
+              assert(!s.ok() ||
+                     (key_iter == keys.rend() && value_iter == values.rend()));
 
               prev_key.assign(keys.front());
               ok = ParseInternalKey(Slice(prev_key), &prev_ikey);
@@ -165,7 +218,7 @@ Status BuildTable(const std::string& dbname, Env* env,
             }
           } else {
             // Handle Put/Delete-type keys by simply writing them
-            builder->Add(key, value);
+            s = AddToTable(builder, blob_builder.get(), key, value, meta);
             prev_key.assign(key.data(), key.size());
             ok = ParseInternalKey(Slice(prev_key), &prev_ikey);
             assert(ok);
@@ -176,22 +229,34 @@ Status BuildTable(const std::string& dbname, Env* env,
       }
 
       // The last key is the largest key
-      meta->largest.DecodeFrom(Slice(prev_key));
       SequenceNumber seqno = GetInternalKeySeqno(Slice(prev_key));
       meta->smallest_seqno = std::min(meta->smallest_seqno, seqno);
       meta->largest_seqno = std::max(meta->largest_seqno, seqno);
 
     } else {
-      for (; iter->Valid(); iter->Next()) {
+      for (; s.ok() && iter->Valid(); iter->Next()) {
         Slice key = iter->key();
-        meta->largest.DecodeFrom(key);
-        builder->Add(key, iter->value());
+        s = AddToTable(builder, blob_builder.get(), key, iter->value(), meta);
         SequenceNumber seqno = GetInternalKeySeqno(key);
         meta->smallest_seqno = std::min(meta->smallest_seqno, seqno);
         meta->largest_seqno = std::max(meta->largest_seqno, seqno);
       }
     }
 
+    // Finish the blob file before the table that refers to it
+    if (blob_builder != nullptr) {
+      if (s.ok()) {
+        s = blob_builder->Finish();
+      }
+      if (s.ok()) {
+        blob_file->file_size = blob_builder->file_size();
+        blob_file->total_count = blob_builder->num_blobs();
+        blob_file->total_bytes = blob_builder->blob_bytes();
+      } else {
+        blob_builder->Abandon();
+      }
+    }
+
     // Finish and check for builder errors
     if (s.ok()) {
       s = builder->Finish();
@@ -236,6 +301,12 @@ Status BuildTable(const std::string& dbname, Env* env,
     // Keep it
   } else {
     env->DeleteFile(fname);
+    if (blob_file != nullptr && blob_file->total_count > 0) {
+      env->DeleteFile(BlobFileName(ioptions.db_paths[0].path,
+                                   blob_file_number));
+      blob_file->file_size = 0;
+      blob_file->total_count = 0;
+    }
   }
   return s;
 }
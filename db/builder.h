@@ -17,6 +17,7 @@ namespace rocksdb {
 
 struct Options;
 struct FileMetaData;
+struct BlobFileMetaData;
 
 class Env;
 struct EnvOptions;
@@ -31,13 +32,23 @@ TableBuilder* NewTableBuilder(const ImmutableCFOptions& options,
                               WritableFile* file,
                               const CompressionType compression_type,
                               const CompressionOptions& compression_opts,
-                              const bool skip_filters = false);
+                              const bool skip_filters = false,
+                              const int level = 0);
+
+// The table factory that writes the files of "level", from
+// table_factory_per_level if it has a non-null entry for it
+extern TableFactory* GetTableFactoryForLevel(const ImmutableCFOptions& ioptions,
+                                             int level);
 
 // Build a Table file from the contents of *iter.  The generated file
 // will be named according to number specified in meta. On success, the rest of
 // *meta will be filled with metadata about the generated table.
 // If no data is present in *iter, meta->file_size will be set to
 // zero, and no Table file will be produced.
+// If ioptions.min_blob_size is set and blob_file is not null, the large
+// values are written to the blob file "blob_file_number" instead. On
+// success, *blob_file then describes it; its total_count is zero if no blob
+// file was produced.
 extern Status BuildTable(const std::string& dbname, Env* env,
                          const ImmutableCFOptions& options,
                          const EnvOptions& env_options,
@@ -48,6 +59,8 @@ extern Status BuildTable(const std::string& dbname, Env* env,
                          const SequenceNumber earliest_seqno_in_memtable,
                          const CompressionType compression,
                          const CompressionOptions& compression_opts,
-                         const Env::IOPriority io_priority = Env::IO_HIGH);
+                         const Env::IOPriority io_priority = Env::IO_HIGH,
+                         const uint64_t blob_file_number = 0,
+                         BlobFileMetaData* blob_file = nullptr);
 
 }  // namespace rocksdb
@@ -20,6 +20,7 @@
 #include "db/memtable_list.h"
 #include "db/write_batch_internal.h"
 #include "db/write_controller.h"
+#include "db/blob_file.h"
 #include "db/table_cache.h"
 #include "db/flush_scheduler.h"
 #include "util/instrumented_mutex.h"
@@ -215,6 +216,7 @@ class ColumnFamilyData {
   void CreateNewMemtable(const MutableCFOptions& mutable_cf_options);
 
   TableCache* table_cache() const { return table_cache_.get(); }
+  BlobFileCache* blob_file_cache() const { return blob_file_cache_.get(); }
 
   // See documentation in compaction_picker.h
   // REQUIRES: DB mutex held
@@ -313,6 +315,7 @@ class ColumnFamilyData {
   MutableCFOptions mutable_cf_options_;
 
   std::unique_ptr<TableCache> table_cache_;
+  std::unique_ptr<BlobFileCache> blob_file_cache_;
 
   std::unique_ptr<InternalStats> internal_stats_;
 
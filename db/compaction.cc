@@ -16,6 +16,7 @@
 #include <inttypes.h>
 #include <vector>
 
+#include "db/builder.h"
 #include "db/column_family.h"
 #include "util/logging.h"
 
@@ -141,7 +142,12 @@ bool Compaction::IsTrivialMove() const {
           num_input_files(0) == 1 &&
           num_input_files(1) == 0 &&
           input(0, 0)->fd.GetPathId() == GetOutputPathId() &&
-          TotalFileSize(grandparents_) <= max_grandparent_overlap_bytes_);
+          TotalFileSize(grandparents_) <= max_grandparent_overlap_bytes_ &&
+          // A file moved to a level written by another table factory would
+          // keep its format
+          (cfd_ == nullptr ||
+           GetTableFactoryForLevel(*cfd_->ioptions(), start_level_) ==
+               GetTableFactoryForLevel(*cfd_->ioptions(), output_level_)));
 }
 
 void Compaction::AddInputDeletions(VersionEdit* out_edit) {
@@ -18,7 +18,9 @@
 #include <vector>
 #include <memory>
 #include <list>
+#include <map>
 
+#include "db/blob_file.h"
 #include "db/builder.h"
 #include "db/db_iter.h"
 #include "db/dbformat.h"
@@ -77,6 +79,15 @@ struct CompactionJob::CompactionState {
   std::unique_ptr<WritableFile> outfile;
   std::unique_ptr<TableBuilder> builder;
 
+  // Blob file shared by the outputs, created with the first blob
+  std::unique_ptr<BlobFileBuilder> blob_builder;
+  // Number and size of the records of each input blob file that are no
+  // longer referred to by the outputs
+  std::map<uint64_t, std::pair<uint64_t, uint64_t>> blob_garbage;
+  // Entry of a blob moved out of a blob file that is mostly garbage
+  std::string gc_key;
+  std::string gc_value;
+
   uint64_t total_bytes;
 
   Output* current_output() { return &outputs[outputs.size() - 1]; }
@@ -424,6 +435,9 @@ Status CompactionJob::Run() {
   if (status.ok()) {
     status = input->status();
   }
+  if (status.ok() && compact_->blob_builder != nullptr) {
+    status = compact_->blob_builder->Finish();
+  }
   input.reset();
 
   if (output_directory_ && !db_options_.disableDataSync) {
@@ -522,10 +536,12 @@ Status CompactionJob::ProcessKeyValueCompaction(int64_t* imm_micros,
       kMaxSequenceNumber;
   SequenceNumber visible_in_snapshot = kMaxSequenceNumber;
   ColumnFamilyData* cfd = compact_->compaction->column_family_data();
+  BlobFetcher blob_fetcher(cfd->blob_file_cache(), ReadOptions());
   MergeHelper merge(cfd->user_comparator(), cfd->ioptions()->merge_operator,
                     db_options_.info_log.get(),
                     cfd->ioptions()->min_partial_merge_operands,
-                    false /* internal key corruption is expected */);
+                    false /* internal key corruption is expected */,
+                    &blob_fetcher);
   auto compaction_filter = cfd->ioptions()->compaction_filter;
   std::unique_ptr<CompactionFilter> compaction_filter_from_factory = nullptr;
   if (!compaction_filter) {
@@ -699,6 +715,13 @@ Status CompactionJob::ProcessKeyValueCompaction(int64_t* imm_micros,
         int steps = 0;
         merge.MergeUntil(input, prev_snapshot, bottommost_level_,
                          db_options_.statistics.get(), &steps);
+        if (!merge.status().ok()) {
+          status = merge.status();
+          break;
+        }
+        if (!merge.merged_blob_index().empty()) {
+          AddBlobGarbage(merge.merged_blob_index());
+        }
         // Skip the Merge ops
         combined_idx = combined_idx - 1 + steps;
 
@@ -724,6 +747,9 @@ Status CompactionJob::ProcessKeyValueCompaction(int64_t* imm_micros,
 
       last_sequence_for_key = ikey.sequence;
       visible_in_snapshot = visible;
+      if (drop && ikey.type == kTypeBlobIndex) {
+        AddBlobGarbage(value);
+      }
     }
 
     if (!drop) {
@@ -777,6 +803,11 @@ Status CompactionJob::ProcessKeyValueCompaction(int64_t* imm_micros,
           }
         }
 
+        status = PrepareBlobOutput(&newkey, &value);
+        if (!status.ok()) {
+          break;
+        }
+
         SequenceNumber seqno = GetInternalKeySeqno(newkey);
         if (compact_->builder->NumEntries() == 0) {
           compact_->current_output()->smallest.DecodeFrom(newkey);
@@ -962,6 +993,58 @@ Status CompactionJob::FinishCompactionOutputFile(Iterator* input) {
   return s;
 }
 
+Status CompactionJob::PrepareBlobOutput(Slice* key, Slice* value) {
+  ColumnFamilyData* cfd = compact_->compaction->column_family_data();
+  const ImmutableCFOptions* ioptions = cfd->ioptions();
+  ParsedInternalKey ikey;
+  if (!ParseInternalKey(*key, &ikey)) {
+    return Status::OK();
+  }
+  if (ikey.type == kTypeBlobIndex) {
+    BlobIndex blob_index;
+    Status s = blob_index.DecodeFrom(*value);
+    if (!s.ok()) {
+      return s;
+    }
+    const auto& blob_files =
+        compact_->compaction->input_version()->storage_info()->BlobFiles();
+    auto it = blob_files.find(blob_index.file_number);
+    if (it == blob_files.end() ||
+        it->second.GarbageRatio() < ioptions->blob_gc_discard_ratio) {
+      return Status::OK();
+    }
+    // Turn the entry back into a Put so that its value is written again
+    s = cfd->blob_file_cache()->GetBlob(ReadOptions(), ikey.user_key,
+                                        blob_index, &compact_->gc_value);
+    if (!s.ok()) {
+      return s;
+    }
+    AddBlobGarbage(*value);
+    compact_->gc_key.assign(key->data(), key->size());
+    UpdateInternalKey(&compact_->gc_key[0], compact_->gc_key.size(),
+                      ikey.sequence, kTypeValue);
+    *key = compact_->gc_key;
+    *value = compact_->gc_value;
+  } else if (ikey.type != kTypeValue || ioptions->min_blob_size == 0) {
+    return Status::OK();
+  }
+  if (compact_->blob_builder == nullptr) {
+    // no need to lock because VersionSet::next_file_number_ is atomic
+    compact_->blob_builder.reset(new BlobFileBuilder(
+        *ioptions, env_options_, versions_->NewFileNumber(), Env::IO_LOW));
+  }
+  return compact_->blob_builder->SeparateValue(key, value);
+}
+
+void CompactionJob::AddBlobGarbage(const Slice& blob_index) {
+  BlobIndex index;
+  if (index.DecodeFrom(blob_index).ok()) {
+    auto& garbage = compact_->blob_garbage[index.file_number];
+    garbage.first++;
+    garbage.second += index.size;
+  }
+}
+
 Status CompactionJob::InstallCompactionResults(InstrumentedMutex* db_mutex) {
   db_mutex->AssertHeld();
 
@@ -996,6 +1079,16 @@ Status CompactionJob::InstallCompactionResults(InstrumentedMutex* db_mutex) {
         compaction->output_level(), out.number, out.path_id, out.file_size,
         out.smallest, out.largest, out.smallest_seqno, out.largest_seqno);
   }
+  const BlobFileBuilder* blob_builder = compact_->blob_builder.get();
+  if (blob_builder != nullptr && blob_builder->num_blobs() > 0) {
+    compaction->edit()->AddBlobFile(
+        blob_builder->file_number(), blob_builder->file_size(),
+        blob_builder->num_blobs(), blob_builder->blob_bytes());
+  }
+  for (const auto& garbage : compact_->blob_garbage) {
+    compaction->edit()->AddBlobFileGarbage(
+        garbage.first, garbage.second.first, garbage.second.second);
+  }
   return versions_->LogAndApply(compaction->column_family_data(),
                                 mutable_cf_options_, compaction->edit(),
                                 db_mutex, db_directory_);
@@ -1082,7 +1175,8 @@ Status CompactionJob::OpenCompactionOutputFile() {
   compact_->builder.reset(NewTableBuilder(
       *cfd->ioptions(), cfd->internal_comparator(), compact_->outfile.get(),
       compact_->compaction->OutputCompressionType(),
-      cfd->ioptions()->compression_opts, skip_filters));
+      cfd->ioptions()->compression_opts, skip_filters,
+      compact_->compaction->output_level()));
   LogFlush(db_options_.info_log);
   return s;
 }
@@ -1095,6 +1189,10 @@ void CompactionJob::CleanupCompaction(const Status& status) {
   } else {
     assert(!status.ok() || compact_->outfile == nullptr);
   }
+  if (compact_->blob_builder != nullptr) {
+    // Deletes the blob file if it was not finished
+    compact_->blob_builder->Abandon();
+  }
   for (size_t i = 0; i < compact_->outputs.size(); i++) {
     const CompactionState::Output& out = compact_->outputs[i];
 
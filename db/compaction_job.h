@@ -86,6 +86,12 @@ class CompactionJob {
   // Call compaction_filter_v2->Filter() on kv-pairs in compact
   void CallCompactionFilterV2(CompactionFilterV2* compaction_filter_v2);
   Status FinishCompactionOutputFile(Iterator* input);
+  // Prepare the output entry *key, *value for the table: move a large value
+  // to the blob file of the compaction, and move the blob of a blob index
+  // into a blob file that is mostly garbage to it as well.
+  Status PrepareBlobOutput(Slice* key, Slice* value);
+  // Count the blob referred to by an input entry that is not output
+  void AddBlobGarbage(const Slice& blob_index);
   Status InstallCompactionResults(InstrumentedMutex* db_mutex);
   SequenceNumber findEarliestVisibleSnapshot(
       SequenceNumber in, const std::vector<SequenceNumber>& snapshots,
@@ -81,6 +81,12 @@ class CuckooTableDBTest {
     return result;
   }
 
+  std::vector<Status> MultiGet(const std::vector<std::string>& keys,
+                               std::vector<std::string>* values) {
+    std::vector<Slice> key_slices(keys.begin(), keys.end());
+    return db_->MultiGet(ReadOptions(), key_slices, values);
+  }
+
   int NumTableFilesAtLevel(int level) {
     std::string property;
     ASSERT_TRUE(
@@ -314,6 +320,74 @@ TEST(CuckooTableDBTest, AdaptiveTable) {
   ASSERT_EQ("v4", Get("key4"));
   ASSERT_EQ("v6", Get("key5"));
 }
+
+TEST(CuckooTableDBTest, TableFactoryPerLevel) {
+  // Keep the recent data in block based tables and move the rest into a
+  // cuckoo table in the last level.
+  Options options;
+  options.table_factory.reset(NewBlockBasedTableFactory());
+  options.table_factory_per_level.resize(3);
+  options.table_factory_per_level[2].reset(NewCuckooTableFactory());
+  options.allow_mmap_reads = true;
+  options.create_if_missing = true;
+  options.num_levels = 3;
+  options.level0_file_num_compaction_trigger = 10;
+  Reopen(&options);
+
+  for (int idx = 0; idx < 100; ++idx) {
+    ASSERT_OK(Put(Key(idx), std::string(100, 'a' + idx % 26)));
+  }
+  dbfull()->TEST_FlushMemTable();
+  dbfull()->TEST_CompactRange(0, nullptr, nullptr);
+  dbfull()->TEST_CompactRange(1, nullptr, nullptr);
+  ASSERT_EQ("0,0,1", FilesPerLevel());
+
+  // Update every other key in level 0
+  for (int idx = 0; idx < 100; idx += 2) {
+    ASSERT_OK(Put(Key(idx), std::string(100, 'A' + idx % 26)));
+  }
+  dbfull()->TEST_FlushMemTable();
+  ASSERT_EQ("1,0,1", FilesPerLevel());
+
+  TablePropertiesCollection ptc;
+  reinterpret_cast<DB*>(dbfull())->GetPropertiesOfAllTables(&ptc);
+  ASSERT_EQ(2U, ptc.size());
+  int num_cuckoo_tables = 0;
+  for (const auto& props : ptc) {
+    if (props.second->user_collected_properties.count(
+            CuckooTablePropertyNames::kEmptyKey) > 0) {
+      num_cuckoo_tables++;
+      ASSERT_EQ(100U, props.second->num_entries);
+    }
+  }
+  ASSERT_EQ(1, num_cuckoo_tables);
+
+  std::vector<std::string> keys;
+  for (int idx = 0; idx < 100; ++idx) {
+    keys.push_back(Key(idx));
+  }
+  keys.push_back(Key(100));
+  std::vector<std::string> values;
+  std::vector<Status> statuses = MultiGet(keys, &values);
+  ASSERT_EQ(keys.size(), statuses.size());
+  for (int idx = 0; idx < 100; ++idx) {
+    char c = (idx % 2 == 0 ? 'A' : 'a') + idx % 26;
+    ASSERT_OK(statuses[idx]);
+    ASSERT_EQ(std::string(100, c), values[idx]);
+    ASSERT_EQ(std::string(100, c), Get(Key(idx)));
+  }
+  ASSERT_TRUE(statuses[100].IsNotFound());
+
+  // Compacting everything again keeps the last level in the cuckoo format
+  dbfull()->TEST_CompactRange(0, nullptr, nullptr);
+  dbfull()->TEST_CompactRange(1, nullptr, nullptr);
+  ASSERT_EQ("0,0,1", FilesPerLevel());
+  for (int idx = 0; idx < 100; ++idx) {
+    char c = (idx % 2 == 0 ? 'A' : 'a') + idx % 26;
+    ASSERT_EQ(std::string(100, c), Get(Key(idx)));
+  }
+  ASSERT_EQ("NOT_FOUND", Get(Key(100)));
+}
 }  // namespace rocksdb
 
 int main(int argc, char** argv) { return rocksdb::test::RunAllTests(); }
@@ -281,6 +281,14 @@ DEFINE_int32(block_restart_interval,
              "Number of keys between restart points "
              "for delta encoding of keys.");
 
+DEFINE_int32(index_block_restart_interval,
+             rocksdb::BlockBasedTableOptions().index_block_restart_interval,
+             "Number of keys between restart points "
+             "for delta encoding of keys in index blocks.");
+
+DEFINE_int32(format_version, 2, "Format version of block based tables. "
+             "Version 3 delta encodes the block handles of the index.");
+
 DEFINE_int64(compressed_cache_size, -1,
              "Number of bytes to use as a cache of compressed data.");
 
@@ -313,9 +321,15 @@ DEFINE_int32(cache_numshardbits, -1, "Number of shards for the block cache"
 
 DEFINE_int32(cache_remove_scan_count_limit, 32, "");
 
+DEFINE_bool(use_clock_cache, false, "Use the lock-free CLOCK cache instead of"
+            " the LRU cache for the block cache.");
+
 DEFINE_bool(verify_checksum, false, "Verify checksum for every block read"
             " from storage");
 
+DEFINE_bool(pin_slice, false, "Use the PinnableSlice version of Get() in "
+            "readrandom, which does not copy values found in table files");
+
 DEFINE_bool(statistics, false, "Database statistics");
 static class std::shared_ptr<rocksdb::Statistics> dbstats;
 
@@ -407,6 +421,8 @@ enum rocksdb::CompressionType StringToCompressionType(const char* ctype) {
     return rocksdb::kLZ4Compression;
   else if (!strcasecmp(ctype, "lz4hc"))
     return rocksdb::kLZ4HCCompression;
+  else if (!strcasecmp(ctype, "zstd"))
+    return rocksdb::kZSTD;
 
   fprintf(stdout, "Cannot parse compression type '%s'\n", ctype);
   return rocksdb::kSnappyCompression; //default value
@@ -444,6 +460,14 @@ static bool ValidateCompressionLevel(const char* flagname, int32_t value) {
 static const bool FLAGS_compression_level_dummy __attribute__((unused)) =
     RegisterFlagValidator(&FLAGS_compression_level, &ValidateCompressionLevel);
 
+DEFINE_int32(compression_max_dict_bytes, 0,
+             "Maximum size of the dictionary built for each output file to "
+             "compress its data blocks with. Only used by zlib and zstd.");
+
+DEFINE_int32(compression_parallel_threads, 1,
+             "Number of threads that compress the data blocks of each table "
+             "file being written.");
+
 DEFINE_int32(min_level_to_compress, -1, "If non-negative, compression starts"
              " from this level. Levels with number < min_level_to_compress are"
              " not compressed. Otherwise, apply compression_type to "
@@ -521,6 +545,13 @@ DEFINE_bool(mmap_read, rocksdb::EnvOptions().use_mmap_reads,
 DEFINE_bool(mmap_write, rocksdb::EnvOptions().use_mmap_writes,
             "Allow writes to occur via mmap-ing files");
 
+DEFINE_bool(use_direct_reads, rocksdb::Options().use_direct_reads,
+            "Use O_DIRECT for reading table files");
+
+DEFINE_bool(use_direct_io_for_flush_and_compaction,
+            rocksdb::Options().use_direct_io_for_flush_and_compaction,
+            "Use O_DIRECT for the table files of flushes and compactions");
+
 DEFINE_bool(advise_random_on_open, rocksdb::Options().advise_random_on_open,
             "Advise random access on table file open");
 
@@ -529,6 +560,11 @@ DEFINE_string(compaction_fadvice, "NORMAL",
 static auto FLAGS_compaction_fadvice_e =
   rocksdb::Options().access_hint_on_compaction_start;
 
+DEFINE_uint64(compaction_readahead_size,
+              rocksdb::Options().compaction_readahead_size,
+              "If non-zero, compactions read their input files through a "
+              "readahead buffer of this size");
+
 DEFINE_bool(use_tailing_iterator, false,
             "Use tailing iterator to access a series of keys instead of get");
 DEFINE_int64(iter_refresh_interval_us, -1,
@@ -604,9 +640,17 @@ DEFINE_double(cuckoo_hash_ratio, 0.9, "Hash ratio for Cuckoo SST table.");
 DEFINE_bool(use_hash_search, false, "if use kHashSearch "
             "instead of kBinarySearch. "
             "This is valid if only we use BlockTable");
+DEFINE_bool(use_learned_index, false, "if use kLearnedSearch "
+            "instead of kBinarySearch. "
+            "This is valid if only we use BlockTable");
 DEFINE_bool(use_block_based_filter, false, "if use kBlockBasedFilter "
             "instead of kFullFilter for filter block. "
             "This is valid if only we use BlockTable");
+DEFINE_bool(use_data_block_hash_index, false, "if use "
+            "kDataBlockBinaryAndHash instead of kDataBlockBinarySearch. "
+            "This is valid if only we use BlockTable");
+DEFINE_int32(bloom_format_version, 0, "Format version of full filters. "
+             "1 keeps all probes of a key in one cache line");
 DEFINE_string(merge_operator, "", "The merge operator to use with the database."
               "If a new merge operator is specified, be sure to use fresh"
               " database The possible merge operators are defined in"
@@ -1219,6 +1263,9 @@ class Benchmark {
       case rocksdb::kLZ4HCCompression:
         fprintf(stdout, "Compression: lz4hc\n");
         break;
+      case rocksdb::kZSTD:
+        fprintf(stdout, "Compression: zstd\n");
+        break;
     }
 
     switch (FLAGS_rep_factory) {
@@ -1290,6 +1337,11 @@ class Benchmark {
                                   strlen(text), &compressed);
           name = "LZ4HC";
           break;
+        case kZSTD:
+          result = ZSTD_Compress(Options().compression_opts, text,
+                                 strlen(text), &compressed);
+          name = "ZSTD";
+          break;
         case kNoCompression:
           assert(false); // cannot happen
           break;
@@ -1359,7 +1411,13 @@ class Benchmark {
   Benchmark()
       : cache_(
             FLAGS_cache_size >= 0
-                ? (FLAGS_cache_numshardbits >= 1
+                ? (FLAGS_use_clock_cache
+                       ? (FLAGS_cache_numshardbits >= 1
+                              ? NewClockCache(FLAGS_cache_size,
+                                              FLAGS_cache_numshardbits,
+                                              FLAGS_block_size)
+                              : NewClockCache(FLAGS_cache_size))
+                       : FLAGS_cache_numshardbits >= 1
                        ? NewLRUCache(FLAGS_cache_size, FLAGS_cache_numshardbits,
                                      FLAGS_cache_remove_scan_count_limit)
                        : NewLRUCache(FLAGS_cache_size))
@@ -1372,7 +1430,8 @@ class Benchmark {
                               : nullptr),
         filter_policy_(FLAGS_bloom_bits >= 0
                            ? NewBloomFilterPolicy(FLAGS_bloom_bits,
-                                                  FLAGS_use_block_based_filter)
+                                                  FLAGS_use_block_based_filter,
+                                                  FLAGS_bloom_format_version)
                            : nullptr),
         prefix_extractor_(NewFixedPrefixTransform(FLAGS_prefix_size)),
         num_(FLAGS_num),
@@ -1857,6 +1916,10 @@ class Benchmark {
         ok = LZ4HC_Compress(Options().compression_opts, 2, input.data(),
                             input.size(), &compressed);
         break;
+      case rocksdb::kZSTD:
+        ok = ZSTD_Compress(Options().compression_opts, input.data(),
+                           input.size(), &compressed);
+        break;
       default:
         ok = false;
       }
@@ -1903,6 +1966,10 @@ class Benchmark {
       ok = LZ4HC_Compress(Options().compression_opts, 2, input.data(),
                           input.size(), &compressed);
       break;
+    case rocksdb::kZSTD:
+      ok = ZSTD_Compress(Options().compression_opts, input.data(),
+                         input.size(), &compressed);
+      break;
     default:
       ok = false;
     }
@@ -1938,6 +2005,11 @@ class Benchmark {
                                       &decompress_size, 2);
         ok = uncompressed != nullptr;
         break;
+      case rocksdb::kZSTD:
+        uncompressed = ZSTD_Uncompress(compressed.data(), compressed.size(),
+                                       &decompress_size);
+        ok = uncompressed != nullptr;
+        break;
       default:
         ok = false;
       }
@@ -2085,6 +2157,9 @@ class Benchmark {
           exit(1);
         }
         block_based_options.index_type = BlockBasedTableOptions::kHashSearch;
+      } else if (FLAGS_use_learned_index) {
+        block_based_options.index_type =
+            BlockBasedTableOptions::kLearnedSearch;
       } else {
         block_based_options.index_type = BlockBasedTableOptions::kBinarySearch;
       }
@@ -2095,8 +2170,14 @@ class Benchmark {
       block_based_options.block_cache_compressed = compressed_cache_;
       block_based_options.block_size = FLAGS_block_size;
       block_based_options.block_restart_interval = FLAGS_block_restart_interval;
+      block_based_options.index_block_restart_interval =
+          FLAGS_index_block_restart_interval;
       block_based_options.filter_policy = filter_policy_;
-      block_based_options.format_version = 2;
+      block_based_options.format_version = FLAGS_format_version;
+      if (FLAGS_use_data_block_hash_index) {
+        block_based_options.data_block_index_type =
+            BlockBasedTableOptions::kDataBlockBinaryAndHash;
+      }
       options.table_factory.reset(
           NewBlockBasedTableFactory(block_based_options));
     }
@@ -2117,6 +2198,10 @@ class Benchmark {
       FLAGS_level0_slowdown_writes_trigger;
     options.compression = FLAGS_compression_type_e;
     options.compression_opts.level = FLAGS_compression_level;
+    options.compression_opts.max_dict_bytes =
+        static_cast<uint32_t>(FLAGS_compression_max_dict_bytes);
+    options.compression_opts.parallel_threads =
+        static_cast<uint32_t>(FLAGS_compression_parallel_threads);
     options.WAL_ttl_seconds = FLAGS_wal_ttl_seconds;
     options.WAL_size_limit_MB = FLAGS_wal_size_limit_MB;
     options.max_total_wal_size = FLAGS_max_total_wal_size;
@@ -2146,8 +2231,13 @@ class Benchmark {
     options.allow_os_buffer = FLAGS_bufferedio;
     options.allow_mmap_reads = FLAGS_mmap_read;
     options.allow_mmap_writes = FLAGS_mmap_write;
+    options.use_direct_reads = FLAGS_use_direct_reads;
+    options.use_direct_io_for_flush_and_compaction =
+        FLAGS_use_direct_io_for_flush_and_compaction;
     options.advise_random_on_open = FLAGS_advise_random_on_open;
     options.access_hint_on_compaction_start = FLAGS_compaction_fadvice_e;
+    options.compaction_readahead_size =
+        static_cast<size_t>(FLAGS_compaction_readahead_size);
     options.use_adaptive_mutex = FLAGS_use_adaptive_mutex;
     options.bytes_per_sync = FLAGS_bytes_per_sync;
 
@@ -2515,6 +2605,7 @@ class Benchmark {
     std::unique_ptr<const char[]> key_guard;
     Slice key = AllocateKey(&key_guard);
     std::string value;
+    PinnableSlice pinnable_val;
 
     Duration duration(FLAGS_duration, reads_);
     while (!duration.Done(1)) {
@@ -2526,11 +2617,13 @@ class Benchmark {
       GenerateKeyFromInt(key_rand, FLAGS_num, &key);
       read++;
       Status s;
-      if (FLAGS_num_column_families > 1) {
-        s = db_with_cfh->db->Get(options, db_with_cfh->GetCfh(key_rand), key,
-                                 &value);
+      ColumnFamilyHandle* cfh = FLAGS_num_column_families > 1
+                                    ? db_with_cfh->GetCfh(key_rand)
+                                    : db_with_cfh->db->DefaultColumnFamily();
+      if (FLAGS_pin_slice) {
+        s = db_with_cfh->db->Get(options, cfh, key, &pinnable_val);
       } else {
-        s = db_with_cfh->db->Get(options, key, &value);
+        s = db_with_cfh->db->Get(options, cfh, key, &value);
       }
       if (s.ok()) {
         found++;
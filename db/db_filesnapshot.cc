@@ -113,18 +113,24 @@ Status DBImpl::GetLiveFiles(std::vector<std::string>& ret,
 
   // Make a set of all of the live *.sst files
   std::vector<FileDescriptor> live;
+  std::vector<uint64_t> live_blob_files;
   for (auto cfd : *versions_->GetColumnFamilySet()) {
     cfd->current()->AddLiveFiles(&live);
+    cfd->current()->AddLiveBlobFiles(&live_blob_files);
   }
 
   ret.clear();
-  ret.reserve(live.size() + 2); //*.sst + CURRENT + MANIFEST
+  // *.sst + *.blob + CURRENT + MANIFEST
+  ret.reserve(live.size() + live_blob_files.size() + 2);
 
   // create names of the live files. The names are not absolute
   // paths, instead they are relative to dbname_;
   for (auto live_file : live) {
     ret.push_back(MakeTableFileName("", live_file.GetNumber()));
   }
+  for (auto blob_file : live_blob_files) {
+    ret.push_back(BlobFileName("", blob_file));
+  }
 
   ret.push_back(CurrentFileName(""));
   ret.push_back(DescriptorFileName("", versions_->manifest_file_number()));
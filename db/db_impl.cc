@@ -15,6 +15,7 @@
 
 #include <inttypes.h>
 #include <algorithm>
+#include <atomic>
 #include <climits>
 #include <cstdio>
 #include <set>
@@ -165,6 +166,14 @@ Status SanitizeOptionsByTable(
     if (!s.ok()) {
       return s;
     }
+    for (const auto& table_factory : cf.options.table_factory_per_level) {
+      if (table_factory != nullptr) {
+        s = table_factory->SanitizeOptions(db_opts, cf.options);
+        if (!s.ok()) {
+          return s;
+        }
+      }
+    }
   }
   return Status::OK();
 }
@@ -226,6 +235,8 @@ DBImpl::DBImpl(const DBOptions& options, const std::string& dbname)
       next_job_id_(1),
       flush_on_destroy_(false),
       env_options_(options),
+      env_options_for_compaction_(env_->OptimizeForCompactionTableWrite(
+          env_options_, db_options_)),
 #ifndef ROCKSDB_LITE
       wal_manager_(db_options_, env_options_),
 #endif  // ROCKSDB_LITE
@@ -486,6 +497,8 @@ void DBImpl::FindObsoleteFiles(JobContext* job_context, bool force,
   // get obsolete files
   versions_->GetObsoleteFiles(&job_context->sst_delete_files,
                               job_context->min_pending_output);
+  versions_->GetObsoleteBlobFiles(&job_context->blob_delete_files,
+                                  job_context->min_pending_output);
 
   // store the current filenum, lognum, etc
   job_context->manifest_file_number = versions_->manifest_file_number();
@@ -495,6 +508,7 @@ void DBImpl::FindObsoleteFiles(JobContext* job_context, bool force,
   job_context->prev_log_number = versions_->prev_log_number();
 
   versions_->AddLiveFiles(&job_context->sst_live);
+  versions_->AddLiveBlobFiles(&job_context->blob_live);
   if (doing_the_full_scan) {
     for (uint32_t path_id = 0; path_id < db_options_.db_paths.size();
          path_id++) {
@@ -564,11 +578,14 @@ void DBImpl::PurgeObsoleteFiles(const JobContext& state) {
   for (const FileDescriptor& fd : state.sst_live) {
     sst_live_map[fd.GetNumber()] = &fd;
   }
+  std::unordered_set<uint64_t> blob_live_set(state.blob_live.begin(),
+                                             state.blob_live.end());
 
   auto candidate_files = state.full_scan_candidate_files;
   candidate_files.reserve(candidate_files.size() +
                           state.sst_delete_files.size() +
-                          state.log_delete_files.size());
+                          state.log_delete_files.size() +
+                          state.blob_delete_files.size());
   // We may ignore the dbname when generating the file names.
   const char* kDumbDbName = "";
   for (auto file : state.sst_delete_files) {
@@ -578,6 +595,10 @@ void DBImpl::PurgeObsoleteFiles(const JobContext& state) {
     delete file;
   }
 
+  for (auto file_num : state.blob_delete_files) {
+    candidate_files.emplace_back(BlobFileName(kDumbDbName, file_num), 0);
+  }
+
   for (auto file_num : state.log_delete_files) {
     if (file_num > 0) {
       candidate_files.emplace_back(LogFileName(kDumbDbName, file_num).substr(1),
@@ -620,6 +641,10 @@ void DBImpl::PurgeObsoleteFiles(const JobContext& state) {
         keep = (sst_live_map.find(number) != sst_live_map.end()) ||
                number >= state.min_pending_output;
         break;
+      case kBlobFile:
+        keep = (blob_live_set.find(number) != blob_live_set.end()) ||
+               number >= state.min_pending_output;
+        break;
       case kTempFile:
         // Any temp files that are currently being written to must
         // be recorded in pending_outputs_, which is inserted into "live".
@@ -652,6 +677,13 @@ void DBImpl::PurgeObsoleteFiles(const JobContext& state) {
       // evict from cache
       TableCache::Evict(table_cache_.get(), number);
       fname = TableFileName(db_options_.db_paths, number, path_id);
+    } else if (type == kBlobFile) {
+      // blob files are only written to the first path
+      if (path_id != 0) {
+        continue;
+      }
+      BlobFileCache::Evict(table_cache_.get(), number);
+      fname = BlobFileName(db_options_.db_paths[0].path, number);
     } else {
       fname = ((type == kLogFile) ?
           db_options_.wal_dir : dbname_) + "/" + to_delete;
@@ -1076,6 +1108,9 @@ Status DBImpl::WriteLevel0TableForRecovery(ColumnFamilyData* cfd, MemTable* mem,
   meta.fd = FileDescriptor(versions_->NewFileNumber(), 0, 0);
   auto pending_outputs_inserted_elem =
       CaptureCurrentFileNumberInPendingOutputs();
+  BlobFileMetaData blob_file;
+  const uint64_t blob_file_number =
+      cfd->ioptions()->min_blob_size > 0 ? versions_->NewFileNumber() : 0;
   ReadOptions ro;
   ro.total_order_seek = true;
   Arena arena;
@@ -1093,10 +1128,12 @@ Status DBImpl::WriteLevel0TableForRecovery(ColumnFamilyData* cfd, MemTable* mem,
     {
       mutex_.Unlock();
       s = BuildTable(
-          dbname_, env_, *cfd->ioptions(), env_options_, cfd->table_cache(),
-          iter.get(), &meta, cfd->internal_comparator(), newest_snapshot,
-          earliest_seqno_in_memtable, GetCompressionFlush(*cfd->ioptions()),
-          cfd->ioptions()->compression_opts, Env::IO_HIGH);
+          dbname_, env_, *cfd->ioptions(), env_options_for_compaction_,
+          cfd->table_cache(), iter.get(), &meta, cfd->internal_comparator(),
+          newest_snapshot, earliest_seqno_in_memtable,
+          GetCompressionFlush(*cfd->ioptions()),
+          cfd->ioptions()->compression_opts, Env::IO_HIGH, blob_file_number,
+          &blob_file);
       LogFlush(db_options_.info_log);
       mutex_.Lock();
     }
@@ -1116,11 +1153,15 @@ Status DBImpl::WriteLevel0TableForRecovery(ColumnFamilyData* cfd, MemTable* mem,
     edit->AddFile(level, meta.fd.GetNumber(), meta.fd.GetPathId(),
                   meta.fd.GetFileSize(), meta.smallest, meta.largest,
                   meta.smallest_seqno, meta.largest_seqno);
+    if (blob_file.total_count > 0) {
+      edit->AddBlobFile(blob_file.file_number, blob_file.file_size,
+                        blob_file.total_count, blob_file.total_bytes);
+    }
   }
 
   InternalStats::CompactionStats stats(1);
   stats.micros = env_->NowMicros() - start_micros;
-  stats.bytes_written = meta.fd.GetFileSize();
+  stats.bytes_written = meta.fd.GetFileSize() + blob_file.file_size;
   stats.files_out_levelnp1 = 1;
   cfd->internal_stats()->AddCompactionStats(level, stats);
   cfd->internal_stats()->AddCFStats(
@@ -1137,9 +1178,10 @@ Status DBImpl::FlushMemTableToOutputFile(
   assert(cfd->imm()->IsFlushPending());
 
   FlushJob flush_job(dbname_, cfd, db_options_, mutable_cf_options,
-                     env_options_, versions_.get(), &mutex_, &shutting_down_,
-                     snapshots_.GetNewest(), job_context, log_buffer,
-                     directories_.GetDbDir(), directories_.GetDataDir(0U),
+                     env_options_for_compaction_, versions_.get(), &mutex_,
+                     &shutting_down_, snapshots_.GetNewest(), job_context,
+                     log_buffer, directories_.GetDbDir(),
+                     directories_.GetDataDir(0U),
                      GetCompressionFlush(*cfd->ioptions()), stats_);
 
   uint64_t file_number;
@@ -1411,7 +1453,8 @@ Status DBImpl::CompactFilesImpl(
   };
   CompactionJob compaction_job(
       job_context->job_id, c.get(), db_options_, *c->mutable_cf_options(),
-      env_options_, versions_.get(), &shutting_down_, log_buffer,
+      env_options_for_compaction_, versions_.get(), &shutting_down_,
+      log_buffer,
       directories_.GetDbDir(), directories_.GetDataDir(c->GetOutputPathId()),
       stats_, &snapshots_, is_snapshot_supported_, table_cache_,
       std::move(yield_callback));
@@ -2267,7 +2310,8 @@ Status DBImpl::BackgroundCompaction(bool* madeProgress, JobContext* job_context,
     };
     CompactionJob compaction_job(
         job_context->job_id, c.get(), db_options_, *c->mutable_cf_options(),
-        env_options_, versions_.get(), &shutting_down_, log_buffer,
+        env_options_for_compaction_, versions_.get(), &shutting_down_,
+        log_buffer,
         directories_.GetDbDir(), directories_.GetDataDir(c->GetOutputPathId()),
         stats_, &snapshots_, is_snapshot_supported_, table_cache_,
         std::move(yield_callback));
@@ -2428,9 +2472,92 @@ ColumnFamilyHandle* DBImpl::DefaultColumnFamily() const {
 Status DBImpl::Get(const ReadOptions& read_options,
                    ColumnFamilyHandle* column_family, const Slice& key,
                    std::string* value) {
+  PinnableSlice pinnable_val(value);
+  Status s = GetImpl(read_options, column_family, key, &pinnable_val);
+  if (s.ok() && pinnable_val.IsPinned()) {
+    value->assign(pinnable_val.data(), pinnable_val.size());
+  }
+  return s;
+}
+
+Status DBImpl::Get(const ReadOptions& read_options,
+                   ColumnFamilyHandle* column_family, const Slice& key,
+                   PinnableSlice* value) {
+  value->Reset();
   return GetImpl(read_options, column_family, key, value);
 }
 
+namespace {
+// Keeps the data blocks of the operands returned by GetMergeOperands()
+// pinned until the last PinnableSlice referring to them is released.
+struct PinnedOperandStorage {
+  Cleanable cleanups;
+  std::atomic<int> refs;
+};
+
+void UnrefPinnedOperandStorage(void* arg1, void* arg2) {
+  auto* storage = reinterpret_cast<PinnedOperandStorage*>(arg1);
+  if (storage->refs.fetch_sub(1) == 1) {
+    delete storage;
+  }
+}
+}  // namespace
+
+Status DBImpl::GetMergeOperands(const ReadOptions& read_options,
+                                ColumnFamilyHandle* column_family,
+                                const Slice& key,
+                                PinnableSlice* merge_operands,
+                                int max_operands, int* num_operands) {
+  *num_operands = 0;
+  if (max_operands <= 0) {
+    return Status::InvalidArgument("max_operands must be positive");
+  }
+  MergeContext merge_context;
+  merge_context.CollectOperands(max_operands);
+  PinnableSlice unused_value;
+  Status s = GetImpl(read_options, column_family, key, &unused_value, nullptr,
+                     &merge_context);
+  if (!s.ok()) {
+    return s;
+  }
+
+  const auto& operands = merge_context.GetCollectedOperands();
+  if (operands.empty()) {
+    // Only possible if read_options do not allow reading the table file
+    return Status::Incomplete("merge operands not in memory");
+  }
+  assert(operands.size() <= static_cast<size_t>(max_operands));
+  PinnedOperandStorage* storage = nullptr;
+  int num_pinned = 0;
+  for (const auto& operand : operands) {
+    num_pinned += operand.second ? 1 : 0;
+  }
+  if (num_pinned > 0) {
+    storage = new PinnedOperandStorage();
+    storage->refs.store(num_pinned);
+    merge_context.GetPinnedStorage()->DelegateCleanupsTo(&storage->cleanups);
+  }
+  // Copied operands are moved to the buffers of the result
+  auto copy = merge_context.GetCopiedOperands()->begin();
+  for (const auto& operand : operands) {
+    PinnableSlice* result = &merge_operands[*num_operands];
+    result->Reset();
+    if (operand.second) {
+      result->PinSlice(operand.first, UnrefPinnedOperandStorage, storage,
+                       nullptr);
+    } else {
+      assert(copy->data() == operand.first.data());
+      result->GetSelf()->swap(*copy);
+      result->PinSelf();
+      ++copy;
+    }
+    ++*num_operands;
+  }
+  return merge_context.IsCollectionTruncated()
+             ? Status::Incomplete("more merge operands may exist")
+             : Status::OK();
+}
+
 // JobContext gets created and destructed outside of the lock --
 // we
 // use this convinently to:
@@ -2490,7 +2617,9 @@ SuperVersion* DBImpl::InstallSuperVersion(
 
 Status DBImpl::GetImpl(const ReadOptions& read_options,
                        ColumnFamilyHandle* column_family, const Slice& key,
-                       std::string* value, bool* value_found) {
+                       PinnableSlice* pinnable_val, bool* value_found,
+                       MergeContext* merge_context) {
+  assert(pinnable_val != nullptr);
   StopWatch sw(env_, stats_, DB_GET);
   PERF_TIMER_GUARD(get_snapshot_time);
 
@@ -2509,7 +2638,10 @@ Status DBImpl::GetImpl(const ReadOptions& read_options,
   SuperVersion* sv = GetAndRefSuperVersion(cfd);
 
   // Prepare to store a list of merge operations if merge occurs.
-  MergeContext merge_context;
+  MergeContext local_merge_context;
+  if (merge_context == nullptr) {
+    merge_context = &local_merge_context;
+  }
 
   Status s;
   // First look in the memtable, then in the immutable memtable (if any).
@@ -2518,34 +2650,118 @@ Status DBImpl::GetImpl(const ReadOptions& read_options,
   LookupKey lkey(key, snapshot);
   PERF_TIMER_STOP(get_snapshot_time);
 
-  if (sv->mem->Get(lkey, value, &s, &merge_context)) {
+  // Values found in memtables are copied, those found in table files are
+  // pinned to their data block if possible.
+  if (sv->mem->Get(lkey, pinnable_val->GetSelf(), &s, merge_context)) {
     // Done
+    pinnable_val->PinSelf();
     RecordTick(stats_, MEMTABLE_HIT);
-  } else if (sv->imm->Get(lkey, value, &s, &merge_context)) {
+  } else if (sv->imm->Get(lkey, pinnable_val->GetSelf(), &s,
+                          merge_context)) {
     // Done
+    pinnable_val->PinSelf();
     RecordTick(stats_, MEMTABLE_HIT);
   } else {
     PERF_TIMER_GUARD(get_from_output_files_time);
-    sv->current->Get(read_options, lkey, value, &s, &merge_context,
+    sv->current->Get(read_options, lkey, pinnable_val, &s, merge_context,
                      value_found);
     RecordTick(stats_, MEMTABLE_MISS);
   }
 
+  // KeyMayExist() may not have the value, and collected operands are not
+  // merged
+  const size_t write_back_threshold =
+      sv->mutable_cf_options.merge_write_back_threshold;
+  const bool write_back = write_back_threshold > 0 && s.ok() &&
+                          value_found == nullptr &&
+                          !merge_context->IsCollectingOperands() &&
+                          merge_context->GetNumOperands() >=
+                              write_back_threshold;
+
   {
     PERF_TIMER_GUARD(get_post_process_time);
 
     ReturnAndCleanupSuperVersion(cfd, sv);
 
     RecordTick(stats_, NUMBER_KEYS_READ);
-    RecordTick(stats_, BYTES_READ, value->size());
+    RecordTick(stats_, BYTES_READ, pinnable_val->size());
+  }
+
+  if (write_back) {
+    WriteBackMergeResult(cfd, key, *pinnable_val, snapshot,
+                         merge_context->GetNewestOperandSequence());
   }
   return s;
 }
 
+void DBImpl::WriteBackMergeResult(ColumnFamilyData* cfd, const Slice& key,
+                                  const Slice& value, SequenceNumber snapshot,
+                                  SequenceNumber newest_operand) {
+  // The result must be newer than the operands it replaces. Adding it at a
+  // sequence number after snapshot could hide updates made since.
+  if (newest_operand >= snapshot) {
+    return;
+  }
+
+  InstrumentedMutexLock l(&mutex_);
+  // Entering the write thread without a batch keeps memtable writers out
+  // while the result is added
+  WriteThread::Writer w(&mutex_);
+  Status s = write_thread_.EnterWriteThread(&w, 0);
+  assert(s.ok() && !w.done);  // No timeout and nobody should do our job
+
+  MemTable* mem = cfd->mem();
+  // Updates of key newer than snapshot are looked up before the active
+  // memtable unless it holds everything after snapshot. Its first entry
+  // must also stay the oldest one.
+  bool safe = !cfd->IsDropped() &&
+              !cfd->ioptions()->inplace_update_support &&
+              mem->GetFirstSequenceNumber() != 0 &&
+              mem->GetFirstSequenceNumber() < snapshot;
+  if (safe) {
+    // Another read may have written the result back already
+    Arena arena;
+    ScopedArenaIterator iter(mem->NewIterator(ReadOptions(), &arena));
+    InternalKey ikey(key, snapshot, kValueTypeForSeek);
+    iter->Seek(ikey.Encode());
+    ParsedInternalKey parsed;
+    if (iter->Valid() && ParseInternalKey(iter->key(), &parsed) &&
+        parsed.sequence == snapshot &&
+        cfd->user_comparator()->Compare(parsed.user_key, key) == 0) {
+      safe = false;
+    }
+  }
+  if (safe) {
+    mem->Add(snapshot, kTypeValue, key, value);
+    if (mem->ShouldScheduleFlush()) {
+      flush_scheduler_.ScheduleFlush(cfd);
+      mem->MarkFlushScheduled();
+    }
+    RecordTick(stats_, NUMBER_MERGE_WRITE_BACKS);
+  }
+  write_thread_.ExitWriteThread(&w, &w, s);
+}
+
 std::vector<Status> DBImpl::MultiGet(
     const ReadOptions& read_options,
     const std::vector<ColumnFamilyHandle*>& column_family,
     const std::vector<Slice>& keys, std::vector<std::string>* values) {
+  return MultiGetImpl(read_options, column_family, keys, values, nullptr);
+}
+
+std::vector<Status> DBImpl::MultiGet(
+    const ReadOptions& read_options,
+    const std::vector<ColumnFamilyHandle*>& column_family,
+    const std::vector<Slice>& keys, PinnableSlice* values) {
+  return MultiGetImpl(read_options, column_family, keys, nullptr, values);
+}
+
+std::vector<Status> DBImpl::MultiGetImpl(
+    const ReadOptions& read_options,
+    const std::vector<ColumnFamilyHandle*>& column_family,
+    const std::vector<Slice>& keys, std::vector<std::string>* values,
+    PinnableSlice* pinnable_vals) {
+  assert((values == nullptr) != (pinnable_vals == nullptr));
 
   StopWatch sw(env_, stats_, DB_MULTIGET);
   PERF_TIMER_GUARD(get_snapshot_time);
@@ -2587,7 +2803,9 @@ std::vector<Status> DBImpl::MultiGet(
   // Note: this always resizes the values array
   size_t num_keys = keys.size();
   std::vector<Status> stat_list(num_keys);
-  values->resize(num_keys);
+  if (values != nullptr) {
+    values->resize(num_keys);
+  }
 
   // Keep track of bytes that we read for statistics-recording later
   uint64_t bytes_read = 0;
@@ -2600,7 +2818,12 @@ std::vector<Status> DBImpl::MultiGet(
   for (size_t i = 0; i < num_keys; ++i) {
     merge_context.Clear();
     Status& s = stat_list[i];
-    std::string* value = &(*values)[i];
+    PinnableSlice string_val(values != nullptr ? &(*values)[i] : nullptr);
+    PinnableSlice* value = &string_val;
+    if (pinnable_vals != nullptr) {
+      value = &pinnable_vals[i];
+      value->Reset();
+    }
 
     LookupKey lkey(keys[i], snapshot);
     auto cfh = reinterpret_cast<ColumnFamilyHandleImpl*>(column_family[i]);
@@ -2608,10 +2831,14 @@ std::vector<Status> DBImpl::MultiGet(
     assert(mgd_iter != multiget_cf_data.end());
     auto mgd = mgd_iter->second;
     auto super_version = mgd->super_version;
-    if (super_version->mem->Get(lkey, value, &s, &merge_context)) {
+    if (super_version->mem->Get(lkey, value->GetSelf(), &s,
+                                &merge_context)) {
       // Done
-    } else if (super_version->imm->Get(lkey, value, &s, &merge_context)) {
+      value->PinSelf();
+    } else if (super_version->imm->Get(lkey, value->GetSelf(), &s,
+                                       &merge_context)) {
       // Done
+      value->PinSelf();
     } else {
       PERF_TIMER_GUARD(get_from_output_files_time);
       super_version->current->Get(read_options, lkey, value, &s,
@@ -2620,6 +2847,9 @@ std::vector<Status> DBImpl::MultiGet(
 
     if (s.ok()) {
       bytes_read += value->size();
+      if (values != nullptr && value->IsPinned()) {
+        (*values)[i].assign(value->data(), value->size());
+      }
     }
   }
 
@@ -2790,7 +3020,11 @@ bool DBImpl::KeyMayExist(const ReadOptions& read_options,
   }
   ReadOptions roptions = read_options;
   roptions.read_tier = kBlockCacheTier; // read from block cache only
-  auto s = GetImpl(roptions, column_family, key, value, value_found);
+  PinnableSlice pinnable_val(value);
+  auto s = GetImpl(roptions, column_family, key, &pinnable_val, value_found);
+  if (s.ok() && pinnable_val.IsPinned()) {
+    value->assign(pinnable_val.data(), pinnable_val.size());
+  }
 
   // If block_cache is enabled and the index block of the table didn't
   // not present in block_cache, the return value will be Status::Incomplete.
@@ -2830,7 +3064,8 @@ Iterator* DBImpl::NewIterator(const ReadOptions& read_options,
     return NewDBIterator(env_, *cfd->ioptions(), cfd->user_comparator(), iter,
         kMaxSequenceNumber,
         sv->mutable_cf_options.max_sequential_skip_in_iterations,
-        read_options.iterate_upper_bound);
+        read_options.iterate_upper_bound, read_options.iterate_lower_bound,
+        false, BlobFetcher(cfd->blob_file_cache(), read_options));
 #endif
   } else {
     SequenceNumber latest_snapshot = versions_->LastSequence();
@@ -2887,7 +3122,9 @@ Iterator* DBImpl::NewIterator(const ReadOptions& read_options,
     ArenaWrappedDBIter* db_iter = NewArenaWrappedDbIterator(
         env_, *cfd->ioptions(), cfd->user_comparator(),
         snapshot, sv->mutable_cf_options.max_sequential_skip_in_iterations,
-        read_options.iterate_upper_bound);
+        read_options.iterate_upper_bound, read_options.iterate_lower_bound,
+        read_options.total_order_seek,
+        BlobFetcher(cfd->blob_file_cache(), read_options));
 
     Iterator* internal_iter =
         NewInternalIterator(read_options, cfd, sv, db_iter->GetArena());
@@ -2936,7 +3173,10 @@ Status DBImpl::NewIterators(
       iterators->push_back(
           NewDBIterator(env_, *cfd->ioptions(), cfd->user_comparator(), iter,
               kMaxSequenceNumber,
-              sv->mutable_cf_options.max_sequential_skip_in_iterations));
+              sv->mutable_cf_options.max_sequential_skip_in_iterations,
+              read_options.iterate_upper_bound,
+              read_options.iterate_lower_bound, false,
+              BlobFetcher(cfd->blob_file_cache(), read_options)));
     }
 #endif
   } else {
@@ -2955,7 +3195,10 @@ Status DBImpl::NewIterators(
 
       ArenaWrappedDBIter* db_iter = NewArenaWrappedDbIterator(
           env_, *cfd->ioptions(), cfd->user_comparator(), snapshot,
-          sv->mutable_cf_options.max_sequential_skip_in_iterations);
+          sv->mutable_cf_options.max_sequential_skip_in_iterations,
+          read_options.iterate_upper_bound, read_options.iterate_lower_bound,
+          read_options.total_order_seek,
+          BlobFetcher(cfd->blob_file_cache(), read_options));
       Iterator* internal_iter = NewInternalIterator(
           read_options, cfd, sv, db_iter->GetArena());
       db_iter->SetIterUnderDBIter(internal_iter);
@@ -2966,6 +3209,177 @@ Status DBImpl::NewIterators(
   return Status::OK();
 }
 
+namespace {
+
+// Shared by the threads of one ParallelScan() call
+struct ParallelScanState {
+  ParallelScanState() : cv(&mutex), next_scan(0), num_running(0) {}
+
+  DB* db;
+  ColumnFamilyHandle* column_family;
+  ReadOptions options;
+  const Slice* begin;
+  const Slice* end;
+  std::vector<std::string> split_keys;
+  const DB::ScanCallback* callback;
+
+  // mutex protects the following state
+  port::Mutex mutex;
+  port::CondVar cv;
+  size_t next_scan;
+  // Number of partitions being scanned
+  size_t num_running;
+  Status status;
+};
+
+// Scan partitions until none are left
+void RunParallelScan(ParallelScanState* state) {
+  const size_t num_scans = state->split_keys.size() + 1;
+  MutexLock l(&state->mutex);
+  while (state->next_scan < num_scans) {
+    const size_t i = state->next_scan++;
+    state->num_running++;
+    state->mutex.Unlock();
+
+    Slice lower, upper;
+    ReadOptions options = state->options;
+    options.iterate_lower_bound = state->begin;
+    options.iterate_upper_bound = state->end;
+    if (i > 0) {
+      lower = state->split_keys[i - 1];
+      options.iterate_lower_bound = &lower;
+    }
+    if (i + 1 < num_scans) {
+      upper = state->split_keys[i];
+      options.iterate_upper_bound = &upper;
+    }
+    std::unique_ptr<Iterator> iter(
+        state->db->NewIterator(options, state->column_family));
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+      if (!(*state->callback)(static_cast<int>(i), iter->key(),
+                              iter->value())) {
+        break;
+      }
+    }
+    Status s = iter->status();
+    iter.reset();
+
+    state->mutex.Lock();
+    if (!s.ok() && state->status.ok()) {
+      state->status = s;
+    }
+    state->num_running--;
+  }
+  state->cv.SignalAll();
+}
+
+void BGWorkParallelScan(void* arg) {
+  std::unique_ptr<std::shared_ptr<ParallelScanState>> state(
+      reinterpret_cast<std::shared_ptr<ParallelScanState>*>(arg));
+  RunParallelScan(state->get());
+}
+
+}  // namespace
+
+Status DBImpl::ParallelScan(const ReadOptions& read_options,
+                            ColumnFamilyHandle* column_family,
+                            const Slice* begin, const Slice* end,
+                            int num_partitions,
+                            const ScanCallback& callback) {
+  if (num_partitions <= 0) {
+    return Status::InvalidArgument("num_partitions must be positive");
+  }
+  if (read_options.tailing || read_options.managed) {
+    return Status::InvalidArgument(
+        "ParallelScan() does not support tailing or managed iterators");
+  }
+  auto cfh = reinterpret_cast<ColumnFamilyHandleImpl*>(column_family);
+  auto cfd = cfh->cfd();
+  const Comparator* ucmp = cfd->user_comparator();
+  if (begin != nullptr && end != nullptr && ucmp->Compare(*begin, *end) >= 0) {
+    return Status::OK();
+  }
+
+  // Partitions are split on user keys, which a prefix seek does not order
+  ReadOptions scan_options = read_options;
+  scan_options.total_order_seek = true;
+  const Snapshot* snapshot = nullptr;
+  if (scan_options.snapshot == nullptr) {
+    snapshot = GetSnapshot();
+    scan_options.snapshot = snapshot;
+  }
+
+  // Cut the range where the table data before the cut reaches the next
+  // multiple of 1/num_partitions of the data in the range
+  std::vector<std::string> split_keys;
+  if (num_partitions > 1) {
+    const size_t kSplitPointsPerPartition = 16;
+    std::vector<std::pair<std::string, uint64_t>> points;
+    SuperVersion* sv = GetAndRefSuperVersion(cfd);
+    sv->current->GetSplitPoints(begin, end,
+                                num_partitions * kSplitPointsPerPartition,
+                                &points);
+    ReturnAndCleanupSuperVersion(cfd, sv);
+
+    std::sort(points.begin(), points.end(),
+              [ucmp](const std::pair<std::string, uint64_t>& a,
+                     const std::pair<std::string, uint64_t>& b) {
+                return ucmp->Compare(a.first, b.first) < 0;
+              });
+    uint64_t total_bytes = 0;
+    for (const auto& point : points) {
+      total_bytes += point.second;
+    }
+    uint64_t bytes = 0;
+    for (const auto& point : points) {
+      if (split_keys.size() + 1 >= static_cast<size_t>(num_partitions)) {
+        break;
+      }
+      if (bytes > 0 &&
+          bytes * num_partitions >= total_bytes * (split_keys.size() + 1) &&
+          (begin == nullptr || ucmp->Compare(point.first, *begin) > 0) &&
+          (split_keys.empty() ||
+           ucmp->Compare(point.first, split_keys.back()) > 0)) {
+        split_keys.push_back(point.first);
+      }
+      bytes += point.second;
+    }
+  }
+
+  // The calling thread scans partitions, helped by jobs in the LOW priority
+  // pool of the Env. A job only touches the DB while it scans a partition it
+  // took; the calling thread waits for those before it returns, and a job
+  // that starts later finds no partition left.
+  std::shared_ptr<ParallelScanState> state(new ParallelScanState);
+  state->db = this;
+  state->column_family = column_family;
+  state->options = scan_options;
+  state->begin = begin;
+  state->end = end;
+  state->split_keys = std::move(split_keys);
+  state->callback = &callback;
+  const size_t num_scans = state->split_keys.size() + 1;
+  for (size_t i = 1; i < num_scans; i++) {
+    env_->Schedule(&BGWorkParallelScan,
+                   new std::shared_ptr<ParallelScanState>(state),
+                   Env::Priority::LOW);
+  }
+  RunParallelScan(state.get());
+  Status status;
+  {
+    MutexLock l(&state->mutex);
+    while (state->num_running > 0) {
+      state->cv.Wait();
+    }
+    status = state->status;
+  }
+
+  if (snapshot != nullptr) {
+    ReleaseSnapshot(snapshot);
+  }
+  return status;
+}
+
 const Snapshot* DBImpl::GetSnapshot() {
   int64_t unix_time = 0;
   env_->GetCurrentTime(&unix_time);  // Ignore error
@@ -78,12 +78,26 @@ class DBImpl : public DB {
   virtual Status Get(const ReadOptions& options,
                      ColumnFamilyHandle* column_family, const Slice& key,
                      std::string* value) override;
+  virtual Status Get(const ReadOptions& options,
+                     ColumnFamilyHandle* column_family, const Slice& key,
+                     PinnableSlice* value) override;
   using DB::MultiGet;
   virtual std::vector<Status> MultiGet(
       const ReadOptions& options,
       const std::vector<ColumnFamilyHandle*>& column_family,
       const std::vector<Slice>& keys,
       std::vector<std::string>* values) override;
+  virtual std::vector<Status> MultiGet(
+      const ReadOptions& options,
+      const std::vector<ColumnFamilyHandle*>& column_family,
+      const std::vector<Slice>& keys, PinnableSlice* values) override;
+  using DB::GetMergeOperands;
+  virtual Status GetMergeOperands(const ReadOptions& options,
+                                  ColumnFamilyHandle* column_family,
+                                  const Slice& key,
+                                  PinnableSlice* merge_operands,
+                                  int max_operands,
+                                  int* num_operands) override;
 
   virtual Status CreateColumnFamily(const ColumnFamilyOptions& options,
                                     const std::string& column_family,
@@ -106,6 +120,12 @@ class DBImpl : public DB {
       const ReadOptions& options,
       const std::vector<ColumnFamilyHandle*>& column_families,
       std::vector<Iterator*>* iterators) override;
+  using DB::ParallelScan;
+  virtual Status ParallelScan(const ReadOptions& options,
+                              ColumnFamilyHandle* column_family,
+                              const Slice* begin, const Slice* end,
+                              int num_partitions,
+                              const ScanCallback& callback) override;
   virtual const Snapshot* GetSnapshot() override;
   virtual void ReleaseSnapshot(const Snapshot* snapshot) override;
   using DB::GetProperty;
@@ -297,6 +317,7 @@ class DBImpl : public DB {
 #endif
   friend struct SuperVersion;
   friend class CompactedDBImpl;
+  friend class DBImplSecondary;
   struct CompactionState;
 
   struct WriteContext;
@@ -595,6 +616,9 @@ class DBImpl : public DB {
   // The options to access storage files
   const EnvOptions env_options_;
 
+  // The options for the table files written by flushes and compactions
+  const EnvOptions env_options_for_compaction_;
+
 #ifndef ROCKSDB_LITE
   WalManager wal_manager_;
 #endif  // ROCKSDB_LITE
@@ -664,9 +688,27 @@ class DBImpl : public DB {
 
   // Function that Get and KeyMayExist call with no_io true or false
   // Note: 'value_found' from KeyMayExist propagates here
+  // If merge_context is not null, it is used for the lookup instead of a
+  // local one, see GetMergeOperands()
   Status GetImpl(const ReadOptions& options, ColumnFamilyHandle* column_family,
-                 const Slice& key, std::string* value,
-                 bool* value_found = nullptr);
+                 const Slice& key, PinnableSlice* value,
+                 bool* value_found = nullptr,
+                 MergeContext* merge_context = nullptr);
+
+  // Add value, the full merge result of key as of snapshot, to the active
+  // memtable of cfd if that does not hide any newer update of key. See
+  // merge_write_back_threshold.
+  void WriteBackMergeResult(ColumnFamilyData* cfd, const Slice& key,
+                            const Slice& value, SequenceNumber snapshot,
+                            SequenceNumber newest_operand);
+
+  // Function that both MultiGet()s call. Exactly one of values and
+  // pinnable_vals is not null.
+  std::vector<Status> MultiGetImpl(
+      const ReadOptions& options,
+      const std::vector<ColumnFamilyHandle*>& column_family,
+      const std::vector<Slice>& keys, std::vector<std::string>* values,
+      PinnableSlice* pinnable_vals);
 
   bool GetIntPropertyInternal(ColumnFamilyHandle* column_family,
                               DBPropertyType property_type,
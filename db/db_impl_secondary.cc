@@ -0,0 +1,366 @@
+//  Copyright (c) 2013, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include "db/db_impl_secondary.h"
+
+#include <inttypes.h>
+#include <algorithm>
+#include <limits>
+#include <unordered_set>
+
+#include "db/column_family.h"
+#include "db/filename.h"
+#include "db/log_reader.h"
+#include "db/table_cache.h"
+#include "db/version_set.h"
+#include "db/write_batch_internal.h"
+#include "util/auto_roll_logger.h"
+
+namespace rocksdb {
+
+#ifndef ROCKSDB_LITE
+
+namespace {
+// Number of times TryCatchUpWithPrimary() reads the MANIFEST again because
+// the primary deleted a WAL file before it was replayed
+const int kMaxCatchUpAttempts = 3;
+}  // namespace
+
+DBImplSecondary::DBImplSecondary(const DBOptions& db_options,
+                                 const std::string& dbname)
+    : DBImplReadOnly(db_options, dbname) {
+  // The files belong to the primary
+  disable_delete_obsolete_files_ = 1;
+  Log(INFO_LEVEL, db_options_.info_log, "Opening the db in secondary mode");
+  LogFlush(db_options_.info_log);
+}
+
+DBImplSecondary::~DBImplSecondary() {
+}
+
+Status DBImplSecondary::Get(const ReadOptions& read_options,
+                            ColumnFamilyHandle* column_family, const Slice& key,
+                            std::string* value) {
+  return DBImpl::Get(read_options, column_family, key, value);
+}
+
+Status DBImplSecondary::Get(const ReadOptions& read_options,
+                            ColumnFamilyHandle* column_family, const Slice& key,
+                            PinnableSlice* value) {
+  return DBImpl::Get(read_options, column_family, key, value);
+}
+
+Iterator* DBImplSecondary::NewIterator(const ReadOptions& read_options,
+                                       ColumnFamilyHandle* column_family) {
+  return DBImpl::NewIterator(read_options, column_family);
+}
+
+Status DBImplSecondary::NewIterators(
+    const ReadOptions& read_options,
+    const std::vector<ColumnFamilyHandle*>& column_families,
+    std::vector<Iterator*>* iterators) {
+  return DBImpl::NewIterators(read_options, column_families, iterators);
+}
+
+Status DBImplSecondary::ReplayLogs(bool rebuild, SequenceNumber* max_sequence,
+                                   bool* missing_log) {
+  struct LogReporter : public log::Reader::Reporter {
+    Logger* info_log;
+    const char* fname;
+    Status* status;  // nullptr if db_options_.paranoid_checks==false
+    virtual void Corruption(size_t bytes, const Status& s) override {
+      Log(InfoLogLevel::WARN_LEVEL,
+          info_log, "%s%s: dropping %d bytes; %s",
+          (this->status == nullptr ? "(ignoring error) " : ""),
+          fname, static_cast<int>(bytes), s.ToString().c_str());
+      if (this->status != nullptr && this->status->ok()) *this->status = s;
+    }
+  };
+
+  mutex_.AssertHeld();
+  *missing_log = false;
+
+  std::vector<std::string> filenames;
+  Status status = env_->GetChildren(db_options_.wal_dir, &filenames);
+  if (!status.ok()) {
+    return status;
+  }
+  const uint64_t min_log = versions_->MinLogNumber();
+  std::vector<uint64_t> log_numbers;
+  for (const auto& filename : filenames) {
+    uint64_t number;
+    FileType type;
+    if (ParseFileName(filename, &number, &type) && type == kLogFile &&
+        number >= min_log) {
+      log_numbers.push_back(number);
+    }
+  }
+  std::sort(log_numbers.begin(), log_numbers.end());
+
+  if (rebuild) {
+    for (auto cfd : *versions_->GetColumnFamilySet()) {
+      cfd->CreateNewMemtable(*cfd->GetLatestMutableCFOptions());
+    }
+    log_read_offsets_.clear();
+  }
+  // The column families no longer need the older WAL files
+  log_read_offsets_.erase(log_read_offsets_.begin(),
+                          log_read_offsets_.lower_bound(min_log));
+
+  for (auto log_number : log_numbers) {
+    std::string fname = LogFileName(db_options_.wal_dir, log_number);
+    unique_ptr<SequentialFile> file;
+    status = env_->NewSequentialFile(fname, &file, env_options_);
+    if (!status.ok()) {
+      if (env_->FileExists(fname)) {
+        return status;
+      }
+      // The primary has flushed its contents since the MANIFEST was read
+      *missing_log = true;
+      status = Status::OK();
+      continue;
+    }
+
+    uint64_t* offset = &log_read_offsets_[log_number];
+    LogReporter reporter;
+    reporter.info_log = db_options_.info_log.get();
+    reporter.fname = fname.c_str();
+    reporter.status = (db_options_.paranoid_checks) ? &status : nullptr;
+    // A record the primary is still writing ends the log for now; the next
+    // call starts with it
+    log::Reader reader(std::move(file), &reporter, true /*checksum*/,
+                       *offset);
+
+    std::string scratch;
+    Slice record;
+    WriteBatch batch;
+    while (reader.ReadRecord(&record, &scratch) && status.ok()) {
+      if (record.size() < 12) {
+        reporter.Corruption(record.size(),
+                            Status::Corruption("log record too small"));
+        continue;
+      }
+      WriteBatchInternal::SetContents(&batch, record);
+      // Updates of column families that are not open, or that are already
+      // in a table file, are skipped
+      status = WriteBatchInternal::InsertInto(
+          &batch, column_family_memtables_.get(), true, log_number);
+      MaybeIgnoreError(&status);
+      if (!status.ok()) {
+        break;
+      }
+      *offset = reader.EndOfLastRecordOffset();
+      const SequenceNumber last_seq = WriteBatchInternal::Sequence(&batch) +
+                                      WriteBatchInternal::Count(&batch) - 1;
+      if (last_seq > *max_sequence) {
+        *max_sequence = last_seq;
+      }
+    }
+    // Memtables are never flushed here; they are replaced once the primary
+    // has flushed them
+    flush_scheduler_.Clear();
+    if (!status.ok()) {
+      return status;
+    }
+  }
+  return status;
+}
+
+Status DBImplSecondary::TryCatchUpWithPrimary() {
+  InstrumentedMutexLock l(&mutex_);
+  // Entering the write thread without a batch keeps out merge results
+  // written back by reads while the memtables change
+  WriteThread::Writer w(&mutex_);
+  Status s = write_thread_.EnterWriteThread(&w, 0);
+  assert(s.ok() && !w.done);  // No timeout and nobody should do our job
+
+  bool install = false;
+  SequenceNumber max_sequence = 0;
+  for (int attempt = 1; s.ok(); attempt++) {
+    std::vector<uint64_t> log_numbers;
+    for (auto cfd : *versions_->GetColumnFamilySet()) {
+      log_numbers.push_back(cfd->GetLogNumber());
+    }
+    bool versions_changed = false;
+    SequenceNumber manifest_sequence = 0;
+    s = versions_->ReadNewManifestRecords(&mutex_, &versions_changed,
+                                          &manifest_sequence);
+    if (!s.ok()) {
+      break;
+    }
+    max_sequence = std::max(max_sequence, manifest_sequence);
+
+    // A memtable whose contents the primary has flushed would return them
+    // a second time along with the new table file, so all memtables are
+    // rebuilt from the WAL files that are still needed
+    bool rebuild = false;
+    size_t i = 0;
+    for (auto cfd : *versions_->GetColumnFamilySet()) {
+      if (cfd->GetLogNumber() != log_numbers[i++]) {
+        rebuild = true;
+      }
+    }
+    install = install || versions_changed || rebuild;
+
+    bool missing_log = false;
+    s = ReplayLogs(rebuild, &max_sequence, &missing_log);
+    // The primary deletes a WAL file only after it has recorded the flush of
+    // its contents in the MANIFEST, which the next attempt reads
+    if (!missing_log || attempt >= kMaxCatchUpAttempts) {
+      break;
+    }
+  }
+
+  if (s.ok()) {
+    if (versions_->LastSequence() < max_sequence) {
+      versions_->SetLastSequence(max_sequence);
+    }
+    if (install) {
+      for (auto cfd : *versions_->GetColumnFamilySet()) {
+        delete cfd->InstallSuperVersion(new SuperVersion(), &mutex_);
+      }
+    }
+  }
+
+  // Files dropped from all versions may still be in the table cache
+  std::vector<FileMetaData*> obsolete_files;
+  versions_->GetObsoleteFiles(&obsolete_files,
+                              std::numeric_limits<uint64_t>::max());
+  if (!obsolete_files.empty()) {
+    std::vector<FileDescriptor> live_files;
+    versions_->AddLiveFiles(&live_files);
+    std::unordered_set<uint64_t> live_numbers;
+    for (const auto& fd : live_files) {
+      live_numbers.insert(fd.GetNumber());
+    }
+    for (auto f : obsolete_files) {
+      if (live_numbers.count(f->fd.GetNumber()) == 0) {
+        TableCache::Evict(table_cache_.get(), f->fd.GetNumber());
+      }
+      delete f;
+    }
+  }
+
+  write_thread_.ExitWriteThread(&w, &w, s);
+  if (s.ok()) {
+    Log(InfoLogLevel::INFO_LEVEL, db_options_.info_log,
+        "Caught up with primary to sequence number %" PRIu64,
+        versions_->LastSequence());
+  }
+  return s;
+}
+
+Status DB::OpenAsSecondary(const Options& options, const std::string& dbname,
+                           const std::string& secondary_path, DB** dbptr) {
+  *dbptr = nullptr;
+
+  DBOptions db_options(options);
+  ColumnFamilyOptions cf_options(options);
+  std::vector<ColumnFamilyDescriptor> column_families;
+  column_families.push_back(
+      ColumnFamilyDescriptor(kDefaultColumnFamilyName, cf_options));
+  std::vector<ColumnFamilyHandle*> handles;
+
+  Status s = DB::OpenAsSecondary(db_options, dbname, secondary_path,
+                                 column_families, &handles, dbptr);
+  if (s.ok()) {
+    assert(handles.size() == 1);
+    // i can delete the handle since DBImpl is always holding a
+    // reference to default column family
+    delete handles[0];
+  }
+  return s;
+}
+
+Status DB::OpenAsSecondary(
+    const DBOptions& db_options, const std::string& dbname,
+    const std::string& secondary_path,
+    const std::vector<ColumnFamilyDescriptor>& column_families,
+    std::vector<ColumnFamilyHandle*>* handles, DB** dbptr) {
+  *dbptr = nullptr;
+  handles->clear();
+
+  // The info log of the primary is in dbname
+  DBOptions tmp_options(db_options);
+  if (tmp_options.info_log == nullptr) {
+    Status s = tmp_options.env->CreateDirIfMissing(secondary_path);
+    if (s.ok()) {
+      s = CreateLoggerFromOptions(secondary_path, "", tmp_options.env,
+                                  tmp_options, &tmp_options.info_log);
+    }
+    if (!s.ok()) {
+      tmp_options.info_log = nullptr;
+    }
+  }
+
+  DBImplSecondary* impl = new DBImplSecondary(tmp_options, dbname);
+  impl->mutex_.Lock();
+  Status s = impl->Recover(column_families, true /* read only */,
+                           false /* error_if_log_file_exist */);
+  if (s.ok()) {
+    // set column family handles
+    for (auto cf : column_families) {
+      auto cfd =
+          impl->versions_->GetColumnFamilySet()->GetColumnFamily(cf.name);
+      if (cfd == nullptr) {
+        s = Status::InvalidArgument("Column family not found: ", cf.name);
+        break;
+      }
+      handles->push_back(new ColumnFamilyHandleImpl(cfd, impl, &impl->mutex_));
+    }
+  }
+  if (s.ok()) {
+    // Recover() does not tell how far each WAL file was read, so the
+    // memtables are filled again from replayed records whose end is known
+    SequenceNumber max_sequence = 0;
+    bool missing_log = false;
+    s = impl->ReplayLogs(true /* rebuild */, &max_sequence, &missing_log);
+    if (s.ok() && impl->versions_->LastSequence() < max_sequence) {
+      impl->versions_->SetLastSequence(max_sequence);
+    }
+  }
+  if (s.ok()) {
+    for (auto cfd : *impl->versions_->GetColumnFamilySet()) {
+      delete cfd->InstallSuperVersion(new SuperVersion(), &impl->mutex_);
+    }
+  }
+  impl->mutex_.Unlock();
+  if (s.ok()) {
+    *dbptr = impl;
+    for (auto* h : *handles) {
+      impl->NewThreadStatusCfInfo(
+          reinterpret_cast<ColumnFamilyHandleImpl*>(h)->cfd());
+    }
+  } else {
+    for (auto h : *handles) {
+      delete h;
+    }
+    handles->clear();
+    delete impl;
+  }
+  return s;
+}
+
+#else  // !ROCKSDB_LITE
+
+Status DB::OpenAsSecondary(const Options& options, const std::string& dbname,
+                           const std::string& secondary_path, DB** dbptr) {
+  return Status::NotSupported("Not supported in ROCKSDB_LITE.");
+}
+
+Status DB::OpenAsSecondary(
+    const DBOptions& db_options, const std::string& dbname,
+    const std::string& secondary_path,
+    const std::vector<ColumnFamilyDescriptor>& column_families,
+    std::vector<ColumnFamilyHandle*>* handles, DB** dbptr) {
+  return Status::NotSupported("Not supported in ROCKSDB_LITE.");
+}
+#endif  // !ROCKSDB_LITE
+
+}   // namespace rocksdb
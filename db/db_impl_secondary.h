@@ -0,0 +1,69 @@
+//  Copyright (c) 2013, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#pragma once
+
+#ifndef ROCKSDB_LITE
+
+#include "db/db_impl_readonly.h"
+#include <map>
+#include <vector>
+#include <string>
+
+namespace rocksdb {
+
+// A read only instance that follows a primary instance writing to the same
+// database from another process. TryCatchUpWithPrimary() applies the new
+// MANIFEST records to the versions and replays the new WAL records into the
+// memtables of the secondary.
+class DBImplSecondary : public DBImplReadOnly {
+ public:
+  DBImplSecondary(const DBOptions& options, const std::string& dbname);
+  virtual ~DBImplSecondary();
+
+  // The versions and memtables change after open, so reads go through
+  // DBImpl, which references the SuperVersion they use
+  using DB::Get;
+  virtual Status Get(const ReadOptions& options,
+                     ColumnFamilyHandle* column_family, const Slice& key,
+                     std::string* value) override;
+  virtual Status Get(const ReadOptions& options,
+                     ColumnFamilyHandle* column_family, const Slice& key,
+                     PinnableSlice* value) override;
+
+  using DBImpl::NewIterator;
+  virtual Iterator* NewIterator(const ReadOptions&,
+                                ColumnFamilyHandle* column_family) override;
+
+  virtual Status NewIterators(
+      const ReadOptions& options,
+      const std::vector<ColumnFamilyHandle*>& column_families,
+      std::vector<Iterator*>* iterators) override;
+
+  virtual Status TryCatchUpWithPrimary() override;
+
+ private:
+  friend class DB;
+
+  // Replay the WAL files still needed by the column families into their
+  // memtables. If rebuild is true, the memtables are replaced and all WAL
+  // files are read from the start, otherwise only the records after the
+  // ones read by the previous call. *max_sequence is raised to the last
+  // sequence number replayed, and *missing_log is set if a WAL file was
+  // deleted before it could be read.
+  // REQUIRES: mutex_ is held and this thread is in the write thread
+  Status ReplayLogs(bool rebuild, SequenceNumber* max_sequence,
+                    bool* missing_log);
+
+  // Offset just past the last record replayed from each WAL file
+  std::map<uint64_t, uint64_t> log_read_offsets_;
+
+  // No copying allowed
+  DBImplSecondary(const DBImplSecondary&);
+  void operator=(const DBImplSecondary&);
+};
+}
+
+#endif  // !ROCKSDB_LITE
@@ -61,7 +61,10 @@ class DBIter: public Iterator {
   DBIter(Env* env, const ImmutableCFOptions& ioptions,
          const Comparator* cmp, Iterator* iter, SequenceNumber s,
          bool arena_mode, uint64_t max_sequential_skip_in_iterations,
-         const Slice* iterate_upper_bound = nullptr)
+         const Slice* iterate_upper_bound = nullptr,
+         const Slice* iterate_lower_bound = nullptr,
+         bool total_order_seek = false,
+         const BlobFetcher& blob_fetcher = BlobFetcher(nullptr, ReadOptions()))
       : arena_mode_(arena_mode),
         env_(env),
         logger_(ioptions.info_log),
@@ -73,9 +76,13 @@ class DBIter: public Iterator {
         valid_(false),
         current_entry_is_merged_(false),
         statistics_(ioptions.statistics),
-        iterate_upper_bound_(iterate_upper_bound) {
+        iterate_upper_bound_(iterate_upper_bound),
+        iterate_lower_bound_(iterate_lower_bound),
+        blob_fetcher_(blob_fetcher) {
     RecordTick(statistics_, NO_ITERATORS);
-    prefix_extractor_ = ioptions.prefix_extractor;
+    // The internal iterator does not do prefix seeks in total order mode
+    prefix_extractor_ =
+        total_order_seek ? nullptr : ioptions.prefix_extractor;
     max_skip_ = max_sequential_skip_in_iterations;
   }
   virtual ~DBIter() {
@@ -95,6 +102,10 @@ class DBIter: public Iterator {
     assert(valid_);
     return saved_key_.GetKey();
   }
+  virtual bool IsKeyPinned() const override {
+    assert(valid_);
+    return saved_key_.IsKeyPinned();
+  }
   virtual Slice value() const override {
     assert(valid_);
     return (direction_ == kForward && !current_entry_is_merged_) ?
@@ -124,6 +135,7 @@ class DBIter: public Iterator {
   inline void FindNextUserEntry(bool skipping);
   void FindNextUserEntryInternal(bool skipping);
   bool ParseKey(ParsedInternalKey* key);
+  bool FetchBlob(const Slice& blob_index, std::string* value);
   void MergeValuesNewToOld();
 
   inline void ClearSavedValue() {
@@ -153,6 +165,8 @@ class DBIter: public Iterator {
   Statistics* statistics_;
   uint64_t max_skip_;
   const Slice* iterate_upper_bound_;
+  const Slice* iterate_lower_bound_;
+  const BlobFetcher blob_fetcher_;
 
   // No copying allowed
   DBIter(const DBIter&);
@@ -171,6 +185,17 @@ inline bool DBIter::ParseKey(ParsedInternalKey* ikey) {
   }
 }
 
+// Read the value of the current user key from a blob file
+inline bool DBIter::FetchBlob(const Slice& blob_index, std::string* value) {
+  Status s = blob_fetcher_.FetchBlob(saved_key_.GetKey(), blob_index, value);
+  if (!s.ok()) {
+    status_ = s;
+    valid_ = false;
+    return false;
+  }
+  return true;
+}
+
 void DBIter::Next() {
   assert(valid_);
 
@@ -215,7 +240,8 @@ void DBIter::FindNextUserEntryInternal(bool skipping) {
 
     if (ParseKey(&ikey)) {
       if (iterate_upper_bound_ != nullptr &&
-          ikey.user_key.compare(*iterate_upper_bound_) >= 0) {
+          user_comparator_->Compare(ikey.user_key,
+                                    *iterate_upper_bound_) >= 0) {
         break;
       }
 
@@ -229,18 +255,24 @@ void DBIter::FindNextUserEntryInternal(bool skipping) {
             case kTypeDeletion:
               // Arrange to skip all upcoming entries for this key since
               // they are hidden by this deletion.
-              saved_key_.SetKey(ikey.user_key);
+              saved_key_.SetKey(ikey.user_key, !iter_->IsKeyPinned());
               skipping = true;
               num_skipped = 0;
               PERF_COUNTER_ADD(internal_delete_skipped_count, 1);
               break;
             case kTypeValue:
               valid_ = true;
-              saved_key_.SetKey(ikey.user_key);
+              saved_key_.SetKey(ikey.user_key, !iter_->IsKeyPinned());
+              return;
+            case kTypeBlobIndex:
+              // The value is returned from saved_value_ like a merge result
+              saved_key_.SetKey(ikey.user_key, !iter_->IsKeyPinned());
+              current_entry_is_merged_ = true;
+              valid_ = FetchBlob(iter_->value(), &saved_value_);
               return;
             case kTypeMerge:
               // By now, we are sure the current ikey is going to yield a value
-              saved_key_.SetKey(ikey.user_key);
+              saved_key_.SetKey(ikey.user_key, !iter_->IsKeyPinned());
               current_entry_is_merged_ = true;
               valid_ = true;
               MergeValuesNewToOld();  // Go to a different state machine
@@ -308,11 +340,18 @@ void DBIter::MergeValuesNewToOld() {
       break;
     }
 
-    if (kTypeValue == ikey.type) {
+    if (kTypeValue == ikey.type || kTypeBlobIndex == ikey.type) {
       // hit a put, merge the put value with operands and store the
       // final result in saved_value_. We are done!
       // ignore corruption if there is any.
-      const Slice val = iter_->value();
+      Slice val = iter_->value();
+      std::string blob_value;
+      if (kTypeBlobIndex == ikey.type) {
+        if (!FetchBlob(val, &blob_value)) {
+          return;
+        }
+        val = blob_value;
+      }
       user_merge_operator_->FullMerge(ikey.user_key, &val, operands,
                                       &saved_value_, logger_);
       // iter_ is positioned after put
@@ -354,7 +393,14 @@ void DBIter::PrevInternal() {
   ParsedInternalKey ikey;
 
   while (iter_->Valid()) {
-    saved_key_.SetKey(ExtractUserKey(iter_->key()));
+    saved_key_.SetKey(ExtractUserKey(iter_->key()),
+                      !iter_->IsKeyPinned());
+    if (iterate_lower_bound_ != nullptr &&
+        user_comparator_->Compare(saved_key_.GetKey(),
+                                  *iterate_lower_bound_) < 0) {
+      valid_ = false;
+      return;
+    }
     if (FindValueForCurrentKey()) {
       valid_ = true;
       if (!iter_->Valid()) {
@@ -366,7 +412,7 @@ void DBIter::PrevInternal() {
       }
       return;
     }
-    if (!iter_->Valid()) {
+    if (!iter_->Valid() || !status_.ok()) {
       break;
     }
     FindParseableKey(&ikey, kReverse);
@@ -376,7 +422,7 @@ void DBIter::PrevInternal() {
     }
   }
   // We haven't found any key - iterator is not valid
-  assert(!iter_->Valid());
+  assert(!iter_->Valid() || !status_.ok());
   valid_ = false;
 }
 
@@ -404,9 +450,10 @@ bool DBIter::FindValueForCurrentKey() {
     last_key_entry_type = ikey.type;
     switch (last_key_entry_type) {
       case kTypeValue:
+      case kTypeBlobIndex:
         operands.clear();
         saved_value_ = iter_->value().ToString();
-        last_not_merge_type = kTypeValue;
+        last_not_merge_type = last_key_entry_type;
         break;
       case kTypeDeletion:
         operands.clear();
@@ -437,8 +484,15 @@ bool DBIter::FindValueForCurrentKey() {
         user_merge_operator_->FullMerge(saved_key_.GetKey(), nullptr, operands,
                                         &saved_value_, logger_);
       } else {
-        assert(last_not_merge_type == kTypeValue);
-        std::string last_put_value = saved_value_;
+        std::string last_put_value;
+        if (last_not_merge_type == kTypeBlobIndex) {
+          if (!FetchBlob(saved_value_, &last_put_value)) {
+            return false;
+          }
+        } else {
+          assert(last_not_merge_type == kTypeValue);
+          last_put_value = saved_value_;
+        }
         Slice temp_slice(last_put_value);
         user_merge_operator_->FullMerge(saved_key_.GetKey(), &temp_slice,
                                         operands, &saved_value_, logger_);
@@ -447,6 +501,14 @@ bool DBIter::FindValueForCurrentKey() {
     case kTypeValue:
       // do nothing - we've already has value in saved_value_
       break;
+    case kTypeBlobIndex: {
+      std::string blob_index;
+      blob_index.swap(saved_value_);
+      if (!FetchBlob(blob_index, &saved_value_)) {
+        return false;
+      }
+      break;
+    }
     default:
       assert(false);
       break;
@@ -477,6 +539,10 @@ bool DBIter::FindValueForCurrentKeyUsingSeek() {
     valid_ = false;
     return false;
   }
+  if (ikey.type == kTypeBlobIndex) {
+    valid_ = FetchBlob(iter_->value(), &saved_value_);
+    return valid_;
+  }
 
   // kTypeMerge. We need to collect all kTypeMerge values and save them
   // in operands
@@ -505,7 +571,14 @@ bool DBIter::FindValueForCurrentKeyUsingSeek() {
     return true;
   }
 
-  const Slice& val = iter_->value();
+  Slice val = iter_->value();
+  std::string blob_value;
+  if (ikey.type == kTypeBlobIndex) {
+    if (!FetchBlob(val, &blob_value)) {
+      return false;
+    }
+    val = blob_value;
+  }
   user_merge_operator_->FullMerge(saved_key_.GetKey(), &val, operands,
                                   &saved_value_, logger_);
   valid_ = true;
@@ -584,7 +657,12 @@ void DBIter::Seek(const Slice& target) {
 
   saved_key_.Clear();
   // now savved_key is used to store internal key.
-  saved_key_.SetInternalKey(target, sequence_);
+  if (iterate_lower_bound_ != nullptr &&
+      user_comparator_->Compare(target, *iterate_lower_bound_) < 0) {
+    saved_key_.SetInternalKey(*iterate_lower_bound_, sequence_);
+  } else {
+    saved_key_.SetInternalKey(target, sequence_);
+  }
 
   {
     PERF_TIMER_GUARD(seek_internal_seek_time);
@@ -611,7 +689,20 @@ void DBIter::SeekToFirst() {
 
   {
     PERF_TIMER_GUARD(seek_internal_seek_time);
-    iter_->SeekToFirst();
+    if (iterate_lower_bound_ != nullptr && prefix_extractor_ == nullptr) {
+      saved_key_.Clear();
+      saved_key_.SetInternalKey(*iterate_lower_bound_, sequence_);
+      iter_->Seek(saved_key_.GetKey());
+    } else {
+      iter_->SeekToFirst();
+    }
+    // A prefix seek does not give a total order, so with a prefix extractor
+    // the entries before the bound are skipped one by one
+    while (iterate_lower_bound_ != nullptr && iter_->Valid() &&
+           user_comparator_->Compare(ExtractUserKey(iter_->key()),
+                                     *iterate_lower_bound_) < 0) {
+      iter_->Next();
+    }
   }
 
   if (iter_->Valid()) {
@@ -632,7 +723,26 @@ void DBIter::SeekToLast() {
 
   {
     PERF_TIMER_GUARD(seek_internal_seek_time);
-    iter_->SeekToLast();
+    if (iterate_upper_bound_ != nullptr && prefix_extractor_ == nullptr) {
+      // Position before all entries of the bound key
+      saved_key_.Clear();
+      saved_key_.SetInternalKey(*iterate_upper_bound_, kMaxSequenceNumber);
+      iter_->Seek(saved_key_.GetKey());
+      if (iter_->Valid()) {
+        iter_->Prev();
+      } else {
+        iter_->SeekToLast();
+      }
+    } else {
+      iter_->SeekToLast();
+    }
+    // A prefix seek does not give a total order, so with a prefix extractor
+    // the entries past the bound are skipped one by one
+    while (iterate_upper_bound_ != nullptr && iter_->Valid() &&
+           user_comparator_->Compare(ExtractUserKey(iter_->key()),
+                                     *iterate_upper_bound_) >= 0) {
+      iter_->Prev();
+    }
   }
 
   PrevInternal();
@@ -643,10 +753,14 @@ Iterator* NewDBIterator(Env* env, const ImmutableCFOptions& ioptions,
                         Iterator* internal_iter,
                         const SequenceNumber& sequence,
                         uint64_t max_sequential_skip_in_iterations,
-                        const Slice* iterate_upper_bound) {
+                        const Slice* iterate_upper_bound,
+                        const Slice* iterate_lower_bound,
+                        bool total_order_seek,
+                        const BlobFetcher& blob_fetcher) {
   return new DBIter(env, ioptions, user_key_comparator, internal_iter, sequence,
                     false, max_sequential_skip_in_iterations,
-                    iterate_upper_bound);
+                    iterate_upper_bound, iterate_lower_bound,
+                    total_order_seek, blob_fetcher);
 }
 
 ArenaWrappedDBIter::~ArenaWrappedDBIter() { db_iter_->~DBIter(); }
@@ -666,6 +780,9 @@ inline void ArenaWrappedDBIter::Seek(const Slice& target) {
 inline void ArenaWrappedDBIter::Next() { db_iter_->Next(); }
 inline void ArenaWrappedDBIter::Prev() { db_iter_->Prev(); }
 inline Slice ArenaWrappedDBIter::key() const { return db_iter_->key(); }
+inline bool ArenaWrappedDBIter::IsKeyPinned() const {
+  return db_iter_->IsKeyPinned();
+}
 inline Slice ArenaWrappedDBIter::value() const { return db_iter_->value(); }
 inline Status ArenaWrappedDBIter::status() const { return db_iter_->status(); }
 void ArenaWrappedDBIter::RegisterCleanup(CleanupFunction function, void* arg1,
@@ -678,13 +795,15 @@ ArenaWrappedDBIter* NewArenaWrappedDbIterator(
     const Comparator* user_key_comparator,
     const SequenceNumber& sequence,
     uint64_t max_sequential_skip_in_iterations,
-    const Slice* iterate_upper_bound) {
+    const Slice* iterate_upper_bound, const Slice* iterate_lower_bound,
+    bool total_order_seek, const BlobFetcher& blob_fetcher) {
   ArenaWrappedDBIter* iter = new ArenaWrappedDBIter();
   Arena* arena = iter->GetArena();
   auto mem = arena->AllocateAligned(sizeof(DBIter));
   DBIter* db_iter = new (mem) DBIter(env, ioptions, user_key_comparator,
       nullptr, sequence, true, max_sequential_skip_in_iterations,
-      iterate_upper_bound);
+      iterate_upper_bound, iterate_lower_bound, total_order_seek,
+      blob_fetcher);
 
   iter->SetDBIter(db_iter);
 
@@ -10,6 +10,7 @@
 #pragma once
 #include <stdint.h>
 #include "rocksdb/db.h"
+#include "db/blob_file.h"
 #include "db/dbformat.h"
 #include "util/arena.h"
 #include "util/autovector.h"
@@ -21,7 +22,8 @@ class DBIter;
 
 // Return a new iterator that converts internal keys (yielded by
 // "*internal_iter") that were live at the specified "sequence" number
-// into appropriate user keys.
+// into appropriate user keys. The values of the entries that refer to blob
+// files are read with "blob_fetcher".
 extern Iterator* NewDBIterator(
     Env* env,
     const ImmutableCFOptions& options,
@@ -29,7 +31,10 @@ extern Iterator* NewDBIterator(
     Iterator* internal_iter,
     const SequenceNumber& sequence,
     uint64_t max_sequential_skip_in_iterations,
-    const Slice* iterate_upper_bound = nullptr);
+    const Slice* iterate_upper_bound = nullptr,
+    const Slice* iterate_lower_bound = nullptr,
+    bool total_order_seek = false,
+    const BlobFetcher& blob_fetcher = BlobFetcher(nullptr, ReadOptions()));
 
 // A wrapper iterator which wraps DB Iterator and the arena, with which the DB
 // iterator is supposed be allocated. This class is used as an entry point of
@@ -58,6 +63,7 @@ class ArenaWrappedDBIter : public Iterator {
   virtual void Next() override;
   virtual void Prev() override;
   virtual Slice key() const override;
+  virtual bool IsKeyPinned() const override;
   virtual Slice value() const override;
   virtual Status status() const override;
   void RegisterCleanup(CleanupFunction function, void* arg1, void* arg2);
@@ -72,6 +78,9 @@ extern ArenaWrappedDBIter* NewArenaWrappedDbIterator(
     Env* env, const ImmutableCFOptions& options,
     const Comparator* user_key_comparator,
     const SequenceNumber& sequence, uint64_t max_sequential_skip_in_iterations,
-    const Slice* iterate_upper_bound = nullptr);
+    const Slice* iterate_upper_bound = nullptr,
+    const Slice* iterate_lower_bound = nullptr,
+    bool total_order_seek = false,
+    const BlobFetcher& blob_fetcher = BlobFetcher(nullptr, ReadOptions()));
 
 }  // namespace rocksdb
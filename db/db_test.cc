@@ -165,6 +165,9 @@ class SpecialEnv : public EnvWrapper {
   bool count_random_reads_;
   anon::AtomicCounter random_read_counter_;
 
+  // Slow down every counted random read, in micro-seconds.
+  std::atomic<int> random_read_slowdown_;
+
   bool count_sequential_reads_;
   anon::AtomicCounter sequential_read_counter_;
 
@@ -195,6 +198,7 @@ class SpecialEnv : public EnvWrapper {
     manifest_write_error_.store(false, std::memory_order_release);
     log_write_error_.store(false, std::memory_order_release);
     log_write_slowdown_ = 0;
+    random_read_slowdown_ = 0;
     bytes_written_ = 0;
     sync_counter_ = 0;
     non_writeable_rate_ = 0;
@@ -332,22 +336,26 @@ class SpecialEnv : public EnvWrapper {
     class CountingFile : public RandomAccessFile {
      private:
       unique_ptr<RandomAccessFile> target_;
-      anon::AtomicCounter* counter_;
+      SpecialEnv* env_;
      public:
-      CountingFile(unique_ptr<RandomAccessFile>&& target,
-                   anon::AtomicCounter* counter)
-          : target_(std::move(target)), counter_(counter) {
+      CountingFile(unique_ptr<RandomAccessFile>&& target, SpecialEnv* env)
+          : target_(std::move(target)), env_(env) {
       }
       virtual Status Read(uint64_t offset, size_t n, Slice* result,
                           char* scratch) const override {
-        counter_->Increment();
+        env_->random_read_counter_.Increment();
+        int slowdown =
+            env_->random_read_slowdown_.load(std::memory_order_acquire);
+        if (slowdown > 0) {
+          env_->SleepForMicroseconds(slowdown);
+        }
         return target_->Read(offset, n, result, scratch);
       }
     };
 
     Status s = target()->NewRandomAccessFile(f, r, soptions);
     if (s.ok() && count_random_reads_) {
-      r->reset(new CountingFile(std::move(*r), &random_read_counter_));
+      r->reset(new CountingFile(std::move(*r), this));
     }
     return s;
   }
@@ -1494,6 +1502,57 @@ TEST(DBTest, CompactedDB) {
   ASSERT_TRUE(status_list[5].IsNotFound());
 }
 
+TEST(DBTest, CompactedDBFileLookup) {
+  Options options;
+  options.disable_auto_compactions = true;
+  options.write_buffer_size = 100 << 10;
+  options.target_file_size_base = 20 << 10;
+  options.max_bytes_for_level_base = 1 << 30;
+  options.compression = kNoCompression;
+  options = CurrentOptions(options);
+  Reopen(options);
+  // All keys share the "key" prefix
+  const int kNumKeys = 4000;
+  Random rnd(301);
+  for (int i = 0; i < kNumKeys; i += 2) {
+    ASSERT_OK(Put(Key(i), RandomString(&rnd, 100)));
+  }
+  db_->CompactRange(nullptr, nullptr);
+  ASSERT_GT(NumTableFilesAtLevel(1), 5);
+  std::vector<std::string> expected;
+  for (int i = 0; i < kNumKeys; i++) {
+    expected.push_back(Get(Key(i)));
+  }
+  Close();
+
+  options.max_open_files = -1;
+  ASSERT_OK(ReadOnlyReopen(options));
+  ASSERT_EQ(Put("new", "value").ToString(),
+            "Not implemented: Not supported in compacted db mode.");
+  std::vector<std::string> keys;
+  for (int i = 0; i < kNumKeys; i++) {
+    keys.push_back(Key(i));
+    ASSERT_EQ(expected[i], Get(Key(i)));
+  }
+  // Keys without the shared prefix or outside the key range
+  for (std::string key : {"", "a", "key", "key0", "key1", "kez", "z"}) {
+    ASSERT_EQ("NOT_FOUND", Get(key));
+  }
+
+  std::vector<Slice> key_slices(keys.begin(), keys.end());
+  std::vector<std::string> values;
+  std::vector<Status> status_list =
+      dbfull()->MultiGet(ReadOptions(), key_slices, &values);
+  for (int i = 0; i < kNumKeys; i++) {
+    if (i % 2 == 0) {
+      ASSERT_OK(status_list[i]);
+      ASSERT_EQ(expected[i], values[i]);
+    } else {
+      ASSERT_TRUE(status_list[i].IsNotFound());
+    }
+  }
+}
+
 // Make sure that when options.block_cache is set, after a new table is
 // created its index/filter blocks are added to block cache.
 TEST(DBTest, IndexAndFilterBlocksOfNewTableAddedToCache) {
@@ -1650,6 +1709,73 @@ TEST(DBTest, GetFromVersions) {
   } while (ChangeOptions());
 }
 
+TEST(DBTest, GetPinnableSlice) {
+  Options options = CurrentOptions();
+  options.merge_operator = MergeOperators::CreateStringAppendOperator();
+  BlockBasedTableOptions table_options;
+  table_options.block_cache = NewLRUCache(8 << 20);
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  CreateAndReopenWithCF({"pikachu"}, options);
+
+  std::string big_value(32 << 10, 'x');
+  ASSERT_OK(Put(1, "big", big_value));
+  ASSERT_OK(Put(1, "merged", "a"));
+  ASSERT_OK(Flush(1));
+  ASSERT_OK(db_->Merge(WriteOptions(), handles_[1], "merged", "b"));
+  ASSERT_OK(Put(1, "deleted", "v"));
+  ASSERT_OK(Delete(1, "deleted"));
+  ASSERT_OK(Flush(1));
+  ASSERT_OK(Put(1, "mem", "v1"));
+
+  // Values in table files refer to the pinned data block
+  PinnableSlice value;
+  ASSERT_OK(db_->Get(ReadOptions(), handles_[1], "big", &value));
+  ASSERT_TRUE(value.IsPinned());
+  ASSERT_EQ(big_value, value.ToString());
+
+  // Merge results and memtable values are copied
+  PinnableSlice merged;
+  ASSERT_OK(db_->Get(ReadOptions(), handles_[1], "merged", &merged));
+  ASSERT_TRUE(!merged.IsPinned());
+  ASSERT_EQ("a,b", merged.ToString());
+  ASSERT_OK(db_->Get(ReadOptions(), handles_[1], "mem", &merged));
+  ASSERT_TRUE(!merged.IsPinned());
+  ASSERT_EQ("v1", merged.ToString());
+  ASSERT_TRUE(db_->Get(ReadOptions(), handles_[1], "deleted", &merged)
+                  .IsNotFound());
+  ASSERT_TRUE(db_->Get(ReadOptions(), handles_[1], "none", &merged)
+                  .IsNotFound());
+
+  std::vector<Slice> keys({"big", "merged", "mem", "deleted"});
+  std::vector<ColumnFamilyHandle*> cfs(keys.size(), handles_[1]);
+  std::unique_ptr<PinnableSlice[]> values(new PinnableSlice[keys.size()]);
+  std::vector<Status> statuses =
+      db_->MultiGet(ReadOptions(), cfs, keys, values.get());
+  ASSERT_OK(statuses[0]);
+  ASSERT_TRUE(values[0].IsPinned());
+  ASSERT_EQ(big_value, values[0].ToString());
+  ASSERT_OK(statuses[1]);
+  ASSERT_EQ("a,b", values[1].ToString());
+  ASSERT_OK(statuses[2]);
+  ASSERT_EQ("v1", values[2].ToString());
+  ASSERT_TRUE(statuses[3].IsNotFound());
+
+  // The std::string versions return the same values
+  ASSERT_EQ(big_value, Get(1, "big"));
+  ASSERT_EQ("a,b", Get(1, "merged"));
+
+  // The block outlives the file it was read from
+  const char* data = value.data();
+  ASSERT_OK(Put(1, "big", "small"));
+  ASSERT_OK(Flush(1));
+  dbfull()->TEST_CompactRange(0, nullptr, nullptr, handles_[1]);
+  ASSERT_EQ("small", Get(1, "big"));
+  ASSERT_EQ(data, value.data());
+  ASSERT_EQ(big_value, value.ToString());
+  value.Reset();
+  ASSERT_TRUE(value.empty());
+}
+
 TEST(DBTest, GetSnapshot) {
   anon::OptionsOverride options_override;
   options_override.skip_policy = kSkipNoSnapshot;
@@ -2304,6 +2430,61 @@ TEST(DBTest, IterLongKeys) {
   delete iter;
 }
 
+TEST(DBTest, IterPinnedData) {
+  Options options = CurrentOptions();
+  options.compression = kNoCompression;
+  BlockBasedTableOptions table_options;
+  table_options.block_size = 256;
+  table_options.use_delta_encoding = false;
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  DestroyAndReopen(options);
+
+  // Keys spread over two levels, an L0 file and the memtable
+  Random rnd(301);
+  std::map<std::string, std::string> expected;
+  for (int i = 0; i < 400; i++) {
+    std::string k = RandomString(&rnd, 10 + rnd.Uniform(20));
+    std::string v = RandomString(&rnd, 20);
+    expected[k] = v;
+    ASSERT_OK(Put(k, v));
+    if (i == 150) {
+      ASSERT_OK(Flush());
+      dbfull()->TEST_CompactRange(0, nullptr, nullptr);
+    } else if (i == 300) {
+      ASSERT_OK(Flush());
+    }
+  }
+  ASSERT_GT(NumTableFilesAtLevel(0), 0);
+
+  ReadOptions ro;
+  ro.pin_data = true;
+  for (bool forward : {true, false}) {
+    std::unique_ptr<Iterator> iter(db_->NewIterator(ro));
+    std::vector<Slice> keys;
+    if (forward) {
+      for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+        ASSERT_TRUE(iter->IsKeyPinned());
+        keys.push_back(iter->key());
+      }
+    } else {
+      for (iter->SeekToLast(); iter->Valid(); iter->Prev()) {
+        ASSERT_TRUE(iter->IsKeyPinned());
+        keys.push_back(iter->key());
+      }
+      std::reverse(keys.begin(), keys.end());
+    }
+    ASSERT_OK(iter->status());
+
+    // All slices are still valid after the iterator moved past them
+    ASSERT_EQ(expected.size(), keys.size());
+    auto it = expected.begin();
+    for (const Slice& k : keys) {
+      ASSERT_EQ(it->first, k.ToString());
+      ++it;
+    }
+  }
+}
+
 
 TEST(DBTest, IterNextWithNewerSeq) {
   ASSERT_OK(Put("0", "0"));
@@ -6486,6 +6667,127 @@ TEST(DBTest, ManualCompaction) {
 
 }
 
+TEST(DBTest, CompactionReadahead) {
+  // Values both smaller and larger than the readahead buffer
+  for (size_t readahead_size : {4096, 1 << 20}) {
+    Options options = CurrentOptions();
+    options.disable_auto_compactions = true;
+    options.compaction_readahead_size = readahead_size;
+    options.statistics = rocksdb::CreateDBStatistics();
+    DestroyAndReopen(options);
+
+    Random rnd(301);
+    std::vector<std::string> values;
+    const int kNumFiles = 3;
+    const int kKeysPerFile = 100;
+    for (int f = 0; f < kNumFiles; f++) {
+      for (int i = 0; i < kKeysPerFile; i++) {
+        values.push_back(RandomString(&rnd, 100 + rnd.Uniform(10000)));
+        ASSERT_OK(Put(Key(f * kKeysPerFile + i), values.back()));
+      }
+      ASSERT_OK(Flush());
+    }
+    ASSERT_EQ(kNumFiles, NumTableFilesAtLevel(0));
+
+    // Every input file is opened again by the compaction
+    long file_opens = TestGetTickerCount(options, NO_FILE_OPENS);
+    db_->CompactRange(nullptr, nullptr);
+    ASSERT_EQ(0, NumTableFilesAtLevel(0));
+    ASSERT_GE(TestGetTickerCount(options, NO_FILE_OPENS) - file_opens,
+              kNumFiles);
+
+    for (size_t i = 0; i < values.size(); i++) {
+      ASSERT_EQ(values[i], Get(Key(static_cast<int>(i))));
+    }
+  }
+}
+
+TEST(DBTest, CompactionReadaheadWithMmapReads) {
+  // mmaped files are read without the readahead buffer, whose reads would go
+  // past the end of the file
+  for (bool plain_table : {false, true}) {
+    Options options = CurrentOptions();
+    options.disable_auto_compactions = true;
+    options.allow_mmap_reads = true;
+    options.compaction_readahead_size = 1 << 20;
+    if (plain_table) {
+      options.table_factory.reset(new PlainTableFactory());
+      options.prefix_extractor.reset(NewFixedPrefixTransform(1));
+    }
+    DestroyAndReopen(options);
+
+    Random rnd(301);
+    std::vector<std::string> values;
+    for (int f = 0; f < 3; f++) {
+      for (int i = 0; i < 100; i++) {
+        values.push_back(RandomString(&rnd, 100 + rnd.Uniform(1000)));
+        ASSERT_OK(Put(Key(f * 100 + i), values.back()));
+      }
+      ASSERT_OK(Flush());
+    }
+    ASSERT_EQ(3, NumTableFilesAtLevel(0));
+
+    ASSERT_OK(db_->CompactRange(nullptr, nullptr));
+    ASSERT_EQ(0, NumTableFilesAtLevel(0));
+    for (size_t i = 0; i < values.size(); i++) {
+      ASSERT_EQ(values[i], Get(Key(static_cast<int>(i))));
+    }
+  }
+}
+
+TEST(DBTest, DirectIO) {
+  {
+    EnvOptions soptions;
+    soptions.use_direct_writes = true;
+    unique_ptr<WritableFile> file;
+    Status s = env_->NewWritableFile(dbname_ + "/direct_io_probe", &file,
+                                     soptions);
+    if (!s.ok()) {
+      fprintf(stderr, "Skipped, O_DIRECT is not supported here: %s\n",
+              s.ToString().c_str());
+      return;
+    }
+    file.reset();
+    env_->DeleteFile(dbname_ + "/direct_io_probe");
+  }
+
+  for (int i = 0; i < 3; i++) {
+    Options options = CurrentOptions();
+    options.disable_auto_compactions = true;
+    options.use_direct_reads = (i != 1);
+    options.use_direct_io_for_flush_and_compaction = (i != 0);
+    options.compaction_readahead_size = (i == 2) ? (1 << 20) : 0;
+    DestroyAndReopen(options);
+
+    Random rnd(301);
+    std::vector<std::string> values;
+    for (int f = 0; f < 3; f++) {
+      for (int k = 0; k < 100; k++) {
+        values.push_back(RandomString(&rnd, 100 + rnd.Uniform(10000)));
+        ASSERT_OK(Put(Key(f * 100 + k), values.back()));
+      }
+      ASSERT_OK(Flush());
+    }
+    ASSERT_EQ(3, NumTableFilesAtLevel(0));
+    db_->CompactRange(nullptr, nullptr);
+    ASSERT_EQ(0, NumTableFilesAtLevel(0));
+
+    Reopen(options);
+    for (size_t k = 0; k < values.size(); k++) {
+      ASSERT_EQ(values[k], Get(Key(static_cast<int>(k))));
+    }
+    Iterator* iter = db_->NewIterator(ReadOptions());
+    size_t count = 0;
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+      ASSERT_EQ(values[count], iter->value().ToString());
+      count++;
+    }
+    ASSERT_OK(iter->status());
+    ASSERT_EQ(values.size(), count);
+    delete iter;
+  }
+}
+
 TEST(DBTest, ManualCompactionOutputPathId) {
   Options options = CurrentOptions();
   options.create_if_missing = true;
@@ -9854,6 +10156,524 @@ TEST(DBTest, DBIteratorBoundTest) {
   }
 }
 
+TEST(DBTest, DBIteratorBoundPruning) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  options.compression = kNoCompression;
+  BlockBasedTableOptions table_options;
+  table_options.block_size = 256;
+  table_options.no_block_cache = true;
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+
+  std::string lower_key = Key(150);
+  std::string upper_key = Key(200);
+  Slice lower(lower_key);
+  Slice upper(upper_key);
+  ReadOptions bounded;
+  bounded.iterate_lower_bound = &lower;
+  bounded.iterate_upper_bound = &upper;
+
+  for (int level = 0; level < 2; level++) {
+    // Five files with disjoint key ranges in one level
+    DestroyAndReopen(options);
+    for (int f = 0; f < 5; f++) {
+      for (int i = 0; i < 100; i++) {
+        ASSERT_OK(Put(Key(f * 100 + i), std::string(50, 'v')));
+      }
+      ASSERT_OK(Flush());
+      if (level == 1) {
+        ASSERT_OK(dbfull()->TEST_CompactRange(0, nullptr, nullptr));
+      }
+    }
+    ASSERT_EQ(5, NumTableFilesAtLevel(level));
+
+    // Without bounds, the reads go into the files that follow
+    perf_context.Reset();
+    std::unique_ptr<Iterator> iter(db_->NewIterator(ReadOptions()));
+    int count = 0;
+    for (iter->Seek(lower); iter->Valid() && iter->key().compare(upper) < 0;
+         iter->Next()) {
+      count++;
+    }
+    ASSERT_EQ(50, count);
+    uint64_t unbounded_reads = perf_context.block_read_count;
+
+    perf_context.Reset();
+    iter.reset(db_->NewIterator(bounded));
+    count = 0;
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+      ASSERT_EQ(Key(150 + count), iter->key().ToString());
+      count++;
+    }
+    ASSERT_OK(iter->status());
+    ASSERT_EQ(50, count);
+    ASSERT_LT(perf_context.block_read_count, unbounded_reads);
+
+    count = 0;
+    for (iter->SeekToLast(); iter->Valid(); iter->Prev()) {
+      ASSERT_EQ(Key(199 - count), iter->key().ToString());
+      count++;
+    }
+    ASSERT_OK(iter->status());
+    ASSERT_EQ(50, count);
+
+    // Seek targets outside the bounds
+    iter->Seek(Key(0));
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(Key(150), iter->key().ToString());
+    iter->Prev();
+    ASSERT_TRUE(!iter->Valid());
+    iter->Seek(Key(250));
+    ASSERT_TRUE(!iter->Valid());
+  }
+}
+
+TEST(DBTest, ParallelScan) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  options.compression = kNoCompression;
+  BlockBasedTableOptions table_options;
+  table_options.block_size = 256;
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  DestroyAndReopen(options);
+
+  // Four table files in L1, one in L0 and deletions in the memtable
+  for (int f = 0; f < 4; f++) {
+    for (int i = 0; i < 500; i++) {
+      ASSERT_OK(Put(Key(f * 500 + i), "old"));
+    }
+    ASSERT_OK(Flush());
+    ASSERT_OK(dbfull()->TEST_CompactRange(0, nullptr, nullptr));
+  }
+  for (int i = 0; i < 2000; i += 7) {
+    ASSERT_OK(Put(Key(i), "new"));
+  }
+  ASSERT_OK(Flush());
+  for (int i = 0; i < 2000; i += 11) {
+    ASSERT_OK(Delete(Key(i)));
+  }
+  ASSERT_EQ("1,4", FilesPerLevel());
+
+  const int kPartitions = 4;
+  std::vector<std::vector<std::string>> scanned;
+  port::Mutex mutex;
+  auto collect = [&](int partition, const Slice& key, const Slice& value) {
+    MutexLock l(&mutex);
+    scanned[partition].push_back(key.ToString() + "=" + value.ToString());
+    return true;
+  };
+  auto check = [&](int first, int last) {
+    std::vector<std::string> expected;
+    for (int i = first; i < last; i++) {
+      if (i % 11 != 0) {
+        expected.push_back(Key(i) + "=" + (i % 7 == 0 ? "new" : "old"));
+      }
+    }
+    std::vector<std::string> entries;
+    int non_empty = 0;
+    for (const auto& partition : scanned) {
+      entries.insert(entries.end(), partition.begin(), partition.end());
+      non_empty += partition.empty() ? 0 : 1;
+    }
+    ASSERT_TRUE(entries == expected);
+    ASSERT_GT(non_empty, 1);
+  };
+
+  std::string begin_key = Key(100);
+  std::string end_key = Key(1900);
+  Slice begin(begin_key);
+  Slice end(end_key);
+  scanned.assign(kPartitions, std::vector<std::string>());
+  ASSERT_OK(db_->ParallelScan(ReadOptions(), &begin, &end, kPartitions,
+                              collect));
+  check(100, 1900);
+
+  scanned.assign(kPartitions, std::vector<std::string>());
+  ASSERT_OK(db_->ParallelScan(ReadOptions(), nullptr, nullptr, kPartitions,
+                              collect));
+  check(0, 2000);
+
+  // The scan reads from the given snapshot only
+  const Snapshot* snapshot = db_->GetSnapshot();
+  ASSERT_OK(Put(Key(1), "after"));
+  ASSERT_OK(Put(Key(1999), "after"));
+  ReadOptions snapshot_read;
+  snapshot_read.snapshot = snapshot;
+  scanned.assign(kPartitions, std::vector<std::string>());
+  ASSERT_OK(db_->ParallelScan(snapshot_read, nullptr, nullptr, kPartitions,
+                              collect));
+  check(0, 2000);
+  db_->ReleaseSnapshot(snapshot);
+
+  // A callback that stops its partition after the first entry
+  scanned.assign(kPartitions, std::vector<std::string>());
+  ASSERT_OK(db_->ParallelScan(
+      ReadOptions(), nullptr, nullptr, kPartitions,
+      [&](int partition, const Slice& key, const Slice& value) {
+        MutexLock l(&mutex);
+        scanned[partition].push_back(key.ToString());
+        return false;
+      }));
+  ASSERT_EQ(Key(1), scanned[0][0]);
+  for (const auto& partition : scanned) {
+    ASSERT_LE(partition.size(), 1U);
+  }
+
+  ASSERT_TRUE(db_->ParallelScan(ReadOptions(), nullptr, nullptr, 0, collect)
+                  .IsInvalidArgument());
+}
+
+TEST(DBTest, GetMergeOperands) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  options.merge_operator = MergeOperators::CreateStringAppendOperator();
+  DestroyAndReopen(options);
+
+  // A base value and two operands in table files, two in the memtable
+  ASSERT_OK(Put("k", "v0"));
+  ASSERT_OK(Flush());
+  for (int i = 1; i <= 4; i++) {
+    ASSERT_OK(db_->Merge(WriteOptions(), "k", "a" + ToString(i)));
+    if (i <= 2) {
+      ASSERT_OK(Flush());
+    }
+  }
+  ASSERT_EQ("v0,a1,a2,a3,a4", Get("k"));
+
+  const int kMaxOperands = 10;
+  PinnableSlice operands[kMaxOperands];
+  int num_operands = 0;
+  ASSERT_OK(db_->GetMergeOperands(ReadOptions(), "k", operands, kMaxOperands,
+                                  &num_operands));
+  ASSERT_EQ(5, num_operands);
+  const char* expected[] = {"v0", "a1", "a2", "a3", "a4"};
+  for (int i = 0; i < num_operands; i++) {
+    ASSERT_EQ(expected[i], operands[i].ToString());
+    // Operands in table files are not copied
+    ASSERT_EQ(i < 3, operands[i].IsPinned());
+  }
+  // Pinned operands outlive the table files
+  ASSERT_OK(db_->CompactRange(nullptr, nullptr));
+  ASSERT_EQ("0,1", FilesPerLevel());
+  for (int i = 0; i < num_operands; i++) {
+    ASSERT_EQ(expected[i], operands[i].ToString());
+  }
+
+  // The lookup stops after max_operands operands
+  ASSERT_OK(db_->Merge(WriteOptions(), "k", "a5"));
+  ASSERT_OK(db_->Merge(WriteOptions(), "k", "a6"));
+  Status s = db_->GetMergeOperands(ReadOptions(), "k", operands, 2,
+                                   &num_operands);
+  ASSERT_TRUE(s.IsIncomplete());
+  ASSERT_EQ(2, num_operands);
+  ASSERT_EQ("a5", operands[0].ToString());
+  ASSERT_EQ("a6", operands[1].ToString());
+  // The compaction merged the older operands into the base value
+  ASSERT_OK(db_->GetMergeOperands(ReadOptions(), "k", operands, 3,
+                                  &num_operands));
+  ASSERT_EQ(3, num_operands);
+  ASSERT_EQ("v0,a1,a2,a3,a4", operands[0].ToString());
+
+  // Operands without a base value, or after a deletion
+  ASSERT_OK(db_->Merge(WriteOptions(), "m", "x"));
+  ASSERT_OK(Put("d", "old"));
+  ASSERT_OK(Delete("d"));
+  ASSERT_OK(db_->Merge(WriteOptions(), "d", "z"));
+  ASSERT_OK(Flush());
+  ASSERT_OK(db_->Merge(WriteOptions(), "m", "y"));
+  ASSERT_OK(db_->GetMergeOperands(ReadOptions(), "m", operands, kMaxOperands,
+                                  &num_operands));
+  ASSERT_EQ(2, num_operands);
+  ASSERT_EQ("x", operands[0].ToString());
+  ASSERT_EQ("y", operands[1].ToString());
+  ASSERT_OK(db_->GetMergeOperands(ReadOptions(), "d", operands, kMaxOperands,
+                                  &num_operands));
+  ASSERT_EQ(1, num_operands);
+  ASSERT_EQ("z", operands[0].ToString());
+
+  // A plain value is its only operand
+  ASSERT_OK(Put("p", "value"));
+  ASSERT_OK(db_->GetMergeOperands(ReadOptions(), "p", operands, kMaxOperands,
+                                  &num_operands));
+  ASSERT_EQ(1, num_operands);
+  ASSERT_EQ("value", operands[0].ToString());
+
+  ASSERT_TRUE(db_->GetMergeOperands(ReadOptions(), "missing", operands,
+                                    kMaxOperands, &num_operands)
+                  .IsNotFound());
+  ASSERT_EQ(0, num_operands);
+  ASSERT_TRUE(db_->GetMergeOperands(ReadOptions(), "d", operands, 0,
+                                    &num_operands).IsInvalidArgument());
+}
+
+TEST(DBTest, MergeWriteBack) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  options.merge_operator = MergeOperators::CreateStringAppendOperator();
+  options.merge_write_back_threshold = 2;
+  options.statistics = rocksdb::CreateDBStatistics();
+  DestroyAndReopen(options);
+
+  ASSERT_OK(Put("k", "v0"));
+  ASSERT_OK(Flush());
+  ASSERT_OK(db_->Merge(WriteOptions(), "k", "a1"));
+  ASSERT_OK(Flush());
+  ASSERT_OK(db_->Merge(WriteOptions(), "k", "a2"));
+  // The newest operand is at the sequence number of the read
+  ASSERT_EQ("v0,a1,a2", Get("k"));
+  ASSERT_EQ(0, TestGetTickerCount(options, NUMBER_MERGE_WRITE_BACKS));
+
+  ASSERT_OK(Put("other", "x"));
+  ASSERT_EQ("v0,a1,a2", Get("k"));
+  ASSERT_EQ(1, TestGetTickerCount(options, NUMBER_MERGE_WRITE_BACKS));
+  PinnableSlice operands[4];
+  int num_operands = 0;
+  ASSERT_OK(db_->GetMergeOperands(ReadOptions(), "k", operands, 4,
+                                  &num_operands));
+  ASSERT_EQ(1, num_operands);
+  ASSERT_EQ("v0,a1,a2", operands[0].ToString());
+  // Nothing left to merge
+  ASSERT_EQ("v0,a1,a2", Get("k"));
+  ASSERT_EQ(1, TestGetTickerCount(options, NUMBER_MERGE_WRITE_BACKS));
+
+  // Older snapshots do not see the results of later reads
+  const Snapshot* snapshot = db_->GetSnapshot();
+  ASSERT_OK(db_->Merge(WriteOptions(), "k", "a3"));
+  ASSERT_OK(Put("other", "x"));
+  ASSERT_EQ("v0,a1,a2,a3", Get("k"));
+  ASSERT_EQ(1, TestGetTickerCount(options, NUMBER_MERGE_WRITE_BACKS));
+  ASSERT_OK(db_->Merge(WriteOptions(), "k", "a4"));
+  ASSERT_OK(Put("other", "x"));
+  ASSERT_EQ("v0,a1,a2,a3,a4", Get("k"));
+  ASSERT_EQ(2, TestGetTickerCount(options, NUMBER_MERGE_WRITE_BACKS));
+  ASSERT_EQ("v0,a1,a2", Get("k", snapshot));
+  db_->ReleaseSnapshot(snapshot);
+
+  // Not written back to a memtable that is newer than the snapshot
+  ASSERT_OK(db_->Merge(WriteOptions(), "k", "a5"));
+  ASSERT_OK(db_->Merge(WriteOptions(), "k", "a6"));
+  ASSERT_OK(Put("other", "x"));
+  snapshot = db_->GetSnapshot();
+  ASSERT_OK(Flush());
+  ASSERT_OK(Put("other", "y"));
+  ASSERT_EQ("v0,a1,a2,a3,a4,a5,a6", Get("k", snapshot));
+  ASSERT_EQ(2, TestGetTickerCount(options, NUMBER_MERGE_WRITE_BACKS));
+  ASSERT_OK(Put("other", "z"));
+  ASSERT_EQ("v0,a1,a2,a3,a4,a5,a6", Get("k"));
+  ASSERT_EQ(3, TestGetTickerCount(options, NUMBER_MERGE_WRITE_BACKS));
+
+  ASSERT_OK(db_->Merge(WriteOptions(), "k", "a7"));
+  ASSERT_OK(Flush());
+  ASSERT_OK(db_->CompactRange(nullptr, nullptr));
+  ASSERT_EQ("v0,a1,a2,a3,a4,a5,a6", Get("k", snapshot));
+  ASSERT_EQ("v0,a1,a2,a3,a4,a5,a6,a7", Get("k"));
+  db_->ReleaseSnapshot(snapshot);
+  Reopen(options);
+  ASSERT_EQ("v0,a1,a2,a3,a4,a5,a6,a7", Get("k"));
+}
+
+TEST(DBTest, ReadDeadline) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  options.env = env_;
+  env_->count_random_reads_ = true;
+  DestroyAndReopen(options);
+
+  Random rnd(301);
+  for (int i = 0; i < 100; i++) {
+    ASSERT_OK(Put(Key(i), RandomString(&rnd, 100)));
+  }
+  ASSERT_OK(Flush());
+  ASSERT_OK(Put("mem", "v"));
+
+  // An expired read still finds keys in the memtable, but does not read
+  // table files
+  ReadOptions ro;
+  ro.deadline = 1;
+  std::string value;
+  ASSERT_OK(db_->Get(ro, "mem", &value));
+  ASSERT_EQ("v", value);
+  int reads = env_->random_read_counter_.Read();
+  ASSERT_TRUE(db_->Get(ro, Key(10), &value).IsTimedOut());
+  std::unique_ptr<Iterator> iter(db_->NewIterator(ro));
+  iter->Seek(Key(20));
+  ASSERT_TRUE(iter->status().IsTimedOut());
+  iter.reset();
+  ASSERT_EQ(reads, env_->random_read_counter_.Read());
+
+  ro.deadline = env_->NowMicros() + 60 * 1000000U;
+  ASSERT_OK(db_->Get(ro, Key(10), &value));
+  iter.reset(db_->NewIterator(ro));
+  int count = 0;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    count++;
+  }
+  ASSERT_OK(iter->status());
+  ASSERT_EQ(101, count);
+  iter.reset();
+
+  // Block reads slower than io_timeout fail
+  Reopen(options);
+  env_->random_read_slowdown_.store(20000);
+  ro = ReadOptions();
+  ro.io_timeout = 1000;
+  ASSERT_TRUE(db_->Get(ro, Key(50), &value).IsTimedOut());
+  ro.io_timeout = 60 * 1000000U;
+  ASSERT_OK(db_->Get(ro, Key(50), &value));
+  env_->random_read_slowdown_.store(0);
+  env_->count_random_reads_ = false;
+}
+
+TEST(DBTest, ReadDeadlineStopsIterator) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  options.compression = kNoCompression;
+  options.env = env_;
+  BlockBasedTableOptions table_options;
+  table_options.block_size = 256;
+  table_options.block_cache = NewLRUCache(8 << 20);
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  env_->count_random_reads_ = true;
+  DestroyAndReopen(options);
+
+  // Old versions of all the keys in level 1, all of whose blocks are cached
+  Random rnd(301);
+  const int kNumKeys = 100;
+  for (int i = 0; i < kNumKeys; i++) {
+    ASSERT_OK(Put(Key(i), "old" + RandomString(&rnd, 100)));
+  }
+  ASSERT_OK(Flush());
+  dbfull()->TEST_CompactRange(0, nullptr, nullptr);
+  std::unique_ptr<Iterator> iter(db_->NewIterator(ReadOptions()));
+  int count = 0;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    count++;
+  }
+  ASSERT_OK(iter->status());
+  ASSERT_EQ(kNumKeys, count);
+  iter.reset();
+
+  // New versions of the even keys and deletions of the odd ones in level 0,
+  // of which only the first block is cached
+  for (int i = 0; i < kNumKeys; i++) {
+    if (i % 2 == 0) {
+      ASSERT_OK(Put(Key(i), "new" + RandomString(&rnd, 100)));
+    } else {
+      ASSERT_OK(Delete(Key(i)));
+    }
+  }
+  ASSERT_OK(Flush());
+  ASSERT_EQ("1,1", FilesPerLevel());
+  ASSERT_EQ("new", Get(Key(0)).substr(0, 3));
+
+  // Reading any other block of level 0 times out. The iterators stop there
+  // instead of returning the old versions of level 1.
+  env_->random_read_slowdown_.store(20000);
+  ReadOptions ro;
+  ro.io_timeout = 1000;
+  iter.reset(db_->NewIterator(ro));
+  count = 0;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    ASSERT_EQ(0, iter->key().ToString().compare(Key(2 * count)));
+    ASSERT_EQ("new", iter->value().ToString().substr(0, 3));
+    count++;
+  }
+  ASSERT_TRUE(iter->status().IsTimedOut());
+  ASSERT_GT(count, 0);
+  ASSERT_LT(count, kNumKeys / 2);
+
+  iter.reset(db_->NewIterator(ro));
+  for (iter->Seek(Key(kNumKeys / 2)); iter->Valid(); iter->Next()) {
+    ASSERT_EQ("new", iter->value().ToString().substr(0, 3));
+  }
+  ASSERT_TRUE(iter->status().IsTimedOut());
+
+  iter.reset(db_->NewIterator(ro));
+  iter->SeekToLast();
+  ASSERT_TRUE(!iter->Valid());
+  ASSERT_TRUE(iter->status().IsTimedOut());
+  iter.reset();
+  env_->random_read_slowdown_.store(0);
+}
+
+TEST(DBTest, SecondaryInstance) {
+  Options options = CurrentOptions();
+  options.max_open_files = -1;
+  options.disable_auto_compactions = true;
+  Reopen(options);
+  ASSERT_OK(Put("a", "v1"));
+  ASSERT_OK(Put("b", "v1"));
+  ASSERT_OK(Flush());
+  ASSERT_OK(Put("c", "v1"));
+
+  const std::string secondary_path = test::TmpDir(env_) + "/db_secondary";
+  DB* secondary = nullptr;
+  ASSERT_OK(DB::OpenAsSecondary(options, dbname_, secondary_path, &secondary));
+  std::string value;
+  ASSERT_OK(secondary->Get(ReadOptions(), "a", &value));
+  ASSERT_EQ("v1", value);
+  ASSERT_OK(secondary->Get(ReadOptions(), "c", &value));
+  ASSERT_EQ("v1", value);
+  ASSERT_TRUE(secondary->Put(WriteOptions(), "d", "v1").IsNotSupported());
+  ASSERT_TRUE(db_->TryCatchUpWithPrimary().IsNotSupported());
+
+  // New WAL records are read on catch up
+  ASSERT_OK(Put("a", "v2"));
+  ASSERT_OK(Delete("b"));
+  ASSERT_OK(secondary->Get(ReadOptions(), "a", &value));
+  ASSERT_EQ("v1", value);
+  ASSERT_OK(secondary->TryCatchUpWithPrimary());
+  ASSERT_OK(secondary->Get(ReadOptions(), "a", &value));
+  ASSERT_EQ("v2", value);
+  ASSERT_TRUE(secondary->Get(ReadOptions(), "b", &value).IsNotFound());
+  std::unique_ptr<Iterator> iter(secondary->NewIterator(ReadOptions()));
+
+  // Flushes, compactions and a new WAL file
+  ASSERT_OK(Put("e", "v1"));
+  ASSERT_OK(Flush());
+  ASSERT_OK(db_->CompactRange(nullptr, nullptr));
+  ASSERT_OK(Put("a", "v3"));
+  ASSERT_OK(Put("f", "v1"));
+  ASSERT_OK(secondary->TryCatchUpWithPrimary());
+  ASSERT_OK(secondary->Get(ReadOptions(), "a", &value));
+  ASSERT_EQ("v3", value);
+  ASSERT_TRUE(secondary->Get(ReadOptions(), "b", &value).IsNotFound());
+  for (std::string key : {"c", "e", "f"}) {
+    ASSERT_OK(secondary->Get(ReadOptions(), key, &value));
+    ASSERT_EQ("v1", value);
+  }
+
+  // Iterators keep their view, even of the files the compaction deleted
+  std::string contents;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    contents += iter->key().ToString() + "=" + iter->value().ToString() + ",";
+  }
+  ASSERT_OK(iter->status());
+  ASSERT_EQ("a=v2,c=v1,", contents);
+  iter.reset();
+
+  // The primary writes a new MANIFEST when it is reopened
+  Reopen(options);
+  ASSERT_OK(Put("g", "v1"));
+  ASSERT_OK(Delete("c"));
+  ASSERT_OK(secondary->TryCatchUpWithPrimary());
+  ASSERT_OK(secondary->Get(ReadOptions(), "a", &value));
+  ASSERT_EQ("v3", value);
+  ASSERT_OK(secondary->Get(ReadOptions(), "g", &value));
+  ASSERT_EQ("v1", value);
+  ASSERT_TRUE(secondary->Get(ReadOptions(), "c", &value).IsNotFound());
+  contents.clear();
+  iter.reset(secondary->NewIterator(ReadOptions()));
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    contents += iter->key().ToString() + "=" + iter->value().ToString() + ",";
+  }
+  ASSERT_EQ("a=v3,e=v1,f=v1,g=v1,", contents);
+  iter.reset();
+
+  delete secondary;
+  ASSERT_OK(DestroyDB(secondary_path, options));
+}
+
 TEST(DBTest, WriteSingleThreadEntry) {
   std::vector<std::thread> threads;
   dbfull()->TEST_LockMutex();
@@ -11669,6 +12489,75 @@ TEST(DBTest, DeleteObsoleteFilesPendingOutputs) {
   ASSERT_TRUE(!env_->FileExists(dbname_ + "/" + file_on_L2));
 }
 
+TEST(DBTest, BlobFiles) {
+  Options options = CurrentOptions();
+  options.min_blob_size = 100;
+  options.disable_auto_compactions = true;
+  options.merge_operator = MergeOperators::CreateStringAppendOperator();
+  DestroyAndReopen(options);
+
+  auto count_blob_files = [&]() {
+    std::vector<std::string> files;
+    env_->GetChildren(dbname_, &files);
+    int count = 0;
+    uint64_t number;
+    FileType type;
+    for (const auto& file : files) {
+      if (ParseFileName(file, &number, &type) && type == kBlobFile) {
+        count++;
+      }
+    }
+    return count;
+  };
+
+  const std::string big1(1000, 'a');
+  const std::string big2(200, 'b');
+  ASSERT_OK(Put("k1", big1));
+  ASSERT_OK(Put("k2", "small"));
+  ASSERT_OK(Put("k3", big2));
+  ASSERT_OK(Flush());
+  ASSERT_EQ(1, count_blob_files());
+
+  ASSERT_EQ(big1, Get("k1"));
+  ASSERT_EQ("small", Get("k2"));
+  ASSERT_EQ(big2, Get("k3"));
+  ASSERT_EQ("(k1->" + big1 + ")(k2->small)(k3->" + big2 + ")",
+            Contents());
+
+  // Merge into a value that is in the blob file, through a flush and a
+  // compaction
+  ASSERT_OK(db_->Merge(WriteOptions(), "k3", "c"));
+  ASSERT_EQ(big2 + ",c", Get("k3"));
+  ASSERT_OK(Flush());
+  ASSERT_EQ(big2 + ",c", Get("k3"));
+  ASSERT_OK(db_->CompactRange(nullptr, nullptr));
+  ASSERT_EQ(big2 + ",c", Get("k3"));
+  ASSERT_EQ(big1, Get("k1"));
+
+  ASSERT_EQ(2, count_blob_files());
+
+  // Reads that must not do IO do not read blobs from unopened files
+  Reopen(options);
+  ASSERT_EQ("small", Get("k2"));
+  std::string value;
+  bool value_found = true;
+  ASSERT_TRUE(db_->KeyMayExist(ReadOptions(), "k1", &value, &value_found));
+  ASSERT_TRUE(!value_found);
+  ASSERT_EQ(big1, Get("k1"));
+
+  // Once all its blobs are overwritten, a blob file is deleted
+  ASSERT_OK(Put("k1", "v1"));
+  ASSERT_OK(Put("k3", "v3"));
+  ASSERT_OK(Flush());
+  ASSERT_OK(db_->CompactRange(nullptr, nullptr));
+  ASSERT_EQ(0, count_blob_files());
+  ASSERT_EQ("(k1->v1)(k2->small)(k3->v3)", Contents());
+
+  Reopen(options);
+  ASSERT_EQ("v1", Get("k1"));
+  ASSERT_EQ("v3", Get("k3"));
+}
+
 }  // namespace rocksdb
 
 int main(int argc, char** argv) {
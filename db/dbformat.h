@@ -39,6 +39,10 @@ enum ValueType : unsigned char {
   kTypeColumnFamilyDeletion = 0x4,
   kTypeColumnFamilyValue = 0x5,
   kTypeColumnFamilyMerge = 0x6,
+  // The value is a BlobIndex pointing at the actual value in a blob file
+  // (see db/blob_file.h). Only used in sst files, never in write ahead logs
+  // or memtables.
+  kTypeBlobIndex = 0x7,
   kMaxValue = 0x7F
 };
 
@@ -48,7 +52,12 @@ enum ValueType : unsigned char {
 // and the value type is embedded as the low 8 bits in the sequence
 // number in internal keys, we need to use the highest-numbered
 // ValueType, not the lowest).
-static const ValueType kValueTypeForSeek = kTypeMerge;
+static const ValueType kValueTypeForSeek = kTypeBlobIndex;
+
+// Returns true if t is a type that entries of memtables and sst files have
+inline bool IsValueType(ValueType t) {
+  return t <= kTypeMerge || t == kTypeBlobIndex;
+}
 
 // We leave eight bits empty at the bottom so a type and sequence#
 // can be packed together into 64-bits.
@@ -173,7 +182,7 @@ inline bool ParseInternalKey(const Slice& internal_key,
   result->type = static_cast<ValueType>(c);
   assert(result->type <= ValueType::kMaxValue);
   result->user_key = Slice(internal_key.data(), n - 8);
-  return (c <= static_cast<unsigned char>(kValueTypeForSeek));
+  return IsValueType(result->type);
 }
 
 // Update the sequence number in the internal key
@@ -243,7 +252,8 @@ inline LookupKey::~LookupKey() {
 
 class IterKey {
  public:
-  IterKey() : key_(space_), buf_size_(sizeof(space_)), key_size_(0) {}
+  IterKey()
+      : buf_(space_), buf_size_(sizeof(space_)), key_(buf_), key_size_(0) {}
 
   ~IterKey() { ResetBuffer(); }
 
@@ -262,32 +272,45 @@ class IterKey {
     assert(shared_len <= key_size_);
 
     size_t total_size = shared_len + non_shared_len;
-    if (total_size <= buf_size_) {
-      key_size_ = total_size;
-    } else {
+    if (IsKeyPinned()) {
+      // The shared bytes are still in the external storage key_ points to
+      EnlargeBufferIfNeeded(total_size);
+      memcpy(buf_, key_, shared_len);
+    } else if (total_size > buf_size_) {
       // Need to allocate space, delete previous space
       char* p = new char[total_size];
       memcpy(p, key_, shared_len);
 
-      if (key_ != nullptr && key_ != space_) {
-        delete[] key_;
+      if (buf_ != space_) {
+        delete[] buf_;
       }
 
-      key_ = p;
-      key_size_ = total_size;
+      buf_ = p;
       buf_size_ = total_size;
     }
 
-    memcpy(key_ + shared_len, non_shared_data, non_shared_len);
+    memcpy(buf_ + shared_len, non_shared_data, non_shared_len);
+    key_ = buf_;
+    key_size_ = total_size;
   }
 
-  void SetKey(const Slice& key) {
+  // If copy is false, the key is not copied and key.data() must stay valid
+  // as long as this key is used.
+  void SetKey(const Slice& key, bool copy = true) {
     size_t size = key.size();
-    EnlargeBufferIfNeeded(size);
-    memcpy(key_, key.data(), size);
+    if (copy) {
+      EnlargeBufferIfNeeded(size);
+      memcpy(buf_, key.data(), size);
+      key_ = buf_;
+    } else {
+      key_ = key.data();
+    }
     key_size_ = size;
   }
 
+  // True iff the key refers to external storage rather than our own copy
+  bool IsKeyPinned() const { return key_ != buf_; }
+
   void SetInternalKey(const Slice& key_prefix, const Slice& user_key,
                       SequenceNumber s,
                       ValueType value_type = kValueTypeForSeek) {
@@ -295,10 +318,11 @@ class IterKey {
     size_t usize = user_key.size();
     EnlargeBufferIfNeeded(psize + usize + sizeof(uint64_t));
     if (psize > 0) {
-      memcpy(key_, key_prefix.data(), psize);
+      memcpy(buf_, key_prefix.data(), psize);
     }
-    memcpy(key_ + psize, user_key.data(), usize);
-    EncodeFixed64(key_ + usize + psize, PackSequenceAndType(s, value_type));
+    memcpy(buf_ + psize, user_key.data(), usize);
+    EncodeFixed64(buf_ + usize + psize, PackSequenceAndType(s, value_type));
+    key_ = buf_;
     key_size_ = psize + usize + sizeof(uint64_t);
   }
 
@@ -309,6 +333,7 @@ class IterKey {
 
   void Reserve(size_t size) {
     EnlargeBufferIfNeeded(size);
+    key_ = buf_;
     key_size_ = size;
   }
 
@@ -325,21 +350,23 @@ class IterKey {
   void EncodeLengthPrefixedKey(const Slice& key) {
     auto size = key.size();
     EnlargeBufferIfNeeded(size + static_cast<size_t>(VarintLength(size)));
-    char* ptr = EncodeVarint32(key_, static_cast<uint32_t>(size));
+    char* ptr = EncodeVarint32(buf_, static_cast<uint32_t>(size));
     memcpy(ptr, key.data(), size);
+    key_ = buf_;
   }
 
  private:
-  char* key_;
+  char* buf_;
   size_t buf_size_;
+  const char* key_;  // buf_, or external storage if the key is pinned
   size_t key_size_;
   char space_[32];  // Avoid allocation for short keys
 
   void ResetBuffer() {
-    if (key_ != nullptr && key_ != space_) {
-      delete[] key_;
+    if (buf_ != space_) {
+      delete[] buf_;
+      buf_ = space_;
     }
-    key_ = space_;
     buf_size_ = sizeof(space_);
     key_size_ = 0;
   }
@@ -355,7 +382,7 @@ class IterKey {
     if (key_size > buf_size_) {
       // Need to enlarge the buffer.
       ResetBuffer();
-      key_ = new char[key_size];
+      buf_ = new char[key_size];
       buf_size_ = key_size;
     }
   }
@@ -51,6 +51,22 @@ static void TestKey(const std::string& key,
 
 class FormatTest { };
 
+TEST(FormatTest, InternalKey_ValueType) {
+  TestKey("foo", 100, kTypeBlobIndex);
+
+  // A key whose type byte is not a type of memtable or sst file entries,
+  // e.g. after corruption, is rejected
+  for (ValueType vt :
+       {kTypeLogData, kTypeColumnFamilyDeletion, kTypeColumnFamilyValue,
+        kTypeColumnFamilyMerge, static_cast<ValueType>(kTypeBlobIndex + 1),
+        kMaxValue}) {
+    std::string encoded("foo");
+    PutFixed64(&encoded, (100 << 8) | vt);
+    ParsedInternalKey decoded("", 0, kTypeValue);
+    ASSERT_TRUE(!ParseInternalKey(encoded, &decoded));
+  }
+}
+
 TEST(FormatTest, InternalKey_EncodeDecode) {
   const char* keys[] = { "", "k", "hello", "longggggggggggggggggggggg" };
   const uint64_t seq[] = {
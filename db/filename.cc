@@ -103,6 +103,11 @@ std::string TableFileName(const std::vector<DbPath>& db_paths, uint64_t number,
   return MakeTableFileName(path, number);
 }
 
+std::string BlobFileName(const std::string& path, uint64_t number) {
+  assert(number > 0);
+  return MakeFileName(path, number, "blob");
+}
+
 const size_t kFormatFileNumberBufSize = 38;
 
 void FormatFileNumber(uint64_t number, uint32_t path_id, char* out_buf,
@@ -282,6 +287,8 @@ bool ParseFileName(const std::string& fname, uint64_t* number,
       return false; // Archive dir can contain only log files
     } else if (suffix == Slice(".sst")) {
       *type = kTableFile;
+    } else if (suffix == Slice(".blob")) {
+      *type = kBlobFile;
     } else if (suffix == Slice(".dbtmp")) {
       *type = kTempFile;
     } else {
@@ -36,7 +36,8 @@ enum FileType {
   kTempFile,
   kInfoLogFile,  // Either the current one, or an old one
   kMetaDatabase,
-  kIdentityFile
+  kIdentityFile,
+  kBlobFile
 };
 
 // Return the name of the log file with the specified number
@@ -65,6 +66,10 @@ extern uint64_t TableFileNameToNumber(const std::string& name);
 extern std::string TableFileName(const std::vector<DbPath>& db_paths,
                                  uint64_t number, uint32_t path_id);
 
+// Return the name of the blob file with the specified number in the
+// directory "path". The result will be prefixed with "path".
+extern std::string BlobFileName(const std::string& path, uint64_t number);
+
 // Sufficient buffer size for FormatFileNumber.
 extern const size_t kFormatFileNumberBufSize;
 
@@ -140,6 +140,9 @@ Status FlushJob::WriteLevel0Table(const autovector<MemTable*>& mems,
   // path 0 for level 0 file.
   meta.fd = FileDescriptor(versions_->NewFileNumber(), 0, 0);
   *filenumber = meta.fd.GetNumber();
+  BlobFileMetaData blob_file;
+  const uint64_t blob_file_number =
+      cfd_->ioptions()->min_blob_size > 0 ? versions_->NewFileNumber() : 0;
 
   const SequenceNumber earliest_seqno_in_memtable =
       mems[0]->GetFirstSequenceNumber();
@@ -173,7 +176,8 @@ Status FlushJob::WriteLevel0Table(const autovector<MemTable*>& mems,
                      cfd_->table_cache(), iter.get(), &meta,
                      cfd_->internal_comparator(), newest_snapshot_,
                      earliest_seqno_in_memtable, output_compression_,
-                     cfd_->ioptions()->compression_opts, Env::IO_HIGH);
+                     cfd_->ioptions()->compression_opts, Env::IO_HIGH,
+                     blob_file_number, &blob_file);
       LogFlush(db_options_.info_log);
     }
     Log(InfoLogLevel::INFO_LEVEL, db_options_.info_log,
@@ -211,15 +215,24 @@ Status FlushJob::WriteLevel0Table(const autovector<MemTable*>& mems,
       if (fdpath != 0) {
         level = 0;
       }
+      // The file was written by the table factory of level 0
+      if (GetTableFactoryForLevel(*cfd_->ioptions(), level) !=
+          GetTableFactoryForLevel(*cfd_->ioptions(), 0)) {
+        level = 0;
+      }
     }
     edit->AddFile(level, meta.fd.GetNumber(), meta.fd.GetPathId(),
                   meta.fd.GetFileSize(), meta.smallest, meta.largest,
                   meta.smallest_seqno, meta.largest_seqno);
+    if (blob_file.total_count > 0) {
+      edit->AddBlobFile(blob_file.file_number, blob_file.file_size,
+                        blob_file.total_count, blob_file.total_bytes);
+    }
   }
 
   InternalStats::CompactionStats stats(1);
   stats.micros = db_options_.env->NowMicros() - start_micros;
-  stats.bytes_written = meta.fd.GetFileSize();
+  stats.bytes_written = meta.fd.GetFileSize() + blob_file.file_size;
   cfd_->internal_stats()->AddCompactionStats(level, stats);
   cfd_->internal_stats()->AddCFStats(InternalStats::BYTES_FLUSHED,
                                      meta.fd.GetFileSize());
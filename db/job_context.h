@@ -21,7 +21,8 @@ class MemTable;
 struct JobContext {
   inline bool HaveSomethingToDelete() const {
     return full_scan_candidate_files.size() || sst_delete_files.size() ||
-           log_delete_files.size() || new_superversion != nullptr ||
+           log_delete_files.size() || blob_delete_files.size() ||
+           new_superversion != nullptr ||
            superversions_to_free.size() > 0 || memtables_to_free.size() > 0;
   }
 
@@ -54,6 +55,12 @@ struct JobContext {
   // a list of log files that we need to delete
   std::vector<uint64_t> log_delete_files;
 
+  // the numbers of all live blob files that cannot be deleted
+  std::vector<uint64_t> blob_live;
+
+  // the numbers of the blob files that we need to delete
+  std::vector<uint64_t> blob_delete_files;
+
   // a list of memtables to be free
   autovector<MemTable*> memtables_to_free;
 
@@ -31,6 +31,7 @@ Reader::Reader(unique_ptr<SequentialFile>&& _file, Reporter* reporter,
       read_error_(false),
       eof_offset_(0),
       last_record_offset_(0),
+      end_of_last_record_offset_(0),
       end_of_buffer_offset_(0),
       initial_offset_(initial_offset) {}
 
@@ -92,6 +93,7 @@ bool Reader::ReadRecord(Slice* record, std::string* scratch) {
         scratch->clear();
         *record = fragment;
         last_record_offset_ = prospective_record_offset;
+        end_of_last_record_offset_ = end_of_buffer_offset_ - buffer_.size();
         return true;
 
       case kFirstType:
@@ -124,6 +126,7 @@ bool Reader::ReadRecord(Slice* record, std::string* scratch) {
           scratch->append(fragment.data(), fragment.size());
           *record = Slice(*scratch);
           last_record_offset_ = prospective_record_offset;
+          end_of_last_record_offset_ = end_of_buffer_offset_ - buffer_.size();
           return true;
         }
         break;
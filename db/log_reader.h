@@ -62,6 +62,14 @@ class Reader {
   // Undefined before the first call to ReadRecord.
   uint64_t LastRecordOffset();
 
+  // Returns the physical offset just past the last record returned by
+  // ReadRecord. A Reader created with this initial_offset starts with the
+  // record after it, even if that one was not completely written yet when
+  // this Reader hit the end of the file.
+  //
+  // Undefined before the first call to ReadRecord.
+  uint64_t EndOfLastRecordOffset() const { return end_of_last_record_offset_; }
+
   // returns true if the reader has encountered an eof condition.
   bool IsEOF() {
     return eof_;
@@ -91,6 +99,8 @@ class Reader {
 
   // Offset of the last record returned by ReadRecord.
   uint64_t last_record_offset_;
+  // Offset just past the end of the last record returned by ReadRecord.
+  uint64_t end_of_last_record_offset_;
   // Offset of the first location past the end of buffer_.
   uint64_t end_of_buffer_offset_;
 
@@ -297,6 +297,25 @@ class LogTest {
     ASSERT_TRUE(!offset_reader->ReadRecord(&record, &scratch));
   }
 
+  // Reads the records in the first size bytes of the log, starting at
+  // initial_offset. Returns the offset just past the last record read, or
+  // initial_offset if there is none.
+  uint64_t ReadRecordsFrom(uint64_t initial_offset, size_t size,
+                           std::vector<std::string>* records) {
+    Slice contents(dest_contents().data(), size);
+    unique_ptr<StringSource> source(new StringSource(contents));
+    Reader reader(std::move(source), &report_, true /*checksum*/,
+                  initial_offset);
+    Slice record;
+    std::string scratch;
+    uint64_t end = initial_offset;
+    while (reader.ReadRecord(&record, &scratch)) {
+      records->push_back(record.ToString());
+      end = reader.EndOfLastRecordOffset();
+    }
+    return end;
+  }
+
   void CheckInitialOffsetRecord(uint64_t initial_offset,
                                 int expected_record_offset) {
     WriteInitialOffsetLog();
@@ -617,6 +636,34 @@ TEST(LogTest, ReadPastEnd) {
   CheckOffsetPastEndReturnsNoRecords(5);
 }
 
+TEST(LogTest, ResumeAtEndOfLastRecord) {
+  Write("foo");
+  Write(BigString("bar", 2 * kBlockSize));
+  Write("baz");
+
+  // The second record is only partially written when it is first read
+  std::vector<std::string> records;
+  uint64_t end = ReadRecordsFrom(0, 3 * kHeaderSize + 3 + kBlockSize,
+                                 &records);
+  ASSERT_EQ(1U, records.size());
+  ASSERT_EQ("foo", records[0]);
+  ASSERT_EQ(kHeaderSize + 3, end);
+
+  // Once it is complete, a new reader continues with it
+  records.clear();
+  end = ReadRecordsFrom(end, WrittenBytes(), &records);
+  ASSERT_EQ(2U, records.size());
+  ASSERT_EQ(BigString("bar", 2 * kBlockSize), records[0]);
+  ASSERT_EQ("baz", records[1]);
+  ASSERT_EQ(WrittenBytes(), end);
+
+  records.clear();
+  ASSERT_EQ(end, ReadRecordsFrom(end, WrittenBytes(), &records));
+  ASSERT_EQ(0U, records.size());
+  ASSERT_EQ(0U, DroppedBytes());
+  ASSERT_EQ("", ReportMessage());
+}
+
 TEST(LogTest, ClearEofSingleBlock) {
   Write("foo");
   Write("bar");
@@ -255,6 +255,8 @@ class MemTableIterator: public Iterator {
     assert(Valid());
     return GetLengthPrefixedSlice(iter_->key());
   }
+  // Keys live in the memtable's arena
+  virtual bool IsKeyPinned() const override { return true; }
   virtual Slice value() const override {
     assert(Valid());
     Slice key_slice = GetLengthPrefixedSlice(iter_->key());
@@ -347,6 +349,45 @@ struct Saver {
 };
 }  // namespace
 
+// SaveValue() for a merge context that collects operands instead of merging
+// them. Memtable entries are copied.
+static bool CollectOperand(Saver* s, ValueType type, const Slice& value) {
+  MergeContext* merge_context = s->merge_context;
+  switch (type) {
+    case kTypeValue: {
+      if (s->inplace_update_support) {
+        s->mem->GetLock(s->key->user_key())->ReadLock();
+      }
+      // The base value is the oldest operand
+      merge_context->PushCollectedOperand(value, nullptr);
+      if (s->inplace_update_support) {
+        s->mem->GetLock(s->key->user_key())->ReadUnlock();
+      }
+      merge_context->FinishCollectedOperands();
+      *(s->status) = Status::OK();
+      *(s->found_final_value) = true;
+      return false;
+    }
+    case kTypeDeletion:
+      merge_context->FinishCollectedOperands();
+      *(s->status) =
+          *(s->merge_in_progress) ? Status::OK() : Status::NotFound();
+      *(s->found_final_value) = true;
+      return false;
+    case kTypeMerge:
+      *(s->merge_in_progress) = true;
+      if (!merge_context->PushCollectedOperand(value, nullptr)) {
+        *(s->status) = Status::OK();
+        *(s->found_final_value) = true;
+        return false;
+      }
+      return true;
+    default:
+      assert(false);
+      return true;
+  }
+}
+
 static bool SaveValue(void* arg, const char* entry) {
   Saver* s = reinterpret_cast<Saver*>(arg);
   MergeContext* merge_context = s->merge_context;
@@ -369,6 +410,10 @@ static bool SaveValue(void* arg, const char* entry) {
           Slice(key_ptr, key_length - 8), s->key->user_key()) == 0) {
     // Correct user key
     const uint64_t tag = DecodeFixed64(key_ptr + key_length - 8);
+    if (merge_context->IsCollectingOperands()) {
+      return CollectOperand(s, static_cast<ValueType>(tag & 0xff),
+                            GetLengthPrefixedSlice(key_ptr + key_length));
+    }
     switch (static_cast<ValueType>(tag & 0xff)) {
       case kTypeValue: {
         if (s->inplace_update_support) {
@@ -424,7 +469,7 @@ static bool SaveValue(void* arg, const char* entry) {
         }
         Slice v = GetLengthPrefixedSlice(key_ptr + key_length);
         *(s->merge_in_progress) = true;
-        merge_context->PushOperand(v);
+        merge_context->PushOperand(v, tag >> 8);
         return true;
       }
       default:
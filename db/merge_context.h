@@ -5,9 +5,11 @@
 //
 #pragma once
 #include "db/dbformat.h"
+#include "rocksdb/cleanable.h"
 #include "rocksdb/slice.h"
 #include <string>
 #include <deque>
+#include <memory>
 
 namespace rocksdb {
 
@@ -32,9 +34,12 @@ public:
     operand_list->clear();
     operand_list->push_front(std::move(merge_result));
   }
-  // Push a merge operand
-  void PushOperand(const Slice& operand_slice) {
+  // Push a merge operand. Lookups push operands newest first.
+  void PushOperand(const Slice& operand_slice, SequenceNumber sequence) {
     Initialize();
+    if (operand_list->empty()) {
+      newest_operand_sequence_ = sequence;
+    }
     operand_list->push_front(operand_slice.ToString());
   }
   // return total number of operands in the list
@@ -56,6 +61,57 @@ public:
     }
     return *operand_list;
   }
+
+  // Sequence number of the newest operand pushed since the list was last
+  // empty
+  SequenceNumber GetNewestOperandSequence() const {
+    return newest_operand_sequence_;
+  }
+
+  // Make lookups collect the operands for GetMergeOperands() instead of
+  // merging them. The base value, if any, is collected as the oldest
+  // operand. Lookups stop once max_operands operands have been collected.
+  void CollectOperands(size_t max_operands) {
+    collect_operands_ = true;
+    max_collected_operands_ = max_operands;
+  }
+  bool IsCollectingOperands() const { return collect_operands_; }
+  // Push a collected operand. If pinner is not null, the operand is not
+  // copied; its storage is kept alive by moving the cleanups of pinner to
+  // this context. Returns false if no more operands are wanted.
+  bool PushCollectedOperand(const Slice& operand_slice, Cleanable* pinner) {
+    assert(collect_operands_);
+    if (pinner != nullptr) {
+      if (!pinned_storage_) {
+        pinned_storage_.reset(new Cleanable());
+      }
+      pinner->DelegateCleanupsTo(pinned_storage_.get());
+      collected_operands_.emplace_front(operand_slice, true);
+    } else {
+      copied_operands_.push_front(operand_slice.ToString());
+      collected_operands_.emplace_front(copied_operands_.front(), false);
+    }
+    if (collected_operands_.size() >= max_collected_operands_) {
+      collection_truncated_ = true;
+      return false;
+    }
+    return true;
+  }
+  // Mark the collection complete because the base value or the start of
+  // the key history was reached.
+  void FinishCollectedOperands() { collection_truncated_ = false; }
+  // Return the collected operands, oldest first, each with whether it
+  // refers to pinned storage.
+  const std::deque<std::pair<Slice, bool>>& GetCollectedOperands() const {
+    return collected_operands_;
+  }
+  // True if the lookup stopped before reaching the start of the key history
+  bool IsCollectionTruncated() const { return collection_truncated_; }
+  // Holds the cleanups of the storage of pinned operands, or is null
+  Cleanable* GetPinnedStorage() { return pinned_storage_.get(); }
+  // Storage of the copied operands, which may be moved out
+  std::deque<std::string>* GetCopiedOperands() { return &copied_operands_; }
+
 private:
   void Initialize() {
     if (!operand_list) {
@@ -63,6 +119,16 @@ private:
     }
   }
   std::unique_ptr<std::deque<std::string>> operand_list;
+  SequenceNumber newest_operand_sequence_ = 0;
+
+  bool collect_operands_ = false;
+  size_t max_collected_operands_ = 0;
+  bool collection_truncated_ = false;
+  // A deque does not move its elements on push_front(), so the collected
+  // slices may refer to the copies
+  std::deque<std::string> copied_operands_;
+  std::deque<std::pair<Slice, bool>> collected_operands_;
+  std::unique_ptr<Cleanable> pinned_storage_;
 };
 
 } // namespace rocksdb
@@ -4,6 +4,7 @@
 //  of patent rights can be found in the PATENTS file in the same directory.
 //
 #include "merge_helper.h"
+#include "db/blob_file.h"
 #include "db/dbformat.h"
 #include "rocksdb/comparator.h"
 #include "rocksdb/db.h"
@@ -32,6 +33,8 @@ void MergeHelper::MergeUntil(Iterator* iter, SequenceNumber stop_before,
   assert(user_merge_operator_);
 
   success_ = false;   // Will become true if we hit Put/Delete or bottom
+  status_ = Status::OK();
+  merged_blob_index_.clear();
 
   // We need to parse the internal key again as the parsed key is
   // backed by the internal key!
@@ -103,13 +106,25 @@ void MergeHelper::MergeUntil(Iterator* iter, SequenceNumber stop_before,
       return;
     }
 
-    if (kTypeValue == ikey.type) {
+    if (kTypeValue == ikey.type || kTypeBlobIndex == ikey.type) {
       // hit a put
       //   => merge the put value with operands_
       //   => store result in operands_.back() (and update keys_.back())
       //   => change the entry type to kTypeValue for keys_.back()
       // We are done! Success!
-      const Slice val = iter->value();
+      Slice val = iter->value();
+      if (kTypeBlobIndex == ikey.type) {
+        if (blob_fetcher_ == nullptr) {
+          status_ = Status::NotSupported("cannot merge into a blob value");
+        } else {
+          status_ = blob_fetcher_->FetchBlob(ikey.user_key, val, &blob_value_);
+        }
+        if (!status_.ok()) {
+          break;
+        }
+        merged_blob_index_ = val.ToString();
+        val = blob_value_;
+      }
       success_ = user_merge_operator_->FullMerge(ikey.user_key, &val, operands_,
                                                  &merge_result, logger_);
 
@@ -8,11 +8,13 @@
 
 #include "db/dbformat.h"
 #include "rocksdb/slice.h"
+#include "rocksdb/status.h"
 #include <string>
 #include <deque>
 
 namespace rocksdb {
 
+class BlobFetcher;
 class Comparator;
 class Iterator;
 class Logger;
@@ -24,19 +26,22 @@ class MergeHelper {
   MergeHelper(const Comparator* user_comparator,
               const MergeOperator* user_merge_operator, Logger* logger,
               unsigned min_partial_merge_operands,
-              bool assert_valid_internal_key)
+              bool assert_valid_internal_key,
+              const BlobFetcher* blob_fetcher = nullptr)
       : user_comparator_(user_comparator),
         user_merge_operator_(user_merge_operator),
         logger_(logger),
         min_partial_merge_operands_(min_partial_merge_operands),
         assert_valid_internal_key_(assert_valid_internal_key),
+        blob_fetcher_(blob_fetcher),
         keys_(),
         operands_(),
         success_(false) {}
 
   // Merge entries until we hit
   //     - a corrupted key
-  //     - a Put/Delete,
+  //     - a Put/Delete (the value of a Put whose value is in a blob file is
+  //       read with blob_fetcher),
   //     - a different user key,
   //     - a specific sequence number (snapshot boundary),
   //  or - the end of iteration
@@ -88,6 +93,12 @@ class MergeHelper {
     assert(!success_); return operands_;
   }
   bool HasOperator() const { return user_merge_operator_ != nullptr; }
+  // Not ok if the value of a Put could not be read from its blob file. The
+  // iterator is then left at that Put.
+  const Status& status() const { return status_; }
+  // The encoded BlobIndex of the Put merged by the last MergeUntil call, if
+  // its value was in a blob file, or empty
+  const std::string& merged_blob_index() const { return merged_blob_index_; }
 
  private:
   const Comparator* user_comparator_;
@@ -95,12 +106,16 @@ class MergeHelper {
   Logger* logger_;
   unsigned min_partial_merge_operands_;
   bool assert_valid_internal_key_; // enforce no internal key corruption?
+  const BlobFetcher* blob_fetcher_;
 
   // the scratch area that holds the result of MergeUntil
   // valid up to the next MergeUntil call
   std::deque<std::string> keys_;    // Keeps track of the sequence of keys seen
   std::deque<std::string> operands_;  // Parallel with keys_; stores the values
   bool success_;
+  Status status_;
+  std::string merged_blob_index_;
+  std::string blob_value_;
 };
 
 } // namespace rocksdb
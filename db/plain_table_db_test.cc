@@ -1084,6 +1084,84 @@ TEST(PlainTableDBTest, AdaptiveTable) {
   ASSERT_NE("v5", Get("3000000000000bar"));
 }
 
+namespace {
+// Keys of 16 bytes, ten for each prefix of 8 bytes
+std::string MakeTotalOrderKey(int i) {
+  char buf[100];
+  snprintf(buf, sizeof(buf), "%08d%08d", i / 10 * 7, i);
+  return std::string(buf);
+}
+}  // namespace
+
+TEST(PlainTableDBTest, TotalOrderIndex) {
+  for (int store_index_in_file = 0; store_index_in_file <= 1;
+       ++store_index_in_file) {
+    Options options = CurrentOptions();
+    options.create_if_missing = true;
+    options.memtable_factory.reset(new SkipListFactory);
+
+    PlainTableOptions plain_table_options;
+    plain_table_options.user_key_len = 16;
+    plain_table_options.bloom_bits_per_key = 10;
+    plain_table_options.hash_table_ratio = 0.75;
+    plain_table_options.index_sparseness = 3;
+    plain_table_options.encoding_type = kPlain;
+    plain_table_options.store_index_in_file = store_index_in_file;
+    plain_table_options.total_order_index = true;
+    options.table_factory.reset(NewPlainTableFactory(plain_table_options));
+    DestroyAndReopen(&options);
+
+    for (int i = 0; i < 100; i++) {
+      ASSERT_OK(Put(MakeTotalOrderKey(i), ToString(i)));
+    }
+    dbfull()->TEST_FlushMemTable();
+    ASSERT_EQ("1", FilesPerLevel());
+
+    ReadOptions ro;
+    ro.total_order_seek = true;
+    Iterator* iter = dbfull()->NewIterator(ro);
+    for (int i = 0; i < 100; i++) {
+      iter->Seek(MakeTotalOrderKey(i));
+      ASSERT_TRUE(iter->Valid());
+      ASSERT_EQ(MakeTotalOrderKey(i), iter->key().ToString());
+      ASSERT_EQ(ToString(i), iter->value().ToString());
+    }
+    // Seek to a prefix without keys, and across all the prefixes
+    iter->Seek("00000003");
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(MakeTotalOrderKey(10), iter->key().ToString());
+    iter->Seek("0000000000000004a");
+    for (int i = 5; i < 100; i++) {
+      ASSERT_TRUE(iter->Valid());
+      ASSERT_EQ(MakeTotalOrderKey(i), iter->key().ToString());
+      iter->Next();
+    }
+    ASSERT_TRUE(!iter->Valid());
+    iter->Seek("1");
+    ASSERT_TRUE(!iter->Valid());
+    ASSERT_OK(iter->status());
+    delete iter;
+
+    // Prefix seeks and point lookups still use the hash index
+    iter = dbfull()->NewIterator(ReadOptions());
+    iter->Seek(MakeTotalOrderKey(42));
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(MakeTotalOrderKey(42), iter->key().ToString());
+    delete iter;
+    ASSERT_EQ("57", Get(MakeTotalOrderKey(57)));
+
+    // Without the index, total order seeks are not supported
+    plain_table_options.total_order_index = false;
+    options.table_factory.reset(NewPlainTableFactory(plain_table_options));
+    Reopen(&options);
+    iter = dbfull()->NewIterator(ro);
+    iter->Seek(MakeTotalOrderKey(0));
+    ASSERT_TRUE(!iter->Valid());
+    ASSERT_TRUE(iter->status().IsInvalidArgument());
+    delete iter;
+  }
+}
+
 }  // namespace rocksdb
 
 int main(int argc, char** argv) {
@@ -9,14 +9,19 @@
 
 #include "db/table_cache.h"
 
+#include <string.h>
+
 #include "db/filename.h"
 #include "db/version_edit.h"
 
 #include "rocksdb/statistics.h"
+#include "rocksdb/table.h"
+#include "table/format.h"
 #include "table/iterator_wrapper.h"
 #include "table/table_reader.h"
 #include "table/get_context.h"
 #include "util/coding.h"
+#include "util/readahead_file.h"
 #include "util/stop_watch.h"
 
 namespace rocksdb {
@@ -32,11 +37,70 @@ static void UnrefEntry(void* arg1, void* arg2) {
   cache->Release(h);
 }
 
+static void DeleteTableReader(void* arg1, void* arg2) {
+  TableReader* table_reader = reinterpret_cast<TableReader*>(arg1);
+  delete table_reader;
+}
+
 static Slice GetSliceForFileNumber(const uint64_t* file_number) {
   return Slice(reinterpret_cast<const char*>(file_number),
                sizeof(*file_number));
 }
 
+extern const uint64_t kBlockBasedTableMagicNumber;
+extern const uint64_t kLegacyBlockBasedTableMagicNumber;
+#ifndef ROCKSDB_LITE
+extern const uint64_t kPlainTableMagicNumber;
+extern const uint64_t kLegacyPlainTableMagicNumber;
+extern const uint64_t kCuckooTableMagicNumber;
+#endif  // ROCKSDB_LITE
+
+// Return the name of the table factory that writes tables with the magic
+// number "magic_number", or nullptr if it is not known
+static const char* GetTableFactoryName(uint64_t magic_number) {
+  if (magic_number == kBlockBasedTableMagicNumber ||
+      magic_number == kLegacyBlockBasedTableMagicNumber) {
+    return "BlockBasedTable";
+  }
+#ifndef ROCKSDB_LITE
+  if (magic_number == kPlainTableMagicNumber ||
+      magic_number == kLegacyPlainTableMagicNumber) {
+    return "PlainTable";
+  }
+  if (magic_number == kCuckooTableMagicNumber) {
+    return "CuckooTable";
+  }
+#endif  // ROCKSDB_LITE
+  return nullptr;
+}
+
+// With table_factory_per_level, the files of a column family do not all
+// have the same format. Find the table factory of the column family that
+// reads "file".
+static Status GetTableFactoryForFile(const ImmutableCFOptions& ioptions,
+                                     RandomAccessFile* file,
+                                     uint64_t file_size,
+                                     TableFactory** table_factory) {
+  *table_factory = ioptions.table_factory;
+  Footer footer;
+  Status s = ReadFooterFromFile(file, file_size, &footer);
+  if (!s.ok()) {
+    return s;
+  }
+  const char* name = GetTableFactoryName(footer.table_magic_number());
+  if (name == nullptr || strcmp(name, ioptions.table_factory->Name()) == 0) {
+    return s;
+  }
+  for (TableFactory* level_table_factory : ioptions.table_factory_per_level) {
+    if (level_table_factory != nullptr &&
+        strcmp(name, level_table_factory->Name()) == 0) {
+      *table_factory = level_table_factory;
+      break;
+    }
+  }
+  return s;
+}
+
 TableCache::TableCache(const ImmutableCFOptions& ioptions,
                        const EnvOptions& env_options, Cache* const cache)
     : ioptions_(ioptions),
@@ -54,6 +118,39 @@ void TableCache::ReleaseHandle(Cache::Handle* handle) {
   cache_->Release(handle);
 }
 
+Status TableCache::GetTableReader(
+    const EnvOptions& env_options,
+    const InternalKeyComparator& internal_comparator, const FileDescriptor& fd,
+    size_t readahead_size, unique_ptr<TableReader>* table_reader) {
+  std::string fname =
+      TableFileName(ioptions_.db_paths, fd.GetNumber(), fd.GetPathId());
+  unique_ptr<RandomAccessFile> file;
+  Status s = ioptions_.env->NewRandomAccessFile(fname, &file, env_options);
+  RecordTick(ioptions_.statistics, NO_FILE_OPENS);
+  if (s.ok()) {
+    // mmap reads are served from memory without copying
+    if (readahead_size > 0 && !env_options.use_mmap_reads) {
+      file->Hint(RandomAccessFile::SEQUENTIAL);
+      file = NewReadaheadRandomAccessFile(std::move(file), fd.GetFileSize(),
+                                          readahead_size);
+    } else if (ioptions_.advise_random_on_open) {
+      file->Hint(RandomAccessFile::RANDOM);
+    }
+    StopWatch sw(ioptions_.env, ioptions_.statistics, TABLE_OPEN_IO_MICROS);
+    TableFactory* table_factory = ioptions_.table_factory;
+    if (!ioptions_.table_factory_per_level.empty()) {
+      s = GetTableFactoryForFile(ioptions_, file.get(), fd.GetFileSize(),
+                                 &table_factory);
+    }
+    if (s.ok()) {
+      s = table_factory->NewTableReader(ioptions_, env_options,
+                                        internal_comparator, std::move(file),
+                                        fd.GetFileSize(), table_reader);
+    }
+  }
+  return s;
+}
+
 Status TableCache::FindTable(const EnvOptions& env_options,
                              const InternalKeyComparator& internal_comparator,
                              const FileDescriptor& fd, Cache::Handle** handle,
@@ -66,21 +163,9 @@ Status TableCache::FindTable(const EnvOptions& env_options,
     if (no_io) { // Dont do IO and return a not-found status
       return Status::Incomplete("Table not found in table_cache, no_io is set");
     }
-    std::string fname =
-        TableFileName(ioptions_.db_paths, fd.GetNumber(), fd.GetPathId());
-    unique_ptr<RandomAccessFile> file;
     unique_ptr<TableReader> table_reader;
-    s = ioptions_.env->NewRandomAccessFile(fname, &file, env_options);
-    RecordTick(ioptions_.statistics, NO_FILE_OPENS);
-    if (s.ok()) {
-      if (ioptions_.advise_random_on_open) {
-        file->Hint(RandomAccessFile::RANDOM);
-      }
-      StopWatch sw(ioptions_.env, ioptions_.statistics, TABLE_OPEN_IO_MICROS);
-      s = ioptions_.table_factory->NewTableReader(
-          ioptions_, env_options, internal_comparator, std::move(file),
-          fd.GetFileSize(), &table_reader);
-    }
+    s = GetTableReader(env_options, internal_comparator, fd,
+                       0 /* readahead_size */, &table_reader);
 
     if (!s.ok()) {
       assert(table_reader == nullptr);
@@ -103,20 +188,41 @@ Iterator* TableCache::NewIterator(const ReadOptions& options,
   if (table_reader_ptr != nullptr) {
     *table_reader_ptr = nullptr;
   }
-  TableReader* table_reader = fd.table_reader;
+  TableReader* table_reader = nullptr;
   Cache::Handle* handle = nullptr;
   Status s;
-  if (table_reader == nullptr) {
-    s = FindTable(env_options, icomparator, fd, &handle,
-                  options.read_tier == kBlockCacheTier);
+  // Compaction inputs may be read through a table reader of their own,
+  // which the iterator deletes
+  const bool create_new_table_reader =
+      for_compaction &&
+      (ioptions_.compaction_readahead_size > 0 ||
+       env_options.use_direct_reads != env_options_.use_direct_reads);
+  if (create_new_table_reader) {
+    unique_ptr<TableReader> table_reader_unique_ptr;
+    s = GetTableReader(env_options, icomparator, fd,
+                       ioptions_.compaction_readahead_size,
+                       &table_reader_unique_ptr);
     if (!s.ok()) {
       return NewErrorIterator(s, arena);
     }
-    table_reader = GetTableReaderFromHandle(handle);
+    table_reader = table_reader_unique_ptr.release();
+  } else {
+    table_reader = fd.table_reader;
+    if (table_reader == nullptr) {
+      s = FindTable(env_options, icomparator, fd, &handle,
+                    options.read_tier == kBlockCacheTier);
+      if (!s.ok()) {
+        return NewErrorIterator(s, arena);
+      }
+      table_reader = GetTableReaderFromHandle(handle);
+    }
   }
 
-  Iterator* result = table_reader->NewIterator(options, arena);
-  if (handle != nullptr) {
+  Iterator* result = table_reader->NewIterator(options, arena, for_compaction);
+  if (create_new_table_reader) {
+    assert(handle == nullptr);
+    result->RegisterCleanup(&DeleteTableReader, table_reader, nullptr);
+  } else if (handle != nullptr) {
     result->RegisterCleanup(&UnrefEntry, cache_, handle);
   }
   if (table_reader_ptr != nullptr) {
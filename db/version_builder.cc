@@ -15,6 +15,7 @@
 
 #include <inttypes.h>
 #include <algorithm>
+#include <map>
 #include <set>
 #include <unordered_map>
 #include <unordered_set>
@@ -81,6 +82,8 @@ class VersionBuilder::Rep {
   TableCache* table_cache_;
   VersionStorageInfo* base_vstorage_;
   LevelState* levels_;
+  // Blob files of the base version with the added files and garbage applied
+  std::map<uint64_t, BlobFileMetaData> blob_files_;
   FileComparator level_zero_cmp_;
   FileComparator level_nonzero_cmp_;
 
@@ -89,7 +92,8 @@ class VersionBuilder::Rep {
       VersionStorageInfo* base_vstorage)
       : env_options_(env_options),
         table_cache_(table_cache),
-        base_vstorage_(base_vstorage) {
+        base_vstorage_(base_vstorage),
+        blob_files_(base_vstorage->BlobFiles()) {
     levels_ = new LevelState[base_vstorage_->num_levels()];
     level_zero_cmp_.sort_method = FileComparator::kLevel0;
     level_nonzero_cmp_.sort_method = FileComparator::kLevelNon0;
@@ -221,6 +225,19 @@ class VersionBuilder::Rep {
       levels_[level].deleted_files.erase(f->fd.GetNumber());
       levels_[level].added_files[f->fd.GetNumber()] = f;
     }
+
+    // Add new blob files, then account for their garbage
+    for (const auto& blob_file : edit->GetNewBlobFiles()) {
+      assert(blob_files_.find(blob_file.file_number) == blob_files_.end());
+      blob_files_[blob_file.file_number] = blob_file;
+    }
+    for (const auto& garbage : edit->GetBlobFileGarbage()) {
+      auto it = blob_files_.find(garbage.file_number);
+      if (it != blob_files_.end()) {
+        it->second.garbage_count += garbage.count;
+        it->second.garbage_bytes += garbage.bytes;
+      }
+    }
   }
 
   // Save the current state in *v.
@@ -275,6 +292,13 @@ class VersionBuilder::Rep {
       }
     }
 
+    // Drop the blob files no table refers to any more
+    for (const auto& blob_file : blob_files_) {
+      if (blob_file.second.garbage_count < blob_file.second.total_count) {
+        vstorage->AddBlobFile(blob_file.second);
+      }
+    }
+
     CheckConsistency(vstorage);
   }
 
@@ -35,6 +35,9 @@ enum Tag {
   kColumnFamilyAdd = 201,
   kColumnFamilyDrop = 202,
   kMaxColumnFamily = 203,
+
+  kNewBlobFile = 300,
+  kBlobFileGarbage = 301,
 };
 
 uint64_t PackFileNumberAndPathId(uint64_t number, uint64_t path_id) {
@@ -58,6 +61,8 @@ void VersionEdit::Clear() {
   has_max_column_family_ = false;
   deleted_files_.clear();
   new_files_.clear();
+  new_blob_files_.clear();
+  blob_file_garbage_.clear();
   column_family_ = 0;
   is_column_family_add_ = 0;
   is_column_family_drop_ = 0;
@@ -120,6 +125,21 @@ bool VersionEdit::EncodeTo(std::string* dst) const {
     PutVarint64(dst, f.largest_seqno);
   }
 
+  for (const auto& blob_file : new_blob_files_) {
+    PutVarint32(dst, kNewBlobFile);
+    PutVarint64(dst, blob_file.file_number);
+    PutVarint64(dst, blob_file.file_size);
+    PutVarint64(dst, blob_file.total_count);
+    PutVarint64(dst, blob_file.total_bytes);
+  }
+
+  for (const auto& garbage : blob_file_garbage_) {
+    PutVarint32(dst, kBlobFileGarbage);
+    PutVarint64(dst, garbage.file_number);
+    PutVarint64(dst, garbage.count);
+    PutVarint64(dst, garbage.bytes);
+  }
+
   // 0 is default and does not need to be explicitly written
   if (column_family_ != 0) {
     PutVarint32(dst, kColumnFamily);
@@ -303,6 +323,36 @@ Status VersionEdit::DecodeFrom(const Slice& src) {
         break;
       }
 
+      case kNewBlobFile: {
+        BlobFileMetaData blob_file;
+        if (GetVarint64(&input, &blob_file.file_number) &&
+            GetVarint64(&input, &blob_file.file_size) &&
+            GetVarint64(&input, &blob_file.total_count) &&
+            GetVarint64(&input, &blob_file.total_bytes)) {
+          new_blob_files_.push_back(blob_file);
+        } else {
+          if (!msg) {
+            msg = "new blob file entry";
+          }
+        }
+        break;
+      }
+
+      case kBlobFileGarbage: {
+        uint64_t number;
+        uint64_t count;
+        uint64_t bytes;
+        if (GetVarint64(&input, &number) && GetVarint64(&input, &count) &&
+            GetVarint64(&input, &bytes)) {
+          blob_file_garbage_.emplace_back(number, count, bytes);
+        } else {
+          if (!msg) {
+            msg = "blob file garbage entry";
+          }
+        }
+        break;
+      }
+
       case kColumnFamily:
         if (!GetVarint32(&input, &column_family_)) {
           if (!msg) {
@@ -387,6 +437,24 @@ std::string VersionEdit::DebugString(bool hex_key) const {
     r.append(" .. ");
     r.append(f.largest.DebugString(hex_key));
   }
+  for (const auto& blob_file : new_blob_files_) {
+    r.append("\n  AddBlobFile: ");
+    AppendNumberTo(&r, blob_file.file_number);
+    r.append(" ");
+    AppendNumberTo(&r, blob_file.file_size);
+    r.append(" ");
+    AppendNumberTo(&r, blob_file.total_count);
+    r.append(" ");
+    AppendNumberTo(&r, blob_file.total_bytes);
+  }
+  for (const auto& garbage : blob_file_garbage_) {
+    r.append("\n  BlobFileGarbage: ");
+    AppendNumberTo(&r, garbage.file_number);
+    r.append(" ");
+    AppendNumberTo(&r, garbage.count);
+    r.append(" ");
+    AppendNumberTo(&r, garbage.bytes);
+  }
   r.append("\n  ColumnFamily: ");
   AppendNumberTo(&r, column_family_);
   if (is_column_family_add_) {
@@ -99,6 +99,41 @@ struct FileMetaData {
         init_stats_from_file(false) {}
 };
 
+// A blob file referenced by the tables of a version (see db/blob_file.h)
+struct BlobFileMetaData {
+  uint64_t file_number;
+  uint64_t file_size;
+  uint64_t total_count;    // number of blobs written to the file
+  uint64_t total_bytes;    // total size of their records
+  uint64_t garbage_count;  // number of blobs no table refers to any more
+  uint64_t garbage_bytes;  // total size of their records
+
+  BlobFileMetaData()
+      : file_number(0),
+        file_size(0),
+        total_count(0),
+        total_bytes(0),
+        garbage_count(0),
+        garbage_bytes(0) {}
+
+  // Fraction of the blob bytes that is garbage
+  double GarbageRatio() const {
+    return total_bytes == 0
+               ? 0.0
+               : static_cast<double>(garbage_bytes) / total_bytes;
+  }
+};
+
+// Blobs of a blob file that a compaction dropped or copied to another file
+struct BlobFileGarbage {
+  uint64_t file_number;
+  uint64_t count;
+  uint64_t bytes;
+
+  BlobFileGarbage(uint64_t _file_number, uint64_t _count, uint64_t _bytes)
+      : file_number(_file_number), count(_count), bytes(_bytes) {}
+};
+
 // A compressed copy of file meta data that just contain
 // smallest and largest key's slice
 struct FdWithKeyRange {
@@ -181,8 +216,29 @@ class VersionEdit {
     deleted_files_.insert({level, file});
   }
 
+  // Add the blob file with the specified number, which holds "total_count"
+  // blob records of "total_bytes" bytes.
+  void AddBlobFile(uint64_t file, uint64_t file_size, uint64_t total_count,
+                   uint64_t total_bytes) {
+    BlobFileMetaData meta;
+    meta.file_number = file;
+    meta.file_size = file_size;
+    meta.total_count = total_count;
+    meta.total_bytes = total_bytes;
+    new_blob_files_.push_back(meta);
+  }
+
+  // Record that "count" blobs of "bytes" bytes of the specified blob file are
+  // not referenced by any table any more.
+  void AddBlobFileGarbage(uint64_t file, uint64_t count, uint64_t bytes) {
+    blob_file_garbage_.emplace_back(file, count, bytes);
+  }
+
   // Number of edits
-  size_t NumEntries() { return new_files_.size() + deleted_files_.size(); }
+  size_t NumEntries() {
+    return new_files_.size() + deleted_files_.size() +
+           new_blob_files_.size() + blob_file_garbage_.size();
+  }
 
   bool IsColumnFamilyManipulation() {
     return is_column_family_add_ || is_column_family_drop_;
@@ -219,6 +275,12 @@ class VersionEdit {
   const std::vector<std::pair<int, FileMetaData>>& GetNewFiles() {
     return new_files_;
   }
+  const std::vector<BlobFileMetaData>& GetNewBlobFiles() {
+    return new_blob_files_;
+  }
+  const std::vector<BlobFileGarbage>& GetBlobFileGarbage() {
+    return blob_file_garbage_;
+  }
 
   std::string DebugString(bool hex_key = false) const;
 
@@ -244,6 +306,8 @@ class VersionEdit {
 
   DeletedFileSet deleted_files_;
   std::vector<std::pair<int, FileMetaData>> new_files_;
+  std::vector<BlobFileMetaData> new_blob_files_;
+  std::vector<BlobFileGarbage> blob_file_garbage_;
 
   // Each version edit record should have column_family_id set
   // If it's not set, it is default (0)
@@ -68,6 +68,31 @@ TEST(VersionEditTest, ColumnFamilyTest) {
   TestEncodeDecode(edit);
 }
 
+TEST(VersionEditTest, BlobFiles) {
+  static const uint64_t kBig = 1ull << 50;
+
+  VersionEdit edit;
+  edit.AddBlobFile(kBig + 1, kBig + 2, 3, kBig + 4);
+  edit.AddBlobFile(5, 6, 7, 8);
+  edit.AddBlobFileGarbage(kBig + 1, 1, 100);
+  TestEncodeDecode(edit);
+
+  std::string encoded;
+  edit.EncodeTo(&encoded);
+  VersionEdit parsed;
+  ASSERT_OK(parsed.DecodeFrom(encoded));
+  ASSERT_EQ(3U, parsed.NumEntries());
+  ASSERT_EQ(2U, parsed.GetNewBlobFiles().size());
+  ASSERT_EQ(kBig + 1, parsed.GetNewBlobFiles()[0].file_number);
+  ASSERT_EQ(kBig + 2, parsed.GetNewBlobFiles()[0].file_size);
+  ASSERT_EQ(3U, parsed.GetNewBlobFiles()[0].total_count);
+  ASSERT_EQ(kBig + 4, parsed.GetNewBlobFiles()[0].total_bytes);
+  ASSERT_EQ(1U, parsed.GetBlobFileGarbage().size());
+  ASSERT_EQ(kBig + 1, parsed.GetBlobFileGarbage()[0].file_number);
+  ASSERT_EQ(1U, parsed.GetBlobFileGarbage()[0].count);
+  ASSERT_EQ(100U, parsed.GetBlobFileGarbage()[0].bytes);
+}
+
 }  // namespace rocksdb
 
 int main(int argc, char** argv) {
@@ -20,9 +20,11 @@
 #include <set>
 #include <climits>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <string>
 
+#include "db/blob_file.h"
 #include "db/filename.h"
 #include "db/log_reader.h"
 #include "db/log_writer.h"
@@ -411,11 +413,23 @@ bool SomeFileOverlapsRange(
 
 namespace {
 
+// Return true if no key of file can be returned by an iterator with the
+// iterate bounds of read_options
+bool FileOutsideIterateBounds(const Comparator* ucmp,
+                              const ReadOptions& read_options,
+                              const FdWithKeyRange& file) {
+  return (read_options.iterate_upper_bound != nullptr &&
+          ucmp->Compare(ExtractUserKey(file.smallest_key),
+                        *read_options.iterate_upper_bound) >= 0) ||
+         (read_options.iterate_lower_bound != nullptr &&
+          ucmp->Compare(ExtractUserKey(file.largest_key),
+                        *read_options.iterate_lower_bound) < 0);
+}
+
 // An internal iterator.  For a given version/level pair, yields
 // information about the files in the level.  For a given entry, key()
-// is the largest key that occurs in the file, and value() is an
-// 16-byte value containing the file number and file size, both
-// encoded using EncodeFixed64.
+// is the largest key that occurs in the file, and value() is the
+// FdWithKeyRange of the file.
 class LevelFileNumIterator : public Iterator {
  public:
   LevelFileNumIterator(const InternalKeyComparator& icmp,
@@ -423,7 +437,7 @@ class LevelFileNumIterator : public Iterator {
       : icmp_(icmp),
         flevel_(flevel),
         index_(static_cast<uint32_t>(flevel->num_files)),
-        current_value_(0, 0, 0) {  // Marks as invalid
+        current_value_() {  // Marks as invalid
   }
   virtual bool Valid() const override { return index_ < flevel_->num_files; }
   virtual void Seek(const Slice& target) override {
@@ -454,10 +468,9 @@ class LevelFileNumIterator : public Iterator {
   Slice value() const override {
     assert(Valid());
 
-    auto file_meta = flevel_->files[index_];
-    current_value_ = file_meta.fd;
+    current_value_ = flevel_->files[index_];
     return Slice(reinterpret_cast<const char*>(&current_value_),
-                 sizeof(FileDescriptor));
+                 sizeof(FdWithKeyRange));
   }
   virtual Status status() const override { return Status::OK(); }
 
@@ -465,7 +478,7 @@ class LevelFileNumIterator : public Iterator {
   const InternalKeyComparator icmp_;
   const LevelFilesBrief* flevel_;
   uint32_t index_;
-  mutable FileDescriptor current_value_;
+  mutable FdWithKeyRange current_value_;
 };
 
 class LevelFileIteratorState : public TwoLevelIteratorState {
@@ -474,20 +487,24 @@ class LevelFileIteratorState : public TwoLevelIteratorState {
     const ReadOptions& read_options, const EnvOptions& env_options,
     const InternalKeyComparator& icomparator, bool for_compaction,
     bool prefix_enabled)
-    : TwoLevelIteratorState(prefix_enabled),
+    : TwoLevelIteratorState(prefix_enabled, read_options.pin_data),
       table_cache_(table_cache), read_options_(read_options),
       env_options_(env_options), icomparator_(icomparator),
       for_compaction_(for_compaction) {}
 
   Iterator* NewSecondaryIterator(const Slice& meta_handle) override {
-    if (meta_handle.size() != sizeof(FileDescriptor)) {
+    if (meta_handle.size() != sizeof(FdWithKeyRange)) {
       return NewErrorIterator(
           Status::Corruption("FileReader invoked with unexpected value"));
     } else {
-      const FileDescriptor* fd =
-          reinterpret_cast<const FileDescriptor*>(meta_handle.data());
+      const FdWithKeyRange* file =
+          reinterpret_cast<const FdWithKeyRange*>(meta_handle.data());
+      if (FileOutsideIterateBounds(icomparator_.user_comparator(),
+                                   read_options_, *file)) {
+        return NewEmptyIterator();
+      }
       return table_cache_->NewIterator(
-          read_options_, env_options_, icomparator_, *fd,
+          read_options_, env_options_, icomparator_, file->fd,
           nullptr /* don't need reference to table*/, for_compaction_);
     }
   }
@@ -496,6 +513,21 @@ class LevelFileIteratorState : public TwoLevelIteratorState {
     return true;
   }
 
+  // The largest key of a file is before the smallest key of the next one
+  bool KeyReachesUpperBound(const Slice& largest_key) override {
+    return read_options_.iterate_upper_bound != nullptr &&
+           icomparator_.user_comparator()->Compare(
+               ExtractUserKey(largest_key),
+               *read_options_.iterate_upper_bound) >= 0;
+  }
+
+  bool KeyBelowLowerBound(const Slice& largest_key) override {
+    return read_options_.iterate_lower_bound != nullptr &&
+           icomparator_.user_comparator()->Compare(
+               ExtractUserKey(largest_key),
+               *read_options_.iterate_lower_bound) < 0;
+  }
+
  private:
   TableCache* table_cache_;
   const ReadOptions read_options_;
@@ -510,10 +542,12 @@ class LevelFileIteratorState : public TwoLevelIteratorState {
 class BaseReferencedVersionBuilder {
  public:
   explicit BaseReferencedVersionBuilder(ColumnFamilyData* cfd)
+      : BaseReferencedVersionBuilder(cfd, cfd->current()) {}
+  BaseReferencedVersionBuilder(ColumnFamilyData* cfd, Version* base_version)
       : version_builder_(new VersionBuilder(
-            cfd->current()->version_set()->env_options(), cfd->table_cache(),
-            cfd->current()->storage_info())),
-        version_(cfd->current()) {
+            base_version->version_set()->env_options(), cfd->table_cache(),
+            base_version->storage_info())),
+        version_(base_version) {
     version_->Ref();
   }
   ~BaseReferencedVersionBuilder() {
@@ -611,6 +645,73 @@ size_t Version::GetMemoryUsageByTableReaders() {
   return total_usage;
 }
 
+void Version::GetSplitPoints(
+    const Slice* begin, const Slice* end, size_t target_points,
+    std::vector<std::pair<std::string, uint64_t>>* points) {
+  const Comparator* ucmp = cfd_->internal_comparator().user_comparator();
+  std::vector<FileMetaData*> files;
+  for (int level = 0; level < storage_info_.num_non_empty_levels(); level++) {
+    for (auto* f : storage_info_.LevelFiles(level)) {
+      if ((end != nullptr &&
+           ucmp->Compare(f->smallest.user_key(), *end) >= 0) ||
+          (begin != nullptr &&
+           ucmp->Compare(f->largest.user_key(), *begin) < 0)) {
+        continue;
+      }
+      files.push_back(f);
+    }
+  }
+  if (files.empty()) {
+    return;
+  }
+  // Opening a table to sample its index costs I/O, so only the largest
+  // files, which hold most of the data, are sampled, each in proportion to
+  // its size. The others only contribute their smallest key.
+  const size_t kMaxSampledFiles = 16;
+  std::sort(files.begin(), files.end(),
+            [](const FileMetaData* a, const FileMetaData* b) {
+              return a->fd.GetFileSize() > b->fd.GetFileSize();
+            });
+  const size_t num_sampled = std::min(files.size(), kMaxSampledFiles);
+  uint64_t sampled_bytes = 0;
+  for (size_t i = 0; i < num_sampled; i++) {
+    sampled_bytes += files[i]->fd.GetFileSize();
+  }
+
+  std::vector<std::string> keys;
+  for (size_t i = 0; i < files.size(); i++) {
+    FileMetaData* f = files[i];
+    size_t samples_per_file = 0;
+    if (i < num_sampled && sampled_bytes > 0) {
+      samples_per_file = static_cast<size_t>(
+          target_points * f->fd.GetFileSize() / sampled_bytes);
+    }
+    keys.clear();
+    keys.push_back(f->smallest.Encode().ToString());
+    if (samples_per_file > 0) {
+      TableReader* table_reader = nullptr;
+      Iterator* iter = cfd_->table_cache()->NewIterator(
+          ReadOptions(), vset_->env_options_, cfd_->internal_comparator(),
+          f->fd, &table_reader);
+      if (table_reader != nullptr) {
+        table_reader->SampleKeys(samples_per_file, &keys);
+      }
+      delete iter;
+    }
+    uint64_t bytes_per_key = f->fd.GetFileSize() / keys.size();
+    for (const auto& key : keys) {
+      Slice user_key = ExtractUserKey(key);
+      if (end != nullptr && ucmp->Compare(user_key, *end) >= 0) {
+        continue;
+      }
+      if (begin != nullptr && ucmp->Compare(user_key, *begin) < 0) {
+        user_key = *begin;
+      }
+      points->emplace_back(user_key.ToString(), bytes_per_key);
+    }
+  }
+}
+
 void Version::GetColumnFamilyMetaData(ColumnFamilyMetaData* cf_meta) {
   assert(cf_meta);
   assert(cfd_);
@@ -692,6 +793,10 @@ void Version::AddIterators(const ReadOptions& read_options,
   // Merge all level zero files together since they may overlap
   for (size_t i = 0; i < storage_info_.LevelFilesBrief(0).num_files; i++) {
     const auto& file = storage_info_.LevelFilesBrief(0).files[i];
+    if (FileOutsideIterateBounds(cfd_->user_comparator(), read_options,
+                                 file)) {
+      continue;
+    }
     merge_iter_builder->AddIterator(cfd_->table_cache()->NewIterator(
         read_options, soptions, cfd_->internal_comparator(), file.fd, nullptr,
         false, merge_iter_builder->GetArena()));
@@ -774,7 +879,7 @@ Version::Version(ColumnFamilyData* column_family_data, VersionSet* vset,
 
 void Version::Get(const ReadOptions& read_options,
                   const LookupKey& k,
-                  std::string* value,
+                  PinnableSlice* value,
                   Status* status,
                   MergeContext* merge_context,
                   bool* value_found) {
@@ -783,10 +888,11 @@ void Version::Get(const ReadOptions& read_options,
 
   assert(status->ok() || status->IsMergeInProgress());
 
+  BlobFetcher blob_fetcher(cfd_->blob_file_cache(), read_options);
   GetContext get_context(
       user_comparator(), merge_operator_, info_log_, db_statistics_,
       status->ok() ? GetContext::kNotFound : GetContext::kMerge, user_key,
-      value, value_found, merge_context);
+      value, value_found, merge_context, &blob_fetcher);
 
   FilePicker fp(
       storage_info_.files_, user_key, ikey, &storage_info_.level_files_brief_,
@@ -794,6 +900,11 @@ void Version::Get(const ReadOptions& read_options,
       user_comparator(), internal_comparator());
   FdWithKeyRange* f = fp.GetNextFile();
   while (f != nullptr) {
+    if (read_options.deadline != 0 &&
+        vset_->env_->NowMicros() >= read_options.deadline) {
+      *status = Status::TimedOut("read deadline exceeded");
+      return;
+    }
     *status = table_cache_->Get(read_options, *internal_comparator(), f->fd,
                                 ikey, &get_context);
     // TODO: examine the behavior for corrupted key
@@ -827,7 +938,12 @@ void Version::Get(const ReadOptions& read_options,
     f = fp.GetNextFile();
   }
 
-  if (GetContext::kMerge == get_context.State()) {
+  if (GetContext::kMerge == get_context.State() &&
+      merge_context->IsCollectingOperands()) {
+    // The collected operands reach back to the start of the key history
+    merge_context->FinishCollectedOperands();
+    *status = Status::OK();
+  } else if (GetContext::kMerge == get_context.State()) {
     if (!merge_operator_) {
       *status =  Status::InvalidArgument(
           "merge_operator is not properly initialized.");
@@ -836,8 +952,9 @@ void Version::Get(const ReadOptions& read_options,
     // merge_operands are in saver and we hit the beginning of the key history
     // do a final merge of nullptr and operands;
     if (merge_operator_->FullMerge(user_key, nullptr,
-                                   merge_context->GetOperands(), value,
-                                   info_log_)) {
+                                   merge_context->GetOperands(),
+                                   value->GetSelf(), info_log_)) {
+      value->PinSelf();
       *status = Status::OK();
     } else {
       RecordTick(db_statistics_, NUMBER_MERGE_FAILURES);
@@ -1617,6 +1734,12 @@ void Version::AddLiveFiles(std::vector<FileDescriptor>* live) {
   }
 }
 
+void Version::AddLiveBlobFiles(std::vector<uint64_t>* live) {
+  for (const auto& blob_file : storage_info_.blob_files_) {
+    live->push_back(blob_file.first);
+  }
+}
+
 std::string Version::DebugString(bool hex) const {
   std::string r;
   for (int level = 0; level < storage_info_.num_levels_; level++) {
@@ -1675,8 +1798,10 @@ VersionSet::VersionSet(const std::string& dbname, const DBOptions* db_options,
       prev_log_number_(0),
       current_version_number_(0),
       manifest_file_size_(0),
+      manifest_read_offset_(0),
       env_options_(storage_options),
-      env_options_compactions_(env_options_) {}
+      env_options_compactions_(
+          env_->OptimizeForCompactionTableRead(env_options_, *db_options_)) {}
 
 VersionSet::~VersionSet() {
   // we need to delete column_family_set_ because its destructor depends on
@@ -1703,6 +1828,14 @@ void VersionSet::AppendVersion(ColumnFamilyData* column_family_data,
   Version* current = column_family_data->current();
   assert(v != current);
   if (current != nullptr) {
+    // The blob files dropped by this version can be deleted once the older
+    // versions that still refer to them are gone
+    const auto& new_blob_files = v->storage_info_.BlobFiles();
+    for (const auto& blob_file : current->storage_info_.BlobFiles()) {
+      if (new_blob_files.count(blob_file.first) == 0) {
+        obsolete_blob_files_.push_back(blob_file.first);
+      }
+    }
     assert(current->refs_ > 0);
     current->Unref();
   }
@@ -2208,6 +2341,7 @@ Status VersionSet::Recover(
         have_last_sequence = true;
       }
     }
+    manifest_read_offset_ = reader.EndOfLastRecordOffset();
   }
 
   if (s.ok()) {
@@ -2292,6 +2426,121 @@ Status VersionSet::Recover(
   return s;
 }
 
+Status VersionSet::ReadNewManifestRecords(InstrumentedMutex* mu,
+                                          bool* changed,
+                                          SequenceNumber* last_sequence) {
+  mu->AssertHeld();
+  *changed = false;
+  *last_sequence = 0;
+
+  std::string manifest_filename;
+  Status s = ReadFileToString(env_, CurrentFileName(dbname_),
+                              &manifest_filename);
+  if (!s.ok()) {
+    return s;
+  }
+  if (manifest_filename.empty() || manifest_filename.back() != '\n') {
+    return Status::Corruption("CURRENT file does not end with newline");
+  }
+  manifest_filename.resize(manifest_filename.size() - 1);
+  uint64_t manifest_number;
+  FileType type;
+  if (!ParseFileName(manifest_filename, &manifest_number, &type) ||
+      type != kDescriptorFile) {
+    return Status::Corruption("CURRENT file corrupted");
+  }
+  // A new manifest starts with a snapshot of all files, so its records are
+  // applied to empty versions
+  const bool new_manifest = manifest_number != manifest_file_number_;
+  const uint64_t offset = new_manifest ? 0 : manifest_read_offset_;
+
+  unique_ptr<SequentialFile> manifest_file;
+  s = env_->NewSequentialFile(dbname_ + "/" + manifest_filename,
+                              &manifest_file, env_options_);
+  if (!s.ok()) {
+    return s;
+  }
+
+  std::unordered_map<uint32_t, std::unique_ptr<BaseReferencedVersionBuilder>>
+      builders;
+  std::unordered_map<uint32_t, uint64_t> log_numbers;
+  uint64_t end_offset = offset;
+  {
+    VersionSet::LogReporter reporter;
+    reporter.status = &s;
+    log::Reader reader(std::move(manifest_file), &reporter, true /*checksum*/,
+                       offset);
+    Slice record;
+    std::string scratch;
+    while (reader.ReadRecord(&record, &scratch) && s.ok()) {
+      VersionEdit edit;
+      s = edit.DecodeFrom(record);
+      if (!s.ok()) {
+        break;
+      }
+      end_offset = reader.EndOfLastRecordOffset();
+
+      if (edit.has_last_sequence_ && edit.last_sequence_ > *last_sequence) {
+        *last_sequence = edit.last_sequence_;
+      }
+      if (edit.has_prev_log_number_) {
+        prev_log_number_ = edit.prev_log_number_;
+      }
+      ColumnFamilyData* cfd =
+          column_family_set_->GetColumnFamily(edit.column_family_);
+      if (cfd == nullptr || edit.is_column_family_add_ ||
+          edit.is_column_family_drop_) {
+        continue;
+      }
+      if (edit.max_level_ >= cfd->current()->storage_info()->num_levels()) {
+        s = Status::InvalidArgument(
+            "db has more levels than options.num_levels");
+        break;
+      }
+
+      auto builder = builders.find(edit.column_family_);
+      if (builder == builders.end()) {
+        Version* base = new_manifest
+                            ? new Version(cfd, this, current_version_number_++)
+                            : cfd->current();
+        builder = builders.emplace(edit.column_family_,
+                                   std::unique_ptr<BaseReferencedVersionBuilder>(
+                                       new BaseReferencedVersionBuilder(
+                                           cfd, base))).first;
+      }
+      builder->second->version_builder()->Apply(&edit);
+      if (edit.has_log_number_) {
+        log_numbers[edit.column_family_] = edit.log_number_;
+      }
+    }
+  }
+  if (!s.ok()) {
+    return s;
+  }
+
+  for (auto& builder : builders) {
+    ColumnFamilyData* cfd = column_family_set_->GetColumnFamily(builder.first);
+    assert(cfd != nullptr);
+    auto* version_builder = builder.second->version_builder();
+    if (db_options_->max_open_files == -1) {
+      version_builder->LoadTableHandlers();
+    }
+    Version* v = new Version(cfd, this, current_version_number_++);
+    version_builder->SaveTo(v->storage_info());
+    v->PrepareApply(*cfd->GetLatestMutableCFOptions());
+    AppendVersion(cfd, v);
+    auto log_number = log_numbers.find(builder.first);
+    if (log_number != log_numbers.end() &&
+        log_number->second > cfd->GetLogNumber()) {
+      cfd->SetLogNumber(log_number->second);
+    }
+    *changed = true;
+  }
+  manifest_file_number_ = manifest_number;
+  manifest_read_offset_ = end_offset;
+  return s;
+}
+
 Status VersionSet::ListColumnFamilies(std::vector<std::string>* column_families,
                                       const std::string& dbname, Env* env) {
   // these are just for performance reasons, not correcntes,
@@ -2680,6 +2929,16 @@ Status VersionSet::WriteSnapshot(log::Writer* log) {
                        f->smallest_seqno, f->largest_seqno);
         }
       }
+      for (const auto& blob_file :
+           cfd->current()->storage_info()->BlobFiles()) {
+        const BlobFileMetaData& meta = blob_file.second;
+        edit.AddBlobFile(meta.file_number, meta.file_size, meta.total_count,
+                         meta.total_bytes);
+        if (meta.garbage_count > 0) {
+          edit.AddBlobFileGarbage(meta.file_number, meta.garbage_count,
+                                  meta.garbage_bytes);
+        }
+      }
       edit.SetLogNumber(cfd->GetLogNumber());
       std::string record;
       if (!edit.EncodeTo(&record)) {
@@ -2938,6 +3197,35 @@ void VersionSet::GetLiveFilesMetaData(std::vector<LiveFileMetaData>* metadata) {
   }
 }
 
+void VersionSet::AddLiveBlobFiles(std::vector<uint64_t>* live_list) {
+  for (auto cfd : *column_family_set_) {
+    Version* dummy_versions = cfd->dummy_versions();
+    for (Version* v = dummy_versions->next_; v != dummy_versions;
+         v = v->next_) {
+      v->AddLiveBlobFiles(live_list);
+    }
+  }
+}
+
+void VersionSet::GetObsoleteBlobFiles(std::vector<uint64_t>* files,
+                                      uint64_t min_pending_output) {
+  if (obsolete_blob_files_.empty()) {
+    return;
+  }
+  std::vector<uint64_t> live_list;
+  AddLiveBlobFiles(&live_list);
+  std::unordered_set<uint64_t> live(live_list.begin(), live_list.end());
+  std::vector<uint64_t> pending_files;
+  for (uint64_t number : obsolete_blob_files_) {
+    if (live.count(number) == 0 && number < min_pending_output) {
+      files->push_back(number);
+    } else {
+      pending_files.push_back(number);
+    }
+  }
+  obsolete_blob_files_.swap(pending_files);
+}
+
 void VersionSet::GetObsoleteFiles(std::vector<FileMetaData*>* files,
                                   uint64_t min_pending_output) {
   std::vector<FileMetaData*> pending_files;
@@ -96,6 +96,10 @@ class VersionStorageInfo {
 
   void AddFile(int level, FileMetaData* f);
 
+  void AddBlobFile(const BlobFileMetaData& meta) {
+    blob_files_[meta.file_number] = meta;
+  }
+
   void SetFinalized();
 
   // Update num_non_empty_levels_.
@@ -202,6 +206,11 @@ class VersionStorageInfo {
     return files_[level];
   }
 
+  // The blob files referenced by the tables, by file number
+  const std::map<uint64_t, BlobFileMetaData>& BlobFiles() const {
+    return blob_files_;
+  }
+
   const rocksdb::LevelFilesBrief& LevelFilesBrief(int level) const {
     assert(level < static_cast<int>(level_files_brief_.size()));
     return level_files_brief_[level];
@@ -310,6 +319,9 @@ class VersionStorageInfo {
   // in increasing order of keys
   std::vector<FileMetaData*>* files_;
 
+  // Blob files referenced by the files in files_
+  std::map<uint64_t, BlobFileMetaData> blob_files_;
+
   // Level that L0 data should be compacted to. All levels < base_level_ should
   // be empty.
   int base_level_;
@@ -373,10 +385,11 @@ class Version {
                     MergeIteratorBuilder* merger_iter_builder);
 
   // Lookup the value for key.  If found, store it in *val and
-  // return OK.  Else return a non-OK status.
+  // return OK.  Else return a non-OK status. *val may be pinned to a block
+  // of the table the value was found in instead of holding a copy.
   // Uses *operands to store merge_operator operations to apply later
   // REQUIRES: lock is not held
-  void Get(const ReadOptions&, const LookupKey& key, std::string* val,
+  void Get(const ReadOptions&, const LookupKey& key, PinnableSlice* val,
            Status* status, MergeContext* merge_context,
            bool* value_found = nullptr);
 
@@ -394,6 +407,9 @@ class Version {
   // Add all files listed in the current version to *live.
   void AddLiveFiles(std::vector<FileDescriptor>* live);
 
+  // Add the numbers of the blob files of the current version to *live.
+  void AddLiveBlobFiles(std::vector<uint64_t>* live);
+
   // Return a human readable string that describes this version's contents.
   std::string DebugString(bool hex = false) const;
 
@@ -421,6 +437,17 @@ class Version {
 
   size_t GetMemoryUsageByTableReaders();
 
+  // Append to *points user keys in [*begin, *end) that split the data of
+  // this version, each with an estimate of the bytes it stands for: the
+  // smallest key of every overlapping file plus about target_points keys
+  // sampled from the indexes of the largest overlapping files. Points are in
+  // no particular order. begin==nullptr and end==nullptr mean before and
+  // after all keys.
+  // REQUIRES: lock is not held
+  void GetSplitPoints(const Slice* begin, const Slice* end,
+                      size_t target_points,
+                      std::vector<std::pair<std::string, uint64_t>>* points);
+
   ColumnFamilyData* cfd() const { return cfd_; }
 
   // Return the next Version in the linked list. Used for debug only
@@ -511,6 +538,18 @@ class VersionSet {
   Status Recover(const std::vector<ColumnFamilyDescriptor>& column_families,
                  bool read_only = false);
 
+  // Read the records appended to the manifest since Recover() or the last
+  // call, and install a new version for every column family they change.
+  // If CURRENT names a new manifest, it is read from the start instead.
+  // Records of column families that are not open, and column family
+  // creation and drop records, are ignored. *changed is set if a version
+  // was installed, and *last_sequence to the largest last sequence number
+  // recorded, or 0. For secondary instances, which read the manifest
+  // written by a primary instance.
+  // REQUIRES: *mu is held
+  Status ReadNewManifestRecords(InstrumentedMutex* mu, bool* changed,
+                                SequenceNumber* last_sequence);
+
   // Reads a manifest file and returns a list of column families in
   // column_families.
   static Status ListColumnFamilies(std::vector<std::string>* column_families,
@@ -587,6 +626,9 @@ class VersionSet {
   // Add all files listed in any live version to *live.
   void AddLiveFiles(std::vector<FileDescriptor>* live_list);
 
+  // Add the numbers of the blob files of any live version to *live.
+  void AddLiveBlobFiles(std::vector<uint64_t>* live_list);
+
   // Return the approximate offset in the database of the data for
   // "key" as of version "v".
   uint64_t ApproximateOffsetOf(Version* v, const InternalKey& key);
@@ -608,6 +650,11 @@ class VersionSet {
   void GetObsoleteFiles(std::vector<FileMetaData*>* files,
                         uint64_t min_pending_output);
 
+  // Move the numbers of the blob files that were dropped from the current
+  // versions and are no longer referenced by any live version to *files.
+  void GetObsoleteBlobFiles(std::vector<uint64_t>* files,
+                            uint64_t min_pending_output);
+
   ColumnFamilySet* GetColumnFamilySet() { return column_family_set_.get(); }
   const EnvOptions& env_options() { return env_options_; }
 
@@ -660,13 +707,20 @@ class VersionSet {
   // Current size of manifest file
   uint64_t manifest_file_size_;
 
+  // Offset just past the last manifest record read by Recover() or
+  // ReadNewManifestRecords()
+  uint64_t manifest_read_offset_;
+
   std::vector<FileMetaData*> obsolete_files_;
 
+  // Blob files dropped from the current version of their column family
+  std::vector<uint64_t> obsolete_blob_files_;
+
   // env options for all reads and writes except compactions
   const EnvOptions& env_options_;
 
   // env options used for compactions. This is a copy of
-  // env_options_ but with readaheads set to readahead_compactions_.
+  // env_options_ with the options for the input files of compactions.
   const EnvOptions env_options_compactions_;
 
   // No copying allowed
@@ -49,6 +49,21 @@ extern shared_ptr<Cache> NewLRUCache(size_t capacity, int numShardBits);
 extern shared_ptr<Cache> NewLRUCache(size_t capacity, int numShardBits,
                                      int removeScanCountLimit);
 
+// Create a new cache with a fixed size capacity that evicts with the
+// CLOCK policy. Entries live in per-shard open-addressing tables with
+// atomic reference counts, so Lookup() and Release() never take a lock;
+// only Insert() and Erase() synchronize within a shard. Referenced
+// entries are never evicted.
+//
+// The table of each shard is sized up front for
+// capacity / estimatedEntryCharge entries. If entries are much smaller
+// than estimatedEntryCharge on average, the cache evicts before reaching
+// its capacity. The function without parameters numShardBits and
+// estimatedEntryCharge uses 4 shard bits and a 4KB entry charge.
+extern shared_ptr<Cache> NewClockCache(size_t capacity);
+extern shared_ptr<Cache> NewClockCache(size_t capacity, int numShardBits,
+                                       size_t estimatedEntryCharge);
+
 class Cache {
  public:
   Cache() { }
@@ -0,0 +1,52 @@
+// Copyright (c) 2013, Facebook, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// Cleanable holds a list of function/arg1/arg2 triples that are invoked
+// when it is destroyed. It is the base of objects that keep resources
+// (such as block cache handles) alive on behalf of their users, e.g.
+// Iterator and PinnableSlice.
+
+#ifndef STORAGE_ROCKSDB_INCLUDE_CLEANABLE_H_
+#define STORAGE_ROCKSDB_INCLUDE_CLEANABLE_H_
+
+namespace rocksdb {
+
+class Cleanable {
+ public:
+  Cleanable();
+  ~Cleanable();
+
+  // Clients are allowed to register function/arg1/arg2 triples that
+  // will be invoked when this object is destroyed.
+  typedef void (*CleanupFunction)(void* arg1, void* arg2);
+  void RegisterCleanup(CleanupFunction function, void* arg1, void* arg2);
+
+  // Move all the registered cleanups to "other", which then invokes them
+  // when it is destroyed instead of this object.
+  void DelegateCleanupsTo(Cleanable* other);
+
+  // Invoke all the registered cleanups now and forget them.
+  void Reset();
+
+ private:
+  struct Cleanup {
+    CleanupFunction function;
+    void* arg1;
+    void* arg2;
+    Cleanup* next;
+  };
+  Cleanup cleanup_;
+
+  // No copying allowed
+  Cleanable(const Cleanable&);
+  void operator=(const Cleanable&);
+};
+
+}  // namespace rocksdb
+
+#endif  // STORAGE_ROCKSDB_INCLUDE_CLEANABLE_H_
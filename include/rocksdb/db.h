@@ -11,6 +11,7 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include <functional>
 #include <memory>
 #include <vector>
 #include <string>
@@ -127,6 +128,35 @@ class DB {
       std::vector<ColumnFamilyHandle*>* handles, DB** dbptr,
       bool error_if_log_file_exist = false);
 
+  // Open the database as a secondary instance. A secondary instance follows
+  // a primary instance that has the database open in another process: it
+  // starts from the state in the primary's MANIFEST and WAL files, and
+  // TryCatchUpWithPrimary() reads what the primary has written since. Like
+  // a read only instance, it never modifies the files of the database.
+  // secondary_path is a directory for the files of the secondary instance
+  // itself, such as its info log.
+  //
+  // Table files deleted by the primary can still be read only if the
+  // secondary already has them open, so max_open_files should be -1.
+  //
+  // Not supported in ROCKSDB_LITE, in which case the function will
+  // return Status::NotSupported.
+  static Status OpenAsSecondary(const Options& options,
+                                const std::string& name,
+                                const std::string& secondary_path,
+                                DB** dbptr);
+
+  // Open the database as a secondary instance with column families. As with
+  // OpenForReadOnly(), a subset of the column families may be opened.
+  //
+  // Not supported in ROCKSDB_LITE, in which case the function will
+  // return Status::NotSupported.
+  static Status OpenAsSecondary(
+      const DBOptions& db_options, const std::string& name,
+      const std::string& secondary_path,
+      const std::vector<ColumnFamilyDescriptor>& column_families,
+      std::vector<ColumnFamilyHandle*>* handles, DB** dbptr);
+
   // Open DB with column families.
   // db_options specify database specific options
   // column_families is the vector of all column families in the database,
@@ -221,6 +251,29 @@ class DB {
     return Get(options, DefaultColumnFamily(), key, value);
   }
 
+  // Same as above, but *value may refer to the data block or memory the
+  // value was found in instead of holding a copy. That storage is pinned
+  // (e.g. a block cache handle is held) until *value is destroyed or
+  // Reset(), which must happen before the DB is closed. Anything *value
+  // referred to before the call is released.
+  //
+  // The default implementation copies the value.
+  virtual Status Get(const ReadOptions& options,
+                     ColumnFamilyHandle* column_family, const Slice& key,
+                     PinnableSlice* value) {
+    assert(value != nullptr);
+    value->Reset();
+    Status s = Get(options, column_family, key, value->GetSelf());
+    if (s.ok()) {
+      value->PinSelf();
+    }
+    return s;
+  }
+  virtual Status Get(const ReadOptions& options, const Slice& key,
+                     PinnableSlice* value) {
+    return Get(options, DefaultColumnFamily(), key, value);
+  }
+
   // If keys[i] does not exist in the database, then the i'th returned
   // status will be one for which Status::IsNotFound() is true, and
   // (*values)[i] will be set to some arbitrary value (often ""). Otherwise,
@@ -243,6 +296,56 @@ class DB {
                     keys, values);
   }
 
+  // Same as above, but values must point to an array of keys.size()
+  // PinnableSlices, which are filled like Get() with a PinnableSlice does.
+  //
+  // The default implementation calls Get() for every key.
+  virtual std::vector<Status> MultiGet(
+      const ReadOptions& options,
+      const std::vector<ColumnFamilyHandle*>& column_family,
+      const std::vector<Slice>& keys, PinnableSlice* values) {
+    std::vector<Status> statuses(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+      statuses[i] = Get(options, column_family[i], keys[i], &values[i]);
+    }
+    return statuses;
+  }
+  virtual std::vector<Status> MultiGet(const ReadOptions& options,
+                                       const std::vector<Slice>& keys,
+                                       PinnableSlice* values) {
+    return MultiGet(options, std::vector<ColumnFamilyHandle*>(
+                                 keys.size(), DefaultColumnFamily()),
+                    keys, values);
+  }
+
+  // Look up the merge operands of key without merging them. On success,
+  // *num_operands is set to their number and merge_operands[0] to
+  // merge_operands[*num_operands - 1] refer to them, oldest first. If the
+  // key has a value that the operands apply to, or no operands at all, that
+  // value is returned as the oldest operand. merge_operands must point to
+  // an array of max_operands PinnableSlices. Operands found in block based
+  // tables are not copied; like Get() with a PinnableSlice, their data
+  // blocks stay pinned until the PinnableSlices are reset or destroyed.
+  //
+  // Returns NotFound if the key does not exist, and Incomplete if the
+  // lookup stopped after finding max_operands operands, in which case
+  // merge_operands holds the newest max_operands ones and older ones may
+  // exist.
+  virtual Status GetMergeOperands(const ReadOptions& options,
+                                  ColumnFamilyHandle* column_family,
+                                  const Slice& key,
+                                  PinnableSlice* merge_operands,
+                                  int max_operands, int* num_operands) {
+    return Status::NotSupported("GetMergeOperands() not supported");
+  }
+  virtual Status GetMergeOperands(const ReadOptions& options,
+                                  const Slice& key,
+                                  PinnableSlice* merge_operands,
+                                  int max_operands, int* num_operands) {
+    return GetMergeOperands(options, DefaultColumnFamily(), key,
+                            merge_operands, max_operands, num_operands);
+  }
+
   // If the key definitely does not exist in the database, then this method
   // returns false, else true. If the caller wants to obtain value when the key
   // is found in memory, a bool for 'value_found' must be passed. 'value_found'
@@ -282,6 +385,38 @@ class DB {
       const std::vector<ColumnFamilyHandle*>& column_families,
       std::vector<Iterator*>* iterators) = 0;
 
+  // Receives the entries of one partition of ParallelScan(). Returning false
+  // stops the scan of that partition.
+  typedef std::function<bool(int partition, const Slice& key,
+                             const Slice& value)> ScanCallback;
+
+  // Scan the keys in [*begin, *end) with up to num_partitions iterators
+  // that run in parallel: the calling thread scans partitions, helped by
+  // jobs in the LOW priority thread pool of the DB's Env, which it shares
+  // with compactions. begin==nullptr is treated as a key before all keys
+  // and end==nullptr as a key after all keys. The range is split at
+  // table file boundaries and at keys sampled from table indexes, so that
+  // the partitions hold about the same amount of data, and every partition
+  // reads from the same snapshot: options.snapshot, or one taken by the
+  // call. callback is invoked for each entry with the number of its
+  // partition, in key order within a partition, and concurrently from
+  // several threads for different partitions. Partition i only holds keys
+  // smaller than those of partition i + 1. The iterate bounds of options
+  // are not used. Returns the first error any partition ran into.
+  virtual Status ParallelScan(const ReadOptions& options,
+                              ColumnFamilyHandle* column_family,
+                              const Slice* begin, const Slice* end,
+                              int num_partitions,
+                              const ScanCallback& callback) {
+    return Status::NotSupported("ParallelScan() not supported");
+  }
+  virtual Status ParallelScan(const ReadOptions& options, const Slice* begin,
+                              const Slice* end, int num_partitions,
+                              const ScanCallback& callback) {
+    return ParallelScan(options, DefaultColumnFamily(), begin, end,
+                        num_partitions, callback);
+  }
+
   // Return a handle to the current DB state.  Iterators created with
   // this handle will all observe a stable snapshot of the current DB
   // state.  The caller must call ReleaseSnapshot(result) when the
@@ -562,6 +697,13 @@ class DB {
   // Returns default column family handle
   virtual ColumnFamilyHandle* DefaultColumnFamily() const = 0;
 
+  // For a secondary instance, apply the changes the primary has made to its
+  // MANIFEST and WAL files since the last call, so that reads started after
+  // this returns see them. Other instances return Status::NotSupported.
+  virtual Status TryCatchUpWithPrimary() {
+    return Status::NotSupported("TryCatchUpWithPrimary() not supported");
+  }
+
 #ifndef ROCKSDB_LITE
   virtual Status GetPropertiesOfAllTables(ColumnFamilyHandle* column_family,
                                           TablePropertiesCollection* props) = 0;
@@ -62,6 +62,14 @@ struct EnvOptions {
    // If true, then use mmap to write data
   bool use_mmap_writes = true;
 
+  // If true, then open files with O_DIRECT for reading. Takes precedence
+  // over use_mmap_reads.
+  bool use_direct_reads = false;
+
+  // If true, then open files with O_DIRECT for writing. Takes precedence
+  // over use_mmap_writes.
+  bool use_direct_writes = false;
+
   // If true, set the FD_CLOEXEC on open fd.
   bool set_fd_cloexec = true;
 
@@ -304,6 +312,18 @@ class Env {
   // files. Default implementation returns the copy of the same object.
   virtual EnvOptions OptimizeForManifestWrite(const EnvOptions& env_options)
       const;
+  // OptimizeForCompactionTableWrite will create a new EnvOptions object that
+  // is a copy of the EnvOptions in the parameters, but is optimized for
+  // writing the table files of flushes and compactions. Default
+  // implementation applies use_direct_io_for_flush_and_compaction.
+  virtual EnvOptions OptimizeForCompactionTableWrite(
+      const EnvOptions& env_options, const DBOptions& db_options) const;
+  // OptimizeForCompactionTableRead will create a new EnvOptions object that
+  // is a copy of the EnvOptions in the parameters, but is optimized for
+  // reading the input files of compactions. Default implementation applies
+  // use_direct_io_for_flush_and_compaction.
+  virtual EnvOptions OptimizeForCompactionTableRead(
+      const EnvOptions& env_options, const DBOptions& db_options) const;
 
   // Returns the status of all threads that belong to the current Env.
   virtual Status GetThreadList(std::vector<ThreadStatus>* thread_list) {
@@ -114,6 +114,18 @@ class FilterPolicy {
 // is 10, which yields a filter with ~ 1% false positive rate.
 // use_block_based_builder: use block based filter rather than full fiter.
 // If you want to builder full filter, it needs to be set to false.
+// full_filter_format_version: format of the full filters that are built.
+//   0 -- the original format, readable by all versions of RocksDB that
+//   support full filters.
+//   1 -- all probes for a key fall into one 64-byte cache line and keys are
+//   hashed with a 64-bit hash, so a lookup costs at most one cache miss.
+//   Confining the probes to a line makes the false positive rate higher
+//   than that of a standard bloom filter with the same bits_per_key, and
+//   more so the larger bits_per_key is: about 0.9% instead of 0.8% at 10,
+//   and 0.08% instead of 0.05% at 16. One more bit per key makes up for it.
+//   Filters of this format can only be read by this and later versions of
+//   RocksDB. Full filters of all formats can be read regardless of this
+//   setting.
 //
 // Callers must delete the result after any database that is using the
 // result has been closed.
@@ -126,7 +138,7 @@ class FilterPolicy {
 // FilterPolicy (like NewBloomFilterPolicy) that does not ignore
 // trailing spaces in keys.
 extern const FilterPolicy* NewBloomFilterPolicy(int bits_per_key,
-    bool use_block_based_builder = true);
+    bool use_block_based_builder = true, int full_filter_format_version = 0);
 }
 
 #endif  // STORAGE_ROCKSDB_INCLUDE_FILTER_POLICY_H_
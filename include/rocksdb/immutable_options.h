@@ -64,6 +64,8 @@ struct ImmutableCFOptions {
 
   TableFactory* table_factory;
 
+  std::vector<TableFactory*> table_factory_per_level;
+
   Options::TablePropertiesCollectorFactories
     table_properties_collector_factories;
 
@@ -91,10 +93,16 @@ struct ImmutableCFOptions {
 
   Options::AccessHint access_hint_on_compaction_start;
 
+  size_t compaction_readahead_size;
+
   int num_levels;
 
   bool optimize_filters_for_hits;
 
+  uint64_t min_blob_size;
+
+  double blob_gc_discard_ratio;
+
 #ifndef ROCKSDB_LITE
   // A vector of EventListeners which call-back functions will be called
   // when specific RocksDB event happens.
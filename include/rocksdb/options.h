@@ -52,7 +52,8 @@ enum CompressionType : char {
   // NOTE: do not change the values of existing entries, as these are
   // part of the persistent format on disk.
   kNoCompression = 0x0, kSnappyCompression = 0x1, kZlibCompression = 0x2,
-  kBZip2Compression = 0x3, kLZ4Compression = 0x4, kLZ4HCCompression = 0x5
+  kBZip2Compression = 0x3, kLZ4Compression = 0x4, kLZ4HCCompression = 0x5,
+  kZSTD = 0x7
 };
 
 enum CompactionStyle : char {
@@ -84,9 +85,35 @@ struct CompressionOptions {
   int window_bits;
   int level;
   int strategy;
-  CompressionOptions() : window_bits(-14), level(-1), strategy(0) {}
-  CompressionOptions(int wbits, int _lev, int _strategy)
-      : window_bits(wbits), level(_lev), strategy(_strategy) {}
+  // Maximum size of the dictionary that kZlibCompression and kZSTD share
+  // between the data blocks of a block based table file. The dictionary is
+  // made of samples of the first data blocks of the file, which are held in
+  // memory until it is built, and is stored in the file. With kZSTD it is
+  // trained from the samples. Helps most with small blocks of similar data.
+  // Files written with a dictionary cannot be read by older versions.
+  // Default: 0, no dictionary
+  uint32_t max_dict_bytes;
+  // Number of threads that compress the data blocks of each block based
+  // table file being written. With more than one, full data blocks are
+  // handed to that many worker threads, and the thread building the file
+  // writes them out in order once they are compressed. The file contents
+  // are the same as with a single thread.
+  // Default: 1, data blocks are compressed by the thread building the file
+  uint32_t parallel_threads;
+  CompressionOptions()
+      : window_bits(-14),
+        level(-1),
+        strategy(0),
+        max_dict_bytes(0),
+        parallel_threads(1) {}
+  CompressionOptions(int wbits, int _lev, int _strategy,
+                     uint32_t _max_dict_bytes = 0,
+                     uint32_t _parallel_threads = 1)
+      : window_bits(wbits),
+        level(_lev),
+        strategy(_strategy),
+        max_dict_bytes(_max_dict_bytes),
+        parallel_threads(_parallel_threads) {}
 };
 
 enum UpdateStatus {    // Return status For inplace update callback
@@ -551,6 +578,31 @@ struct ColumnFamilyOptions {
   // BlockBasedTableOptions.
   std::shared_ptr<TableFactory> table_factory;
 
+  // Different table factories for different levels. If not empty,
+  // table_factory_per_level[i] writes the files that flushes and compactions
+  // put to level i, and the last entry the files of all levels beyond the
+  // end of the vector. A nullptr entry stands for table_factory. Flushes
+  // always use the entry of level 0. A file is never moved to a level of
+  // another format without being rewritten.
+  //
+  // Files are read with the factory of their format, found by the magic
+  // number of the file: the factory of this vector or table_factory whose
+  // Name() is that of the format, or else table_factory. So a level can
+  // switch formats, and the files written before keep being readable.
+  //
+  // This allows for example a CuckooTableFactory for the last level, with
+  // O(1) point lookups, and block based tables above it:
+  //   options.table_factory_per_level.resize(options.num_levels);
+  //   options.table_factory_per_level.back().reset(NewCuckooTableFactory());
+  // The format of a level has to support every entry written to it, or the
+  // compactions into the level fail. Cuckoo tables need keys of one size and
+  // values of one size, no merge operands and no more than one entry per
+  // user key, i.e. no snapshots while compacting into the level. Cuckoo and
+  // plain tables can only be read with allow_mmap_reads.
+  //
+  // Default: empty
+  std::vector<std::shared_ptr<TableFactory>> table_factory_per_level;
+
   // Block-based table related options are moved to BlockBasedTableOptions.
   // Related options that were originally here but now moved include:
   //   no_block_cache
@@ -674,6 +726,19 @@ struct ColumnFamilyOptions {
   // Dynamically changeable through SetOptions() API
   size_t max_successive_merges;
 
+  // When a Get() merges at least this many merge operands, the result is
+  // written back to the active memtable as a regular value, so that later
+  // reads of the key do not repeat the merge until compaction collapses the
+  // operands. The value is added at the sequence number of the read, and
+  // only if that keeps every newer update of the key visible; otherwise it
+  // is not written back. It is not written to the WAL, since it can always
+  // be computed again from the operands.
+  //
+  // Default: 0 (disabled)
+  //
+  // Dynamically changeable through SetOptions() API
+  size_t merge_write_back_threshold;
+
   // The number of partial merge operands to accumulate before partial
   // merge will be performed. Partial merge will not be called
   // if the list of values to merge is less than min_partial_merge_operands.
@@ -699,6 +764,29 @@ struct ColumnFamilyOptions {
   // Default: false
   bool optimize_filters_for_hits;
 
+  // If non-zero, flushes and compactions write every value of at least this
+  // many bytes to a blob file, and the table files store only a small
+  // reference to it. Compactions then no longer rewrite large values when
+  // they reorder the keys, which reduces write amplification at the cost of
+  // an extra read for each large value that is looked up.
+  //
+  // A DB that has written blob files cannot be opened by a version of RocksDB
+  // without blob file support, even after this option is turned off.
+  //
+  // Default: 0 (values are always stored in the table files)
+  uint64_t min_blob_size;
+
+  // When a compaction comes across a reference into a blob file in which at
+  // least this fraction of the blob bytes is no longer referenced by any
+  // table, it copies the blob to the blob file of the compaction. Once all
+  // blobs of a file are copied or dropped, the file is deleted.
+  //
+  // Setting this to a value > 1 turns off this garbage collection; blob files
+  // are then only deleted once compactions drop all keys that refer to them.
+  //
+  // Default: 0.5
+  double blob_gc_discard_ratio;
+
 #ifndef ROCKSDB_LITE
   // A vector of EventListeners which call-back functions will be called
   // when specific RocksDB event happens.
@@ -937,6 +1025,27 @@ struct DBOptions {
   // Allow the OS to mmap file for writing. Default: false
   bool allow_mmap_writes;
 
+  // Open table files with O_DIRECT for user reads (Get, MultiGet and
+  // iterators), bypassing the OS page cache. Blocks are read with aligned
+  // reads and then copied into the block buffers, so the block cache should
+  // be sized to hold the working set. Takes precedence over
+  // allow_mmap_reads for those files.
+  // Default: false
+  bool use_direct_reads;
+
+  // Use O_DIRECT for the table files written by flushes and compactions and
+  // for the input files read by compactions, so that they do not evict the
+  // pages of user reads from the OS page cache. Compaction inputs are then
+  // read through a table reader of their own, see
+  // compaction_readahead_size, which should be set as well to keep the
+  // reads large. Takes precedence over allow_mmap_writes for those files.
+  // Table files are written in 1MB chunks, and each file that reaches that
+  // size gets a thread of its own that writes one chunk while the flush or
+  // compaction fills the next. Starting the thread costs little next to
+  // writing the file.
+  // Default: false
+  bool use_direct_io_for_flush_and_compaction;
+
   // Disable child process inherit open files. Default: true
   bool is_fd_close_on_exec;
 
@@ -975,6 +1084,19 @@ struct DBOptions {
   };
   AccessHint access_hint_on_compaction_start;
 
+  // If non-zero, a compaction reads each of its input files through a table
+  // reader of its own instead of the one in the table cache. That reader
+  // opens a separate file handle and reads the file sequentially in chunks
+  // of this many bytes, so that compaction issues few large reads. This
+  // helps on spinning disks and other storage with a high cost per read.
+  // The blocks it reads are not added to the block cache. With
+  // allow_mmap_reads the file is not read in chunks, as it is already
+  // mapped into memory.
+  // Recommended: 2MB or more.
+  //
+  // Default: 0
+  size_t compaction_readahead_size;
+
   // Use adaptive mutex, which spins in the user space before resorting
   // to kernel. This could reduce context switch when the mutex is not
   // heavily contended. However, if the mutex is hot, we could end up
@@ -1090,12 +1212,23 @@ struct ReadOptions {
   // not a valid entry.  If iterator_extractor is not null, the Seek target
   // and iterator_upper_bound need to have the same prefix.
   // This is because ordering is not guaranteed outside of prefix domain.
-  // There is no lower bound on the iterator. If needed, that can be easily
-  // implemented
+  // SeekToLast() positions the iterator at the last entry before the bound.
+  // Table files and data blocks that only hold keys at or past the bound
+  // are skipped without being read.
   //
   // Default: nullptr
   const Slice* iterate_upper_bound;
 
+  // "iterate_lower_bound" defines the smallest key the iterator can return.
+  // Once the backward iterator passes the bound, Valid() will be false.
+  // The bound is inclusive. Seek() to a smaller target and SeekToFirst()
+  // position the iterator at the first entry at or after the bound. Table
+  // files and data blocks that only hold keys before the bound are skipped
+  // without being read.
+  //
+  // Default: nullptr
+  const Slice* iterate_lower_bound;
+
   // Specify if this read request should process data that ALREADY
   // resides on a particular cache. If the required data is not
   // found at the specified cache, then Status::Incomplete is returned.
@@ -1122,6 +1255,33 @@ struct ReadOptions {
   // this option.
   bool total_order_seek;
 
+  // Keep the blocks loaded by an iterator pinned in memory until the
+  // iterator is deleted, instead of releasing each one when the iterator
+  // moves past it. Keys are then not copied out of blocks where they are
+  // stored without delta encoding, so the slice returned by key() stays
+  // valid for the lifetime of the iterator whenever Iterator::IsKeyPinned()
+  // returns true. With BlockBasedTableOptions::use_delta_encoding = false
+  // that holds for every key of a block based table. Memory usage grows
+  // with the amount of data the iterator has read.
+  // Default: false
+  bool pin_data;
+
+  // If non-zero, the time in microseconds, as returned by Env::NowMicros(),
+  // after which the read gives up and returns Status::TimedOut. It is
+  // checked before each table file Get() looks up and before each block
+  // read from a file, so an expired read does not start any more I/O. An
+  // iterator that hits the deadline stops at the first block it could not
+  // read and becomes invalid, with status() returning Status::TimedOut; it
+  // never skips such a block.
+  // Default: 0
+  uint64_t deadline;
+
+  // If non-zero, a block read from a file that takes longer than this many
+  // microseconds fails with Status::TimedOut, like an I/O error. A read
+  // that is already in progress is not interrupted.
+  // Default: 0
+  uint64_t io_timeout;
+
   ReadOptions();
   ReadOptions(bool cksum, bool cache);
 };
@@ -0,0 +1,72 @@
+// Copyright (c) 2013, Facebook, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+// A PersistentCache is a secondary, file-backed cache tier for table blocks.
+// It is meant to live on a device that is faster than the one holding the
+// database (e.g. a local SSD in front of network attached storage) and to
+// hold blocks that do not fit into the in-memory block cache.
+//
+// BlockBasedTable consults the persistent cache after a miss in the block
+// cache and before reading the block from the table file. Blocks are
+// admitted to the persistent cache when they are evicted from the block
+// cache.
+
+#ifndef STORAGE_ROCKSDB_INCLUDE_PERSISTENT_CACHE_H_
+#define STORAGE_ROCKSDB_INCLUDE_PERSISTENT_CACHE_H_
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+
+#include "rocksdb/slice.h"
+#include "rocksdb/status.h"
+
+namespace rocksdb {
+
+class Env;
+class Logger;
+
+class PersistentCache {
+ public:
+  virtual ~PersistentCache() {}
+
+  // Insert a mapping from key->data. Inserting a key that is already
+  // present is a no-op. May return a non-OK status without inserting, e.g.
+  // when the cache cannot keep up with the inserts.
+  virtual Status Insert(const Slice& key, const char* data,
+                        const size_t size) = 0;
+
+  // If the cache has a mapping for "key", fill *data and *size with a
+  // copy of it and return OK. Return NotFound otherwise.
+  virtual Status Lookup(const Slice& key, std::unique_ptr<char[]>* data,
+                        size_t* size) = 0;
+
+  // Returns the maximum configured capacity of the cache, in bytes.
+  virtual uint64_t GetCapacity() const = 0;
+
+  // Returns the number of bytes of the cache files currently in use.
+  virtual uint64_t GetUsage() const = 0;
+};
+
+// Create a persistent cache that stores up to "size" bytes of blocks in
+// files under the directory "path", creating it if missing.
+//
+// Insert() queues the block in memory and a job in env's LOW priority
+// thread pool appends it to a sequence of cache files together with a
+// checksum; inserts are dropped while several MB are queued. A cache file
+// is synced once it is full and when the cache is closed. When the
+// capacity is exceeded the oldest file is dropped as a whole. The index is rebuilt from the cache files when the cache is
+// opened, so a cache that was written by a previous process is reused,
+// and records torn by a crash are detected by their checksum and skipped.
+//
+// "path" must not be shared by two open caches at the same time.
+extern Status NewPersistentCache(Env* env, const std::string& path,
+                                 uint64_t size,
+                                 const std::shared_ptr<Logger>& info_log,
+                                 std::shared_ptr<PersistentCache>* cache);
+
+}  // namespace rocksdb
+
+#endif  // STORAGE_ROCKSDB_INCLUDE_PERSISTENT_CACHE_H_
@@ -24,6 +24,8 @@
 #include <string.h>
 #include <string>
 
+#include "rocksdb/cleanable.h"
+
 namespace rocksdb {
 
 class Slice {
@@ -102,6 +104,70 @@ class Slice {
   // Intentionally copyable
 };
 
+// A Slice that can keep the storage it refers to alive. DB::Get() either
+// points it into a block that stays pinned (e.g. in the block cache) until
+// the PinnableSlice is destroyed or Reset(), or copies the value into a
+// buffer owned by the PinnableSlice.
+class PinnableSlice : public Slice, public Cleanable {
+ public:
+  PinnableSlice() : buf_(&self_space_), pinned_(false) {}
+  // Use "buf" instead of an internal buffer when the value is copied.
+  explicit PinnableSlice(std::string* buf) : buf_(buf), pinned_(false) {}
+
+  // Refer to "s", whose storage stays valid until "release" is called with
+  // arg1 and arg2.
+  inline void PinSlice(const Slice& s, CleanupFunction release, void* arg1,
+                       void* arg2) {
+    assert(!pinned_);
+    pinned_ = true;
+    data_ = s.data();
+    size_ = s.size();
+    RegisterCleanup(release, arg1, arg2);
+  }
+
+  // Refer to "s", whose storage stays valid until the cleanups of
+  // "cleanable" run. They are moved to this PinnableSlice.
+  inline void PinSlice(const Slice& s, Cleanable* cleanable) {
+    assert(!pinned_);
+    pinned_ = true;
+    data_ = s.data();
+    size_ = s.size();
+    cleanable->DelegateCleanupsTo(this);
+  }
+
+  // Copy "s" into the own buffer and refer to it.
+  inline void PinSelf(const Slice& s) {
+    assert(!pinned_);
+    buf_->assign(s.data(), s.size());
+    data_ = buf_->data();
+    size_ = buf_->size();
+  }
+
+  // Refer to the own buffer after it was filled through GetSelf().
+  inline void PinSelf() {
+    assert(!pinned_);
+    data_ = buf_->data();
+    size_ = buf_->size();
+  }
+
+  // Release whatever is pinned and refer to an empty slice.
+  void Reset() {
+    Cleanable::Reset();
+    pinned_ = false;
+    clear();
+  }
+
+  inline std::string* GetSelf() { return buf_; }
+
+  // True iff this refers to storage other than its own buffer.
+  inline bool IsPinned() const { return pinned_; }
+
+ private:
+  std::string self_space_;
+  std::string* buf_;
+  bool pinned_;
+};
+
 // A set of Slices that are virtually concatenated together.  'parts' points
 // to an array of Slices.  The number of elements in the array is 'num_parts'.
 struct SliceParts {
@@ -139,6 +139,11 @@ enum Tickers : uint32_t {
   NUMBER_SUPERVERSION_RELEASES,
   NUMBER_SUPERVERSION_CLEANUPS,
   NUMBER_BLOCK_NOT_COMPRESSED,
+  // # of times data blocks were found / not found in the persistent cache.
+  PERSISTENT_CACHE_HIT,
+  PERSISTENT_CACHE_MISS,
+  // # of merge results written back to the memtable by Get().
+  NUMBER_MERGE_WRITE_BACKS,
   TICKER_ENUM_MAX
 };
 
@@ -205,6 +210,9 @@ const std::vector<std::pair<Tickers, std::string>> TickersNameMap = {
     {NUMBER_SUPERVERSION_RELEASES, "rocksdb.number.superversion_releases"},
     {NUMBER_SUPERVERSION_CLEANUPS, "rocksdb.number.superversion_cleanups"},
     {NUMBER_BLOCK_NOT_COMPRESSED, "rocksdb.number.block.not_compressed"},
+    {PERSISTENT_CACHE_HIT, "rocksdb.persistent.cache.hit"},
+    {PERSISTENT_CACHE_MISS, "rocksdb.persistent.cache.miss"},
+    {NUMBER_MERGE_WRITE_BACKS, "rocksdb.number.merge.write.backs"},
 };
 
 /**
@@ -30,6 +30,7 @@ namespace rocksdb {
 
 // -- Block-based Table
 class FlushBlockPolicyFactory;
+class PersistentCache;
 class RandomAccessFile;
 class TableBuilder;
 class TableReader;
@@ -71,6 +72,16 @@ struct BlockBasedTableOptions {
     // The hash index, if enabled, will do the hash lookup when
     // `Options.prefix_extractor` is provided.
     kHashSearch,
+
+    // The binary search index, plus a small piecewise linear model of the
+    // position of each key in it, so that seeks only binary search the few
+    // index entries around the predicted one. Pays off for keys of a fixed,
+    // smooth distribution (e.g. dense integers), and falls back to binary
+    // search over the whole index for keys the model does not bound.
+    // Requires the bytewise comparator; with any other this is plain
+    // kBinarySearch. Files written with this index type cannot be read by
+    // older versions of RocksDB.
+    kLearnedSearch,
   };
 
   IndexType index_type = kBinarySearch;
@@ -81,6 +92,26 @@ struct BlockBasedTableOptions {
   // (less memory consumption)
   bool hash_index_allow_collision = true;
 
+  // The search structure of data blocks.
+  enum DataBlockIndexType : char {
+    // Binary search over the restart points of the block.
+    kDataBlockBinarySearch,
+
+    // In addition, a hash index from user key to restart point is appended
+    // to each data block, so that point lookups (Get) need no binary search
+    // in most cases. Requires that user keys that the comparator finds equal
+    // are equal bytewise. Files written with this index type cannot be read
+    // by older versions of RocksDB.
+    kDataBlockBinaryAndHash,
+  };
+
+  DataBlockIndexType data_block_index_type = kDataBlockBinarySearch;
+
+  // Number of keys per bucket of the data block hash index. Smaller values
+  // use more space and cause fewer hash collisions, which fall back to
+  // binary search. Only used by kDataBlockBinaryAndHash.
+  double data_block_hash_table_util_ratio = 0.75;
+
   // Use the specified checksum type. Newly created table files will be
   // protected with this checksum type. Old table files will still be readable,
   // even though they have different checksum type.
@@ -99,6 +130,12 @@ struct BlockBasedTableOptions {
   // If NULL, rocksdb will not use a compressed block cache.
   std::shared_ptr<Cache> block_cache_compressed = nullptr;
 
+  // If non-NULL use the specified persistent cache as a second tier behind
+  // block_cache. Data blocks evicted from block_cache are written to it, and
+  // block_cache misses are served from it before going to the table file.
+  // Requires block_cache. See include/rocksdb/persistent_cache.h.
+  std::shared_ptr<PersistentCache> persistent_cache = nullptr;
+
   // Approximate size of user data packed per block.  Note that the
   // block size specified here corresponds to uncompressed data.  The
   // actual size of the unit read from disk may be smaller if
@@ -117,6 +154,27 @@ struct BlockBasedTableOptions {
   // leave this parameter alone.
   int block_restart_interval = 16;
 
+  // Delta encode keys within a restart interval of a data block. When false,
+  // every key is stored in full, which makes data blocks larger but lets
+  // iterators created with ReadOptions::pin_data return keys that point
+  // into the block instead of copying them.
+  bool use_delta_encoding = true;
+
+  // Number of index entries between restart points of the index block. The
+  // keys of the index entries within a restart interval are delta encoded,
+  // and with format_version >= 3 so are their block handles. Larger values
+  // make index blocks smaller at the cost of a longer linear search within
+  // the restart interval on seeks. Ignored by kHashSearch and
+  // kLearnedSearch, whose indexes always use 1.
+  int index_block_restart_interval = 1;
+
+  // Once an iterator reads data blocks sequentially, it reads ahead of the
+  // block it needs, starting with 8KB and doubling the readahead on every
+  // read up to this size. Set it to 0 to disable this readahead. Iterators
+  // of compactions and tables opened with allow_mmap_reads never read ahead
+  // by themselves; compactions use Options::compaction_readahead_size.
+  size_t max_auto_readahead_size = 256 * 1024;
+
   // If non-nullptr, use the specified filter policy to reduce disk reads.
   // Many applications will benefit from passing the result of
   // NewBloomFilterPolicy() here.
@@ -138,6 +196,12 @@ struct BlockBasedTableOptions {
   // encode compressed blocks with LZ4, BZip2 and Zlib compression. If you
   // don't plan to run RocksDB before version 3.10, you should probably use
   // this.
+  // 3 -- Can be read by RocksDB's versions since 3.11. Only the size of the
+  // block handles of index entries that are not at a restart point is
+  // stored, their offset follows from the previous entry. In addition, if
+  // no user key spans two data blocks, the index keys of the binary search
+  // index are stored without their sequence number. Together with
+  // index_block_restart_interval > 1 this makes index blocks much smaller.
   // This option only affects newly written tables. When reading exising tables,
   // the information about version is read from the footer.
   uint32_t format_version = 0;
@@ -151,6 +215,8 @@ struct BlockBasedTablePropertyNames {
   static const std::string kWholeKeyFiltering;
   // value is "1" for true and "0" for false.
   static const std::string kPrefixFiltering;
+  // value is "1" if the index keys are user keys, without sequence number
+  static const std::string kIndexKeyIsUserKey;
 };
 
 // Create default block based table factory.
@@ -236,6 +302,18 @@ struct PlainTableOptions {
   //                       file building and store it in file. When reading
   //                       file, index will be mmaped instead of recomputation.
   bool store_index_in_file = false;
+
+  // @total_order_index: with a prefix extractor and encoding type kPlain,
+  //                     also keep a sorted index over the offsets of every
+  //                     index_sparseness-th row of the file, so that
+  //                     iterators created with ReadOptions::total_order_seek
+  //                     can seek by a binary search over the index followed
+  //                     by a scan of at most index_sparseness rows. Without
+  //                     it, such iterators are not supported. It is stored
+  //                     in the file if store_index_in_file is true. Tables
+  //                     built without a prefix extractor always use such an
+  //                     index.
+  bool total_order_index = false;
 };
 
 // -- Plain Table with prefix-only seek
@@ -96,6 +96,16 @@ class StackableDB : public DB {
     return db_->NewIterators(options, column_families, iterators);
   }
 
+  using DB::ParallelScan;
+  virtual Status ParallelScan(const ReadOptions& options,
+                              ColumnFamilyHandle* column_family,
+                              const Slice* begin, const Slice* end,
+                              int num_partitions,
+                              const ScanCallback& callback) override {
+    return db_->ParallelScan(options, column_family, begin, end,
+                             num_partitions, callback);
+  }
+
 
   virtual const Snapshot* GetSnapshot() override {
     return db_->GetSnapshot();
@@ -221,6 +231,10 @@ class StackableDB : public DB {
     return db_->DeleteFile(name);
   }
 
+  virtual Status TryCatchUpWithPrimary() override {
+    return db_->TryCatchUpWithPrimary();
+  }
+
   virtual Status GetDbIdentity(std::string& identity) override {
     return db_->GetDbIdentity(identity);
   }
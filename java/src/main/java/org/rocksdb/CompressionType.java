@@ -20,7 +20,8 @@ public enum CompressionType {
   ZLIB_COMPRESSION((byte) 2, "z"),
   BZLIB2_COMPRESSION((byte) 3, "bzip2"),
   LZ4_COMPRESSION((byte) 4, "lz4"),
-  LZ4HC_COMPRESSION((byte) 5, "lz4hc");
+  LZ4HC_COMPRESSION((byte) 5, "lz4hc"),
+  ZSTD_COMPRESSION((byte) 7, "zstd");
 
   /**
    * <p>Get the CompressionType enumeration value by
@@ -124,7 +124,9 @@ public enum TickerType {
   NUMBER_SUPERVERSION_RELEASES(56),
   NUMBER_SUPERVERSION_CLEANUPS(57),
   NUMBER_BLOCK_NOT_COMPRESSED(58),
-  TICKER_ENUM_MAX(59);
+  PERSISTENT_CACHE_HIT(59),
+  PERSISTENT_CACHE_MISS(60),
+  TICKER_ENUM_MAX(61);
 
   private final int value_;
 
@@ -67,6 +67,10 @@
 #define fdatasync fsync
 #endif
 
+// printf() length modifier and conversion for size_t, e.g.
+// printf("%" ROCKSDB_PRIszt "\n", sizeof(x));
+#define ROCKSDB_PRIszt "zu"
+
 namespace rocksdb {
 namespace port {
 
@@ -1,5 +1,6 @@
 # These are the sources from which librocksdb.a is built:
 LIB_SOURCES =                                                   \
+  db/blob_file.cc                                               \
   db/builder.cc                                                 \
   db/c.cc                                                       \
   db/column_family.cc                                           \
@@ -11,6 +12,7 @@ LIB_SOURCES =                                                   \
   db/db_impl.cc                                                 \
   db/db_impl_debug.cc                                           \
   db/db_impl_readonly.cc                                        \
+  db/db_impl_secondary.cc                                       \
   db/db_iter.cc                                                 \
   db/file_indexer.cc                                            \
   db/filename.cc                                                \
@@ -47,11 +49,13 @@ LIB_SOURCES =                                                   \
   table/block_builder.cc                                        \
   table/block.cc                                                \
   table/block_hash_index.cc                                     \
+  table/block_learned_index.cc                                  \
   table/block_prefix_index.cc                                   \
   table/bloom_block.cc                                          \
   table/cuckoo_table_builder.cc                                 \
   table/cuckoo_table_factory.cc                                 \
   table/cuckoo_table_reader.cc                                  \
+  table/data_block_hash_index.cc                                \
   table/flush_block_policy.cc                                   \
   table/format.cc                                               \
   table/full_filter_block.cc                                    \
@@ -71,6 +75,7 @@ LIB_SOURCES =                                                   \
   util/bloom.cc                                                 \
   util/build_version.cc                                         \
   util/cache.cc                                                 \
+  util/clock_cache.cc                                           \
   util/coding.cc                                                \
   util/comparator.cc                                            \
   util/crc32c.cc                                                \
@@ -117,7 +122,9 @@ LIB_SOURCES =                                                   \
   util/options.cc                                               \
   util/options_helper.cc                                        \
   util/perf_context.cc                                          \
+  util/persistent_cache.cc                                      \
   util/rate_limiter.cc                                          \
+  util/readahead_file.cc                                        \
   util/skiplistrep.cc                                           \
   util/slice.cc                                                 \
   util/sst_dump_tool.cc                                         \
@@ -173,9 +180,11 @@ TEST_BENCH_SOURCES =                                                    \
   db/write_controller_test.cc                                           \
   table/block_based_filter_block_test.cc                                \
   table/block_hash_index_test.cc                                        \
+  table/block_learned_index_test.cc                                     \
   table/block_test.cc                                                   \
   table/cuckoo_table_builder_test.cc                                    \
   table/cuckoo_table_reader_test.cc                                     \
+  table/data_block_hash_index_test.cc                                   \
   table/full_filter_block_test.cc                                       \
   table/merger_test.cc                                                  \
   table/table_reader_bench.cc                                           \
@@ -210,6 +219,7 @@ TEST_BENCH_SOURCES =                                                    \
   util/memenv_test.cc                                                   \
   util/mock_env_test.cc                                                 \
   util/options_test.cc                                                  \
+  util/persistent_cache_test.cc                                         \
   util/rate_limiter_test.cc                                             \
   util/signal_test.cc                                                   \
   util/slice_transform_test.cc                                          \
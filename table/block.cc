@@ -19,6 +19,7 @@
 #include "rocksdb/comparator.h"
 #include "table/format.h"
 #include "table/block_hash_index.h"
+#include "table/block_learned_index.h"
 #include "table/block_prefix_index.h"
 #include "util/coding.h"
 #include "util/logging.h"
@@ -63,6 +64,28 @@ void BlockIter::Next() {
 void BlockIter::Prev() {
   assert(Valid());
 
+  // The entry before current_ is in the same restart interval and was
+  // cached by an earlier call
+  if (prev_entries_idx_ > 0 &&
+      prev_entries_[prev_entries_idx_].offset == current_) {
+    prev_entries_idx_--;
+    const CachedPrevEntry& entry = prev_entries_[prev_entries_idx_];
+    current_ = entry.offset;
+    if (entry.key_ptr != nullptr) {
+      key_.SetKey(Slice(entry.key_ptr, entry.key_size), false /* copy */);
+    } else {
+      key_.SetKey(Slice(prev_entries_keys_buff_.data() + entry.key_offset,
+                        entry.key_size));
+    }
+    value_ = entry.value;
+    if (value_delta_encoded_) {
+      decoded_handle_ = entry.handle;
+      decoded_value_.clear();
+      decoded_handle_.EncodeTo(&decoded_value_);
+    }
+    return;
+  }
+
   // Scan backwards to a restart point before current_
   const uint32_t original = current_;
   while (GetRestartPoint(restart_index_) >= original) {
@@ -75,23 +98,46 @@ void BlockIter::Prev() {
     restart_index_--;
   }
 
+  // Loop until end of current entry hits the start of original entry,
+  // caching the entries on the way for the next calls
+  prev_entries_idx_ = -1;
+  prev_entries_.clear();
+  prev_entries_keys_buff_.clear();
   SeekToRestartPoint(restart_index_);
-  do {
-    // Loop until end of current entry hits the start of original entry
-  } while (ParseNextKey() && NextEntryOffset() < original);
+  while (ParseNextKey()) {
+    Slice current_key = key_.GetKey();
+    if (key_.IsKeyPinned()) {
+      prev_entries_.emplace_back(current_, current_key.data(), 0,
+                                 current_key.size(), value_);
+    } else {
+      prev_entries_.emplace_back(current_, nullptr,
+                                 prev_entries_keys_buff_.size(),
+                                 current_key.size(), value_);
+      prev_entries_keys_buff_.append(current_key.data(), current_key.size());
+    }
+    prev_entries_.back().handle = decoded_handle_;
+    if (NextEntryOffset() >= original) {
+      prev_entries_idx_ = static_cast<int32_t>(prev_entries_.size()) - 1;
+      break;
+    }
+  }
 }
 
 void BlockIter::Seek(const Slice& target) {
   if (data_ == nullptr) {  // Not init yet
     return;
   }
+  Slice seek_key = key_includes_seq_ ? target : ExtractUserKey(target);
   uint32_t index = 0;
   bool ok = false;
   if (prefix_index_) {
     ok = PrefixSeek(target, &index);
+  } else if (hash_index_) {
+    ok = HashSeek(target, &index);
+  } else if (learned_index_) {
+    ok = LearnedSeek(target, seek_key, &index);
   } else {
-    ok = hash_index_ ? HashSeek(target, &index)
-      : BinarySeek(target, 0, num_restarts_ - 1, &index);
+    ok = BinarySeek(seek_key, 0, num_restarts_ - 1, &index);
   }
 
   if (!ok) {
@@ -101,12 +147,67 @@ void BlockIter::Seek(const Slice& target) {
   // Linear search (within restart block) for first key >= target
 
   while (true) {
-    if (!ParseNextKey() || Compare(key_.GetKey(), target) >= 0) {
+    if (!ParseNextKey() || Compare(key_.GetKey(), seek_key) >= 0) {
       return;
     }
   }
 }
 
+bool BlockIter::SeekForGet(const Slice& target,
+                           const Comparator* user_comparator) {
+  if (data_block_hash_index_ == nullptr) {
+    Seek(target);
+    return true;
+  }
+  if (data_ == nullptr) {  // Not init yet
+    return true;
+  }
+  Slice target_user_key = ExtractUserKey(target);
+  uint8_t entry = data_block_hash_index_->Lookup(target_user_key);
+  if (entry == kNoEntry) {
+    // Every user key of the block is in the index. The index entry of this
+    // block sorts before the user key of the first entry of the next block,
+    // so a user key that is not in this block is in no later block either.
+    current_ = restarts_;
+    restart_index_ = num_restarts_;
+    return false;
+  }
+  if (entry == kCollision || entry >= num_restarts_) {
+    Seek(target);
+    return true;
+  }
+
+  // All entries of the user key in this block are in this restart interval,
+  // so the linear search does not need to go past it.
+  SeekToRestartPoint(entry);
+  const uint32_t limit = static_cast<uint32_t>(entry) + 1 < num_restarts_
+                             ? GetRestartPoint(entry + 1)
+                             : restarts_;
+  while (true) {
+    if (!ParseNextKey()) {
+      // End of block or corruption. Older versions of the user key than
+      // the ones before target may follow in the next block.
+      return true;
+    }
+    if (Compare(key_.GetKey(), target) >= 0) {
+      break;
+    }
+    if (limit < restarts_ && NextEntryOffset() >= limit) {
+      current_ = restarts_;
+      restart_index_ = num_restarts_;
+      return false;
+    }
+  }
+  if (user_comparator->Compare(ExtractUserKey(key_.GetKey()),
+                               target_user_key) != 0) {
+    // The entry was a false positive of the hash index
+    current_ = restarts_;
+    restart_index_ = num_restarts_;
+    return false;
+  }
+  return true;
+}
+
 void BlockIter::SeekToFirst() {
   if (data_ == nullptr) {  // Not init yet
     return;
@@ -151,16 +252,48 @@ bool BlockIter::ParseNextKey() {
       CorruptionError();
       return false;
     } else {
-      key_.TrimAppend(shared, p, non_shared);
+      if (shared == 0) {
+        // The whole key is stored in the block, refer to it without copying
+        key_.SetKey(Slice(p, non_shared), false /* copy */);
+      } else {
+        key_.TrimAppend(shared, p, non_shared);
+      }
       value_ = Slice(p + non_shared, value_length);
       while (restart_index_ + 1 < num_restarts_ &&
-             GetRestartPoint(restart_index_ + 1) < current_) {
+             GetRestartPoint(restart_index_ + 1) <= current_) {
         ++restart_index_;
       }
+      if (value_delta_encoded_ &&
+          !DecodeCurrentValue(GetRestartPoint(restart_index_) == current_)) {
+        CorruptionError();
+        return false;
+      }
       return true;
     }
   }
 
+bool BlockIter::DecodeCurrentValue(bool is_restart) {
+  Slice input = value_;
+  if (is_restart) {
+    // The whole handle is stored at restart points
+    if (!decoded_handle_.DecodeFrom(&input).ok()) {
+      return false;
+    }
+  } else {
+    // The entry before is the previous block of the file
+    uint64_t size = 0;
+    if (!GetVarint64(&input, &size)) {
+      return false;
+    }
+    decoded_handle_.set_offset(decoded_handle_.offset() +
+                               decoded_handle_.size() + kBlockTrailerSize);
+    decoded_handle_.set_size(size);
+  }
+  decoded_value_.clear();
+  decoded_handle_.EncodeTo(&decoded_value_);
+  return true;
+}
+
 // Binary search in restart array to find the first restart point
 // with a key >= target (TODO: this comment is inaccurate)
 bool BlockIter::BinarySeek(const Slice& target, uint32_t left, uint32_t right,
@@ -292,9 +425,34 @@ bool BlockIter::PrefixSeek(const Slice& target, uint32_t* index) {
   }
 }
 
+// Binary search only the restart points that the learned index predicts for
+// target if the keys around them confirm that the one to seek from is among
+// them, and all of them otherwise.
+bool BlockIter::LearnedSeek(const Slice& target, const Slice& seek_key,
+                            uint32_t* index) {
+  assert(learned_index_);
+  uint32_t left = 0;
+  uint32_t right = num_restarts_ - 1;
+  uint32_t predicted_left, predicted_right;
+  if (learned_index_->Predict(ExtractUserKey(target), num_restarts_,
+                              &predicted_left, &predicted_right) &&
+      (predicted_left == 0 ||
+       CompareBlockKey(predicted_left, seek_key) <= 0) &&
+      (predicted_right == right ||
+       CompareBlockKey(predicted_right + 1, seek_key) >= 0)) {
+    left = predicted_left;
+    right = predicted_right;
+  }
+  if (!status_.ok()) {
+    return false;
+  }
+  return BinarySeek(seek_key, left, right, index);
+}
+
 uint32_t Block::NumRestarts() const {
   assert(size_ >= 2*sizeof(uint32_t));
-  return DecodeFixed32(data_ + size_ - sizeof(uint32_t));
+  return DecodeFixed32(data_ + size_ - sizeof(uint32_t)) &
+         ~kDataBlockHashIndexFlag;
 }
 
 Block::Block(BlockContents&& contents)
@@ -304,9 +462,18 @@ Block::Block(BlockContents&& contents)
   if (size_ < sizeof(uint32_t)) {
     size_ = 0;  // Error marker
   } else {
-    restart_offset_ =
-        static_cast<uint32_t>(size_) - (1 + NumRestarts()) * sizeof(uint32_t);
-    if (restart_offset_ > size_ - sizeof(uint32_t)) {
+    size_t index_size = 0;
+    const uint32_t footer = DecodeFixed32(data_ + size_ - sizeof(uint32_t));
+    if ((footer & kDataBlockHashIndexFlag) != 0 &&
+        !data_block_hash_index_.Initialize(data_, size_ - sizeof(uint32_t),
+                                           &index_size)) {
+      size_ = 0;
+      return;
+    }
+    const uint32_t trailer_size = static_cast<uint32_t>(index_size) +
+                                  (1 + NumRestarts()) * sizeof(uint32_t);
+    restart_offset_ = static_cast<uint32_t>(size_) - trailer_size;
+    if (restart_offset_ > size_ - sizeof(uint32_t) - index_size) {
       // The size is too small for NumRestarts() and therefore
       // restart_offset_ wrapped around.
       size_ = 0;
@@ -315,7 +482,8 @@ Block::Block(BlockContents&& contents)
 }
 
 Iterator* Block::NewIterator(
-    const Comparator* cmp, BlockIter* iter, bool total_order_seek) {
+    const Comparator* cmp, BlockIter* iter, bool total_order_seek,
+    bool key_includes_seq, bool value_delta_encoded) {
   if (size_ < 2*sizeof(uint32_t)) {
     if (iter != nullptr) {
       iter->SetStatus(Status::Corruption("bad block contents"));
@@ -337,13 +505,20 @@ Iterator* Block::NewIterator(
         total_order_seek ? nullptr : hash_index_.get();
     BlockPrefixIndex* prefix_index_ptr =
         total_order_seek ? nullptr : prefix_index_.get();
+    const BlockLearnedIndex* learned_index_ptr = learned_index_.get();
+    const DataBlockHashIndex* data_block_hash_index_ptr =
+        data_block_hash_index_.Valid() ? &data_block_hash_index_ : nullptr;
 
     if (iter != nullptr) {
       iter->Initialize(cmp, data_, restart_offset_, num_restarts,
-                    hash_index_ptr, prefix_index_ptr);
+                    hash_index_ptr, prefix_index_ptr,
+                    data_block_hash_index_ptr, key_includes_seq,
+                    value_delta_encoded, learned_index_ptr);
     } else {
       iter = new BlockIter(cmp, data_, restart_offset_, num_restarts,
-                           hash_index_ptr, prefix_index_ptr);
+                           hash_index_ptr, prefix_index_ptr,
+                           data_block_hash_index_ptr, key_includes_seq,
+                           value_delta_encoded, learned_index_ptr);
     }
   }
 
@@ -358,6 +533,10 @@ void Block::SetBlockPrefixIndex(BlockPrefixIndex* prefix_index) {
   prefix_index_.reset(prefix_index);
 }
 
+void Block::SetBlockLearnedIndex(BlockLearnedIndex* learned_index) {
+  learned_index_.reset(learned_index);
+}
+
 size_t Block::ApproximateMemoryUsage() const {
   size_t usage = size();
   if (hash_index_) {
@@ -366,6 +545,9 @@ size_t Block::ApproximateMemoryUsage() const {
   if (prefix_index_) {
     usage += prefix_index_->ApproximateMemoryUsage();
   }
+  if (learned_index_) {
+    usage += learned_index_->ApproximateMemoryUsage();
+  }
   return usage;
 }
 
@@ -10,12 +10,16 @@
 #pragma once
 #include <stddef.h>
 #include <stdint.h>
+#include <string>
+#include <vector>
 
 #include "rocksdb/iterator.h"
 #include "rocksdb/options.h"
 #include "db/dbformat.h"
 #include "table/block_prefix_index.h"
 #include "table/block_hash_index.h"
+#include "table/block_learned_index.h"
+#include "table/data_block_hash_index.h"
 
 #include "format.h"
 
@@ -25,6 +29,7 @@ struct BlockContents;
 class Comparator;
 class BlockIter;
 class BlockHashIndex;
+class BlockLearnedIndex;
 class BlockPrefixIndex;
 
 class Block {
@@ -54,11 +59,21 @@ class Block {
   //
   // If total_order_seek is true, hash_index_ and prefix_index_ are ignored.
   // This option only applies for index block. For data block, hash_index_
-  // and prefix_index_ are null, so this option does not matter.
+  // and prefix_index_ are null, so this option does not matter. The
+  // learned index keys the total order, so it is used either way.
+  //
+  // The remaining options are for index blocks written with format_version
+  // >= 3. If key_includes_seq is false, the keys of the block are user keys,
+  // comparator must be the user comparator, and the iterator still takes
+  // and returns internal keys. If value_delta_encoded is true, the values
+  // are block handles of which only the size is stored for entries within a
+  // restart interval.
   Iterator* NewIterator(const Comparator* comparator,
-      BlockIter* iter = nullptr, bool total_order_seek = true);
+      BlockIter* iter = nullptr, bool total_order_seek = true,
+      bool key_includes_seq = true, bool value_delta_encoded = false);
   void SetBlockHashIndex(BlockHashIndex* hash_index);
   void SetBlockPrefixIndex(BlockPrefixIndex* prefix_index);
+  void SetBlockLearnedIndex(BlockLearnedIndex* learned_index);
 
   // Report an approximation of how much memory has been used.
   size_t ApproximateMemoryUsage() const;
@@ -68,8 +83,10 @@ class Block {
   const char* data_;            // contents_.data.data()
   size_t size_;                 // contents_.data.size()
   uint32_t restart_offset_;     // Offset in data_ of restart array
+  DataBlockHashIndex data_block_hash_index_;
   std::unique_ptr<BlockHashIndex> hash_index_;
   std::unique_ptr<BlockPrefixIndex> prefix_index_;
+  std::unique_ptr<BlockLearnedIndex> learned_index_;
 
   // No copying allowed
   Block(const Block&);
@@ -87,19 +104,31 @@ class BlockIter : public Iterator {
         restart_index_(0),
         status_(Status::OK()),
         hash_index_(nullptr),
-        prefix_index_(nullptr) {}
+        prefix_index_(nullptr),
+        data_block_hash_index_(nullptr),
+        learned_index_(nullptr),
+        key_includes_seq_(true),
+        value_delta_encoded_(false),
+        prev_entries_idx_(-1) {}
 
   BlockIter(const Comparator* comparator, const char* data, uint32_t restarts,
        uint32_t num_restarts, BlockHashIndex* hash_index,
-       BlockPrefixIndex* prefix_index)
+       BlockPrefixIndex* prefix_index,
+       const DataBlockHashIndex* data_block_hash_index,
+       bool key_includes_seq = true, bool value_delta_encoded = false,
+       const BlockLearnedIndex* learned_index = nullptr)
       : BlockIter() {
     Initialize(comparator, data, restarts, num_restarts,
-        hash_index, prefix_index);
+        hash_index, prefix_index, data_block_hash_index, key_includes_seq,
+        value_delta_encoded, learned_index);
   }
 
   void Initialize(const Comparator* comparator, const char* data,
       uint32_t restarts, uint32_t num_restarts, BlockHashIndex* hash_index,
-      BlockPrefixIndex* prefix_index) {
+      BlockPrefixIndex* prefix_index,
+      const DataBlockHashIndex* data_block_hash_index,
+      bool key_includes_seq = true, bool value_delta_encoded = false,
+      const BlockLearnedIndex* learned_index = nullptr) {
     assert(data_ == nullptr);           // Ensure it is called only once
     assert(num_restarts > 0);           // Ensure the param is valid
 
@@ -111,6 +140,13 @@ class BlockIter : public Iterator {
     restart_index_ = num_restarts_;
     hash_index_ = hash_index;
     prefix_index_ = prefix_index;
+    data_block_hash_index_ = data_block_hash_index;
+    learned_index_ = learned_index;
+    key_includes_seq_ = key_includes_seq;
+    value_delta_encoded_ = value_delta_encoded;
+    // Hash and prefix indexes are only built over internal keys
+    assert(key_includes_seq_ || (hash_index_ == nullptr &&
+                                 prefix_index_ == nullptr));
   }
 
   void SetStatus(Status s) {
@@ -121,10 +157,24 @@ class BlockIter : public Iterator {
   virtual Status status() const override { return status_; }
   virtual Slice key() const override {
     assert(Valid());
+    if (!key_includes_seq_) {
+      // The smallest internal key of the user key, which still separates
+      // the data blocks
+      internal_key_.SetInternalKey(key_.GetKey(), kMaxSequenceNumber,
+                                   kValueTypeForSeek);
+      return internal_key_.GetKey();
+    }
     return key_.GetKey();
   }
+  // Keys stored without delta encoding are not copied out of the block
+  virtual bool IsKeyPinned() const override {
+    return key_includes_seq_ && key_.IsKeyPinned();
+  }
   virtual Slice value() const override {
     assert(Valid());
+    if (value_delta_encoded_) {
+      return decoded_value_;
+    }
     return value_;
   }
 
@@ -134,6 +184,14 @@ class BlockIter : public Iterator {
 
   virtual void Seek(const Slice& target) override;
 
+  // Position at the first entry >= target like Seek(), using the data block
+  // hash index if the block has one. target must be an internal key.
+  // Returns false if the user key of target is neither in this block nor
+  // in any block after it, in which case the iterator is not valid.
+  // Returns true otherwise; the iterator is then not valid if the user key
+  // of target is not in this block but may continue in the next one.
+  bool SeekForGet(const Slice& target, const Comparator* user_comparator);
+
   virtual void SeekToFirst() override;
 
   virtual void SeekToLast() override;
@@ -152,6 +210,45 @@ class BlockIter : public Iterator {
   Status status_;
   BlockHashIndex* hash_index_;
   BlockPrefixIndex* prefix_index_;
+  const DataBlockHashIndex* data_block_hash_index_;
+  const BlockLearnedIndex* learned_index_;
+  bool key_includes_seq_;
+  // key() of an entry whose key is a user key
+  mutable IterKey internal_key_;
+  bool value_delta_encoded_;
+  // The block handle of the current entry and its full encoding, which
+  // value() returns if value_delta_encoded_
+  BlockHandle decoded_handle_;
+  std::string decoded_value_;
+
+  // An entry of the restart interval decoded by the last Prev() that had to
+  // scan forward from a restart point.
+  struct CachedPrevEntry {
+    CachedPrevEntry(uint32_t _offset, const char* _key_ptr, size_t _key_offset,
+                    size_t _key_size, Slice _value)
+        : offset(_offset),
+          key_ptr(_key_ptr),
+          key_offset(_key_offset),
+          key_size(_key_size),
+          value(_value) {}
+
+    // Offset of the entry in data_
+    uint32_t offset;
+    // The key in data_ if it is stored whole, otherwise nullptr and the key
+    // is at key_offset in prev_entries_keys_buff_
+    const char* key_ptr;
+    size_t key_offset;
+    size_t key_size;
+    Slice value;
+    // The decoded block handle if value_delta_encoded_
+    BlockHandle handle;
+  };
+  // Consecutive Prev() calls step back through these entries instead of
+  // decoding the restart interval again for every entry.
+  std::string prev_entries_keys_buff_;
+  std::vector<CachedPrevEntry> prev_entries_;
+  // Index of the current entry in prev_entries_, or -1 if it is not cached
+  int32_t prev_entries_idx_;
 
   inline int Compare(const Slice& a, const Slice& b) const {
     return comparator_->Compare(a, b);
@@ -182,6 +279,10 @@ class BlockIter : public Iterator {
 
   bool ParseNextKey();
 
+  // Decode the block handle of the current entry into decoded_handle_ and
+  // decoded_value_. Returns false if the value is corrupted.
+  bool DecodeCurrentValue(bool is_restart);
+
   bool BinarySeek(const Slice& target, uint32_t left, uint32_t right,
                   uint32_t* index);
 
@@ -195,6 +296,9 @@ class BlockIter : public Iterator {
 
   bool PrefixSeek(const Slice& target, uint32_t* index);
 
+  bool LearnedSeek(const Slice& target, const Slice& seek_key,
+                   uint32_t* index);
+
 };
 
 }  // namespace rocksdb
@@ -13,11 +13,17 @@
 #include <inttypes.h>
 #include <stdio.h>
 
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "db/dbformat.h"
 
@@ -31,6 +37,7 @@
 #include "table/block.h"
 #include "table/block_based_table_reader.h"
 #include "table/block_builder.h"
+#include "table/block_learned_index.h"
 #include "table/filter_block.h"
 #include "table/block_based_filter_block.h"
 #include "table/block_based_table_factory.h"
@@ -49,6 +56,7 @@ namespace rocksdb {
 
 extern const std::string kHashIndexPrefixesBlock;
 extern const std::string kHashIndexPrefixesMetadataBlock;
+extern const std::string kLearnedIndexBlock;
 
 typedef BlockBasedTableOptions::IndexType IndexType;
 
@@ -104,6 +112,10 @@ class IndexBuilder {
   // Get the estimated size for index block.
   virtual size_t EstimatedSize() const = 0;
 
+  // Whether the keys of the index block are internal keys. If not, they are
+  // the user keys without sequence number.
+  virtual bool separator_is_key_plus_seq() const { return true; }
+
  protected:
   const Comparator* comparator_;
 };
@@ -111,21 +123,43 @@ class IndexBuilder {
 // This index builder builds space-efficient index block.
 //
 // Optimizations:
-//  1. Made block's `block_restart_interval` to be 1, which will avoid linear
-//     search when doing index lookup.
+//  1. By default, made block's `block_restart_interval` to be 1, which will
+//     avoid linear search when doing index lookup. Larger intervals trade
+//     that search for delta encoded keys.
 //  2. Shorten the key length for index block. Other than honestly using the
 //     last key in the data block as the index key, we instead find a shortest
 //     substitute key that serves the same function.
+//  3. With `use_value_delta_encoding`, only the size of the block handle is
+//     stored for entries within a restart interval, the data blocks being
+//     contiguous in the file.
+//  4. With `allow_user_key`, the index keys are also collected without
+//     sequence number, and that block is used if no user key spans two data
+//     blocks.
 class ShortenedIndexBuilder : public IndexBuilder {
  public:
-  explicit ShortenedIndexBuilder(const Comparator* comparator)
+  explicit ShortenedIndexBuilder(const InternalKeyComparator* comparator,
+                                 int index_block_restart_interval = 1,
+                                 bool use_value_delta_encoding = false,
+                                 bool allow_user_key = false)
       : IndexBuilder(comparator),
-        index_block_builder_(1 /* block_restart_interval == 1 */) {}
+        user_comparator_(comparator->user_comparator()),
+        index_block_builder_(index_block_restart_interval),
+        index_block_builder_without_seq_(index_block_restart_interval),
+        use_value_delta_encoding_(use_value_delta_encoding),
+        separator_is_key_plus_seq_(!allow_user_key),
+        last_handle_(0, 0) {}
 
   virtual void AddIndexEntry(std::string* last_key_in_current_block,
                              const Slice* first_key_in_next_block,
                              const BlockHandle& block_handle) override {
     if (first_key_in_next_block != nullptr) {
+      if (!separator_is_key_plus_seq_ &&
+          user_comparator_->Compare(
+              ExtractUserKey(*last_key_in_current_block),
+              ExtractUserKey(*first_key_in_next_block)) == 0) {
+        // Only the sequence number tells these blocks apart
+        separator_is_key_plus_seq_ = true;
+      }
       comparator_->FindShortestSeparator(last_key_in_current_block,
                                          *first_key_in_next_block);
     } else {
@@ -134,20 +168,58 @@ class ShortenedIndexBuilder : public IndexBuilder {
 
     std::string handle_encoding;
     block_handle.EncodeTo(&handle_encoding);
-    index_block_builder_.Add(*last_key_in_current_block, handle_encoding);
+    std::string handle_delta_encoding;
+    Slice handle_delta_encoding_slice;
+    const Slice* delta_value = nullptr;
+    if (use_value_delta_encoding_) {
+      // The data blocks are written back to back
+      assert(last_handle_.size() == 0 ||
+             block_handle.offset() == last_handle_.offset() +
+                                          last_handle_.size() +
+                                          kBlockTrailerSize);
+      PutVarint64(&handle_delta_encoding, block_handle.size());
+      handle_delta_encoding_slice = handle_delta_encoding;
+      delta_value = &handle_delta_encoding_slice;
+      last_handle_ = block_handle;
+    }
+    index_block_builder_.Add(*last_key_in_current_block, handle_encoding,
+                             delta_value);
+    if (!separator_is_key_plus_seq_) {
+      index_block_builder_without_seq_.Add(
+          ExtractUserKey(*last_key_in_current_block), handle_encoding,
+          delta_value);
+    }
   }
 
   virtual Status Finish(IndexBlocks* index_blocks) override {
-    index_blocks->index_block_contents = index_block_builder_.Finish();
+    if (separator_is_key_plus_seq_) {
+      index_blocks->index_block_contents = index_block_builder_.Finish();
+    } else {
+      index_blocks->index_block_contents =
+          index_block_builder_without_seq_.Finish();
+    }
     return Status::OK();
   }
 
   virtual size_t EstimatedSize() const override {
-    return index_block_builder_.CurrentSizeEstimate();
+    if (separator_is_key_plus_seq_) {
+      return index_block_builder_.CurrentSizeEstimate();
+    } else {
+      return index_block_builder_without_seq_.CurrentSizeEstimate();
+    }
+  }
+
+  virtual bool separator_is_key_plus_seq() const override {
+    return separator_is_key_plus_seq_;
   }
 
  private:
+  const Comparator* user_comparator_;
   BlockBuilder index_block_builder_;
+  BlockBuilder index_block_builder_without_seq_;
+  const bool use_value_delta_encoding_;
+  bool separator_is_key_plus_seq_;
+  BlockHandle last_handle_;
 };
 
 // HashIndexBuilder contains a binary-searchable primary index and the
@@ -176,7 +248,9 @@ class ShortenedIndexBuilder : public IndexBuilder {
 // data copy or small heap allocations for prefixes.
 class HashIndexBuilder : public IndexBuilder {
  public:
-  explicit HashIndexBuilder(const Comparator* comparator,
+  // The prefix metadata refers to the entries of the primary index by their
+  // restart index, so its restart interval stays 1.
+  explicit HashIndexBuilder(const InternalKeyComparator* comparator,
                             const SliceTransform* hash_key_extractor)
       : IndexBuilder(comparator),
         primary_index_builder_(comparator),
@@ -260,19 +334,86 @@ class HashIndexBuilder : public IndexBuilder {
   uint64_t current_restart_index_ = 0;
 };
 
+// LearnedIndexBuilder contains a binary-searchable primary index and a
+// piecewise linear model of the position of its entries, which is stored in
+// a metablock (see block_learned_index.h). The model maps keys to entries
+// by their restart index, so the restart interval of the primary index stays
+// 1. It needs the bytewise order of the user keys and is left out of tables
+// of other comparators, which then fall back to plain binary search.
+class LearnedIndexBuilder : public IndexBuilder {
+ public:
+  // Every entry is predicted within this many entries of its position
+  static const uint32_t kMaxError = 8;
+
+  explicit LearnedIndexBuilder(const InternalKeyComparator* comparator,
+                               bool use_value_delta_encoding)
+      : IndexBuilder(comparator),
+        primary_index_builder_(comparator, 1 /* restart interval */,
+                               use_value_delta_encoding,
+                               use_value_delta_encoding /* allow_user_key */),
+        model_builder_(kMaxError),
+        bytewise_(comparator->user_comparator() == BytewiseComparator()) {}
+
+  virtual void AddIndexEntry(std::string* last_key_in_current_block,
+                             const Slice* first_key_in_next_block,
+                             const BlockHandle& block_handle) override {
+    primary_index_builder_.AddIndexEntry(last_key_in_current_block,
+                                         first_key_in_next_block,
+                                         block_handle);
+    if (bytewise_) {
+      // The key has been replaced by the separator of the entry
+      model_builder_.Add(ExtractUserKey(*last_key_in_current_block));
+    }
+  }
+
+  virtual Status Finish(IndexBlocks* index_blocks) override {
+    Status s = primary_index_builder_.Finish(index_blocks);
+    if (s.ok() && bytewise_) {
+      model_builder_.Finish(&model_block_);
+      index_blocks->meta_blocks.insert(
+          {kLearnedIndexBlock.c_str(), model_block_});
+    }
+    return s;
+  }
+
+  virtual size_t EstimatedSize() const override {
+    return primary_index_builder_.EstimatedSize() + model_block_.size();
+  }
+
+  virtual bool separator_is_key_plus_seq() const override {
+    return primary_index_builder_.separator_is_key_plus_seq();
+  }
+
+ private:
+  ShortenedIndexBuilder primary_index_builder_;
+  BlockLearnedIndex::Builder model_builder_;
+  const bool bytewise_;
+  std::string model_block_;
+};
+
 // Without anonymous namespace here, we fail the warning -Wmissing-prototypes
 namespace {
 
 // Create a index builder based on its type.
-IndexBuilder* CreateIndexBuilder(IndexType type, const Comparator* comparator,
-                                 const SliceTransform* prefix_extractor) {
+IndexBuilder* CreateIndexBuilder(IndexType type,
+                                 const InternalKeyComparator* comparator,
+                                 const SliceTransform* prefix_extractor,
+                                 const BlockBasedTableOptions& table_opt) {
   switch (type) {
     case BlockBasedTableOptions::kBinarySearch: {
-      return new ShortenedIndexBuilder(comparator);
+      const bool delta_encoded_index = table_opt.format_version >= 3;
+      return new ShortenedIndexBuilder(
+          comparator, table_opt.index_block_restart_interval,
+          delta_encoded_index /* use_value_delta_encoding */,
+          delta_encoded_index /* allow_user_key */);
     }
     case BlockBasedTableOptions::kHashSearch: {
       return new HashIndexBuilder(comparator, prefix_extractor);
     }
+    case BlockBasedTableOptions::kLearnedSearch: {
+      return new LearnedIndexBuilder(
+          comparator, table_opt.format_version >= 3 /* delta encoded */);
+    }
     default: {
       assert(!"Do not recognize the index type ");
       return nullptr;
@@ -305,9 +446,12 @@ bool GoodCompressionRatio(size_t compressed_size, size_t raw_size) {
 }
 
 // format_version is the block format as defined in include/rocksdb/table.h
+// compression_dict is only used by zlib and zstd, the block can then only be
+// uncompressed with the same dictionary.
 Slice CompressBlock(const Slice& raw,
                     const CompressionOptions& compression_options,
                     CompressionType* type, uint32_t format_version,
+                    const Slice& compression_dict,
                     std::string* compressed_output) {
   if (*type == kNoCompression) {
     return raw;
@@ -327,7 +471,7 @@ Slice CompressBlock(const Slice& raw,
       if (Zlib_Compress(
               compression_options,
               GetCompressFormatForVersion(kZlibCompression, format_version),
-              raw.data(), raw.size(), compressed_output) &&
+              raw.data(), raw.size(), compressed_output, compression_dict) &&
           GoodCompressionRatio(compressed_output->size(), raw.size())) {
         return *compressed_output;
       }
@@ -358,6 +502,13 @@ Slice CompressBlock(const Slice& raw,
           GoodCompressionRatio(compressed_output->size(), raw.size())) {
         return *compressed_output;
       }
+      break;  // fall back to no compression.
+    case kZSTD:
+      if (ZSTD_Compress(compression_options, raw.data(), raw.size(),
+                        compressed_output, compression_dict) &&
+          GoodCompressionRatio(compressed_output->size(), raw.size())) {
+        return *compressed_output;
+      }
       break;     // fall back to no compression.
     default: {}  // Do not recognize this compression type
   }
@@ -381,6 +532,11 @@ extern const uint64_t kBlockBasedTableMagicNumber = 0x88e241b785f4cff7ull;
 extern const uint64_t kLegacyBlockBasedTableMagicNumber = 0xdb4775248b80fb57ull;
 
 // A collector that collects properties of interest to block-based table.
+// The uncompressed data blocks are buffered until this many times
+// compression_opts.max_dict_bytes have been added, the dictionary is then
+// built from them.
+static const size_t kDictBufferRatio = 100;
+
 // For now this class looks heavy-weight since we only write one additional
 // property.
 // But in the forseeable future, we will add more and more properties that are
@@ -390,10 +546,11 @@ class BlockBasedTableBuilder::BlockBasedTablePropertiesCollector
  public:
   explicit BlockBasedTablePropertiesCollector(
       BlockBasedTableOptions::IndexType index_type, bool whole_key_filtering,
-      bool prefix_filtering)
+      bool prefix_filtering, const IndexBuilder* index_builder)
       : index_type_(index_type),
         whole_key_filtering_(whole_key_filtering),
-        prefix_filtering_(prefix_filtering) {}
+        prefix_filtering_(prefix_filtering),
+        index_builder_(index_builder) {}
 
   virtual Status Add(const Slice& key, const Slice& value) override {
     // Intentionally left blank. Have no interest in collecting stats for
@@ -409,6 +566,11 @@ class BlockBasedTableBuilder::BlockBasedTablePropertiesCollector
                         whole_key_filtering_ ? kPropTrue : kPropFalse});
     properties->insert({BlockBasedTablePropertyNames::kPrefixFiltering,
                         prefix_filtering_ ? kPropTrue : kPropFalse});
+    // Files of older versions do not have it either
+    if (!index_builder_->separator_is_key_plus_seq()) {
+      properties->insert(
+          {BlockBasedTablePropertyNames::kIndexKeyIsUserKey, kPropTrue});
+    }
     return Status::OK();
   }
 
@@ -426,6 +588,59 @@ class BlockBasedTableBuilder::BlockBasedTablePropertiesCollector
   BlockBasedTableOptions::IndexType index_type_;
   bool whole_key_filtering_;
   bool prefix_filtering_;
+  // Finished before the properties are collected
+  const IndexBuilder* index_builder_;
+};
+
+// The state shared with the compression workers. Only the thread building
+// the file adds and removes blocks, the workers just compress them.
+struct BlockBasedTableBuilder::ParallelCompressionRep {
+  // A data block on its way through the pipeline
+  struct BlockRep {
+    std::string raw;
+    std::string compressed_output;
+    Slice contents;
+    CompressionType type;
+    // Set by the worker once contents and type are final
+    bool compressed = false;
+    // Set once the next data block was started, the index entry of this
+    // block is added with it when the block is written
+    bool has_next_key = false;
+    std::string first_key_in_next_block;
+  };
+
+  explicit ParallelCompressionRep(uint32_t _num_threads)
+      : num_threads(_num_threads) {}
+
+  ~ParallelCompressionRep() { Stop(); }
+
+  void Stop() {
+    {
+      std::lock_guard<std::mutex> lock(mu);
+      shutdown = true;
+    }
+    work_cv.notify_all();
+    for (auto& worker : workers) {
+      worker.join();
+    }
+    workers.clear();
+  }
+
+  const uint32_t num_threads;
+  std::vector<std::thread> workers;
+  // Blocks in file order, the one at the front is written next
+  std::deque<std::unique_ptr<BlockRep>> blocks;
+  // Uncompressed size of the blocks in the pipeline
+  size_t raw_bytes_in_flight = 0;
+
+  std::mutex mu;
+  // Signaled when a block is added to to_compress or on shutdown
+  std::condition_variable work_cv;
+  // Signaled when a block was compressed
+  std::condition_variable done_cv;
+  // Blocks not picked up by a worker yet
+  std::deque<BlockRep*> to_compress;
+  bool shutdown = false;
 };
 
 struct BlockBasedTableBuilder::Rep {
@@ -458,6 +673,19 @@ struct BlockBasedTableBuilder::Rep {
   std::vector<std::unique_ptr<TablePropertiesCollector>>
       table_properties_collectors;
 
+  // While true, finished data blocks are kept in data_block_buffers instead
+  // of being written, until enough of them are there to build
+  // compression_dict. Their keys are only added to the filter and index
+  // when they are written.
+  bool buffer_data_blocks;
+  std::vector<std::string> data_block_buffers;
+  size_t data_block_buffers_size = 0;
+  std::string compression_dict;
+
+  // Set if more than one compression thread is used. The keys are then
+  // added to the filter and index when their block is written.
+  std::unique_ptr<ParallelCompressionRep> pc_rep;
+
   Rep(const ImmutableCFOptions& _ioptions,
       const BlockBasedTableOptions& table_opt,
       const InternalKeyComparator& icomparator, WritableFile* f,
@@ -467,18 +695,31 @@ struct BlockBasedTableBuilder::Rep {
         table_options(table_opt),
         internal_comparator(icomparator),
         file(f),
-        data_block(table_options.block_restart_interval),
+        data_block(table_options.block_restart_interval,
+                   table_options.data_block_index_type ==
+                       BlockBasedTableOptions::kDataBlockBinaryAndHash,
+                   table_options.data_block_hash_table_util_ratio,
+                   table_options.use_delta_encoding),
         internal_prefix_transform(_ioptions.prefix_extractor),
         index_builder(CreateIndexBuilder(table_options.index_type,
                                          &internal_comparator,
-                                         &this->internal_prefix_transform)),
+                                         &this->internal_prefix_transform,
+                                         table_options)),
         compression_type(_compression_type),
         compression_opts(_compression_opts),
         filter_block(skip_filters ? nullptr : CreateFilterBlockBuilder(
                                                   _ioptions, table_options)),
         flush_block_policy(
             table_options.flush_block_policy_factory->NewFlushBlockPolicy(
-                table_options, data_block)) {
+                table_options, data_block)),
+        buffer_data_blocks(_compression_opts.max_dict_bytes > 0 &&
+                           (_compression_type == kZlibCompression ||
+                            _compression_type == kZSTD)) {
+    if (_compression_opts.parallel_threads > 1 &&
+        _compression_type != kNoCompression) {
+      pc_rep.reset(
+          new ParallelCompressionRep(_compression_opts.parallel_threads));
+    }
     for (auto& collector_factories :
          ioptions.table_properties_collector_factories) {
       table_properties_collectors.emplace_back(
@@ -487,7 +728,7 @@ struct BlockBasedTableBuilder::Rep {
     table_properties_collectors.emplace_back(
         new BlockBasedTablePropertiesCollector(
             table_options.index_type, table_options.whole_key_filtering,
-            _ioptions.prefix_extractor != nullptr));
+            _ioptions.prefix_extractor != nullptr, index_builder.get()));
   }
 };
 
@@ -548,12 +789,22 @@ void BlockBasedTableBuilder::Add(const Slice& key, const Slice& value) {
     // "the r" as the key for the index block entry since it is >= all
     // entries in the first block and < all entries in subsequent
     // blocks.
-    if (ok()) {
-      r->index_builder->AddIndexEntry(&r->last_key, &key, r->pending_handle);
+    if (ok() && !r->buffer_data_blocks) {
+      if (r->pc_rep != nullptr && !r->pc_rep->blocks.empty()) {
+        // The block is still in the pipeline
+        auto& block = r->pc_rep->blocks.back();
+        block->has_next_key = true;
+        block->first_key_in_next_block.assign(key.data(), key.size());
+        WriteCompressedBlocks(2 * r->pc_rep->num_threads);
+      } else {
+        r->index_builder->AddIndexEntry(&r->last_key, &key,
+                                        r->pending_handle);
+      }
     }
   }
 
-  if (r->filter_block != nullptr) {
+  const bool defer_keys = r->buffer_data_blocks || r->pc_rep != nullptr;
+  if (r->filter_block != nullptr && !defer_keys) {
     r->filter_block->Add(ExtractUserKey(key));
   }
 
@@ -563,7 +814,9 @@ void BlockBasedTableBuilder::Add(const Slice& key, const Slice& value) {
   r->props.raw_key_size += key.size();
   r->props.raw_value_size += value.size();
 
-  r->index_builder->OnKeyAdded(key);
+  if (!defer_keys) {
+    r->index_builder->OnKeyAdded(key);
+  }
   NotifyCollectTableCollectorsOnAdd(key, value, r->table_properties_collectors,
                                     r->ioptions.info_log);
 }
@@ -573,7 +826,27 @@ void BlockBasedTableBuilder::Flush() {
   assert(!r->closed);
   if (!ok()) return;
   if (r->data_block.empty()) return;
-  WriteBlock(&r->data_block, &r->pending_handle);
+  if (r->buffer_data_blocks) {
+    Slice raw = r->data_block.Finish();
+    r->data_block_buffers.emplace_back(raw.data(), raw.size());
+    r->data_block_buffers_size += raw.size();
+    r->data_block.Reset();
+    if (r->data_block_buffers_size >=
+        kDictBufferRatio * r->compression_opts.max_dict_bytes) {
+      EnterUnbuffered();
+    }
+    return;
+  }
+  if (r->pc_rep != nullptr) {
+    SubmitDataBlock();
+    return;
+  }
+  WriteBlock(&r->data_block, &r->pending_handle, true /* is_data_block */);
+  DataBlockWritten();
+}
+
+void BlockBasedTableBuilder::DataBlockWritten() {
+  Rep* r = rep_;
   if (ok()) {
     r->status = r->file->Flush();
   }
@@ -584,14 +857,180 @@ void BlockBasedTableBuilder::Flush() {
   ++r->props.num_data_blocks;
 }
 
+void BlockBasedTableBuilder::EnterUnbuffered() {
+  Rep* r = rep_;
+  assert(r->buffer_data_blocks);
+  r->buffer_data_blocks = false;
+
+  const size_t max_dict_bytes = r->compression_opts.max_dict_bytes;
+  if (r->compression_type == kZSTD) {
+    std::vector<size_t> sample_lens;
+    std::string samples;
+    samples.reserve(r->data_block_buffers_size);
+    for (const auto& block : r->data_block_buffers) {
+      samples.append(block);
+      sample_lens.push_back(block.size());
+    }
+    r->compression_dict =
+        ZSTD_TrainDictionary(samples, sample_lens, max_dict_bytes);
+  }
+  if (r->compression_dict.empty() && r->data_block_buffers_size > 0) {
+    // Take evenly spaced samples from the buffered blocks. zlib looks for
+    // matches at the end of the dictionary first, so the later samples are
+    // the ones preferred.
+    const size_t kSampleBytes = 64;
+    size_t num_samples = std::max<size_t>(max_dict_bytes / kSampleBytes, 1);
+    size_t stride =
+        std::max<size_t>(r->data_block_buffers_size / num_samples, 1);
+    size_t pos = 0;
+    for (const auto& block : r->data_block_buffers) {
+      while (pos < block.size() &&
+             r->compression_dict.size() < max_dict_bytes) {
+        size_t len = std::min(
+            {kSampleBytes, block.size() - pos,
+             max_dict_bytes - r->compression_dict.size()});
+        r->compression_dict.append(block, pos, len);
+        pos += stride;
+      }
+      pos -= std::min(pos, block.size());
+    }
+  }
+
+  for (size_t i = 0; ok() && i < r->data_block_buffers.size(); ++i) {
+    const std::string& raw = r->data_block_buffers[i];
+    std::string last_key;
+    AddBlockKeysToFilterAndIndex(raw, &last_key);
+    WriteBlock(raw, &r->pending_handle, true /* is_data_block */);
+    if (!ok()) {
+      break;
+    }
+    DataBlockWritten();
+
+    // The index entry of the last block is added by the caller, once the
+    // next key is known.
+    if (ok() && i + 1 < r->data_block_buffers.size()) {
+      Block next_block(BlockContents(Slice(r->data_block_buffers[i + 1]),
+                                     false /* cachable */, kNoCompression));
+      std::unique_ptr<Iterator> next_iter(
+          next_block.NewIterator(&r->internal_comparator));
+      next_iter->SeekToFirst();
+      assert(next_iter->Valid());
+      Slice first_key_in_next_block = next_iter->key();
+      r->index_builder->AddIndexEntry(&last_key, &first_key_in_next_block,
+                                      r->pending_handle);
+    }
+  }
+  r->data_block_buffers.clear();
+  r->data_block_buffers_size = 0;
+}
+
+void BlockBasedTableBuilder::AddBlockKeysToFilterAndIndex(
+    const Slice& raw_block_contents, std::string* last_key) {
+  Rep* r = rep_;
+  Block block(BlockContents(raw_block_contents, false /* cachable */,
+                            kNoCompression));
+  std::unique_ptr<Iterator> iter(block.NewIterator(&r->internal_comparator));
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    if (r->filter_block != nullptr) {
+      r->filter_block->Add(ExtractUserKey(iter->key()));
+    }
+    r->index_builder->OnKeyAdded(iter->key());
+    last_key->assign(iter->key().data(), iter->key().size());
+  }
+}
+
+void BlockBasedTableBuilder::SubmitDataBlock() {
+  Rep* r = rep_;
+  ParallelCompressionRep* pc = r->pc_rep.get();
+  if (pc->workers.empty()) {
+    for (uint32_t i = 0; i < pc->num_threads; ++i) {
+      pc->workers.emplace_back(&BlockBasedTableBuilder::CompressionWorker,
+                               this);
+    }
+  }
+
+  std::unique_ptr<ParallelCompressionRep::BlockRep> block(
+      new ParallelCompressionRep::BlockRep());
+  Slice raw = r->data_block.Finish();
+  block->raw.assign(raw.data(), raw.size());
+  r->data_block.Reset();
+  pc->raw_bytes_in_flight += block->raw.size();
+  {
+    std::lock_guard<std::mutex> lock(pc->mu);
+    pc->to_compress.push_back(block.get());
+  }
+  pc->blocks.push_back(std::move(block));
+  pc->work_cv.notify_one();
+}
+
+void BlockBasedTableBuilder::CompressionWorker() {
+  ParallelCompressionRep* pc = rep_->pc_rep.get();
+  std::unique_lock<std::mutex> lock(pc->mu);
+  while (true) {
+    pc->work_cv.wait(
+        lock, [pc] { return pc->shutdown || !pc->to_compress.empty(); });
+    if (pc->shutdown) {
+      return;
+    }
+    ParallelCompressionRep::BlockRep* block = pc->to_compress.front();
+    pc->to_compress.pop_front();
+    lock.unlock();
+    CompressionType type;
+    Slice contents = CompressBlockContents(
+        block->raw, true /* is_data_block */, &type, &block->compressed_output);
+    lock.lock();
+    block->contents = contents;
+    block->type = type;
+    block->compressed = true;
+    pc->done_cv.notify_all();
+  }
+}
+
+void BlockBasedTableBuilder::WriteCompressedBlocks(size_t max_in_flight) {
+  Rep* r = rep_;
+  ParallelCompressionRep* pc = r->pc_rep.get();
+  while (ok() && !pc->blocks.empty()) {
+    ParallelCompressionRep::BlockRep* front = pc->blocks.front().get();
+    {
+      std::unique_lock<std::mutex> lock(pc->mu);
+      if (!front->compressed) {
+        if (pc->blocks.size() <= max_in_flight) {
+          break;
+        }
+        pc->done_cv.wait(lock, [front] { return front->compressed; });
+      }
+    }
+    std::unique_ptr<ParallelCompressionRep::BlockRep> block =
+        std::move(pc->blocks.front());
+    pc->blocks.pop_front();
+    pc->raw_bytes_in_flight -= block->raw.size();
+
+    std::string last_key;
+    AddBlockKeysToFilterAndIndex(block->raw, &last_key);
+    WriteRawBlock(block->contents, block->type, &r->pending_handle);
+    if (!ok()) {
+      break;
+    }
+    DataBlockWritten();
+    // The index entry of the last block of the file is added by Finish()
+    if (ok() && block->has_next_key) {
+      Slice first_key_in_next_block(block->first_key_in_next_block);
+      r->index_builder->AddIndexEntry(&last_key, &first_key_in_next_block,
+                                      r->pending_handle);
+    }
+  }
+}
+
 void BlockBasedTableBuilder::WriteBlock(BlockBuilder* block,
-                                        BlockHandle* handle) {
-  WriteBlock(block->Finish(), handle);
+                                        BlockHandle* handle,
+                                        bool is_data_block) {
+  WriteBlock(block->Finish(), handle, is_data_block);
   block->Reset();
 }
 
 void BlockBasedTableBuilder::WriteBlock(const Slice& raw_block_contents,
-                                        BlockHandle* handle) {
+                                        BlockHandle* handle,
+                                        bool is_data_block) {
   // File format contains a sequence of blocks where each block has:
   //    block_data: uint8[n]
   //    type: uint8
@@ -599,21 +1038,29 @@ void BlockBasedTableBuilder::WriteBlock(const Slice& raw_block_contents,
   assert(ok());
   Rep* r = rep_;
 
-  auto type = r->compression_type;
-  Slice block_contents;
-  if (raw_block_contents.size() < kCompressionSizeLimit) {
-    block_contents =
-        CompressBlock(raw_block_contents, r->compression_opts, &type,
-                      r->table_options.format_version, &r->compressed_output);
-  } else {
-    RecordTick(r->ioptions.statistics, NUMBER_BLOCK_NOT_COMPRESSED);
-    type = kNoCompression;
-    block_contents = raw_block_contents;
-  }
+  CompressionType type;
+  Slice block_contents = CompressBlockContents(
+      raw_block_contents, is_data_block, &type, &r->compressed_output);
   WriteRawBlock(block_contents, type, handle);
   r->compressed_output.clear();
 }
 
+Slice BlockBasedTableBuilder::CompressBlockContents(
+    const Slice& raw_block_contents, bool is_data_block, CompressionType* type,
+    std::string* compressed_output) const {
+  Rep* r = rep_;
+  *type = r->compression_type;
+  if (raw_block_contents.size() < kCompressionSizeLimit) {
+    return CompressBlock(raw_block_contents, r->compression_opts, type,
+                         r->table_options.format_version,
+                         is_data_block ? Slice(r->compression_dict) : Slice(),
+                         compressed_output);
+  }
+  RecordTick(r->ioptions.statistics, NUMBER_BLOCK_NOT_COMPRESSED);
+  *type = kNoCompression;
+  return raw_block_contents;
+}
+
 void BlockBasedTableBuilder::WriteRawBlock(const Slice& block_contents,
                                            CompressionType type,
                                            BlockHandle* handle) {
@@ -711,6 +1158,13 @@ Status BlockBasedTableBuilder::Finish() {
   Rep* r = rep_;
   bool empty_data_block = r->data_block.empty();
   Flush();
+  if (r->buffer_data_blocks) {
+    EnterUnbuffered();
+  }
+  if (r->pc_rep != nullptr) {
+    WriteCompressedBlocks(0);
+    r->pc_rep->Stop();
+  }
   assert(!r->closed);
   r->closed = true;
 
@@ -745,7 +1199,7 @@ Status BlockBasedTableBuilder::Finish() {
   MetaIndexBuilder meta_index_builder;
   for (const auto& item : index_blocks.meta_blocks) {
     BlockHandle block_handle;
-    WriteBlock(item.second, &block_handle);
+    WriteBlock(item.second, &block_handle, false /* is_data_block */);
     meta_index_builder.Add(item.first, block_handle);
   }
 
@@ -763,6 +1217,16 @@ Status BlockBasedTableBuilder::Finish() {
       meta_index_builder.Add(key, filter_block_handle);
     }
 
+    // Write the compression dictionary, which the reader needs to
+    // uncompress the data blocks.
+    if (!r->compression_dict.empty()) {
+      BlockHandle compression_dict_block_handle;
+      WriteRawBlock(r->compression_dict, kNoCompression,
+                    &compression_dict_block_handle);
+      meta_index_builder.Add(kCompressionDictBlock,
+                             compression_dict_block_handle);
+    }
+
     // Write properties block.
     {
       PropertyBlockBuilder property_block_builder;
@@ -795,7 +1259,8 @@ Status BlockBasedTableBuilder::Finish() {
     // flush the meta index block
     WriteRawBlock(meta_index_builder.Finish(), kNoCompression,
                   &metaindex_block_handle);
-    WriteBlock(index_blocks.index_block_contents, &index_block_handle);
+    WriteBlock(index_blocks.index_block_contents, &index_block_handle,
+               false /* is_data_block */);
   }
 
   // Write footer
@@ -853,6 +1318,9 @@ Status BlockBasedTableBuilder::Finish() {
 void BlockBasedTableBuilder::Abandon() {
   Rep* r = rep_;
   assert(!r->closed);
+  if (r->pc_rep != nullptr) {
+    r->pc_rep->Stop();
+  }
   r->closed = true;
 }
 
@@ -861,7 +1329,10 @@ uint64_t BlockBasedTableBuilder::NumEntries() const {
 }
 
 uint64_t BlockBasedTableBuilder::FileSize() const {
-  return rep_->offset;
+  // Count the buffered data blocks and the ones still being compressed so
+  // that compactions still cut their output files at the target size.
+  return rep_->offset + rep_->data_block_buffers_size +
+         (rep_->pc_rep != nullptr ? rep_->pc_rep->raw_bytes_in_flight : 0);
 }
 
 const std::string BlockBasedTable::kFilterBlockPrefix = "filter.";
@@ -70,14 +70,23 @@ class BlockBasedTableBuilder : public TableBuilder {
   bool ok() const { return status().ok(); }
   // Call block's Finish() method and then write the finalize block contents to
   // file.
-  void WriteBlock(BlockBuilder* block, BlockHandle* handle);
-  // Directly write block content to the file.
-  void WriteBlock(const Slice& block_contents, BlockHandle* handle);
+  void WriteBlock(BlockBuilder* block, BlockHandle* handle,
+                  bool is_data_block);
+  // Directly write block content to the file. Only data blocks are
+  // compressed with the compression dictionary.
+  void WriteBlock(const Slice& block_contents, BlockHandle* handle,
+                  bool is_data_block);
+  // Compress a block unless that does not pay off, and set *type to the
+  // compression used. Safe to call from the compression workers.
+  Slice CompressBlockContents(const Slice& raw_block_contents,
+                              bool is_data_block, CompressionType* type,
+                              std::string* compressed_output) const;
   void WriteRawBlock(const Slice& data, CompressionType, BlockHandle* handle);
   Status InsertBlockInCache(const Slice& block_contents,
                             const CompressionType type,
                             const BlockHandle* handle);
   struct Rep;
+  struct ParallelCompressionRep;
   class BlockBasedTablePropertiesCollectorFactory;
   class BlockBasedTablePropertiesCollector;
   Rep* rep_;
@@ -88,6 +97,30 @@ class BlockBasedTableBuilder : public TableBuilder {
   // REQUIRES: Finish(), Abandon() have not been called
   void Flush();
 
+  // Update the bookkeeping after a data block was written to the file.
+  void DataBlockWritten();
+
+  // Build the compression dictionary from the buffered data blocks, then
+  // write them out and add their keys to the filter and index. Afterwards
+  // data blocks are written as soon as they are full.
+  void EnterUnbuffered();
+
+  // Add the keys of a data block that is about to be written to the filter
+  // and index, and set *last_key to its last key.
+  void AddBlockKeysToFilterAndIndex(const Slice& raw_block_contents,
+                                    std::string* last_key);
+
+  // Hand the full data block to the compression workers.
+  void SubmitDataBlock();
+
+  // Loop of the compression worker threads.
+  void CompressionWorker();
+
+  // Write the compressed data blocks at the front of the pipeline, in file
+  // order. Waits for the compression workers while more than max_in_flight
+  // blocks are in the pipeline.
+  void WriteCompressedBlocks(size_t max_in_flight);
+
   // Some compression libraries fail when the raw size is bigger than int. If
   // uncompressed size is bigger than kCompressionSizeLimit, don't compress it
   const uint64_t kCompressionSizeLimit = std::numeric_limits<int>::max();
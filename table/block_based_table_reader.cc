@@ -9,6 +9,7 @@
 
 #include "table/block_based_table_reader.h"
 
+#include <algorithm>
 #include <string>
 #include <utility>
 
@@ -20,6 +21,7 @@
 #include "rocksdb/filter_policy.h"
 #include "rocksdb/iterator.h"
 #include "rocksdb/options.h"
+#include "rocksdb/persistent_cache.h"
 #include "rocksdb/statistics.h"
 #include "rocksdb/table.h"
 #include "rocksdb/table_properties.h"
@@ -30,6 +32,7 @@
 #include "table/block_based_table_factory.h"
 #include "table/full_filter_block.h"
 #include "table/block_hash_index.h"
+#include "table/block_learned_index.h"
 #include "table/block_prefix_index.h"
 #include "table/format.h"
 #include "table/meta_blocks.h"
@@ -37,7 +40,9 @@
 #include "table/get_context.h"
 
 #include "util/coding.h"
+#include "util/murmurhash.h"
 #include "util/perf_context_imp.h"
+#include "util/readahead_file.h"
 #include "util/stop_watch.h"
 #include "util/string_util.h"
 
@@ -46,6 +51,7 @@ namespace rocksdb {
 extern const uint64_t kBlockBasedTableMagicNumber;
 extern const std::string kHashIndexPrefixesBlock;
 extern const std::string kHashIndexPrefixesMetadataBlock;
+extern const std::string kLearnedIndexBlock;
 using std::unique_ptr;
 
 typedef BlockBasedTable::IndexReader IndexReader;
@@ -59,16 +65,18 @@ const size_t kMaxCacheKeyPrefixSize __attribute__((unused)) =
     kMaxVarint64Length * 3 + 1;
 
 // Read the block identified by "handle" from "file".
-// The only relevant option is options.verify_checksums for now.
+// The relevant options are verify_checksums, deadline and io_timeout.
 // On failure return non-OK.
 // On success fill *result and return OK - caller owns *result
+// compression_dict is only needed for the data blocks.
 Status ReadBlockFromFile(RandomAccessFile* file, const Footer& footer,
                          const ReadOptions& options, const BlockHandle& handle,
                          std::unique_ptr<Block>* result, Env* env,
-                         bool do_uncompress = true) {
+                         bool do_uncompress = true,
+                         const Slice& compression_dict = Slice()) {
   BlockContents contents;
   Status s = ReadBlockContents(file, footer, options, handle, &contents, env,
-                               do_uncompress);
+                               do_uncompress, compression_dict);
   if (s.ok()) {
     result->reset(new Block(std::move(contents)));
   }
@@ -76,6 +84,13 @@ Status ReadBlockFromFile(RandomAccessFile* file, const Footer& footer,
   return s;
 }
 
+// Readahead window used once an iterator reads data blocks sequentially.
+// It starts small and doubles on every refill up to
+// BlockBasedTableOptions::max_auto_readahead_size.
+const size_t kInitAutoReadaheadSize = 8 * 1024;
+// Number of back-to-back sequential block reads before readahead starts.
+const int kNumSequentialReadsForReadahead = 2;
+
 // Delete the resource that is held by the iterator.
 template <class ResourceType>
 void DeleteHeldResource(void* arg, void* ignored) {
@@ -96,6 +111,53 @@ void ReleaseCachedEntry(void* arg, void* h) {
   cache->Release(handle);
 }
 
+// Data blocks of tables with a persistent cache are kept in the block cache
+// wrapped in a PersistentCacheBlock, so that they can be admitted to the
+// persistent cache once the block cache evicts them.
+struct PersistentCacheBlock {
+  PersistentCacheBlock(Block* _block,
+                       const std::shared_ptr<PersistentCache>& _cache,
+                       const Slice& _key)
+      : block(_block), persistent_cache(_cache), key(_key.ToString()) {}
+
+  std::unique_ptr<Block> block;
+  std::shared_ptr<PersistentCache> persistent_cache;
+  std::string key;
+};
+
+void AdmitToPersistentCache(const Slice& key, void* value) {
+  auto entry = reinterpret_cast<PersistentCacheBlock*>(value);
+  // Inserting a block that came from the persistent cache is a no-op.
+  entry->persistent_cache->Insert(entry->key, entry->block->data(),
+                                  entry->block->size());
+  delete entry;
+}
+
+// Insert an uncompressed data block into the block cache, setting it up for
+// admission to the persistent cache if persistent_cache_key is not empty.
+Cache::Handle* InsertDataBlock(
+    Cache* block_cache, const Slice& block_cache_key, Block* block,
+    const std::shared_ptr<PersistentCache>& persistent_cache,
+    const Slice& persistent_cache_key) {
+  if (persistent_cache_key.empty()) {
+    return block_cache->Insert(block_cache_key, block, block->size(),
+                               &DeleteCachedEntry<Block>);
+  }
+  return block_cache->Insert(
+      block_cache_key,
+      new PersistentCacheBlock(block, persistent_cache, persistent_cache_key),
+      block->size(), &AdmitToPersistentCache);
+}
+
+Block* DataBlockFromCache(Cache* block_cache, Cache::Handle* handle,
+                          const Slice& persistent_cache_key) {
+  void* value = block_cache->Value(handle);
+  if (persistent_cache_key.empty()) {
+    return reinterpret_cast<Block*>(value);
+  }
+  return reinterpret_cast<PersistentCacheBlock*>(value)->block.get();
+}
+
 Slice GetCacheKey(const char* cache_key_prefix, size_t cache_key_prefix_size,
                   const BlockHandle& handle, char* cache_key) {
   assert(cache_key != nullptr);
@@ -165,17 +227,21 @@ class BinarySearchIndexReader : public IndexReader {
   // `BinarySearchIndexReader`.
   // On success, index_reader will be populated; otherwise it will remain
   // unmodified.
+  // If index_key_includes_seq is false, comparator is the user comparator.
   static Status Create(RandomAccessFile* file, const Footer& footer,
                        const BlockHandle& index_handle, Env* env,
                        const Comparator* comparator,
-                       IndexReader** index_reader) {
+                       IndexReader** index_reader,
+                       bool index_key_includes_seq = true,
+                       bool index_value_delta_encoded = false) {
     std::unique_ptr<Block> index_block;
     auto s = ReadBlockFromFile(file, footer, ReadOptions(), index_handle,
                                &index_block, env);
 
     if (s.ok()) {
-      *index_reader =
-          new BinarySearchIndexReader(comparator, std::move(index_block));
+      *index_reader = new BinarySearchIndexReader(
+          comparator, std::move(index_block), index_key_includes_seq,
+          index_value_delta_encoded);
     }
 
     return s;
@@ -183,7 +249,9 @@ class BinarySearchIndexReader : public IndexReader {
 
   virtual Iterator* NewIterator(
       BlockIter* iter = nullptr, bool dont_care = true) override {
-    return index_block_->NewIterator(comparator_, iter, true);
+    return index_block_->NewIterator(comparator_, iter, true,
+                                     index_key_includes_seq_,
+                                     index_value_delta_encoded_);
   }
 
   virtual size_t size() const override { return index_block_->size(); }
@@ -195,11 +263,18 @@ class BinarySearchIndexReader : public IndexReader {
 
  private:
   BinarySearchIndexReader(const Comparator* comparator,
-                          std::unique_ptr<Block>&& index_block)
-      : IndexReader(comparator), index_block_(std::move(index_block)) {
+                          std::unique_ptr<Block>&& index_block,
+                          bool index_key_includes_seq,
+                          bool index_value_delta_encoded)
+      : IndexReader(comparator),
+        index_block_(std::move(index_block)),
+        index_key_includes_seq_(index_key_includes_seq),
+        index_value_delta_encoded_(index_value_delta_encoded) {
     assert(index_block_ != nullptr);
   }
   std::unique_ptr<Block> index_block_;
+  const bool index_key_includes_seq_;
+  const bool index_value_delta_encoded_;
 };
 
 // Index that leverages an internal hash table to quicken the lookup for a given
@@ -320,6 +395,83 @@ class HashIndexReader : public IndexReader {
   BlockContents prefixes_contents_;
 };
 
+// Binary search index whose seeks are narrowed down by a learned model of
+// the positions of its keys.
+class LearnedIndexReader : public IndexReader {
+ public:
+  static Status Create(RandomAccessFile* file, const Footer& footer,
+                       const BlockHandle& index_handle, Env* env,
+                       const Comparator* comparator,
+                       Iterator* meta_index_iter, IndexReader** index_reader,
+                       bool index_key_includes_seq,
+                       bool index_value_delta_encoded) {
+    std::unique_ptr<Block> index_block;
+    auto s = ReadBlockFromFile(file, footer, ReadOptions(), index_handle,
+                               &index_block, env);
+
+    if (!s.ok()) {
+      return s;
+    }
+
+    // Like for the hash index, the binary search index works without the
+    // model, so failing to load it is not an error.
+    auto new_index_reader = new LearnedIndexReader(
+        comparator, std::move(index_block), index_key_includes_seq,
+        index_value_delta_encoded);
+    *index_reader = new_index_reader;
+
+    BlockHandle model_handle;
+    s = FindMetaBlock(meta_index_iter, kLearnedIndexBlock, &model_handle);
+    if (!s.ok()) {
+      // Not written for comparators other than bytewise
+      return Status::OK();
+    }
+    BlockContents model_contents;
+    s = ReadBlockContents(file, footer, ReadOptions(), model_handle,
+                          &model_contents, env, true /* do decompression */);
+    if (!s.ok()) {
+      // TODO: log error
+      return Status::OK();
+    }
+    BlockLearnedIndex* learned_index = nullptr;
+    s = BlockLearnedIndex::Create(model_contents.data, &learned_index);
+    // TODO: log error
+    if (s.ok()) {
+      new_index_reader->index_block_->SetBlockLearnedIndex(learned_index);
+    }
+
+    return Status::OK();
+  }
+
+  virtual Iterator* NewIterator(
+      BlockIter* iter = nullptr, bool dont_care = true) override {
+    return index_block_->NewIterator(comparator_, iter, true,
+                                     index_key_includes_seq_,
+                                     index_value_delta_encoded_);
+  }
+
+  virtual size_t size() const override { return index_block_->size(); }
+
+  virtual size_t ApproximateMemoryUsage() const override {
+    assert(index_block_);
+    return index_block_->ApproximateMemoryUsage();
+  }
+
+ private:
+  LearnedIndexReader(const Comparator* comparator,
+                     std::unique_ptr<Block>&& index_block,
+                     bool index_key_includes_seq,
+                     bool index_value_delta_encoded)
+      : IndexReader(comparator),
+        index_block_(std::move(index_block)),
+        index_key_includes_seq_(index_key_includes_seq),
+        index_value_delta_encoded_(index_value_delta_encoded) {
+    assert(index_block_ != nullptr);
+  }
+  std::unique_ptr<Block> index_block_;
+  const bool index_key_includes_seq_;
+  const bool index_value_delta_encoded_;
+};
 
 struct BlockBasedTable::Rep {
   Rep(const ImmutableCFOptions& _ioptions, const EnvOptions& _env_options,
@@ -340,10 +492,17 @@ struct BlockBasedTable::Rep {
   const InternalKeyComparator& internal_comparator;
   Status status;
   unique_ptr<RandomAccessFile> file;
+  uint64_t file_size = 0;
   char cache_key_prefix[kMaxCacheKeyPrefixSize];
   size_t cache_key_prefix_size = 0;
   char compressed_cache_key_prefix[kMaxCacheKeyPrefixSize];
   size_t compressed_cache_key_prefix_size = 0;
+  // Unlike the block cache keys, the keys of the persistent cache must not
+  // be reused by another file after a restart, so they are derived from the
+  // unique ID of the file together with the shape of the table. Zero when the
+  // persistent cache is not used.
+  char persistent_cache_key_prefix[kMaxCacheKeyPrefixSize];
+  size_t persistent_cache_key_prefix_size = 0;
 
   // Footer contains the fixed table information
   Footer footer;
@@ -363,6 +522,11 @@ struct BlockBasedTable::Rep {
   // and compatible with existing code, we introduce a wrapper that allows
   // block to extract prefix without knowing if a key is internal or not.
   unique_ptr<SliceTransform> internal_prefix_transform;
+
+  // The dictionary the data blocks were compressed with, empty if the file
+  // does not have one
+  BlockContents compression_dict_block;
+  Slice compression_dict() const { return compression_dict_block.data; }
 };
 
 BlockBasedTable::~BlockBasedTable() {
@@ -436,6 +600,36 @@ void BlockBasedTable::GenerateCachePrefix(Cache* cc,
   }
 }
 
+void BlockBasedTable::SetupPersistentCacheKeyPrefix(Rep* rep,
+                                                    uint64_t file_size) {
+  rep->persistent_cache_key_prefix_size = 0;
+  if (rep->table_options.persistent_cache == nullptr ||
+      rep->table_options.block_cache == nullptr) {
+    return;
+  }
+  char id[kMaxCacheKeyPrefixSize];
+  size_t id_size = rep->file->GetUniqueId(id, kMaxCacheKeyPrefixSize);
+  if (id_size == 0) {
+    // Without a stable ID, blocks cannot be found again after a restart.
+    return;
+  }
+  std::string fingerprint(id, id_size);
+  PutVarint64(&fingerprint, file_size);
+  rep->footer.index_handle().EncodeTo(&fingerprint);
+  rep->footer.metaindex_handle().EncodeTo(&fingerprint);
+  if (rep->table_properties) {
+    PutVarint64(&fingerprint, rep->table_properties->num_entries);
+    PutVarint64(&fingerprint, rep->table_properties->raw_key_size);
+    PutVarint64(&fingerprint, rep->table_properties->raw_value_size);
+  }
+  const int len = static_cast<int>(fingerprint.size());
+  EncodeFixed64(rep->persistent_cache_key_prefix,
+                MurmurHash(fingerprint.data(), len, 0));
+  EncodeFixed64(rep->persistent_cache_key_prefix + 8,
+                MurmurHash(fingerprint.data(), len, 1));
+  rep->persistent_cache_key_prefix_size = 16;
+}
+
 namespace {
 // Return True if table_properties has `user_prop_name` has a `true` value
 // or it doesn't contain this property (for backward compatible).
@@ -484,6 +678,7 @@ Status BlockBasedTable::Open(const ImmutableCFOptions& ioptions,
   Rep* rep = new BlockBasedTable::Rep(
       ioptions, env_options, table_options, internal_comparator);
   rep->file = std::move(file);
+  rep->file_size = file_size;
   rep->footer = footer;
   rep->index_type = table_options.index_type;
   rep->hash_index_allow_collision = table_options.hash_index_allow_collision;
@@ -527,6 +722,20 @@ Status BlockBasedTable::Open(const ImmutableCFOptions& ioptions,
         "Cannot find Properties block from file.");
   }
 
+  // Read the compression dictionary, without it the data blocks cannot be
+  // uncompressed.
+  BlockHandle compression_dict_handle;
+  if (FindMetaBlock(meta_iter.get(), kCompressionDictBlock,
+                    &compression_dict_handle).ok()) {
+    s = ReadBlockContents(rep->file.get(), rep->footer, ReadOptions(),
+                          compression_dict_handle,
+                          &rep->compression_dict_block, rep->ioptions.env,
+                          false /* do_uncompress */);
+    if (!s.ok()) {
+      return s;
+    }
+  }
+
   // Determine whether whole key filtering is supported.
   if (rep->table_properties) {
     rep->whole_key_filtering &=
@@ -538,6 +747,8 @@ Status BlockBasedTable::Open(const ImmutableCFOptions& ioptions,
         BlockBasedTablePropertyNames::kPrefixFiltering, rep->ioptions.info_log);
   }
 
+  SetupPersistentCacheKeyPrefix(rep, file_size);
+
   if (prefetch_index_and_filter) {
     // pre-fetching of blocks is turned on
     // Will use block cache for index/filter blocks access?
@@ -650,7 +861,9 @@ Status BlockBasedTable::GetDataBlockFromCache(
     const Slice& block_cache_key, const Slice& compressed_block_cache_key,
     Cache* block_cache, Cache* block_cache_compressed, Statistics* statistics,
     const ReadOptions& read_options,
-    BlockBasedTable::CachableEntry<Block>* block, uint32_t format_version) {
+    BlockBasedTable::CachableEntry<Block>* block, uint32_t format_version,
+    const std::shared_ptr<PersistentCache>& persistent_cache,
+    const Slice& persistent_cache_key, const Slice& compression_dict) {
   Status s;
   Block* compressed_block = nullptr;
   Cache::Handle* block_cache_compressed_handle = nullptr;
@@ -661,8 +874,8 @@ Status BlockBasedTable::GetDataBlockFromCache(
         GetEntryFromCache(block_cache, block_cache_key, BLOCK_CACHE_DATA_MISS,
                           BLOCK_CACHE_DATA_HIT, statistics);
     if (block->cache_handle != nullptr) {
-      block->value =
-          reinterpret_cast<Block*>(block_cache->Value(block->cache_handle));
+      block->value = DataBlockFromCache(block_cache, block->cache_handle,
+                                        persistent_cache_key);
       return s;
     }
   }
@@ -694,7 +907,7 @@ Status BlockBasedTable::GetDataBlockFromCache(
   BlockContents contents;
   s = UncompressBlockContents(compressed_block->data(),
                               compressed_block->size(), &contents,
-                              format_version);
+                              format_version, compression_dict);
 
   // Insert uncompressed block into block cache
   if (s.ok()) {
@@ -703,10 +916,10 @@ Status BlockBasedTable::GetDataBlockFromCache(
     if (block_cache != nullptr && block->value->cachable() &&
         read_options.fill_cache) {
       block->cache_handle =
-          block_cache->Insert(block_cache_key, block->value,
-                              block->value->size(), &DeleteCachedEntry<Block>);
-      assert(reinterpret_cast<Block*>(
-                 block_cache->Value(block->cache_handle)) == block->value);
+          InsertDataBlock(block_cache, block_cache_key, block->value,
+                          persistent_cache, persistent_cache_key);
+      assert(DataBlockFromCache(block_cache, block->cache_handle,
+                                persistent_cache_key) == block->value);
     }
   }
 
@@ -719,7 +932,9 @@ Status BlockBasedTable::PutDataBlockToCache(
     const Slice& block_cache_key, const Slice& compressed_block_cache_key,
     Cache* block_cache, Cache* block_cache_compressed,
     const ReadOptions& read_options, Statistics* statistics,
-    CachableEntry<Block>* block, Block* raw_block, uint32_t format_version) {
+    CachableEntry<Block>* block, Block* raw_block, uint32_t format_version,
+    const std::shared_ptr<PersistentCache>& persistent_cache,
+    const Slice& persistent_cache_key, const Slice& compression_dict) {
   assert(raw_block->compression_type() == kNoCompression ||
          block_cache_compressed != nullptr);
 
@@ -728,7 +943,7 @@ Status BlockBasedTable::PutDataBlockToCache(
   BlockContents contents;
   if (raw_block->compression_type() != kNoCompression) {
     s = UncompressBlockContents(raw_block->data(), raw_block->size(), &contents,
-                                format_version);
+                                format_version, compression_dict);
   }
   if (!s.ok()) {
     delete raw_block;
@@ -760,13 +975,43 @@ Status BlockBasedTable::PutDataBlockToCache(
   assert((block->value->compression_type() == kNoCompression));
   if (block_cache != nullptr && block->value->cachable()) {
     block->cache_handle =
-        block_cache->Insert(block_cache_key, block->value, block->value->size(),
-                            &DeleteCachedEntry<Block>);
+        InsertDataBlock(block_cache, block_cache_key, block->value,
+                        persistent_cache, persistent_cache_key);
     RecordTick(statistics, BLOCK_CACHE_ADD);
-    assert(reinterpret_cast<Block*>(block_cache->Value(block->cache_handle)) ==
-           block->value);
+    assert(DataBlockFromCache(block_cache, block->cache_handle,
+                              persistent_cache_key) == block->value);
+  }
+
+  return s;
+}
+
+Status BlockBasedTable::GetDataBlockFromPersistentCache(
+    Rep* rep, const Slice& block_cache_key, const Slice& persistent_cache_key,
+    const ReadOptions& read_options, CachableEntry<Block>* block) {
+  assert(block->value == nullptr && block->cache_handle == nullptr);
+  Statistics* statistics = rep->ioptions.statistics;
+  std::unique_ptr<char[]> data;
+  size_t size = 0;
+  Status s = rep->table_options.persistent_cache->Lookup(persistent_cache_key,
+                                                         &data, &size);
+  if (!s.ok()) {
+    RecordTick(statistics, PERSISTENT_CACHE_MISS);
+    return s;
   }
+  RecordTick(statistics, PERSISTENT_CACHE_HIT);
 
+  // The persistent cache holds uncompressed blocks.
+  block->value = new Block(
+      BlockContents(std::move(data), size, true /* cachable */,
+                    kNoCompression));
+  Cache* block_cache = rep->table_options.block_cache.get();
+  if (read_options.fill_cache) {
+    block->cache_handle =
+        InsertDataBlock(block_cache, block_cache_key, block->value,
+                        rep->table_options.persistent_cache,
+                        persistent_cache_key);
+    RecordTick(statistics, BLOCK_CACHE_ADD);
+  }
   return s;
 }
 
@@ -931,8 +1176,11 @@ Iterator* BlockBasedTable::NewIndexIterator(const ReadOptions& read_options,
 // If input_iter is not null, update this iter and return it
 Iterator* BlockBasedTable::NewDataBlockIterator(Rep* rep,
     const ReadOptions& ro, const Slice& index_value,
-    BlockIter* input_iter) {
+    BlockIter* input_iter, RandomAccessFile* file) {
   const bool no_io = (ro.read_tier == kBlockCacheTier);
+  if (file == nullptr) {
+    file = rep->file.get();
+  }
   Cache* block_cache = rep->table_options.block_cache.get();
   Cache* block_cache_compressed =
       rep->table_options.block_cache_compressed.get();
@@ -958,8 +1206,10 @@ Iterator* BlockBasedTable::NewDataBlockIterator(Rep* rep,
     Statistics* statistics = rep->ioptions.statistics;
     char cache_key[kMaxCacheKeyPrefixSize + kMaxVarint64Length];
     char compressed_cache_key[kMaxCacheKeyPrefixSize + kMaxVarint64Length];
+    char persistent_cache_key[kMaxCacheKeyPrefixSize + kMaxVarint64Length];
     Slice key, /* key to the block cache */
-        ckey /* key to the compressed block cache */;
+        ckey, /* key to the compressed block cache */
+        pkey /* key to the persistent cache */;
 
     // create key for block cache
     if (block_cache != nullptr) {
@@ -973,23 +1223,43 @@ Iterator* BlockBasedTable::NewDataBlockIterator(Rep* rep,
                          compressed_cache_key);
     }
 
+    if (rep->persistent_cache_key_prefix_size != 0) {
+      pkey = GetCacheKey(rep->persistent_cache_key_prefix,
+                         rep->persistent_cache_key_prefix_size, handle,
+                         persistent_cache_key);
+    }
+
     s = GetDataBlockFromCache(key, ckey, block_cache, block_cache_compressed,
                               statistics, ro, &block,
-                              rep->table_options.format_version);
+                              rep->table_options.format_version,
+                              rep->table_options.persistent_cache, pkey,
+                              rep->compression_dict());
+
+    // Next, try the persistent cache before going to the file. Failures
+    // there are not fatal, we can still read the block from the file.
+    if (block.value == nullptr && !no_io && !pkey.empty()) {
+      s = GetDataBlockFromPersistentCache(rep, key, pkey, ro, &block);
+      if (!s.ok()) {
+        s = Status::OK();
+      }
+    }
 
     if (block.value == nullptr && !no_io && ro.fill_cache) {
       std::unique_ptr<Block> raw_block;
       {
         StopWatch sw(rep->ioptions.env, statistics, READ_BLOCK_GET_MICROS);
-        s = ReadBlockFromFile(rep->file.get(), rep->footer, ro, handle,
-                              &raw_block, rep->ioptions.env,
-                              block_cache_compressed == nullptr);
+        s = ReadBlockFromFile(file, rep->footer, ro, handle, &raw_block,
+                              rep->ioptions.env,
+                              block_cache_compressed == nullptr,
+                              rep->compression_dict());
       }
 
       if (s.ok()) {
         s = PutDataBlockToCache(key, ckey, block_cache, block_cache_compressed,
                                 ro, statistics, &block, raw_block.release(),
-                                rep->table_options.format_version);
+                                rep->table_options.format_version,
+                                rep->table_options.persistent_cache, pkey,
+                                rep->compression_dict());
       }
     }
   }
@@ -1006,8 +1276,9 @@ Iterator* BlockBasedTable::NewDataBlockIterator(Rep* rep,
       }
     }
     std::unique_ptr<Block> block_value;
-    s = ReadBlockFromFile(rep->file.get(), rep->footer, ro, handle,
-                          &block_value, rep->ioptions.env);
+    s = ReadBlockFromFile(file, rep->footer, ro, handle, &block_value,
+                          rep->ioptions.env, true /* do_uncompress */,
+                          rep->compression_dict());
     if (s.ok()) {
       block.value = block_value.release();
     }
@@ -1036,14 +1307,28 @@ Iterator* BlockBasedTable::NewDataBlockIterator(Rep* rep,
 class BlockBasedTable::BlockEntryIteratorState : public TwoLevelIteratorState {
  public:
   BlockEntryIteratorState(BlockBasedTable* table,
-                          const ReadOptions& read_options)
+                          const ReadOptions& read_options, bool for_compaction)
       : TwoLevelIteratorState(
-          table->rep_->ioptions.prefix_extractor != nullptr),
+          table->rep_->ioptions.prefix_extractor != nullptr,
+          read_options.pin_data),
         table_(table),
-        read_options_(read_options) {}
+        read_options_(read_options) {
+    // mmap reads are served from memory without copying, and compactions
+    // have compaction_readahead_size
+    const size_t max_readahead_size =
+        table->rep_->table_options.max_auto_readahead_size;
+    if (!table->rep_->ioptions.allow_mmap_reads && !for_compaction &&
+        max_readahead_size > 0) {
+      readahead_file_.reset(new ReadaheadRandomAccessFile(
+          table->rep_->file.get(), table->rep_->file_size,
+          kInitAutoReadaheadSize, max_readahead_size,
+          kNumSequentialReadsForReadahead));
+    }
+  }
 
   Iterator* NewSecondaryIterator(const Slice& index_value) override {
-    return NewDataBlockIterator(table_->rep_, read_options_, index_value);
+    return NewDataBlockIterator(table_->rep_, read_options_, index_value,
+                                nullptr, readahead_file_.get());
   }
 
   bool PrefixMayMatch(const Slice& internal_key) override {
@@ -1053,10 +1338,37 @@ class BlockBasedTable::BlockEntryIteratorState : public TwoLevelIteratorState {
     return table_->PrefixMayMatch(internal_key);
   }
 
+  // An index key is at or past the last key of its block and at or before
+  // the first key of the next one
+  bool KeyReachesUpperBound(const Slice& index_key) override {
+    return read_options_.iterate_upper_bound != nullptr &&
+           user_comparator()->Compare(ExtractUserKey(index_key),
+                                      *read_options_.iterate_upper_bound) >= 0;
+  }
+
+  bool KeyBelowLowerBound(const Slice& index_key) override {
+    return read_options_.iterate_lower_bound != nullptr &&
+           user_comparator()->Compare(ExtractUserKey(index_key),
+                                      *read_options_.iterate_lower_bound) < 0;
+  }
+
+  // Don't read ahead past offset
+  void SetReadaheadLimit(uint64_t offset) {
+    if (readahead_file_ != nullptr) {
+      readahead_file_->SetReadaheadLimit(offset);
+    }
+  }
+
  private:
+  const Comparator* user_comparator() const {
+    return table_->rep_->internal_comparator.user_comparator();
+  }
+
   // Don't own table_
   BlockBasedTable* table_;
   const ReadOptions read_options_;
+  // Data block reads of this iterator go through readahead_file_
+  std::unique_ptr<ReadaheadRandomAccessFile> readahead_file_;
 };
 
 // This will be broken if the user specifies an unusual implementation
@@ -1147,9 +1459,25 @@ bool BlockBasedTable::PrefixMayMatch(const Slice& internal_key) {
 }
 
 Iterator* BlockBasedTable::NewIterator(const ReadOptions& read_options,
-                                       Arena* arena) {
-  return NewTwoLevelIterator(new BlockEntryIteratorState(this, read_options),
-                             NewIndexIterator(read_options), arena);
+                                       Arena* arena, bool for_compaction) {
+  auto state = new BlockEntryIteratorState(this, read_options, for_compaction);
+  Iterator* index_iter = NewIndexIterator(read_options);
+  if (read_options.iterate_upper_bound != nullptr) {
+    // Readahead stops at the end of the data block that holds the upper
+    // bound. The two level iterator positions index_iter again before use.
+    InternalKey bound(*read_options.iterate_upper_bound, kMaxSequenceNumber,
+                      kValueTypeForSeek);
+    index_iter->Seek(bound.Encode());
+    if (index_iter->Valid()) {
+      Slice index_value = index_iter->value();
+      BlockHandle handle;
+      if (handle.DecodeFrom(&index_value).ok()) {
+        state->SetReadaheadLimit(handle.offset() + handle.size() +
+                                 kBlockTrailerSize);
+      }
+    }
+  }
+  return NewTwoLevelIterator(state, index_iter, arena);
 }
 
 bool BlockBasedTable::FullFilterKeyMayMatch(FilterBlockReader* filter,
@@ -1216,14 +1544,22 @@ Status BlockBasedTable::Get(
           break;
         }
 
+        if (!biter.SeekForGet(key,
+                              rep_->internal_comparator.user_comparator())) {
+          // The key is neither in this block nor in any later one.
+          done = true;
+        }
+
         // Call the *saver function on each entry/block until it returns false
-        for (biter.Seek(key); biter.Valid(); biter.Next()) {
+        for (; biter.Valid(); biter.Next()) {
           ParsedInternalKey parsed_key;
           if (!ParseInternalKey(biter.key(), &parsed_key)) {
             s = Status::Corruption(Slice());
           }
 
-          if (!get_context->SaveValue(parsed_key, biter.value())) {
+          // The value is not copied: if it is found, the data block stays
+          // pinned by the result until the caller releases it.
+          if (!get_context->SaveValue(parsed_key, biter.value(), &biter)) {
             done = true;
             break;
           }
@@ -1305,10 +1641,20 @@ bool BlockBasedTable::TEST_KeyInCache(const ReadOptions& options,
       GetCacheKey(rep_->cache_key_prefix, rep_->cache_key_prefix_size,
                   handle, cache_key_storage);
   Slice ckey;
+  char persistent_cache_key_storage[kMaxCacheKeyPrefixSize +
+                                    kMaxVarint64Length];
+  Slice pkey;
+  if (rep_->persistent_cache_key_prefix_size != 0) {
+    pkey = GetCacheKey(rep_->persistent_cache_key_prefix,
+                       rep_->persistent_cache_key_prefix_size, handle,
+                       persistent_cache_key_storage);
+  }
 
   s = GetDataBlockFromCache(cache_key, ckey, block_cache, nullptr, nullptr,
                             options, &block,
-                            rep_->table_options.format_version);
+                            rep_->table_options.format_version,
+                            rep_->table_options.persistent_cache, pkey,
+                            rep_->compression_dict());
   assert(s.ok());
   bool in_cache = block.value != nullptr;
   if (in_cache) {
@@ -1342,6 +1688,18 @@ Status BlockBasedTable::CreateIndexReader(IndexReader** index_reader,
   auto comparator = &rep_->internal_comparator;
   const Footer& footer = rep_->footer;
 
+  // Since format_version 3 the block handles of the binary search index are
+  // delta encoded, and its keys may be user keys.
+  const bool index_value_delta_encoded = footer.version() >= 3;
+  bool index_key_includes_seq = true;
+  if (rep_->table_properties) {
+    auto& props = rep_->table_properties->user_collected_properties;
+    auto pos = props.find(BlockBasedTablePropertyNames::kIndexKeyIsUserKey);
+    index_key_includes_seq = pos == props.end() || pos->second != kPropTrue;
+  }
+  const Comparator* binary_search_comparator =
+      index_key_includes_seq ? comparator : comparator->user_comparator();
+
   if (index_type_on_file == BlockBasedTableOptions::kHashSearch &&
       rep_->ioptions.prefix_extractor == nullptr) {
     Log(InfoLogLevel::WARN_LEVEL, rep_->ioptions.info_log,
@@ -1354,7 +1712,8 @@ Status BlockBasedTable::CreateIndexReader(IndexReader** index_reader,
   switch (index_type_on_file) {
     case BlockBasedTableOptions::kBinarySearch: {
       return BinarySearchIndexReader::Create(
-          file, footer, footer.index_handle(), env, comparator, index_reader);
+          file, footer, footer.index_handle(), env, binary_search_comparator,
+          index_reader, index_key_includes_seq, index_value_delta_encoded);
     }
     case BlockBasedTableOptions::kHashSearch: {
       std::unique_ptr<Block> meta_guard;
@@ -1383,6 +1742,28 @@ Status BlockBasedTable::CreateIndexReader(IndexReader** index_reader,
           footer.index_handle(), meta_index_iter, index_reader,
           rep_->hash_index_allow_collision);
     }
+    case BlockBasedTableOptions::kLearnedSearch: {
+      std::unique_ptr<Block> meta_guard;
+      std::unique_ptr<Iterator> meta_iter_guard;
+      auto meta_index_iter = preloaded_meta_index_iter;
+      if (meta_index_iter == nullptr) {
+        auto s = ReadMetaBlock(rep_, &meta_guard, &meta_iter_guard);
+        if (!s.ok()) {
+          Log(InfoLogLevel::WARN_LEVEL, rep_->ioptions.info_log,
+              "Unable to read the metaindex block."
+              " Fall back to binary seach index.");
+          return BinarySearchIndexReader::Create(
+              file, footer, footer.index_handle(), env,
+              binary_search_comparator, index_reader, index_key_includes_seq,
+              index_value_delta_encoded);
+        }
+        meta_index_iter = meta_iter_guard.get();
+      }
+      return LearnedIndexReader::Create(
+          file, footer, footer.index_handle(), env, binary_search_comparator,
+          meta_index_iter, index_reader, index_key_includes_seq,
+          index_value_delta_encoded);
+    }
     default: {
       std::string error_message =
           "Unrecognized index type: " + ToString(rep_->index_type);
@@ -1424,6 +1805,30 @@ uint64_t BlockBasedTable::ApproximateOffsetOf(const Slice& key) {
   return result;
 }
 
+void BlockBasedTable::SampleKeys(size_t num_samples,
+                                 std::vector<std::string>* keys) {
+  if (num_samples == 0) {
+    return;
+  }
+  unique_ptr<Iterator> index_iter(NewIndexIterator(ReadOptions()));
+  size_t num_blocks = 0;
+  for (index_iter->SeekToFirst(); index_iter->Valid(); index_iter->Next()) {
+    num_blocks++;
+  }
+  // The key of the last block ends the table, so it is not a sample
+  size_t step = std::max<size_t>(num_blocks / (num_samples + 1), 1);
+  size_t block = 0;
+  size_t added = 0;
+  for (index_iter->SeekToFirst(); index_iter->Valid() && added < num_samples;
+       index_iter->Next()) {
+    block++;
+    if (block % step == 0 && block < num_blocks) {
+      keys->push_back(index_iter->key().ToString());
+      added++;
+    }
+  }
+}
+
 bool BlockBasedTable::TEST_filter_block_preloaded() const {
   return rep_->filter != nullptr;
 }
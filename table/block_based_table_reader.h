@@ -34,6 +34,7 @@ class FullFilterBlockReader;
 class Footer;
 class InternalKeyComparator;
 class Iterator;
+class PersistentCache;
 class RandomAccessFile;
 class TableCache;
 class TableReader;
@@ -78,7 +79,8 @@ class BlockBasedTable : public TableReader {
   // Returns a new iterator over the table contents.
   // The result of NewIterator() is initially invalid (caller must
   // call one of the Seek methods on the iterator before using it).
-  Iterator* NewIterator(const ReadOptions&, Arena* arena = nullptr) override;
+  Iterator* NewIterator(const ReadOptions&, Arena* arena = nullptr,
+                        bool for_compaction = false) override;
 
   Status Get(const ReadOptions& readOptions, const Slice& key,
              GetContext* get_context) override;
@@ -96,6 +98,9 @@ class BlockBasedTable : public TableReader {
   // be close to the file length.
   uint64_t ApproximateOffsetOf(const Slice& key) override;
 
+  // Samples are taken from the index, so each one ends a data block.
+  void SampleKeys(size_t num_samples, std::vector<std::string>* keys) override;
+
   // Returns true if the block for the specified key is in cache.
   // REQUIRES: key is in this table && block cache enabled
   bool TEST_KeyInCache(const ReadOptions& options, const Slice& key);
@@ -128,9 +133,11 @@ class BlockBasedTable : public TableReader {
 
   class BlockEntryIteratorState;
   // input_iter: if it is not null, update this one and return it as Iterator
+  // file: if it is not null, read the block from it instead of rep->file
   static Iterator* NewDataBlockIterator(Rep* rep, const ReadOptions& ro,
                                         const Slice& index_value,
-                                        BlockIter* input_iter = nullptr);
+                                        BlockIter* input_iter = nullptr,
+                                        RandomAccessFile* file = nullptr);
 
   // For the following two functions:
   // if `no_io == true`, we will not try to read filter/index from sst file
@@ -154,11 +161,16 @@ class BlockBasedTable : public TableReader {
   // block_cache_compressed.
   // On success, Status::OK with be returned and @block will be populated with
   // pointer to the block as well as its block handle.
+  //
+  // If persistent_cache_key is not empty, blocks in block_cache are set up
+  // for admission to persistent_cache on eviction.
   static Status GetDataBlockFromCache(
       const Slice& block_cache_key, const Slice& compressed_block_cache_key,
       Cache* block_cache, Cache* block_cache_compressed, Statistics* statistics,
       const ReadOptions& read_options,
-      BlockBasedTable::CachableEntry<Block>* block, uint32_t format_version);
+      BlockBasedTable::CachableEntry<Block>* block, uint32_t format_version,
+      const std::shared_ptr<PersistentCache>& persistent_cache,
+      const Slice& persistent_cache_key, const Slice& compression_dict);
   // Put a raw block (maybe compressed) to the corresponding block caches.
   // This method will perform decompression against raw_block if needed and then
   // populate the block caches.
@@ -171,7 +183,16 @@ class BlockBasedTable : public TableReader {
       const Slice& block_cache_key, const Slice& compressed_block_cache_key,
       Cache* block_cache, Cache* block_cache_compressed,
       const ReadOptions& read_options, Statistics* statistics,
-      CachableEntry<Block>* block, Block* raw_block, uint32_t format_version);
+      CachableEntry<Block>* block, Block* raw_block, uint32_t format_version,
+      const std::shared_ptr<PersistentCache>& persistent_cache,
+      const Slice& persistent_cache_key, const Slice& compression_dict);
+  // Read an uncompressed block from the persistent cache and, if
+  // read_options.fill_cache is set, insert it into the block cache.
+  // Returns NotFound if the block is not in the persistent cache.
+  static Status GetDataBlockFromPersistentCache(
+      Rep* rep, const Slice& block_cache_key,
+      const Slice& persistent_cache_key, const ReadOptions& read_options,
+      CachableEntry<Block>* block);
 
   // Calls (*handle_result)(arg, ...) repeatedly, starting with the entry found
   // after a call to Seek(key), until handle_result returns false.
@@ -204,6 +225,8 @@ class BlockBasedTable : public TableReader {
       size_t* filter_size = nullptr);
 
   static void SetupCacheKeyPrefix(Rep* rep);
+  // REQUIRES: footer and table properties of rep have been read
+  static void SetupPersistentCacheKeyPrefix(Rep* rep, uint64_t file_size);
 
   explicit BlockBasedTable(Rep* rep)
       : rep_(rep), compaction_optimized_(false) {}
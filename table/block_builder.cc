@@ -30,6 +30,10 @@
 //     restarts: uint32[num_restarts]
 //     num_restarts: uint32
 // restarts[i] contains the offset within the block of the ith restart point.
+//
+// Data blocks may carry a hash index between the restart array and
+// num_restarts, which is then flagged in num_restarts. See
+// table/data_block_hash_index.h.
 
 #include "table/block_builder.h"
 
@@ -41,11 +45,17 @@
 
 namespace rocksdb {
 
-BlockBuilder::BlockBuilder(int block_restart_interval)
+BlockBuilder::BlockBuilder(int block_restart_interval,
+                           bool use_data_block_hash_index,
+                           double data_block_hash_table_util_ratio,
+                           bool use_delta_encoding)
     : block_restart_interval_(block_restart_interval),
+      use_delta_encoding_(use_delta_encoding),
       restarts_(),
       counter_(0),
-      finished_(false) {
+      finished_(false),
+      use_data_block_hash_index_(use_data_block_hash_index),
+      data_block_hash_index_builder_(data_block_hash_table_util_ratio) {
   assert(block_restart_interval_ >= 1);
   restarts_.push_back(0);       // First restart point is at offset 0
 }
@@ -57,12 +67,17 @@ void BlockBuilder::Reset() {
   counter_ = 0;
   finished_ = false;
   last_key_.clear();
+  data_block_hash_index_builder_.Reset();
 }
 
 size_t BlockBuilder::CurrentSizeEstimate() const {
-  return (buffer_.size() +                        // Raw data buffer
-          restarts_.size() * sizeof(uint32_t) +   // Restart array
-          sizeof(uint32_t));                      // Restart array length
+  size_t estimate = buffer_.size() +                       // Raw data buffer
+                    restarts_.size() * sizeof(uint32_t) +  // Restart array
+                    sizeof(uint32_t);                      // Restart array length
+  if (data_block_hash_index_builder_.Valid()) {
+    estimate += data_block_hash_index_builder_.EstimateSize();
+  }
+  return estimate;
 }
 
 size_t BlockBuilder::EstimateSizeAfterKV(const Slice& key, const Slice& value)
@@ -85,21 +100,33 @@ Slice BlockBuilder::Finish() {
   for (size_t i = 0; i < restarts_.size(); i++) {
     PutFixed32(&buffer_, restarts_[i]);
   }
-  PutFixed32(&buffer_, static_cast<uint32_t>(restarts_.size()));
+  uint32_t footer = static_cast<uint32_t>(restarts_.size());
+  if (data_block_hash_index_builder_.Valid()) {
+    data_block_hash_index_builder_.Finish(&buffer_);
+    footer |= kDataBlockHashIndexFlag;
+  }
+  PutFixed32(&buffer_, footer);
   finished_ = true;
   return Slice(buffer_);
 }
 
-void BlockBuilder::Add(const Slice& key, const Slice& value) {
+void BlockBuilder::Add(const Slice& key, const Slice& value,
+                       const Slice* const delta_value) {
   Slice last_key_piece(last_key_);
   assert(!finished_);
   assert(counter_ <= block_restart_interval_);
   size_t shared = 0;
+  Slice stored_value = value;
   if (counter_ < block_restart_interval_) {
-    // See how much sharing to do with previous string
-    const size_t min_length = std::min(last_key_piece.size(), key.size());
-    while ((shared < min_length) && (last_key_piece[shared] == key[shared])) {
-      shared++;
+    if (delta_value != nullptr && counter_ > 0) {
+      stored_value = *delta_value;
+    }
+    if (use_delta_encoding_) {
+      // See how much sharing to do with previous string
+      const size_t min_length = std::min(last_key_piece.size(), key.size());
+      while ((shared < min_length) && (last_key_piece[shared] == key[shared])) {
+        shared++;
+      }
     }
   } else {
     // Restart compression
@@ -108,14 +135,19 @@ void BlockBuilder::Add(const Slice& key, const Slice& value) {
   }
   const size_t non_shared = key.size() - shared;
 
+  if (use_data_block_hash_index_) {
+    data_block_hash_index_builder_.Add(
+        ExtractUserKey(key), static_cast<uint32_t>(restarts_.size() - 1));
+  }
+
   // Add "<shared><non_shared><value_size>" to buffer_
   PutVarint32(&buffer_, static_cast<uint32_t>(shared));
   PutVarint32(&buffer_, static_cast<uint32_t>(non_shared));
-  PutVarint32(&buffer_, static_cast<uint32_t>(value.size()));
+  PutVarint32(&buffer_, static_cast<uint32_t>(stored_value.size()));
 
   // Add string delta to buffer_ followed by value
   buffer_.append(key.data() + shared, non_shared);
-  buffer_.append(value.data(), value.size());
+  buffer_.append(stored_value.data(), stored_value.size());
 
   // Update state
   last_key_.resize(shared);
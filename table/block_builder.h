@@ -12,6 +12,7 @@
 
 #include <stdint.h>
 #include "rocksdb/slice.h"
+#include "table/data_block_hash_index.h"
 
 namespace rocksdb {
 
@@ -20,14 +21,26 @@ class BlockBuilder {
   BlockBuilder(const BlockBuilder&) = delete;
   void operator=(const BlockBuilder&) = delete;
 
-  explicit BlockBuilder(int block_restart_interval);
+  // If use_data_block_hash_index is true, keys must be internal keys and
+  // the block gets a hash index over their user keys when possible (see
+  // table/data_block_hash_index.h).
+  // If use_delta_encoding is false, keys are stored without sharing a
+  // prefix with the previous key.
+  explicit BlockBuilder(int block_restart_interval,
+                        bool use_data_block_hash_index = false,
+                        double data_block_hash_table_util_ratio = 0.75,
+                        bool use_delta_encoding = true);
 
   // Reset the contents as if the BlockBuilder was just constructed.
   void Reset();
 
   // REQUIRES: Finish() has not been callled since the last call to Reset().
   // REQUIRES: key is larger than any previously added key
-  void Add(const Slice& key, const Slice& value);
+  // If delta_value is not nullptr, it is stored instead of value unless the
+  // entry starts a restart interval. The reader must be able to restore
+  // value from it and the values of the entries before it in the interval.
+  void Add(const Slice& key, const Slice& value,
+           const Slice* const delta_value = nullptr);
 
   // Finish building the block and return a slice that refers to the
   // block contents.  The returned slice will remain valid for the
@@ -48,12 +61,16 @@ class BlockBuilder {
 
  private:
   const int          block_restart_interval_;
+  const bool         use_delta_encoding_;
 
   std::string           buffer_;    // Destination buffer
   std::vector<uint32_t> restarts_;  // Restart points
   int                   counter_;   // Number of entries emitted since restart
   bool                  finished_;  // Has Finish() been called?
   std::string           last_key_;
+
+  bool                  use_data_block_hash_index_;
+  DataBlockHashIndexBuilder data_block_hash_index_builder_;
 };
 
 }  // namespace rocksdb
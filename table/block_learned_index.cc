@@ -0,0 +1,203 @@
+//  Copyright (c) 2013, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "table/block_learned_index.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+
+#include "util/coding.h"
+
+namespace rocksdb {
+
+namespace {
+
+// The 8 bytes of key after the first prefix_len, padded with zeros, as a
+// big-endian number.
+uint64_t KeyToNumber(const Slice& key, size_t prefix_len) {
+  uint64_t number = 0;
+  for (size_t i = prefix_len; i < prefix_len + sizeof(uint64_t); i++) {
+    number <<= 8;
+    if (i < key.size()) {
+      number |= static_cast<unsigned char>(key[i]);
+    }
+  }
+  return number;
+}
+
+uint64_t DoubleToBits(double d) {
+  uint64_t bits;
+  memcpy(&bits, &d, sizeof(bits));
+  return bits;
+}
+
+// The number that stands for key in the model of keys sharing prefix. Keys
+// outside the prefix are before or after all of those.
+uint64_t KeyPosition(const Slice& key, const Slice& prefix) {
+  int cmp = memcmp(key.data(), prefix.data(),
+                   std::min(key.size(), prefix.size()));
+  if (cmp == 0 && key.size() < prefix.size()) {
+    cmp = -1;
+  }
+  if (cmp < 0) {
+    return 0;
+  } else if (cmp > 0) {
+    return std::numeric_limits<uint64_t>::max();
+  }
+  return KeyToNumber(key, prefix.size());
+}
+
+double BitsToDouble(uint64_t bits) {
+  double d;
+  memcpy(&d, &bits, sizeof(d));
+  return d;
+}
+
+}  // namespace
+
+// The segments are fitted greedily: a segment is extended with the next
+// entry as long as some slope still predicts all of its entries within
+// max_error_, i.e. as long as the range of such slopes is not empty.
+void BlockLearnedIndex::Builder::Finish(std::string* contents) {
+  // Sorted keys share what the first and the last one share. The key of the
+  // last index entry is a short successor of the last key in the table
+  // (e.g. "b" for "abc"), so it is left out, and has a segment of its own
+  // if it does not share the prefix.
+  size_t prefix_len = 0;
+  if (!keys_.empty()) {
+    const std::string& first = keys_.front();
+    const std::string& last =
+        keys_.size() > 1 ? keys_[keys_.size() - 2] : keys_.back();
+    while (prefix_len < first.size() && prefix_len < last.size() &&
+           first[prefix_len] == last[prefix_len]) {
+      prefix_len++;
+    }
+  }
+  const Slice prefix =
+      keys_.empty() ? Slice() : Slice(keys_.front().data(), prefix_len);
+
+  std::vector<Segment> segments;
+  const double kInfinity = std::numeric_limits<double>::infinity();
+  double min_slope = 0;
+  double max_slope = kInfinity;
+  for (size_t i = 0; i < keys_.size(); i++) {
+    const uint64_t key = KeyPosition(keys_[i], prefix);
+    const uint32_t entry = static_cast<uint32_t>(i);
+    bool fits = false;
+    if (!segments.empty()) {
+      const Segment& segment = segments.back();
+      const uint32_t distance = entry - segment.first_entry;
+      if (key == segment.first_key) {
+        fits = distance <= max_error_;
+      } else {
+        const double dx = static_cast<double>(key - segment.first_key);
+        const double lo =
+            (static_cast<double>(distance) - max_error_) / dx;
+        const double hi =
+            (static_cast<double>(distance) + max_error_) / dx;
+        if (lo <= max_slope && hi >= min_slope) {
+          fits = true;
+          min_slope = std::max(min_slope, lo);
+          max_slope = std::min(max_slope, hi);
+        }
+      }
+    }
+    if (!fits) {
+      if (!segments.empty()) {
+        segments.back().slope = max_slope == kInfinity
+                                    ? min_slope
+                                    : (min_slope + max_slope) / 2;
+      }
+      segments.push_back({key, entry, 0});
+      min_slope = 0;
+      max_slope = kInfinity;
+    }
+  }
+  if (!segments.empty()) {
+    segments.back().slope =
+        max_slope == kInfinity ? min_slope : (min_slope + max_slope) / 2;
+  }
+
+  PutVarint32(contents, max_error_);
+  PutVarint32(contents, static_cast<uint32_t>(keys_.size()));
+  PutLengthPrefixedSlice(contents, prefix);
+  PutVarint32(contents, static_cast<uint32_t>(segments.size()));
+  for (const auto& segment : segments) {
+    PutFixed64(contents, segment.first_key);
+    PutFixed32(contents, segment.first_entry);
+    PutFixed64(contents, DoubleToBits(segment.slope));
+  }
+}
+
+Status BlockLearnedIndex::Create(const Slice& contents,
+                                 BlockLearnedIndex** learned_index) {
+  Slice input = contents;
+  std::unique_ptr<BlockLearnedIndex> index(new BlockLearnedIndex());
+  Slice prefix;
+  uint32_t num_segments = 0;
+  if (!GetVarint32(&input, &index->max_error_) ||
+      !GetVarint32(&input, &index->num_entries_) ||
+      !GetLengthPrefixedSlice(&input, &prefix) ||
+      !GetVarint32(&input, &num_segments)) {
+    return Status::Corruption("bad learned index");
+  }
+  const size_t kSegmentSize = 2 * sizeof(uint64_t) + sizeof(uint32_t);
+  if (input.size() != num_segments * kSegmentSize) {
+    return Status::Corruption("bad learned index segments");
+  }
+  index->prefix_ = prefix.ToString();
+  index->segments_.reserve(num_segments);
+  for (uint32_t i = 0; i < num_segments; i++) {
+    const char* p = input.data() + i * kSegmentSize;
+    Segment segment;
+    segment.first_key = DecodeFixed64(p);
+    segment.first_entry = DecodeFixed32(p + sizeof(uint64_t));
+    segment.slope =
+        BitsToDouble(DecodeFixed64(p + sizeof(uint64_t) + sizeof(uint32_t)));
+    if (segment.first_entry >= index->num_entries_ ||
+        !(segment.slope >= 0) ||
+        (i > 0 && segment.first_key < index->segments_.back().first_key)) {
+      return Status::Corruption("bad learned index segments");
+    }
+    index->segments_.push_back(segment);
+  }
+
+  *learned_index = index.release();
+  return Status::OK();
+}
+
+bool BlockLearnedIndex::Predict(const Slice& user_key, uint32_t num_entries,
+                                uint32_t* left, uint32_t* right) const {
+  if (num_entries != num_entries_ || segments_.empty()) {
+    return false;
+  }
+
+  const uint64_t key = KeyPosition(user_key, prefix_);
+
+  // The last segment that starts at or before key
+  auto segment = std::upper_bound(
+      segments_.begin(), segments_.end(), key,
+      [](uint64_t k, const Segment& s) { return k < s.first_key; });
+  if (segment != segments_.begin()) {
+    --segment;
+  }
+  double entry = segment->first_entry;
+  if (key > segment->first_key) {
+    entry += segment->slope * static_cast<double>(key - segment->first_key);
+  }
+  const uint32_t last = num_entries_ - 1;
+  const uint32_t predicted =
+      entry >= last ? last : static_cast<uint32_t>(entry + 0.5);
+
+  *left = predicted > max_error_ ? predicted - max_error_ - 1 : 0;
+  *right = static_cast<uint32_t>(std::min<uint64_t>(
+      static_cast<uint64_t>(predicted) + max_error_, last));
+  return true;
+}
+
+}  // namespace rocksdb
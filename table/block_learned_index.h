@@ -0,0 +1,83 @@
+//  Copyright (c) 2013, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "rocksdb/slice.h"
+#include "rocksdb/status.h"
+
+namespace rocksdb {
+
+// A learned index over the entries of an index block: a piecewise linear
+// model from user key to the number of the entry (and hence of the data
+// block) that the key belongs to. Every fitted entry is predicted within
+// max_error entries of its actual position, so a seek only has to search a
+// small range of the index block. Keys are modelled by the 8 bytes that
+// follow the prefix shared by the entries, read as a big-endian number,
+// which preserves their order only under the bytewise comparator.
+//
+// The serialized model looks like:
+//
+//   max error: varint32
+//   number of entries: varint32
+//   shared prefix: varint32 length + bytes
+//   number of segments: varint32
+//   segments: [first key: fixed64, first entry: fixed32, slope: fixed64]*
+//
+// where the slope is the bit pattern of a double.
+class BlockLearnedIndex {
+ public:
+  class Builder {
+   public:
+    explicit Builder(uint32_t max_error) : max_error_(max_error) {}
+
+    // Add the user key of the next index entry. Keys must be added in
+    // bytewise order.
+    void Add(const Slice& user_key) { keys_.push_back(user_key.ToString()); }
+
+    // Fit the model to the keys added so far and append it to *contents.
+    void Finish(std::string* contents);
+
+   private:
+    const uint32_t max_error_;
+    std::vector<std::string> keys_;
+  };
+
+  // Create the learned index from a serialized model.
+  static Status Create(const Slice& contents,
+                       BlockLearnedIndex** learned_index);
+
+  // Set [*left, *right] to the range of entries in which the entry for
+  // user_key is predicted to be, widened by one entry on the left so that
+  // a binary search for the last entry before the key stays in range.
+  // Returns false if the model was not fitted to num_entries entries, in
+  // which case it cannot be used.
+  bool Predict(const Slice& user_key, uint32_t num_entries, uint32_t* left,
+               uint32_t* right) const;
+
+  size_t ApproximateMemoryUsage() const {
+    return sizeof(BlockLearnedIndex) + prefix_.size() +
+           segments_.size() * sizeof(Segment);
+  }
+
+ private:
+  struct Segment {
+    uint64_t first_key;
+    uint32_t first_entry;
+    double slope;
+  };
+
+  BlockLearnedIndex() : max_error_(0), num_entries_(0) {}
+
+  uint32_t max_error_;
+  uint32_t num_entries_;
+  std::string prefix_;
+  std::vector<Segment> segments_;
+};
+
+}  // namespace rocksdb
@@ -0,0 +1,138 @@
+//  Copyright (c) 2013, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "table/block_learned_index.h"
+#include "util/random.h"
+#include "util/testharness.h"
+
+namespace rocksdb {
+
+namespace {
+// A fixed prefix followed by the big-endian encoding of n
+std::string NumberKey(uint64_t n) {
+  std::string key = "prefix";
+  char buf[sizeof(uint64_t)];
+  for (size_t i = 0; i < sizeof(buf); i++) {
+    buf[i] = static_cast<char>(n >> (8 * (sizeof(buf) - 1 - i)));
+  }
+  key.append(buf, sizeof(buf));
+  return key;
+}
+
+// Fit a model to keys and check that each key is predicted within the
+// error bound of its entry. Returns the size of the serialized model.
+size_t CheckErrorBound(const std::vector<std::string>& keys,
+                       uint32_t max_error) {
+  BlockLearnedIndex::Builder builder(max_error);
+  for (const auto& key : keys) {
+    builder.Add(key);
+  }
+  std::string contents;
+  builder.Finish(&contents);
+
+  BlockLearnedIndex* index_ptr = nullptr;
+  ASSERT_OK(BlockLearnedIndex::Create(contents, &index_ptr));
+  std::unique_ptr<BlockLearnedIndex> index(index_ptr);
+  const uint32_t num_entries = static_cast<uint32_t>(keys.size());
+  for (uint32_t i = 0; i < num_entries; i++) {
+    uint32_t left, right;
+    ASSERT_TRUE(index->Predict(keys[i], num_entries, &left, &right));
+    ASSERT_LE(left, i);
+    ASSERT_GE(right, i);
+    ASSERT_LE(right - left, 2 * max_error + 1);
+  }
+  // The model is only valid for the index it was built for
+  uint32_t left, right;
+  ASSERT_TRUE(!index->Predict(keys[0], num_entries + 1, &left, &right));
+  return contents.size();
+}
+}  // namespace
+
+class BlockLearnedIndexTest {};
+
+TEST(BlockLearnedIndexTest, LinearKeys) {
+  std::vector<std::string> keys;
+  for (uint64_t i = 0; i < 10000; i++) {
+    keys.push_back(NumberKey(1000 + 37 * i));
+  }
+  // A single segment
+  ASSERT_LT(CheckErrorBound(keys, 8), 64U);
+  ASSERT_LT(CheckErrorBound(keys, 0), 64U);
+}
+
+TEST(BlockLearnedIndexTest, SkewedKeys) {
+  Random rnd(301);
+  std::vector<std::string> keys;
+  uint64_t n = 0;
+  for (int i = 0; i < 10000; i++) {
+    n += 1 + rnd.Skewed(20);
+    keys.push_back(NumberKey(n));
+  }
+  size_t size = CheckErrorBound(keys, 8);
+  ASSERT_GT(size, 64U);
+  // Fewer segments for a larger error bound
+  ASSERT_LT(CheckErrorBound(keys, 64), size);
+  CheckErrorBound(keys, 0);
+}
+
+TEST(BlockLearnedIndexTest, DuplicateAndShortKeys) {
+  // The model only sees 8 bytes after the shared prefix, so groups of ten
+  // of these keys collide and are not all predicted within the bound.
+  // Predictions must still be in range.
+  std::vector<std::string> keys;
+  for (int i = 0; i < 100; i++) {
+    keys.push_back("prefix" + std::string(1, static_cast<char>('0' + i / 10)) +
+                   std::string(10, 'a') + std::to_string(1000 + i));
+  }
+  BlockLearnedIndex::Builder builder(4);
+  for (const auto& key : keys) {
+    builder.Add(key);
+  }
+  std::string contents;
+  builder.Finish(&contents);
+  BlockLearnedIndex* index_ptr = nullptr;
+  ASSERT_OK(BlockLearnedIndex::Create(contents, &index_ptr));
+  std::unique_ptr<BlockLearnedIndex> index(index_ptr);
+  for (const std::string& key : {std::string(), std::string("a"),
+                                 std::string("prefix"), keys[55],
+                                 keys.back() + "x", std::string("z")}) {
+    uint32_t left, right;
+    ASSERT_TRUE(index->Predict(key, 100, &left, &right));
+    ASSERT_LE(left, right);
+    ASSERT_LT(right, 100U);
+  }
+}
+
+TEST(BlockLearnedIndexTest, Corruption) {
+  BlockLearnedIndex::Builder builder(8);
+  for (uint64_t i = 0; i < 100; i++) {
+    builder.Add(NumberKey(i * i));
+  }
+  std::string contents;
+  builder.Finish(&contents);
+
+  BlockLearnedIndex* index = nullptr;
+  ASSERT_TRUE(BlockLearnedIndex::Create(Slice(contents.data(),
+                                              contents.size() - 1),
+                                        &index).IsCorruption());
+  ASSERT_TRUE(BlockLearnedIndex::Create(Slice(), &index).IsCorruption());
+  ASSERT_TRUE(index == nullptr);
+
+  // Empty model
+  std::string empty;
+  BlockLearnedIndex::Builder(8).Finish(&empty);
+  ASSERT_OK(BlockLearnedIndex::Create(empty, &index));
+  uint32_t left, right;
+  ASSERT_TRUE(!index->Predict("key", 0, &left, &right));
+  delete index;
+}
+
+}  // namespace rocksdb
+
+int main(int argc, char** argv) { return rocksdb::test::RunAllTests(); }
@@ -126,6 +126,59 @@ TEST(BlockTest, SimpleTest) {
   delete iter;
 }
 
+TEST(BlockTest, PrevTest) {
+  Random rnd(301);
+  std::vector<std::string> keys;
+  std::vector<std::string> values;
+  const int kNumRecords = 1000;
+  GenerateRandomKVs(&keys, &values, 0, kNumRecords, 1, 4);
+
+  for (bool use_delta_encoding : {true, false}) {
+    for (int restart_interval : {1, 4, 16}) {
+      BlockBuilder builder(restart_interval, false, 0.75, use_delta_encoding);
+      for (int i = 0; i < kNumRecords; i++) {
+        builder.Add(keys[i], values[i]);
+      }
+      BlockContents contents;
+      contents.data = builder.Finish();
+      contents.cachable = false;
+      Block reader(std::move(contents));
+      std::unique_ptr<Iterator> iter(
+          reader.NewIterator(BytewiseComparator()));
+
+      // read contents of block backwards
+      int index = kNumRecords - 1;
+      for (iter->SeekToLast(); iter->Valid(); iter->Prev(), index--) {
+        ASSERT_EQ(keys[index], iter->key().ToString());
+        ASSERT_EQ(values[index], iter->value().ToString());
+      }
+      ASSERT_EQ(-1, index);
+
+      // mix Next() and Prev() from random positions
+      for (int i = 0; i < 100; i++) {
+        index = rnd.Uniform(kNumRecords);
+        iter->Seek(keys[index]);
+        for (int step = 0; step < 50; step++) {
+          if (rnd.OneIn(3)) {
+            iter->Next();
+            index++;
+          } else {
+            iter->Prev();
+            index--;
+          }
+          if (index < 0 || index >= kNumRecords) {
+            ASSERT_TRUE(!iter->Valid());
+            break;
+          }
+          ASSERT_TRUE(iter->Valid());
+          ASSERT_EQ(keys[index], iter->key().ToString());
+          ASSERT_EQ(values[index], iter->value().ToString());
+        }
+      }
+    }
+  }
+}
+
 // return the block contents
 BlockContents GetBlockContents(std::unique_ptr<BlockBuilder> *builder,
                                const std::vector<std::string> &keys,
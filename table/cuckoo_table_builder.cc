@@ -104,12 +104,14 @@ void CuckooTableBuilder::Add(const Slice& key, const Slice& value) {
     largest_user_key_.assign(ikey.user_key.data(), ikey.user_key.size());
     key_size_ = is_last_level_file_ ? ikey.user_key.size() : key.size();
   }
+  // Even if one sequence number is non-zero, then it is not last level.
+  if (is_last_level_file_ && ikey.sequence != 0) {
+    ConvertToInternalKeys();
+  }
   if (key_size_ != (is_last_level_file_ ? ikey.user_key.size() : key.size())) {
     status_ = Status::NotSupported("all keys have to be the same size");
     return;
   }
-  // Even if one sequence number is non-zero, then it is not last level.
-  assert(!is_last_level_file_ || ikey.sequence == 0);
 
   if (ikey.type == kTypeValue) {
     if (!has_seen_first_value_) {
@@ -154,6 +156,29 @@ void CuckooTableBuilder::Add(const Slice& key, const Slice& value) {
   }
 }
 
+void CuckooTableBuilder::ConvertToInternalKeys() {
+  assert(is_last_level_file_);
+  std::string kvs;
+  kvs.reserve(kvs_.size() + num_values_ * 8);
+  for (uint64_t i = 0; i < num_values_; ++i) {
+    const char* kv = &kvs_[i * (key_size_ + value_size_)];
+    kvs.append(kv, key_size_);
+    PutFixed64(&kvs, PackSequenceAndType(0, kTypeValue));
+    kvs.append(kv + key_size_, value_size_);
+  }
+  std::string deleted_keys;
+  deleted_keys.reserve(deleted_keys_.size() +
+                       (num_entries_ - num_values_) * 8);
+  for (uint64_t i = 0; i < num_entries_ - num_values_; ++i) {
+    deleted_keys.append(&deleted_keys_[i * key_size_], key_size_);
+    PutFixed64(&deleted_keys, PackSequenceAndType(0, kTypeDeletion));
+  }
+  kvs_.swap(kvs);
+  deleted_keys_.swap(deleted_keys);
+  key_size_ += 8;
+  is_last_level_file_ = false;
+}
+
 bool CuckooTableBuilder::IsDeletedKey(uint64_t idx) const {
   assert(closed_);
   return idx >= num_values_;
@@ -72,6 +72,9 @@ class CuckooTableBuilder: public TableBuilder {
                        const uint32_t call_id,
                        std::vector<CuckooBucket>* buckets, uint64_t* bucket_id);
   Status MakeHashTable(std::vector<CuckooBucket>* buckets);
+  // Store the keys added so far as internal keys with sequence number zero,
+  // after a key with a non-zero sequence number followed keys without.
+  void ConvertToInternalKeys();
 
   inline bool IsDeletedKey(uint64_t idx) const;
   inline Slice GetKey(uint64_t idx) const;
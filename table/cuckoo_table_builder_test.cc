@@ -182,6 +182,45 @@ TEST(CuckooBuilderTest, WriteSuccessNoCollisionFullKey) {
       expected_unused_bucket, expected_table_size, 2, false);
 }
 
+TEST(CuckooBuilderTest, WriteSuccessMixedSequenceNumbers) {
+  // The leading keys have sequence number zero, as in a last level file, and
+  // are written as full keys once a non-zero sequence number follows.
+  uint32_t num_hash_fun = 4;
+  std::vector<std::string> user_keys = {"key01", "key02", "key03", "key04"};
+  std::vector<std::string> values = {"v01", "v02", "v03", "v04"};
+  hash_map = {
+    {user_keys[0], {0, 1, 2, 3}},
+    {user_keys[1], {1, 2, 3, 4}},
+    {user_keys[2], {2, 3, 4, 5}},
+    {user_keys[3], {3, 4, 5, 6}}
+  };
+  std::vector<uint64_t> expected_locations = {0, 1, 2, 3};
+  std::vector<std::string> keys;
+  for (uint32_t i = 0; i < user_keys.size(); i++) {
+    keys.push_back(GetInternalKey(user_keys[i], i < 2));
+  }
+  uint64_t expected_table_size = NextPowOf2(keys.size() / kHashTableRatio);
+
+  unique_ptr<WritableFile> writable_file;
+  fname = test::TmpDir() + "/MixedSequenceNumbers";
+  ASSERT_OK(env_->NewWritableFile(fname, &writable_file, env_options_));
+  CuckooTableBuilder builder(writable_file.get(), kHashTableRatio,
+      num_hash_fun, 100, BytewiseComparator(), 1, false, false, GetSliceHash);
+  ASSERT_OK(builder.status());
+  for (uint32_t i = 0; i < user_keys.size(); i++) {
+    builder.Add(Slice(keys[i]), Slice(values[i]));
+    ASSERT_EQ(builder.NumEntries(), i + 1);
+    ASSERT_OK(builder.status());
+  }
+  ASSERT_OK(builder.Finish());
+  ASSERT_OK(writable_file->Close());
+
+  std::string expected_unused_bucket = GetInternalKey("key00", true);
+  expected_unused_bucket += std::string(values[0].size(), 'a');
+  CheckFileContents(keys, values, expected_locations,
+      expected_unused_bucket, expected_table_size, 2, false);
+}
+
 TEST(CuckooBuilderTest, WriteSuccessWithCollisionFullKey) {
   uint32_t num_hash_fun = 4;
   std::vector<std::string> user_keys = {"key01", "key02", "key03", "key04"};
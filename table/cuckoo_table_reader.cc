@@ -27,6 +27,8 @@ namespace rocksdb {
 namespace {
 const uint64_t CACHE_LINE_MASK = ~((uint64_t)CACHE_LINE_SIZE - 1);
 const uint32_t kInvalidIndex = std::numeric_limits<uint32_t>::max();
+// Number of keys that MultiGet() looks up together
+const size_t kMultiGetBatchSize = 16;
 }
 
 extern const uint64_t kCuckooTableMagicNumber;
@@ -42,6 +44,7 @@ CuckooTableReader::CuckooTableReader(
       get_slice_hash_(get_slice_hash) {
   if (!ioptions.allow_mmap_reads) {
     status_ = Status::InvalidArgument("File is not mmaped");
+    return;
   }
   TableProperties* props = nullptr;
   status_ = ReadTableProperties(file_.get(), file_size, kCuckooTableMagicNumber,
@@ -127,51 +130,104 @@ CuckooTableReader::CuckooTableReader(
   status_ = file_->Read(0, file_size, &file_data_, nullptr);
 }
 
+const char* CuckooTableReader::GetCuckooBlock(const Slice& user_key,
+                                              uint32_t hash_cnt) const {
+  uint64_t offset = bucket_length_ * CuckooHash(
+      user_key, hash_cnt, use_module_hash_, table_size_,
+      identity_as_first_hash_, get_slice_hash_);
+  return &file_data_.data()[offset];
+}
+
+void CuckooTableReader::PrefetchCuckooBlock(const char* bucket) const {
+  uint64_t addr = reinterpret_cast<uint64_t>(bucket);
+  uint64_t end_addr = addr + cuckoo_block_bytes_minus_one_;
+  for (addr &= CACHE_LINE_MASK; addr < end_addr; addr += CACHE_LINE_SIZE) {
+    PREFETCH(reinterpret_cast<const char*>(addr), 0, 3);
+  }
+}
+
+bool CuckooTableReader::SearchCuckooBlock(const Slice& user_key,
+                                          const char* bucket,
+                                          GetContext* get_context) const {
+  for (uint32_t block_idx = 0; block_idx < cuckoo_block_size_;
+       ++block_idx, bucket += bucket_length_) {
+    if (ucomp_->Compare(Slice(unused_key_.data(), user_key.size()),
+                        Slice(bucket, user_key.size())) == 0) {
+      return true;
+    }
+    // Here, we compare only the user key part as we support only one entry
+    // per user key and we don't support sanpshot.
+    if (ucomp_->Compare(user_key, Slice(bucket, user_key.size())) == 0) {
+      Slice value(bucket + key_length_, value_length_);
+      if (is_last_level_) {
+        get_context->SaveValue(value);
+      } else {
+        Slice full_key(bucket, key_length_);
+        ParsedInternalKey found_ikey;
+        ParseInternalKey(full_key, &found_ikey);
+        get_context->SaveValue(found_ikey, value);
+      }
+      // We don't support merge operations. So, we return here.
+      return true;
+    }
+  }
+  return false;
+}
+
 Status CuckooTableReader::Get(const ReadOptions& readOptions, const Slice& key,
                               GetContext* get_context) {
   assert(key.size() == key_length_ + (is_last_level_ ? 8 : 0));
   Slice user_key = ExtractUserKey(key);
   for (uint32_t hash_cnt = 0; hash_cnt < num_hash_func_; ++hash_cnt) {
-    uint64_t offset = bucket_length_ * CuckooHash(
-        user_key, hash_cnt, use_module_hash_, table_size_,
-        identity_as_first_hash_, get_slice_hash_);
-    const char* bucket = &file_data_.data()[offset];
-    for (uint32_t block_idx = 0; block_idx < cuckoo_block_size_;
-         ++block_idx, bucket += bucket_length_) {
-      if (ucomp_->Compare(Slice(unused_key_.data(), user_key.size()),
-                          Slice(bucket, user_key.size())) == 0) {
-        return Status::OK();
+    if (SearchCuckooBlock(user_key, GetCuckooBlock(user_key, hash_cnt),
+                          get_context)) {
+      break;
+    }
+  }
+  return Status::OK();
+}
+
+void CuckooTableReader::MultiGet(const ReadOptions& read_options,
+                                 size_t num_keys, const Slice* keys,
+                                 GetContext** get_contexts, Status* statuses) {
+  // Indexes of the keys of the batch that are not done yet, and their
+  // cuckoo blocks for the current hash function
+  size_t pending[kMultiGetBatchSize];
+  const char* blocks[kMultiGetBatchSize];
+  for (size_t start = 0; start < num_keys; start += kMultiGetBatchSize) {
+    size_t num_pending = 0;
+    for (size_t i = start; i < num_keys && num_pending < kMultiGetBatchSize;
+         ++i) {
+      assert(keys[i].size() == key_length_ + (is_last_level_ ? 8 : 0));
+      statuses[i] = Status::OK();
+      pending[num_pending++] = i;
+    }
+    for (uint32_t hash_cnt = 0; hash_cnt < num_hash_func_ && num_pending > 0;
+         ++hash_cnt) {
+      for (size_t j = 0; j < num_pending; ++j) {
+        blocks[j] = GetCuckooBlock(ExtractUserKey(keys[pending[j]]), hash_cnt);
+        PrefetchCuckooBlock(blocks[j]);
       }
-      // Here, we compare only the user key part as we support only one entry
-      // per user key and we don't support sanpshot.
-      if (ucomp_->Compare(user_key, Slice(bucket, user_key.size())) == 0) {
-        Slice value(bucket + key_length_, value_length_);
-        if (is_last_level_) {
-          get_context->SaveValue(value);
-        } else {
-          Slice full_key(bucket, key_length_);
-          ParsedInternalKey found_ikey;
-          ParseInternalKey(full_key, &found_ikey);
-          get_context->SaveValue(found_ikey, value);
+      size_t num_not_done = 0;
+      for (size_t j = 0; j < num_pending; ++j) {
+        const size_t i = pending[j];
+        if (!SearchCuckooBlock(ExtractUserKey(keys[i]), blocks[j],
+                               get_contexts[i])) {
+          pending[num_not_done++] = i;
         }
-        // We don't support merge operations. So, we return here.
-        return Status::OK();
       }
+      num_pending = num_not_done;
     }
   }
-  return Status::OK();
 }
 
 void CuckooTableReader::Prepare(const Slice& key) {
   // Prefetch the first Cuckoo Block.
   Slice user_key = ExtractUserKey(key);
-  uint64_t addr = reinterpret_cast<uint64_t>(file_data_.data()) +
-    bucket_length_ * CuckooHash(user_key, 0, use_module_hash_, table_size_,
-                                identity_as_first_hash_, nullptr);
-  uint64_t end_addr = addr + cuckoo_block_bytes_minus_one_;
-  for (addr &= CACHE_LINE_MASK; addr < end_addr; addr += CACHE_LINE_SIZE) {
-    PREFETCH(reinterpret_cast<const char*>(addr), 0, 3);
-  }
+  PrefetchCuckooBlock(
+      file_data_.data() +
+      bucket_length_ * CuckooHash(user_key, 0, use_module_hash_, table_size_,
+                                  identity_as_first_hash_, nullptr));
 }
 
 class CuckooTableIterator : public Iterator {
@@ -352,7 +408,7 @@ Slice CuckooTableIterator::value() const {
 extern Iterator* NewErrorIterator(const Status& status, Arena* arena);
 
 Iterator* CuckooTableReader::NewIterator(
-    const ReadOptions& read_options, Arena* arena) {
+    const ReadOptions& read_options, Arena* arena, bool for_compaction) {
   if (!status().ok()) {
     return NewErrorIterator(
         Status::Corruption("CuckooTableReader status is not okay."), arena);
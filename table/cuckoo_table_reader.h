@@ -43,7 +43,15 @@ class CuckooTableReader: public TableReader {
   Status Get(const ReadOptions& read_options, const Slice& key,
              GetContext* get_context) override;
 
-  Iterator* NewIterator(const ReadOptions&, Arena* arena = nullptr) override;
+  // Looks up the keys in batches. For each hash function in turn, the cuckoo
+  // blocks of all keys of a batch that are not done yet are prefetched
+  // before any of them is searched, so that the cache misses overlap.
+  void MultiGet(const ReadOptions& read_options, size_t num_keys,
+                const Slice* keys, GetContext** get_contexts,
+                Status* statuses) override;
+
+  Iterator* NewIterator(const ReadOptions&, Arena* arena = nullptr,
+                        bool for_compaction = false) override;
   void Prepare(const Slice& target) override;
 
   // Report an approximation of how much memory has been used.
@@ -57,6 +65,15 @@ class CuckooTableReader: public TableReader {
  private:
   friend class CuckooTableIterator;
   void LoadAllKeys(std::vector<std::pair<Slice, uint32_t>>* key_to_bucket_id);
+  // Return the first bucket of the cuckoo block of "user_key" for hash
+  // function "hash_cnt"
+  const char* GetCuckooBlock(const Slice& user_key, uint32_t hash_cnt) const;
+  void PrefetchCuckooBlock(const char* bucket) const;
+  // Search the cuckoo block starting at "bucket" for "user_key". Returns
+  // true if the lookup is done: the key was found and reported to
+  // get_context, or an empty bucket shows that it is not in the table.
+  bool SearchCuckooBlock(const Slice& user_key, const char* bucket,
+                         GetContext* get_context) const;
   std::unique_ptr<RandomAccessFile> file_;
   Slice file_data_;
   bool is_last_level_;
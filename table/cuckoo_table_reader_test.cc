@@ -118,12 +118,31 @@ class CuckooReaderTest {
     ASSERT_OK(reader.status());
     // Assume no merge/deletion
     for (uint32_t i = 0; i < num_items; ++i) {
-      std::string value;
+      PinnableSlice value;
       GetContext get_context(ucomp, nullptr, nullptr, nullptr,
                              GetContext::kNotFound, Slice(user_keys[i]), &value,
                              nullptr, nullptr);
       ASSERT_OK(reader.Get(ReadOptions(), Slice(keys[i]), &get_context));
-      ASSERT_EQ(values[i], value);
+      ASSERT_EQ(values[i], value.ToString());
+    }
+
+    // Look up all the keys again in a single batch
+    std::vector<Slice> key_slices(keys.begin(), keys.end());
+    std::vector<PinnableSlice> multiget_values(num_items);
+    std::vector<std::unique_ptr<GetContext>> multiget_contexts;
+    std::vector<GetContext*> get_contexts;
+    for (uint32_t i = 0; i < num_items; ++i) {
+      multiget_contexts.emplace_back(new GetContext(
+          ucomp, nullptr, nullptr, nullptr, GetContext::kNotFound,
+          Slice(user_keys[i]), &multiget_values[i], nullptr, nullptr));
+      get_contexts.push_back(multiget_contexts.back().get());
+    }
+    std::vector<Status> statuses(num_items);
+    reader.MultiGet(ReadOptions(), num_items, key_slices.data(),
+                    get_contexts.data(), statuses.data());
+    for (uint32_t i = 0; i < num_items; ++i) {
+      ASSERT_OK(statuses[i]);
+      ASSERT_EQ(values[i], multiget_values[i].ToString());
     }
   }
   void UpdateKeys(bool with_zero_seqno) {
@@ -332,7 +351,7 @@ TEST(CuckooReaderTest, WhenKeyNotFound) {
   AddHashLookups(not_found_user_key, 0, kNumHashFunc);
   ParsedInternalKey ikey(not_found_user_key, 1000, kTypeValue);
   AppendInternalKey(&not_found_key, ikey);
-  std::string value;
+  PinnableSlice value;
   GetContext get_context(ucmp, nullptr, nullptr, nullptr, GetContext::kNotFound,
                          Slice(not_found_key), &value, nullptr, nullptr);
   ASSERT_OK(reader.Get(ReadOptions(), Slice(not_found_key), &get_context));
@@ -364,6 +383,34 @@ TEST(CuckooReaderTest, WhenKeyNotFound) {
   ASSERT_OK(reader.Get(ReadOptions(), Slice(unused_key), &get_context3));
   ASSERT_TRUE(value.empty());
   ASSERT_OK(reader.status());
+
+  // The same lookups in a batch, mixed with one that succeeds.
+  Slice batch_keys[4] = {not_found_key, keys[0], not_found_key2, unused_key};
+  PinnableSlice batch_values[4];
+  GetContext batch_context0(ucmp, nullptr, nullptr, nullptr,
+                            GetContext::kNotFound, Slice(not_found_user_key),
+                            &batch_values[0], nullptr, nullptr);
+  GetContext batch_context1(ucmp, nullptr, nullptr, nullptr,
+                            GetContext::kNotFound, Slice(user_keys[0]),
+                            &batch_values[1], nullptr, nullptr);
+  GetContext batch_context2(ucmp, nullptr, nullptr, nullptr,
+                            GetContext::kNotFound, Slice(not_found_user_key2),
+                            &batch_values[2], nullptr, nullptr);
+  GetContext batch_context3(ucmp, nullptr, nullptr, nullptr,
+                            GetContext::kNotFound, ExtractUserKey(unused_key),
+                            &batch_values[3], nullptr, nullptr);
+  GetContext* batch_contexts[4] = {&batch_context0, &batch_context1,
+                                   &batch_context2, &batch_context3};
+  Status batch_statuses[4];
+  reader.MultiGet(ReadOptions(), 4, batch_keys, batch_contexts,
+                  batch_statuses);
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_OK(batch_statuses[i]);
+  }
+  ASSERT_TRUE(batch_values[0].empty());
+  ASSERT_EQ(values[0], batch_values[1].ToString());
+  ASSERT_TRUE(batch_values[2].empty());
+  ASSERT_TRUE(batch_values[3].empty());
 }
 
 // Performance tests
@@ -428,7 +475,7 @@ void WriteFile(const std::vector<std::string>& keys,
       test::Uint64Comparator(), nullptr);
   ASSERT_OK(reader.status());
   ReadOptions r_options;
-  std::string value;
+  PinnableSlice value;
   // Assume only the fast path is triggered
   GetContext get_context(nullptr, nullptr, nullptr, nullptr,
                          GetContext::kNotFound, Slice(), &value,
@@ -440,7 +487,7 @@ void WriteFile(const std::vector<std::string>& keys,
   }
 }
 
-void ReadKeys(uint64_t num, uint32_t batch_size) {
+void ReadKeys(uint64_t num, uint32_t batch_size, bool use_multiget = false) {
   Options options;
   options.allow_mmap_reads = true;
   Env* env = options.env;
@@ -474,13 +521,24 @@ void ReadKeys(uint64_t num, uint32_t batch_size) {
   }
   std::random_shuffle(keys.begin(), keys.end());
 
-  std::string value;
+  PinnableSlice value;
   // Assume only the fast path is triggered
   GetContext get_context(nullptr, nullptr, nullptr, nullptr,
                          GetContext::kNotFound, Slice(), &value,
                          nullptr, nullptr);
+  std::vector<Slice> key_slices;
+  std::vector<GetContext*> get_contexts(batch_size, &get_context);
+  std::vector<Status> statuses(batch_size);
+  for (uint64_t i = 0; i < num; ++i) {
+    key_slices.emplace_back(reinterpret_cast<char*>(&keys[i]), 16);
+  }
   uint64_t start_time = env->NowMicros();
-  if (batch_size > 0) {
+  if (use_multiget) {
+    for (uint64_t i = 0; i < num; i += batch_size) {
+      reader.MultiGet(r_options, std::min<uint64_t>(batch_size, num - i),
+                      &key_slices[i], get_contexts.data(), statuses.data());
+    }
+  } else if (batch_size > 0) {
     for (uint64_t i = 0; i < num; i += batch_size) {
       for (uint64_t j = i; j < i+batch_size && j < num; ++j) {
         reader.Prepare(Slice(reinterpret_cast<char*>(&keys[j]), 16));
@@ -498,8 +556,9 @@ void ReadKeys(uint64_t num, uint32_t batch_size) {
   }
   float time_per_op = (env->NowMicros() - start_time) * 1.0 / num;
   fprintf(stderr,
-      "Time taken per op is %.3fus (%.1f Mqps) with batch size of %u\n",
-      time_per_op, 1.0 / time_per_op, batch_size);
+      "Time taken per op is %.3fus (%.1f Mqps) with batch size of %u%s\n",
+      time_per_op, 1.0 / time_per_op, batch_size,
+      use_multiget ? " (MultiGet)" : "");
 }
 }  // namespace.
 
@@ -528,6 +587,8 @@ TEST(CuckooReaderTest, TestReadPerformance) {
     ReadKeys(num, 25);
     ReadKeys(num, 50);
     ReadKeys(num, 100);
+    ReadKeys(num, 16, true);
+    ReadKeys(num, 100, true);
     fprintf(stderr, "\n");
   }
 }
@@ -0,0 +1,75 @@
+//  Copyright (c) 2013, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "table/data_block_hash_index.h"
+
+#include <algorithm>
+#include <assert.h>
+
+#include "util/coding.h"
+#include "util/hash.h"
+
+namespace rocksdb {
+
+namespace {
+inline uint32_t DataBlockHashIndexHash(const Slice& user_key) {
+  return Hash(user_key.data(), user_key.size(), 0x9ae16a3b);
+}
+}  // namespace
+
+void DataBlockHashIndexBuilder::Add(const Slice& user_key,
+                                    uint32_t restart_index) {
+  // Keep adding past the limit, so that Valid() turns false
+  uint8_t restart = static_cast<uint8_t>(
+      std::min<uint32_t>(restart_index, kMaxRestartSupportedByHashIndex));
+  hash_and_restart_pairs_.emplace_back(DataBlockHashIndexHash(user_key),
+                                       restart);
+}
+
+uint16_t DataBlockHashIndexBuilder::NumBuckets() const {
+  double buckets = hash_and_restart_pairs_.size() / util_ratio_;
+  // Odd so that more bits of the hash are involved in picking a bucket
+  uint32_t num_buckets = static_cast<uint32_t>(buckets) | 1;
+  return static_cast<uint16_t>(std::min<uint32_t>(num_buckets, 0xffff));
+}
+
+void DataBlockHashIndexBuilder::Finish(std::string* buffer) const {
+  assert(Valid());
+  const uint16_t num_buckets = NumBuckets();
+  std::vector<uint8_t> buckets(num_buckets, kNoEntry);
+  for (const auto& entry : hash_and_restart_pairs_) {
+    uint8_t& bucket = buckets[entry.first % num_buckets];
+    if (bucket == kNoEntry) {
+      bucket = entry.second;
+    } else if (bucket != entry.second) {
+      bucket = kCollision;
+    }
+  }
+  buffer->append(reinterpret_cast<const char*>(buckets.data()), num_buckets);
+  PutFixed16(buffer, num_buckets);
+}
+
+bool DataBlockHashIndex::Initialize(const char* data, size_t size,
+                                    size_t* index_size) {
+  if (size < sizeof(uint16_t)) {
+    return false;
+  }
+  uint16_t num_buckets = DecodeFixed16(data + size - sizeof(uint16_t));
+  if (num_buckets == 0 || num_buckets + sizeof(uint16_t) > size) {
+    return false;
+  }
+  num_buckets_ = num_buckets;
+  *index_size = num_buckets + sizeof(uint16_t);
+  buckets_ = data + size - *index_size;
+  return true;
+}
+
+uint8_t DataBlockHashIndex::Lookup(const Slice& user_key) const {
+  assert(Valid());
+  return static_cast<uint8_t>(
+      buckets_[DataBlockHashIndexHash(user_key) % num_buckets_]);
+}
+
+}  // namespace rocksdb
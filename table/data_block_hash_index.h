@@ -0,0 +1,89 @@
+//  Copyright (c) 2013, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "rocksdb/slice.h"
+
+namespace rocksdb {
+
+// A data block hash index maps the user keys of a data block to the restart
+// interval that holds them, so that a point lookup can skip the binary search
+// over the restart array. It is appended to the restart array of the block:
+//
+//     buckets: uint8[num_buckets]
+//     num_buckets: uint16
+//
+// and the block footer is the number of restarts with kDataBlockHashIndexFlag
+// set. A bucket holds the index of the restart interval of the only user key
+// that hashes to it, kNoEntry if no user key does, or kCollision if several
+// user keys do, or the one user key spans several restart intervals. Since
+// buckets are one byte, the index is only built for blocks with at most
+// kMaxRestartSupportedByHashIndex restart intervals.
+//
+// The index requires that user keys that compare equal are equal bytewise.
+
+const uint32_t kDataBlockHashIndexFlag = 1u << 31;
+const uint8_t kNoEntry = 255;
+const uint8_t kCollision = 254;
+const uint8_t kMaxRestartSupportedByHashIndex = 253;
+
+class DataBlockHashIndexBuilder {
+ public:
+  // util_ratio is the number of keys per bucket the index aims for
+  explicit DataBlockHashIndexBuilder(double util_ratio)
+      : util_ratio_(util_ratio) {}
+
+  void Add(const Slice& user_key, uint32_t restart_index);
+
+  // Append the buckets and their count to buffer.
+  // REQUIRES: Valid()
+  void Finish(std::string* buffer) const;
+
+  void Reset() { hash_and_restart_pairs_.clear(); }
+
+  // Returns true if the index can be built for the keys added so far.
+  bool Valid() const {
+    return !hash_and_restart_pairs_.empty() &&
+           hash_and_restart_pairs_.back().second <
+               kMaxRestartSupportedByHashIndex;
+  }
+
+  // Estimated number of bytes Finish() would add
+  size_t EstimateSize() const {
+    return NumBuckets() + sizeof(uint16_t);
+  }
+
+ private:
+  uint16_t NumBuckets() const;
+
+  double util_ratio_;
+  std::vector<std::pair<uint32_t, uint8_t>> hash_and_restart_pairs_;
+};
+
+class DataBlockHashIndex {
+ public:
+  DataBlockHashIndex() : buckets_(nullptr), num_buckets_(0) {}
+
+  // Sets up the index from the end of a block's contents, without the
+  // block footer. On success, *index_size is the number of bytes of the
+  // index. Returns false if the contents cannot hold an index.
+  bool Initialize(const char* data, size_t size, size_t* index_size);
+
+  // Returns the restart interval for user_key, kNoEntry or kCollision
+  uint8_t Lookup(const Slice& user_key) const;
+
+  bool Valid() const { return num_buckets_ != 0; }
+
+ private:
+  const char* buckets_;
+  uint16_t num_buckets_;
+};
+
+}  // namespace rocksdb
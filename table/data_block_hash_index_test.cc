@@ -0,0 +1,239 @@
+//  Copyright (c) 2013, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "db/dbformat.h"
+#include "rocksdb/db.h"
+#include "rocksdb/table.h"
+#include "table/block.h"
+#include "table/block_builder.h"
+#include "table/data_block_hash_index.h"
+#include "table/format.h"
+#include "util/random.h"
+#include "util/testharness.h"
+#include "util/testutil.h"
+
+namespace rocksdb {
+
+namespace {
+std::string UserKey(int i) {
+  char buf[20];
+  snprintf(buf, sizeof(buf), "key%06d", i);
+  return buf;
+}
+
+std::string IKey(int i, SequenceNumber seq) {
+  return InternalKey(UserKey(i), seq, kTypeValue).Encode().ToString();
+}
+
+// Build a data block with versions [1, num_versions] of the even keys in
+// [0, 2 * num_keys), newest version first.
+std::unique_ptr<Block> BuildBlock(int num_keys, int num_versions,
+                                  int restart_interval, bool hash_index,
+                                  std::string* buffer) {
+  BlockBuilder builder(restart_interval, hash_index);
+  for (int i = 0; i < num_keys; i++) {
+    for (int v = num_versions; v >= 1; v--) {
+      builder.Add(IKey(2 * i, v), "v" + std::to_string(v));
+    }
+  }
+  *buffer = builder.Finish().ToString();
+  BlockContents contents;
+  contents.data = Slice(*buffer);
+  contents.cachable = false;
+  return std::unique_ptr<Block>(new Block(std::move(contents)));
+}
+}  // namespace
+
+class DataBlockHashIndexTest {};
+
+TEST(DataBlockHashIndexTest, BuilderAndLookup) {
+  DataBlockHashIndexBuilder builder(0.75);
+  ASSERT_TRUE(!builder.Valid());
+  const int kNumKeys = 200;
+  for (int i = 0; i < kNumKeys; i++) {
+    builder.Add(UserKey(i), i / 4);
+  }
+  ASSERT_TRUE(builder.Valid());
+
+  std::string buffer = "prefix";
+  builder.Finish(&buffer);
+  ASSERT_EQ(buffer.size(), 6 + builder.EstimateSize());
+
+  DataBlockHashIndex index;
+  size_t index_size = 0;
+  ASSERT_TRUE(index.Initialize(buffer.data(), buffer.size(), &index_size));
+  ASSERT_EQ(buffer.size() - 6, index_size);
+  int collisions = 0;
+  for (int i = 0; i < kNumKeys; i++) {
+    uint8_t entry = index.Lookup(UserKey(i));
+    if (entry == kCollision) {
+      collisions++;
+    } else {
+      ASSERT_EQ(i / 4, entry);
+    }
+  }
+  // At 0.75 keys per bucket, about half of the keys share their bucket
+  // with a key of another restart interval.
+  ASSERT_LT(collisions, kNumKeys * 3 / 4);
+
+  // Too many restart intervals for one-byte buckets
+  builder.Reset();
+  builder.Add(UserKey(0), 0);
+  builder.Add(UserKey(1), kMaxRestartSupportedByHashIndex);
+  ASSERT_TRUE(!builder.Valid());
+}
+
+TEST(DataBlockHashIndexTest, BlockFormat) {
+  std::string with_index, without_index;
+  auto block = BuildBlock(100, 1, 4, true, &with_index);
+  auto plain_block = BuildBlock(100, 1, 4, false, &without_index);
+  ASSERT_GT(with_index.size(), without_index.size());
+  ASSERT_EQ(plain_block->NumRestarts(), block->NumRestarts());
+
+  // Both blocks iterate the same
+  InternalKeyComparator icmp(BytewiseComparator());
+  std::unique_ptr<Iterator> iter(block->NewIterator(&icmp));
+  std::unique_ptr<Iterator> plain_iter(plain_block->NewIterator(&icmp));
+  int count = 0;
+  for (iter->SeekToFirst(), plain_iter->SeekToFirst(); iter->Valid();
+       iter->Next(), plain_iter->Next()) {
+    ASSERT_TRUE(plain_iter->Valid());
+    ASSERT_EQ(plain_iter->key().ToString(), iter->key().ToString());
+    count++;
+  }
+  ASSERT_TRUE(!plain_iter->Valid());
+  ASSERT_EQ(100, count);
+
+  // The index is skipped for blocks with too many restarts
+  std::string buffer;
+  block = BuildBlock(300, 1, 1, true, &buffer);
+  ASSERT_EQ(300U, block->NumRestarts());
+  ASSERT_EQ(0U, DecodeFixed32(buffer.data() + buffer.size() - 4) &
+                    kDataBlockHashIndexFlag);
+}
+
+TEST(DataBlockHashIndexTest, SeekForGet) {
+  InternalKeyComparator icmp(BytewiseComparator());
+  for (int restart_interval : {1, 3, 16}) {
+    std::string buffer;
+    const int kNumKeys = 100;
+    const int kNumVersions = 3;
+    auto block =
+        BuildBlock(kNumKeys, kNumVersions, restart_interval, true, &buffer);
+
+    for (int i = 0; i < 2 * kNumKeys; i++) {
+      for (SequenceNumber snapshot = 1; snapshot <= kNumVersions + 1;
+           snapshot++) {
+        BlockIter iter;
+        block->NewIterator(&icmp, &iter);
+        std::string target = IKey(i, snapshot);
+        bool may_exist = iter.SeekForGet(target, BytewiseComparator());
+        ASSERT_OK(iter.status());
+        if (i % 2 == 1) {
+          // Absent keys are not found
+          ASSERT_TRUE(!may_exist || !iter.Valid() ||
+                      ExtractUserKey(iter.key()) != UserKey(i));
+          continue;
+        }
+        // Present keys are found at the newest version <= snapshot
+        ASSERT_TRUE(may_exist);
+        ASSERT_TRUE(iter.Valid());
+        ParsedInternalKey parsed;
+        ASSERT_TRUE(ParseInternalKey(iter.key(), &parsed));
+        ASSERT_EQ(UserKey(i), parsed.user_key.ToString());
+        SequenceNumber expected =
+            std::min<SequenceNumber>(snapshot, kNumVersions);
+        ASSERT_EQ(expected, parsed.sequence);
+      }
+    }
+
+    // Past the last key, older versions may be in the next block
+    BlockIter iter;
+    block->NewIterator(&icmp, &iter);
+    ASSERT_TRUE(iter.SeekForGet(IKey(2 * (kNumKeys - 1), 0),
+                                BytewiseComparator()));
+    ASSERT_TRUE(!iter.Valid());
+  }
+}
+
+TEST(DataBlockHashIndexTest, DBGet) {
+  std::string dbname = test::TmpDir() + "/data_block_hash_index_test";
+  Options options;
+  options.create_if_missing = true;
+  options.compression = kNoCompression;
+  BlockBasedTableOptions table_options;
+  table_options.block_size = 512;
+  table_options.data_block_index_type =
+      BlockBasedTableOptions::kDataBlockBinaryAndHash;
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  ASSERT_OK(DestroyDB(dbname, options));
+
+  DB* db = nullptr;
+  ASSERT_OK(DB::Open(options, dbname, &db));
+  Random rnd(301);
+  const int kNumKeys = 1000;
+  std::map<std::string, std::string> old_values, new_values;
+  for (int i = 0; i < kNumKeys; i += 2) {
+    std::string value = test::RandomKey(&rnd, 20);
+    old_values[UserKey(i)] = value;
+    ASSERT_OK(db->Put(WriteOptions(), UserKey(i), value));
+  }
+  const Snapshot* snapshot = db->GetSnapshot();
+  new_values = old_values;
+  for (int i = 0; i < kNumKeys; i += 6) {
+    std::string value = test::RandomKey(&rnd, 20);
+    new_values[UserKey(i)] = value;
+    ASSERT_OK(db->Put(WriteOptions(), UserKey(i), value));
+  }
+  // Versions of one user key that span several data blocks
+  const std::string kHotKey = UserKey(501);
+  std::vector<const Snapshot*> hot_snapshots;
+  for (int v = 0; v < 100; v++) {
+    ASSERT_OK(db->Put(WriteOptions(), kHotKey, "hot" + std::to_string(v)));
+    hot_snapshots.push_back(db->GetSnapshot());
+  }
+  ASSERT_OK(db->Flush(FlushOptions()));
+
+  for (int v = 0; v < 100; v++) {
+    ReadOptions hot_read;
+    hot_read.snapshot = hot_snapshots[v];
+    std::string hot_value;
+    ASSERT_OK(db->Get(hot_read, kHotKey, &hot_value));
+    ASSERT_EQ("hot" + std::to_string(v), hot_value);
+    db->ReleaseSnapshot(hot_snapshots[v]);
+  }
+
+  ReadOptions snapshot_read;
+  snapshot_read.snapshot = snapshot;
+  std::string value;
+  for (int i = 0; i < kNumKeys; i++) {
+    Status s = db->Get(ReadOptions(), UserKey(i), &value);
+    if (UserKey(i) == kHotKey) {
+      ASSERT_OK(s);
+      ASSERT_EQ("hot99", value);
+      continue;
+    }
+    if (i % 2 == 1) {
+      ASSERT_TRUE(s.IsNotFound());
+      continue;
+    }
+    ASSERT_OK(s);
+    ASSERT_EQ(new_values[UserKey(i)], value);
+    ASSERT_OK(db->Get(snapshot_read, UserKey(i), &value));
+    ASSERT_EQ(old_values[UserKey(i)], value);
+  }
+
+  db->ReleaseSnapshot(snapshot);
+  delete db;
+  ASSERT_OK(DestroyDB(dbname, options));
+}
+
+}  // namespace rocksdb
+
+int main(int argc, char** argv) { return rocksdb::test::RunAllTests(); }
@@ -301,7 +301,8 @@ Status ReadBlock(RandomAccessFile* file, const Footer& footer,
 Status ReadBlockContents(RandomAccessFile* file, const Footer& footer,
                          const ReadOptions& options, const BlockHandle& handle,
                          BlockContents* contents, Env* env,
-                         bool decompression_requested) {
+                         bool decompression_requested,
+                         const Slice& compression_dict) {
   Status status;
   Slice slice;
   size_t n = static_cast<size_t>(handle.size());
@@ -320,18 +321,31 @@ Status ReadBlockContents(RandomAccessFile* file, const Footer& footer,
     used_buf = heap_buf.get();
   }
 
+  uint64_t start_micros = 0;
+  if (env != nullptr && (options.deadline != 0 || options.io_timeout != 0)) {
+    start_micros = env->NowMicros();
+    if (options.deadline != 0 && start_micros >= options.deadline) {
+      return Status::TimedOut("read deadline exceeded");
+    }
+  }
+
   status = ReadBlock(file, footer, options, handle, &slice, used_buf);
 
   if (!status.ok()) {
     return status;
   }
+  if (env != nullptr && options.io_timeout != 0 &&
+      env->NowMicros() - start_micros > options.io_timeout) {
+    return Status::TimedOut("block read exceeded io_timeout");
+  }
 
   PERF_TIMER_GUARD(block_decompress_time);
 
   compression_type = static_cast<rocksdb::CompressionType>(slice.data()[n]);
 
   if (decompression_requested && compression_type != kNoCompression) {
-    return UncompressBlockContents(slice.data(), n, contents, footer.version());
+    return UncompressBlockContents(slice.data(), n, contents, footer.version(),
+                                   compression_dict);
   }
 
   if (slice.data() != used_buf) {
@@ -357,7 +371,8 @@ Status ReadBlockContents(RandomAccessFile* file, const Footer& footer,
 // format_version is the block format as defined in include/rocksdb/table.h
 Status UncompressBlockContents(const char* data, size_t n,
                                BlockContents* contents,
-                               uint32_t format_version) {
+                               uint32_t format_version,
+                               const Slice& compression_dict) {
   std::unique_ptr<char[]> ubuf;
   int decompress_size = 0;
   assert(data[n] != kNoCompression);
@@ -379,7 +394,8 @@ Status UncompressBlockContents(const char* data, size_t n,
     case kZlibCompression:
       ubuf = std::unique_ptr<char[]>(Zlib_Uncompress(
           data, n, &decompress_size,
-          GetCompressFormatForVersion(kZlibCompression, format_version)));
+          GetCompressFormatForVersion(kZlibCompression, format_version),
+          compression_dict));
       if (!ubuf) {
         static char zlib_corrupt_msg[] =
           "Zlib not supported or corrupted Zlib compressed block contents";
@@ -424,6 +440,17 @@ Status UncompressBlockContents(const char* data, size_t n,
       *contents =
           BlockContents(std::move(ubuf), decompress_size, true, kNoCompression);
       break;
+    case kZSTD:
+      ubuf = std::unique_ptr<char[]>(
+          ZSTD_Uncompress(data, n, &decompress_size, compression_dict));
+      if (!ubuf) {
+        static char zstd_corrupt_msg[] =
+          "ZSTD not supported or corrupted ZSTD compressed block contents";
+        return Status::Corruption(zstd_corrupt_msg);
+      }
+      *contents =
+          BlockContents(std::move(ubuf), decompress_size, true, kNoCompression);
+      break;
     default:
       return Status::Corruption("bad block type");
   }
@@ -4,6 +4,7 @@
 //  of patent rights can be found in the PATENTS file in the same directory.
 
 #include "table/get_context.h"
+#include "db/blob_file.h"
 #include "rocksdb/merge_operator.h"
 #include "rocksdb/statistics.h"
 #include "util/statistics.h"
@@ -13,17 +14,19 @@ namespace rocksdb {
 GetContext::GetContext(const Comparator* ucmp,
       const MergeOperator* merge_operator,
       Logger* logger, Statistics* statistics,
-      GetState init_state, const Slice& user_key, std::string* ret_value,
-      bool* value_found, MergeContext* merge_context)
+      GetState init_state, const Slice& user_key,
+      PinnableSlice* pinnable_val, bool* value_found,
+      MergeContext* merge_context, const BlobFetcher* blob_fetcher)
   : ucmp_(ucmp),
     merge_operator_(merge_operator),
     logger_(logger),
     statistics_(statistics),
     state_(init_state),
     user_key_(user_key),
-    value_(ret_value),
+    pinnable_val_(pinnable_val),
     value_found_(value_found),
-    merge_context_(merge_context) {
+    merge_context_(merge_context),
+    blob_fetcher_(blob_fetcher) {
 }
 
 // Called from TableCache::Get and Table::Get when file/block in which
@@ -38,34 +41,85 @@ void GetContext::MarkKeyMayExist() {
   }
 }
 
+bool GetContext::FetchBlob(const Slice& blob_index, std::string* blob_value) {
+  Status s = (blob_fetcher_ == nullptr)
+                 ? Status::NotSupported("no blob files to read from")
+                 : blob_fetcher_->FetchBlob(user_key_, blob_index, blob_value);
+  if (s.IsIncomplete()) {
+    // The blob file is not open and no IO is allowed
+    MarkKeyMayExist();
+    return false;
+  }
+  if (!s.ok()) {
+    state_ = kCorrupt;
+    return false;
+  }
+  return true;
+}
+
 void GetContext::SaveValue(const Slice& value) {
   state_ = kFound;
-  value_->assign(value.data(), value.size());
+  pinnable_val_->PinSelf(value);
 }
 
 bool GetContext::SaveValue(const ParsedInternalKey& parsed_key,
-                           const Slice& value) {
+                           const Slice& value, Cleanable* value_pinner) {
   assert((state_ != kMerge && parsed_key.type != kTypeMerge) ||
          merge_context_ != nullptr);
   if (ucmp_->Compare(parsed_key.user_key, user_key_) == 0) {
+    if (merge_context_ != nullptr && merge_context_->IsCollectingOperands()) {
+      return CollectOperand(parsed_key, value, value_pinner);
+    }
     // Key matches. Process it
     switch (parsed_key.type) {
       case kTypeValue:
         assert(state_ == kNotFound || state_ == kMerge);
         if (kNotFound == state_) {
           state_ = kFound;
-          value_->assign(value.data(), value.size());
+          if (value_pinner != nullptr) {
+            pinnable_val_->PinSlice(value, value_pinner);
+          } else {
+            pinnable_val_->PinSelf(value);
+          }
         } else if (kMerge == state_) {
           assert(merge_operator_ != nullptr);
           state_ = kFound;
           if (!merge_operator_->FullMerge(user_key_, &value,
                                           merge_context_->GetOperands(),
-                                          value_, logger_)) {
+                                          pinnable_val_->GetSelf(), logger_)) {
+            RecordTick(statistics_, NUMBER_MERGE_FAILURES);
+            state_ = kCorrupt;
+          } else {
+            pinnable_val_->PinSelf();
+          }
+        }
+        return false;
+
+      case kTypeBlobIndex: {
+        assert(state_ == kNotFound || state_ == kMerge);
+        std::string blob_value;
+        if (!FetchBlob(value, &blob_value)) {
+          return false;
+        }
+        if (kNotFound == state_) {
+          state_ = kFound;
+          pinnable_val_->GetSelf()->swap(blob_value);
+          pinnable_val_->PinSelf();
+        } else if (kMerge == state_) {
+          assert(merge_operator_ != nullptr);
+          state_ = kFound;
+          Slice blob_slice(blob_value);
+          if (!merge_operator_->FullMerge(user_key_, &blob_slice,
+                                          merge_context_->GetOperands(),
+                                          pinnable_val_->GetSelf(), logger_)) {
             RecordTick(statistics_, NUMBER_MERGE_FAILURES);
             state_ = kCorrupt;
+          } else {
+            pinnable_val_->PinSelf();
           }
         }
         return false;
+      }
 
       case kTypeDeletion:
         assert(state_ == kNotFound || state_ == kMerge);
@@ -75,9 +129,11 @@ bool GetContext::SaveValue(const ParsedInternalKey& parsed_key,
           state_ = kFound;
           if (!merge_operator_->FullMerge(user_key_, nullptr,
                                           merge_context_->GetOperands(),
-                                          value_, logger_)) {
+                                          pinnable_val_->GetSelf(), logger_)) {
             RecordTick(statistics_, NUMBER_MERGE_FAILURES);
             state_ = kCorrupt;
+          } else {
+            pinnable_val_->PinSelf();
           }
         }
         return false;
@@ -85,7 +141,7 @@ bool GetContext::SaveValue(const ParsedInternalKey& parsed_key,
       case kTypeMerge:
         assert(state_ == kNotFound || state_ == kMerge);
         state_ = kMerge;
-        merge_context_->PushOperand(value);
+        merge_context_->PushOperand(value, parsed_key.sequence);
         return true;
 
       default:
@@ -98,4 +154,45 @@ bool GetContext::SaveValue(const ParsedInternalKey& parsed_key,
   return false;
 }
 
+bool GetContext::CollectOperand(const ParsedInternalKey& parsed_key,
+                                const Slice& value, Cleanable* value_pinner) {
+  assert(state_ == kNotFound || state_ == kMerge);
+  switch (parsed_key.type) {
+    case kTypeValue:
+      // The base value is the oldest operand
+      merge_context_->PushCollectedOperand(value, value_pinner);
+      merge_context_->FinishCollectedOperands();
+      state_ = kFound;
+      return false;
+
+    case kTypeBlobIndex: {
+      std::string blob_value;
+      if (!FetchBlob(value, &blob_value)) {
+        return false;
+      }
+      merge_context_->PushCollectedOperand(blob_value, nullptr);
+      merge_context_->FinishCollectedOperands();
+      state_ = kFound;
+      return false;
+    }
+
+    case kTypeDeletion:
+      merge_context_->FinishCollectedOperands();
+      state_ = (kMerge == state_) ? kFound : kDeleted;
+      return false;
+
+    case kTypeMerge:
+      state_ = kMerge;
+      if (!merge_context_->PushCollectedOperand(value, value_pinner)) {
+        state_ = kFound;
+        return false;
+      }
+      return true;
+
+    default:
+      assert(false);
+      return false;
+  }
+}
+
 }  // namespace rocksdb
@@ -6,8 +6,10 @@
 #pragma once
 #include <string>
 #include "db/merge_context.h"
+#include "rocksdb/slice.h"
 
 namespace rocksdb {
+class BlobFetcher;
 class MergeContext;
 
 class GetContext {
@@ -22,15 +24,28 @@ class GetContext {
 
   GetContext(const Comparator* ucmp, const MergeOperator* merge_operator,
              Logger* logger, Statistics* statistics,
-             GetState init_state, const Slice& user_key, std::string* ret_value,
-             bool* value_found, MergeContext* merge_context);
+             GetState init_state, const Slice& user_key,
+             PinnableSlice* pinnable_val, bool* value_found,
+             MergeContext* merge_context,
+             const BlobFetcher* blob_fetcher = nullptr);
 
   void MarkKeyMayExist();
   void SaveValue(const Slice& value);
-  bool SaveValue(const ParsedInternalKey& parsed_key, const Slice& value);
+  // If value_pinner is not null, the found value is not copied. Its storage
+  // is kept alive by moving the cleanups of value_pinner to the result.
+  bool SaveValue(const ParsedInternalKey& parsed_key, const Slice& value,
+                 Cleanable* value_pinner = nullptr);
   GetState State() const { return state_; }
 
  private:
+  // SaveValue() for a merge_context_ that collects operands instead of
+  // merging them
+  bool CollectOperand(const ParsedInternalKey& parsed_key, const Slice& value,
+                      Cleanable* value_pinner);
+  // Read the value of a kTypeBlobIndex entry into *blob_value. On failure,
+  // updates state_ and returns false.
+  bool FetchBlob(const Slice& blob_index, std::string* blob_value);
+
   const Comparator* ucmp_;
   const MergeOperator* merge_operator_;
   // the merge operations encountered;
@@ -39,9 +54,11 @@ class GetContext {
 
   GetState state_;
   Slice user_key_;
-  std::string* value_;
+  PinnableSlice* pinnable_val_;
   bool* value_found_;  // Is value set correctly? Used by KeyMayExist
   MergeContext* merge_context_;
+  // Resolves kTypeBlobIndex entries, nullptr if there is no blob file
+  const BlobFetcher* blob_fetcher_;
 };
 
 }  // namespace rocksdb
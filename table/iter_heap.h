@@ -5,7 +5,8 @@
 //
 
 #pragma once
-#include <queue>
+#include <algorithm>
+#include <vector>
 
 #include "rocksdb/comparator.h"
 #include "table/iterator_wrapper.h"
@@ -41,4 +42,70 @@ class MinIteratorComparator {
   const Comparator* comparator_;
 };
 
+// A binary heap of iterators with the interface of std::priority_queue
+// plus two operations that let MergingIterator keep its heaps across
+// moves: clear() keeps the storage for reuse, and replace_top() restores
+// the heap after the top iterator moved with a single sift down instead
+// of a pop() and a push().
+template <class IteratorComparator>
+class IteratorHeap {
+ public:
+  explicit IteratorHeap(const IteratorComparator& cmp) : cmp_(cmp) {}
+
+  void push(IteratorWrapper* iter) {
+    data_.push_back(iter);
+    std::push_heap(data_.begin(), data_.end(), cmp_);
+  }
+
+  IteratorWrapper* top() const {
+    assert(!empty());
+    return data_.front();
+  }
+
+  void pop() {
+    assert(!empty());
+    data_.front() = data_.back();
+    data_.pop_back();
+    if (!empty()) {
+      SiftDown(0);
+    }
+  }
+
+  // Replace the top of the heap with iter, usually the top iterator itself
+  // after it has been moved.
+  void replace_top(IteratorWrapper* iter) {
+    assert(!empty());
+    data_.front() = iter;
+    SiftDown(0);
+  }
+
+  bool empty() const { return data_.empty(); }
+  size_t size() const { return data_.size(); }
+  void clear() { data_.clear(); }
+
+ private:
+  void SiftDown(size_t index) {
+    IteratorWrapper* iter = data_[index];
+    const size_t n = data_.size();
+    while (true) {
+      size_t child = 2 * index + 1;
+      if (child >= n) {
+        break;
+      }
+      if (child + 1 < n && cmp_(data_[child], data_[child + 1])) {
+        child++;
+      }
+      if (!cmp_(iter, data_[child])) {
+        break;
+      }
+      data_[index] = data_[child];
+      index = child;
+    }
+    data_[index] = iter;
+  }
+
+  IteratorComparator cmp_;
+  std::vector<IteratorWrapper*> data_;
+};
+
 }  // namespace rocksdb
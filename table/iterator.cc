@@ -13,12 +13,14 @@
 
 namespace rocksdb {
 
-Iterator::Iterator() {
+Cleanable::Cleanable() {
   cleanup_.function = nullptr;
   cleanup_.next = nullptr;
 }
 
-Iterator::~Iterator() {
+Cleanable::~Cleanable() { Reset(); }
+
+void Cleanable::Reset() {
   if (cleanup_.function != nullptr) {
     (*cleanup_.function)(cleanup_.arg1, cleanup_.arg2);
     for (Cleanup* c = cleanup_.next; c != nullptr; ) {
@@ -28,9 +30,11 @@ Iterator::~Iterator() {
       c = next;
     }
   }
+  cleanup_.function = nullptr;
+  cleanup_.next = nullptr;
 }
 
-void Iterator::RegisterCleanup(CleanupFunction func, void* arg1, void* arg2) {
+void Cleanable::RegisterCleanup(CleanupFunction func, void* arg1, void* arg2) {
   assert(func != nullptr);
   Cleanup* c;
   if (cleanup_.function == nullptr) {
@@ -45,6 +49,26 @@ void Iterator::RegisterCleanup(CleanupFunction func, void* arg1, void* arg2) {
   c->arg2 = arg2;
 }
 
+void Cleanable::DelegateCleanupsTo(Cleanable* other) {
+  assert(other != nullptr);
+  if (cleanup_.function == nullptr) {
+    return;
+  }
+  other->RegisterCleanup(cleanup_.function, cleanup_.arg1, cleanup_.arg2);
+  for (Cleanup* c = cleanup_.next; c != nullptr; ) {
+    other->RegisterCleanup(c->function, c->arg1, c->arg2);
+    Cleanup* next = c->next;
+    delete c;
+    c = next;
+  }
+  cleanup_.function = nullptr;
+  cleanup_.next = nullptr;
+}
+
+Iterator::Iterator() {}
+
+Iterator::~Iterator() {}
+
 namespace {
 class EmptyIterator : public Iterator {
  public:
@@ -36,6 +36,14 @@ class IteratorWrapper {
     }
   }
 
+  // Stop wrapping the current iterator and return it without deleting it.
+  Iterator* Release() {
+    Iterator* iter = iter_;
+    iter_ = nullptr;
+    valid_ = false;
+    return iter;
+  }
+
   void DeleteIter(bool is_arena_mode) {
     if (!is_arena_mode) {
       delete iter_;
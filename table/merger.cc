@@ -10,7 +10,6 @@
 #include "table/merger.h"
 
 #include <vector>
-#include <queue>
 
 #include "rocksdb/comparator.h"
 #include "rocksdb/iterator.h"
@@ -25,11 +24,9 @@
 namespace rocksdb {
 // Without anonymous namespace here, we fail the warning -Wmissing-prototypes
 namespace {
-typedef std::priority_queue<IteratorWrapper*, std::vector<IteratorWrapper*>,
-                            MaxIteratorComparator> MergerMaxIterHeap;
+typedef IteratorHeap<MaxIteratorComparator> MergerMaxIterHeap;
 
-typedef std::priority_queue<IteratorWrapper*, std::vector<IteratorWrapper*>,
-                            MinIteratorComparator> MergerMinIterHeap;
+typedef IteratorHeap<MinIteratorComparator> MergerMinIterHeap;
 
 // Return's a new MaxHeap of IteratorWrapper's using the provided Comparator.
 MergerMaxIterHeap NewMergerMaxIterHeap(const Comparator* comparator) {
@@ -89,6 +86,9 @@ class MergingIterator : public Iterator {
       child.SeekToFirst();
       if (child.Valid()) {
         minHeap_.push(&child);
+      } else if (TimedOut(child)) {
+        Stop();
+        return;
       }
     }
     FindSmallest();
@@ -101,6 +101,9 @@ class MergingIterator : public Iterator {
       child.SeekToLast();
       if (child.Valid()) {
         maxHeap_.push(&child);
+      } else if (TimedOut(child)) {
+        Stop();
+        return;
       }
     }
     FindLargest();
@@ -138,6 +141,9 @@ class MergingIterator : public Iterator {
           PERF_TIMER_GUARD(seek_min_heap_time);
           minHeap_.push(&child);
         }
+      } else if (TimedOut(child)) {
+        Stop();
+        return;
       }
     }
     if (use_heap_) {
@@ -171,18 +177,30 @@ class MergingIterator : public Iterator {
           }
           if (child.Valid()) {
             minHeap_.push(&child);
+          } else if (TimedOut(child)) {
+            Stop();
+            return;
           }
         }
       }
+      // current_ is the only child at key(), so it ends up on top
+      minHeap_.push(current_);
       direction_ = kForward;
     }
 
     // as the current points to the current record. move the iterator forward.
-    // and if it is valid add it to the heap.
+    // current_ stays on top of the heap, so it only needs to sink to its new
+    // place, or to be removed if it ran out of entries.
     current_->Next();
+    if (TimedOut(*current_)) {
+      Stop();
+      return;
+    }
     if (use_heap_) {
       if (current_->Valid()) {
-        minHeap_.push(current_);
+        minHeap_.replace_top(current_);
+      } else {
+        minHeap_.pop();
       }
       FindSmallest();
     } else if (!current_->Valid()) {
@@ -211,15 +229,26 @@ class MergingIterator : public Iterator {
           }
           if (child.Valid()) {
             maxHeap_.push(&child);
+          } else if (TimedOut(child)) {
+            Stop();
+            return;
           }
         }
       }
+      // current_ is the only child at key(), so it ends up on top
+      maxHeap_.push(current_);
       direction_ = kReverse;
     }
 
     current_->Prev();
+    if (TimedOut(*current_)) {
+      Stop();
+      return;
+    }
     if (current_->Valid()) {
-      maxHeap_.push(current_);
+      maxHeap_.replace_top(current_);
+    } else {
+      maxHeap_.pop();
     }
     FindLargest();
   }
@@ -234,6 +263,11 @@ class MergingIterator : public Iterator {
     return current_->value();
   }
 
+  virtual bool IsKeyPinned() const override {
+    assert(Valid());
+    return current_->iter()->IsKeyPinned();
+  }
+
   virtual Status status() const override {
     Status s;
     for (auto& child : children_) {
@@ -246,10 +280,23 @@ class MergingIterator : public Iterator {
   }
 
  private:
+  // Point current_ at the top of the heap of the current direction. The
+  // top stays in the heap while it is current_.
   void FindSmallest();
   void FindLargest();
   void ClearHeaps();
 
+  // A child that gave up at ReadOptions::deadline may hold newer versions of
+  // the keys of the other children, so none of theirs can be returned: the
+  // iterator becomes invalid, and status() returns the child's.
+  static bool TimedOut(const IteratorWrapper& child) {
+    return !child.Valid() && child.status().IsTimedOut();
+  }
+  void Stop() {
+    ClearHeaps();
+    current_ = nullptr;
+  }
+
   bool is_arena_mode_;
   const Comparator* comparator_;
   autovector<IteratorWrapper, kNumIterReserve> children_;
@@ -266,6 +313,8 @@ class MergingIterator : public Iterator {
     kReverse
   };
   Direction direction_;
+  // Both heaps live as long as the iterator, so that changing direction
+  // reuses their storage.
   MergerMaxIterHeap maxHeap_;
   MergerMinIterHeap minHeap_;
 };
@@ -277,7 +326,6 @@ void MergingIterator::FindSmallest() {
   } else {
     current_ = minHeap_.top();
     assert(current_->Valid());
-    minHeap_.pop();
   }
 }
 
@@ -288,14 +336,13 @@ void MergingIterator::FindLargest() {
   } else {
     current_ = maxHeap_.top();
     assert(current_->Valid());
-    maxHeap_.pop();
   }
 }
 
 void MergingIterator::ClearHeaps() {
   use_heap_ = true;
-  maxHeap_ = NewMergerMaxIterHeap(comparator_);
-  minHeap_ = NewMergerMinIterHeap(comparator_);
+  maxHeap_.clear();
+  minHeap_.clear();
 }
 
 Iterator* NewMergingIterator(const Comparator* cmp, Iterator** list, int n,
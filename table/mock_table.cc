@@ -15,7 +15,8 @@
 namespace rocksdb {
 namespace mock {
 
-Iterator* MockTableReader::NewIterator(const ReadOptions&, Arena* arena) {
+Iterator* MockTableReader::NewIterator(const ReadOptions&, Arena* arena,
+                                       bool for_compaction) {
   return new MockTableIterator(table_);
 }
 
@@ -35,7 +35,8 @@ class MockTableReader : public TableReader {
  public:
   explicit MockTableReader(const MockFileContents& table) : table_(table) {}
 
-  Iterator* NewIterator(const ReadOptions&, Arena* arena) override;
+  Iterator* NewIterator(const ReadOptions&, Arena* arena,
+                        bool for_compaction = false) override;
 
   Status Get(const ReadOptions&, const Slice& key,
              GetContext* get_context) override;
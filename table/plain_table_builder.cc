@@ -62,7 +62,7 @@ PlainTableBuilder::PlainTableBuilder(
     const ImmutableCFOptions& ioptions, WritableFile* file,
     uint32_t user_key_len, EncodingType encoding_type, size_t index_sparseness,
     uint32_t bloom_bits_per_key, uint32_t num_probes, size_t huge_page_tlb_size,
-    double hash_table_ratio, bool store_index_in_file)
+    double hash_table_ratio, bool store_index_in_file, bool total_order_index)
     : ioptions_(ioptions),
       bloom_block_(num_probes),
       file_(file),
@@ -81,6 +81,11 @@ PlainTableBuilder::PlainTableBuilder(
     assert(bloom_bits_per_key_ > 0);
     properties_.user_collected_properties
         [PlainTablePropertyNames::kBloomVersion] = "1";  // For future use
+    if (total_order_index && !IsTotalOrderMode() && encoding_type == kPlain) {
+      // A single bucket, i.e. a sorted index of every index_sparseness-th row
+      total_order_index_builder_.reset(new PlainTableIndexBuilder(
+          &arena_, ioptions, index_sparseness, 0, huge_page_tlb_size_));
+    }
   }
 
   properties_.fixed_key_len = user_key_len;
@@ -142,6 +147,9 @@ void PlainTableBuilder::Add(const Slice& key, const Slice& value) {
                      &meta_bytes_buf_size);
   if (SaveIndexInFile()) {
     index_builder_->AddKeyPrefix(GetPrefix(internal_key), prev_offset);
+    if (total_order_index_builder_) {
+      total_order_index_builder_->AddKeyPrefix(Slice(), prev_offset);
+    }
   }
 
   // Write value length
@@ -217,6 +225,20 @@ Status PlainTableBuilder::Finish() {
     meta_index_builer.Add(BloomBlockBuilder::kBloomBlock, bloom_block_handle);
     meta_index_builer.Add(PlainTableIndexBuilder::kPlainTableIndexBlock,
                           index_block_handle);
+
+    if (total_order_index_builder_) {
+      BlockHandle total_order_index_block_handle;
+      finish_result = total_order_index_builder_->Finish();
+      properties_.index_size += finish_result.size();
+      s = WriteBlock(finish_result, file_, &offset_,
+                     &total_order_index_block_handle);
+      if (!s.ok()) {
+        return s;
+      }
+      meta_index_builer.Add(
+          PlainTableIndexBuilder::kPlainTableTotalOrderIndexBlock,
+          total_order_index_block_handle);
+    }
   }
 
   // Calculate bloom block size and index block size
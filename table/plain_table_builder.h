@@ -35,7 +35,8 @@ class PlainTableBuilder: public TableBuilder {
                     size_t index_sparseness, uint32_t bloom_bits_per_key,
                     uint32_t num_probes = 6, size_t huge_page_tlb_size = 0,
                     double hash_table_ratio = 0,
-                    bool store_index_in_file = false);
+                    bool store_index_in_file = false,
+                    bool total_order_index = false);
 
   // REQUIRES: Either Finish() or Abandon() has been called.
   ~PlainTableBuilder();
@@ -77,6 +78,9 @@ class PlainTableBuilder: public TableBuilder {
 
   BloomBlockBuilder bloom_block_;
   std::unique_ptr<PlainTableIndexBuilder> index_builder_;
+  // Builds the total order index of a table with a prefix extractor, if it
+  // is to be stored in the file
+  std::unique_ptr<PlainTableIndexBuilder> total_order_index_builder_;
 
   WritableFile* file_;
   uint64_t offset_ = 0;
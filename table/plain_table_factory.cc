@@ -23,7 +23,8 @@ Status PlainTableFactory::NewTableReader(const ImmutableCFOptions& ioptions,
   return PlainTableReader::Open(ioptions, env_options, icomp, std::move(file),
                                 file_size, table, bloom_bits_per_key_,
                                 hash_table_ratio_, index_sparseness_,
-                                huge_page_tlb_size_, full_scan_mode_);
+                                huge_page_tlb_size_, full_scan_mode_,
+                                total_order_index_);
 }
 
 TableBuilder* PlainTableFactory::NewTableBuilder(
@@ -39,7 +40,7 @@ TableBuilder* PlainTableFactory::NewTableBuilder(
   return new PlainTableBuilder(ioptions, file, user_key_len_, encoding_type_,
                                index_sparseness_, bloom_bits_per_key_, 6,
                                huge_page_tlb_size_, hash_table_ratio_,
-                               store_index_in_file_);
+                               store_index_in_file_, total_order_index_);
 }
 
 std::string PlainTableFactory::GetPrintableTableOptions() const {
@@ -72,6 +73,9 @@ std::string PlainTableFactory::GetPrintableTableOptions() const {
   snprintf(buffer, kBufferSize, "  store_index_in_file: %d\n",
            store_index_in_file_);
   ret.append(buffer);
+  snprintf(buffer, kBufferSize, "  total_order_index: %d\n",
+           total_order_index_);
+  ret.append(buffer);
   return ret;
 }
 
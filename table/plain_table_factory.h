@@ -151,7 +151,8 @@ class PlainTableFactory : public TableFactory {
         huge_page_tlb_size_(options.huge_page_tlb_size),
         encoding_type_(options.encoding_type),
         full_scan_mode_(options.full_scan_mode),
-        store_index_in_file_(options.store_index_in_file) {}
+        store_index_in_file_(options.store_index_in_file),
+        total_order_index_(options.total_order_index) {}
   const char* Name() const override { return "PlainTable"; }
   Status NewTableReader(
       const ImmutableCFOptions& options, const EnvOptions& soptions,
@@ -187,6 +188,7 @@ class PlainTableFactory : public TableFactory {
   EncodingType encoding_type_;
   bool full_scan_mode_;
   bool store_index_in_file_;
+  bool total_order_index_;
 };
 
 }  // namespace rocksdb
@@ -210,6 +210,8 @@ Slice PlainTableIndexBuilder::FillIndexes(
 
 const std::string PlainTableIndexBuilder::kPlainTableIndexBlock =
     "PlainTableIndexBlock";
+const std::string PlainTableIndexBuilder::kPlainTableTotalOrderIndexBlock =
+    "PlainTableTotalOrderIndexBlock";
 };  // namespace rocksdb
 
 #endif  // ROCKSDB_LITE
@@ -136,6 +136,7 @@ class PlainTableIndexBuilder {
   }
 
   static const std::string kPlainTableIndexBlock;
+  static const std::string kPlainTableTotalOrderIndexBlock;
 
  private:
   struct IndexRecord {
@@ -120,7 +120,8 @@ Status PlainTableReader::Open(const ImmutableCFOptions& ioptions,
                               unique_ptr<TableReader>* table_reader,
                               const int bloom_bits_per_key,
                               double hash_table_ratio, size_t index_sparseness,
-                              size_t huge_page_tlb_size, bool full_scan_mode) {
+                              size_t huge_page_tlb_size, bool full_scan_mode,
+                              bool total_order_index) {
   assert(ioptions.allow_mmap_reads);
   if (file_size > PlainTableIndex::kMaxFileSize) {
     return Status::NotSupported("File is too large for PlainTableReader!");
@@ -170,7 +171,8 @@ Status PlainTableReader::Open(const ImmutableCFOptions& ioptions,
 
   if (!full_scan_mode) {
     s = new_reader->PopulateIndex(props, bloom_bits_per_key, hash_table_ratio,
-                                  index_sparseness, huge_page_tlb_size);
+                                  index_sparseness, huge_page_tlb_size,
+                                  total_order_index);
     if (!s.ok()) {
       return s;
     }
@@ -188,16 +190,18 @@ void PlainTableReader::SetupForCompaction() {
 }
 
 Iterator* PlainTableReader::NewIterator(const ReadOptions& options,
-                                        Arena* arena) {
-  if (options.total_order_seek && !IsTotalOrderMode()) {
+                                        Arena* arena, bool for_compaction) {
+  if (options.total_order_seek && !IsTotalOrderMode() &&
+      !HasTotalOrderIndex()) {
     return NewErrorIterator(
         Status::InvalidArgument("total_order_seek not supported"), arena);
   }
+  bool use_prefix_seek = !IsTotalOrderMode() && !options.total_order_seek;
   if (arena == nullptr) {
-    return new PlainTableIterator(this, prefix_extractor_ != nullptr);
+    return new PlainTableIterator(this, use_prefix_seek);
   } else {
     auto mem = arena->AllocateAligned(sizeof(PlainTableIterator));
-    return new (mem) PlainTableIterator(this, prefix_extractor_ != nullptr);
+    return new (mem) PlainTableIterator(this, use_prefix_seek);
   }
 }
 
@@ -277,7 +281,8 @@ Status PlainTableReader::PopulateIndex(TableProperties* props,
                                        int bloom_bits_per_key,
                                        double hash_table_ratio,
                                        size_t index_sparseness,
-                                       size_t huge_page_tlb_size) {
+                                       size_t huge_page_tlb_size,
+                                       bool total_order_index) {
   assert(props != nullptr);
   table_properties_.reset(props);
 
@@ -378,6 +383,13 @@ Status PlainTableReader::PopulateIndex(TableProperties* props,
                          huge_page_tlb_size, &prefix_hashes);
   }
 
+  if (total_order_index && !IsTotalOrderMode() && encoding_type_ == kPlain) {
+    s = PopulateTotalOrderIndex(index_sparseness, huge_page_tlb_size);
+    if (!s.ok()) {
+      return s;
+    }
+  }
+
   // Fill two table properties.
   if (!index_in_file) {
     props->user_collected_properties["plain_table_hash_table_size"] =
@@ -394,6 +406,84 @@ Status PlainTableReader::PopulateIndex(TableProperties* props,
   return Status::OK();
 }
 
+Status PlainTableReader::PopulateTotalOrderIndex(size_t index_sparseness,
+                                                 size_t huge_page_tlb_size) {
+  BlockContents index_block_contents;
+  Status s = ReadMetaBlock(
+      file_.get(), file_size_, kPlainTableMagicNumber, ioptions_.env,
+      PlainTableIndexBuilder::kPlainTableTotalOrderIndexBlock,
+      &index_block_contents);
+  if (s.ok()) {
+    return total_order_index_.InitFromRawData(index_block_contents.data);
+  }
+
+  // A hash table ratio of 0 makes a single bucket holding a sorted index of
+  // every index_sparseness-th row
+  PlainTableIndexBuilder index_builder(&arena_, ioptions_, index_sparseness, 0,
+                                       huge_page_tlb_size);
+  PlainTableKeyDecoder decoder(encoding_type_, user_key_len_,
+                               ioptions_.prefix_extractor);
+  uint32_t pos = data_start_offset_;
+  while (pos < data_end_offset_) {
+    uint32_t key_offset = pos;
+    ParsedInternalKey key;
+    Slice value_slice;
+    s = Next(&decoder, &pos, &key, nullptr, &value_slice);
+    if (!s.ok()) {
+      return s;
+    }
+    index_builder.AddKeyPrefix(Slice(), key_offset);
+  }
+  return total_order_index_.InitFromRawData(index_builder.Finish());
+}
+
+Status PlainTableReader::GetTotalOrderOffset(const Slice& target,
+                                             uint32_t* offset) const {
+  uint32_t bucket_value;
+  auto res = total_order_index_.GetOffset(0, &bucket_value);
+  if (res == PlainTableIndex::kNoPrefixForBucket) {
+    *offset = data_end_offset_;
+    return Status::OK();
+  } else if (res == PlainTableIndex::kDirectToFile) {
+    // Only the first row is indexed
+    *offset = bucket_value;
+    return Status::OK();
+  }
+
+  uint32_t upper_bound;
+  const char* base_ptr = total_order_index_.GetSubIndexBasePtrAndUpperBound(
+      bucket_value, &upper_bound);
+  ParsedInternalKey parsed_target;
+  if (!ParseInternalKey(target, &parsed_target)) {
+    return Status::Corruption(Slice());
+  }
+  PlainTableKeyDecoder decoder(encoding_type_, user_key_len_,
+                               ioptions_.prefix_extractor);
+  // Find the last indexed row whose key is less than target, if any. The
+  // first key not less than target is at most index_sparseness rows after it.
+  uint32_t low = 0;
+  uint32_t high = upper_bound;
+  while (high - low > 1) {
+    uint32_t mid = (high + low) / 2;
+    uint32_t file_offset = GetFixed32Element(base_ptr, mid);
+    ParsedInternalKey mid_key;
+    size_t tmp;
+    Status s = decoder.NextKey(file_data_.data() + file_offset,
+                               file_data_.data() + data_end_offset_, &mid_key,
+                               nullptr, &tmp);
+    if (!s.ok()) {
+      return s;
+    }
+    if (internal_comparator_.Compare(mid_key, parsed_target) < 0) {
+      low = mid;
+    } else {
+      high = mid;
+    }
+  }
+  *offset = GetFixed32Element(base_ptr, low);
+  return Status::OK();
+}
+
 Status PlainTableReader::GetOffset(const Slice& target, const Slice& prefix,
                                    uint32_t prefix_hash, bool& prefix_matched,
                                    uint32_t* offset) const {
@@ -635,6 +725,18 @@ void PlainTableIterator::Seek(const Slice& target) {
           Status::InvalidArgument("Seek() is not allowed in full scan mode.");
       offset_ = next_offset_ = table_->data_end_offset_;
       return;
+    } else if (table_->HasTotalOrderIndex()) {
+      status_ = table_->GetTotalOrderOffset(target, &next_offset_);
+      if (!status_.ok()) {
+        offset_ = next_offset_ = table_->data_end_offset_;
+        return;
+      }
+      for (Next(); status_.ok() && Valid(); Next()) {
+        if (table_->internal_comparator_.Compare(key(), target) >= 0) {
+          break;
+        }
+      }
+      return;
     } else if (table_->GetIndexSize() > 1) {
       assert(false);
       status_ = Status::NotSupported(
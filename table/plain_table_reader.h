@@ -60,9 +60,10 @@ class PlainTableReader: public TableReader {
                      unique_ptr<TableReader>* table,
                      const int bloom_bits_per_key, double hash_table_ratio,
                      size_t index_sparseness, size_t huge_page_tlb_size,
-                     bool full_scan_mode);
+                     bool full_scan_mode, bool total_order_index = false);
 
-  Iterator* NewIterator(const ReadOptions&, Arena* arena = nullptr) override;
+  Iterator* NewIterator(const ReadOptions&, Arena* arena = nullptr,
+                        bool for_compaction = false) override;
 
   void Prepare(const Slice& target) override;
 
@@ -105,7 +106,8 @@ class PlainTableReader: public TableReader {
 
   Status PopulateIndex(TableProperties* props, int bloom_bits_per_key,
                        double hash_table_ratio, size_t index_sparseness,
-                       size_t huge_page_tlb_size);
+                       size_t huge_page_tlb_size,
+                       bool total_order_index = false);
 
   Status MmapDataFile();
 
@@ -117,6 +119,9 @@ class PlainTableReader: public TableReader {
   Slice file_data_;
 
   PlainTableIndex index_;
+  // A sorted index over the rows for the total order seeks of a table with
+  // a prefix extractor. Empty if not requested.
+  PlainTableIndex total_order_index_;
   bool full_scan_mode_;
 
   // data_start_offset_ and data_end_offset_ defines the range of the
@@ -181,6 +186,11 @@ class PlainTableReader: public TableReader {
   Status PopulateIndexRecordList(PlainTableIndexBuilder* index_builder,
                                  vector<uint32_t>* prefix_hashes);
 
+  // Read the total order index from the file, or build it from all the
+  // rows if it is not there.
+  Status PopulateTotalOrderIndex(size_t index_sparseness,
+                                 size_t huge_page_tlb_size);
+
   // Internal helper function to allocate memory for bloom filter and fill it
   void AllocateAndFillBloom(int bloom_bits_per_key, int num_prefixes,
                             size_t huge_page_tlb_size,
@@ -205,6 +215,13 @@ class PlainTableReader: public TableReader {
   Status GetOffset(const Slice& target, const Slice& prefix,
                    uint32_t prefix_hash, bool& prefix_matched,
                    uint32_t* offset) const;
+  // Get the file offset from which to scan for the first key not less than
+  // target, using the total order index.
+  Status GetTotalOrderOffset(const Slice& target, uint32_t* offset) const;
+
+  bool HasTotalOrderIndex() const {
+    return total_order_index_.GetIndexSize() > 0;
+  }
 
   bool IsTotalOrderMode() const { return (prefix_extractor_ == nullptr); }
 
@@ -9,6 +9,8 @@
 
 #pragma once
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace rocksdb {
 
@@ -34,7 +36,9 @@ class TableReader {
   //        When destroying the iterator, the caller will not call "delete"
   //        but Iterator::~Iterator() directly. The destructor needs to destroy
   //        all the states but those allocated in arena.
-  virtual Iterator* NewIterator(const ReadOptions&, Arena* arena = nullptr) = 0;
+  // for_compaction: the iterator reads the table for a compaction.
+  virtual Iterator* NewIterator(const ReadOptions&, Arena* arena = nullptr,
+                                bool for_compaction = false) = 0;
 
   // Given a key, return an approximate byte offset in the file where
   // the data for that key begins (or would begin if the key were
@@ -44,6 +48,12 @@ class TableReader {
   // be close to the file length.
   virtual uint64_t ApproximateOffsetOf(const Slice& key) = 0;
 
+  // Append up to num_samples internal keys to *keys that split the table
+  // into parts of about equal size, in increasing order. Used to partition
+  // key ranges; the default implementation appends none.
+  virtual void SampleKeys(size_t num_samples,
+                          std::vector<std::string>* keys) {}
+
   // Set up the table for Compaction. Might change some parameters with
   // posix_fadvise
   virtual void SetupForCompaction() = 0;
@@ -68,6 +78,18 @@ class TableReader {
   virtual Status Get(const ReadOptions& readOptions, const Slice& key,
                      GetContext* get_context) = 0;
 
+  // Look up each of the num_keys keys as Get() does, reporting the entries
+  // found for keys[i] to get_contexts[i] and the status of the lookup in
+  // statuses[i]. Tables that can overlap the lookups of a batch override
+  // this; the default implementation calls Get() for each key.
+  virtual void MultiGet(const ReadOptions& readOptions, size_t num_keys,
+                        const Slice* keys, GetContext** get_contexts,
+                        Status* statuses) {
+    for (size_t i = 0; i < num_keys; i++) {
+      statuses[i] = Get(readOptions, keys[i], get_contexts[i]);
+    }
+  }
+
   // Prefetch data corresponding to a give range of keys
   // Typically this functionality is required for table implementations that
   // persists the data on a non volatile storage medium like disk/SSD
@@ -27,6 +27,7 @@
 #include "rocksdb/env.h"
 #include "rocksdb/iterator.h"
 #include "rocksdb/memtablerep.h"
+#include "rocksdb/persistent_cache.h"
 #include "rocksdb/slice_transform.h"
 #include "rocksdb/statistics.h"
 
@@ -142,7 +143,7 @@ class StringSource: public RandomAccessFile {
  public:
   StringSource(const Slice& contents, uint64_t uniq_id, bool mmap)
       : contents_(contents.data(), contents.size()), uniq_id_(uniq_id),
-        mmap_(mmap) {
+        mmap_(mmap), total_reads_(0) {
   }
 
   virtual ~StringSource() { }
@@ -151,6 +152,7 @@ class StringSource: public RandomAccessFile {
 
   virtual Status Read(uint64_t offset, size_t n, Slice* result,
                       char* scratch) const override {
+    total_reads_++;
     if (offset > contents_.size()) {
       return Status::InvalidArgument("invalid Read offset");
     }
@@ -177,10 +179,13 @@ class StringSource: public RandomAccessFile {
     return static_cast<size_t>(rid-id);
   }
 
+  int total_reads() const { return total_reads_; }
+
  private:
   std::string contents_;
   uint64_t uniq_id_;
   bool mmap_;
+  mutable int total_reads_;
 };
 
 typedef std::map<std::string, std::string, STLLessThan> KVMap;
@@ -350,7 +355,7 @@ class TableConstructor: public Constructor {
     unique_ptr<TableBuilder> builder;
     builder.reset(ioptions.table_factory->NewTableBuilder(
         ioptions, internal_comparator, sink_.get(), options.compression,
-        CompressionOptions()));
+        options.compression_opts));
 
     for (const auto kv : kv_map) {
       if (convert_to_internal_key_) {
@@ -372,6 +377,7 @@ class TableConstructor: public Constructor {
     uniq_id_ = cur_uniq_id_++;
     source_.reset(new StringSource(sink_->contents(), uniq_id_,
                                    ioptions.allow_mmap_reads));
+    table_source_ = source_.get();
     return ioptions.table_factory->NewTableReader(
         ioptions, soptions, internal_comparator, std::move(source_),
         sink_->contents().size(), &table_reader_);
@@ -395,6 +401,7 @@ class TableConstructor: public Constructor {
     source_.reset(
         new StringSource(sink_->contents(), uniq_id_,
                          ioptions.allow_mmap_reads));
+    table_source_ = source_.get();
     return ioptions.table_factory->NewTableReader(
         ioptions, soptions, *last_internal_key_, std::move(source_),
         sink_->contents().size(), &table_reader_);
@@ -404,6 +411,12 @@ class TableConstructor: public Constructor {
     return table_reader_.get();
   }
 
+  // The file the current table reader reads from
+  const StringSource* GetTableSource() const { return table_source_; }
+
+  // The contents of the table file written by the last Finish()
+  const std::string& GetFileContents() const { return sink_->contents(); }
+
   virtual bool AnywayDeleteIterator() const override {
     return convert_to_internal_key_;
   }
@@ -414,11 +427,13 @@ class TableConstructor: public Constructor {
     table_reader_.reset();
     sink_.reset();
     source_.reset();
+    table_source_ = nullptr;
   }
 
   uint64_t uniq_id_;
   unique_ptr<StringSink> sink_;
   unique_ptr<StringSource> source_;
+  const StringSource* table_source_ = nullptr;
   unique_ptr<TableReader> table_reader_;
   bool convert_to_internal_key_;
 
@@ -587,6 +602,16 @@ static bool LZ4HCCompressionSupported() {
 #endif
 }
 
+static bool ZSTDCompressionSupported() {
+#ifdef ZSTD
+  std::string out;
+  Slice in = "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa";
+  return ZSTD_Compress(Options().compression_opts, in.data(), in.size(), &out);
+#else
+  return false;
+#endif
+}
+
 enum TestType {
   BLOCK_BASED_TABLE_TEST,
   PLAIN_TABLE_SEMI_FIXED_PREFIX,
@@ -637,6 +662,10 @@ static std::vector<TestArgs> GenerateArgList() {
     compression_types.emplace_back(kLZ4HCCompression, false);
     compression_types.emplace_back(kLZ4HCCompression, true);
   }
+  if (ZSTDCompressionSupported()) {
+    compression_types.emplace_back(kZSTD, false);
+    compression_types.emplace_back(kZSTD, true);
+  }
 
   for (auto test_type : test_types) {
     for (auto reverse_compare : reverse_compare_types) {
@@ -1501,6 +1530,222 @@ TEST(BlockBasedTableTest, IndexSizeStat) {
   }
 }
 
+TEST(BlockBasedTableTest, DeltaEncodedIndex) {
+  Random rnd(301);
+  InternalKeyComparator ikc(BytewiseComparator());
+
+  for (bool split_user_key : {false, true}) {
+    // With split_user_key, the versions of one user key span several data
+    // blocks, so the index has to keep the sequence numbers.
+    std::vector<std::pair<std::string, std::string>> kvs;
+    for (int i = 0; i < 1000; i++) {
+      char key[10];
+      snprintf(key, sizeof(key), "k%06d", i);
+      int versions = (split_user_key && i == 500) ? 50 : 1;
+      for (int v = versions; v > 0; v--) {
+        kvs.emplace_back(InternalKey(key, v, kTypeValue).Encode().ToString(),
+                         RandomString(&rnd, 100));
+      }
+    }
+
+    uint64_t plain_index_size = 0;
+    for (uint32_t format_version : {2, 3}) {
+      for (int index_block_restart_interval : {1, 16}) {
+        Options options;
+        options.compression = kNoCompression;
+        BlockBasedTableOptions table_options;
+        table_options.block_size = 1024;
+        table_options.format_version = format_version;
+        table_options.index_block_restart_interval =
+            index_block_restart_interval;
+        options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+        const ImmutableCFOptions ioptions(options);
+
+        StringSink sink;
+        unique_ptr<TableBuilder> builder(
+            options.table_factory->NewTableBuilder(
+                ioptions, ikc, &sink, options.compression,
+                options.compression_opts));
+        for (const auto& kv : kvs) {
+          builder->Add(kv.first, kv.second);
+        }
+        ASSERT_OK(builder->Finish());
+        unique_ptr<TableReader> reader;
+        ASSERT_OK(options.table_factory->NewTableReader(
+            ioptions, EnvOptions(), ikc,
+            unique_ptr<RandomAccessFile>(
+                new StringSource(sink.contents(), 0, false)),
+            sink.contents().size(), &reader));
+
+        auto props = reader->GetTableProperties();
+        ASSERT_GT(props->num_data_blocks, 100U);
+        bool index_key_is_user_key =
+            props->user_collected_properties.count(
+                BlockBasedTablePropertyNames::kIndexKeyIsUserKey) > 0;
+        ASSERT_EQ(format_version >= 3 && !split_user_key,
+                  index_key_is_user_key);
+        if (format_version == 2 && index_block_restart_interval == 1) {
+          plain_index_size = props->index_size;
+        } else if (format_version == 3 && index_block_restart_interval > 1 &&
+                   !split_user_key) {
+          ASSERT_LT(props->index_size * 2, plain_index_size);
+        }
+
+        unique_ptr<Iterator> iter(reader->NewIterator(ReadOptions()));
+        size_t i = 0;
+        for (iter->SeekToFirst(); iter->Valid(); iter->Next(), i++) {
+          ASSERT_LT(i, kvs.size());
+          ASSERT_EQ(kvs[i].first, iter->key().ToString());
+          ASSERT_EQ(kvs[i].second, iter->value().ToString());
+        }
+        ASSERT_EQ(kvs.size(), i);
+        for (iter->SeekToLast(); iter->Valid(); iter->Prev()) {
+          ASSERT_GT(i, 0U);
+          i--;
+          ASSERT_EQ(kvs[i].first, iter->key().ToString());
+        }
+        ASSERT_EQ(0U, i);
+        ASSERT_OK(iter->status());
+
+        for (i = 0; i < kvs.size(); i += 7) {
+          iter->Seek(kvs[i].first);
+          ASSERT_TRUE(iter->Valid());
+          ASSERT_EQ(kvs[i].first, iter->key().ToString());
+          ASSERT_EQ(kvs[i].second, iter->value().ToString());
+          // A version older than any in the table lands on the next entry
+          ParsedInternalKey ikey;
+          ASSERT_TRUE(ParseInternalKey(kvs[i].first, &ikey));
+          iter->Seek(InternalKey(ikey.user_key, 0, kTypeValue).Encode());
+          size_t next = i + 1;
+          while (next < kvs.size() &&
+                 ExtractUserKey(kvs[next].first) == ikey.user_key) {
+            next++;
+          }
+          if (next == kvs.size()) {
+            ASSERT_TRUE(!iter->Valid());
+          } else {
+            ASSERT_TRUE(iter->Valid());
+            ASSERT_EQ(kvs[next].first, iter->key().ToString());
+          }
+        }
+        ASSERT_OK(iter->status());
+      }
+    }
+  }
+}
+
+TEST(BlockBasedTableTest, LearnedIndex) {
+  Random rnd(301);
+  auto big_endian_key = [](uint64_t n) {
+    std::string key = "key";
+    for (int shift = 56; shift >= 0; shift -= 8) {
+      key.push_back(static_cast<char>(n >> shift));
+    }
+    return key;
+  };
+  // Dense keys of fixed width, whose positions are linear, keys of a skewed
+  // distribution, and decimal keys
+  std::vector<std::vector<std::string>> key_sets(3);
+  uint64_t skewed = 0;
+  for (int i = 0; i < 2000; i++) {
+    key_sets[0].push_back(big_endian_key(10 * i));
+    skewed += 1 + rnd.Skewed(16);
+    key_sets[1].push_back(big_endian_key(skewed));
+    char key[10];
+    snprintf(key, sizeof(key), "k%06d", 3 * i);
+    key_sets[2].push_back(key);
+  }
+
+  for (const auto& user_keys : key_sets) {
+    for (const Comparator* user_comparator :
+         {BytewiseComparator(), ReverseBytewiseComparator()}) {
+      InternalKeyComparator ikc(user_comparator);
+      std::vector<std::string> keys;
+      for (const auto& user_key : user_keys) {
+        keys.push_back(InternalKey(user_key, 1, kTypeValue).Encode().ToString());
+      }
+      std::sort(keys.begin(), keys.end(),
+                [&](const std::string& a, const std::string& b) {
+                  return ikc.Compare(a, b) < 0;
+                });
+      // Seek targets: every key, the user keys right after them, and user
+      // keys before and after all of them
+      std::vector<std::string> targets;
+      for (const auto& user_key : user_keys) {
+        targets.push_back(
+            InternalKey(user_key, 1, kTypeValue).Encode().ToString());
+        targets.push_back(InternalKey(user_key + '\0', kMaxSequenceNumber,
+                                      kValueTypeForSeek).Encode().ToString());
+      }
+      targets.push_back(InternalKey("", kMaxSequenceNumber, kValueTypeForSeek)
+                            .Encode()
+                            .ToString());
+      targets.push_back(InternalKey("zzz", kMaxSequenceNumber,
+                                    kValueTypeForSeek).Encode().ToString());
+
+      for (uint32_t format_version : {2, 3}) {
+        size_t binary_search_usage = 0;
+        for (auto index_type : {BlockBasedTableOptions::kBinarySearch,
+                                BlockBasedTableOptions::kLearnedSearch}) {
+          Options options;
+          options.compression = kNoCompression;
+          options.comparator = user_comparator;
+          BlockBasedTableOptions table_options;
+          table_options.block_size = 64;
+          table_options.format_version = format_version;
+          table_options.index_type = index_type;
+          options.table_factory.reset(
+              NewBlockBasedTableFactory(table_options));
+          const ImmutableCFOptions ioptions(options);
+
+          StringSink sink;
+          unique_ptr<TableBuilder> builder(
+              options.table_factory->NewTableBuilder(
+                  ioptions, ikc, &sink, options.compression,
+                  options.compression_opts));
+          for (const auto& key : keys) {
+            builder->Add(key, RandomString(&rnd, 40));
+          }
+          ASSERT_OK(builder->Finish());
+          unique_ptr<TableReader> reader;
+          ASSERT_OK(options.table_factory->NewTableReader(
+              ioptions, EnvOptions(), ikc,
+              unique_ptr<RandomAccessFile>(
+                  new StringSource(sink.contents(), 0, false)),
+              sink.contents().size(), &reader));
+          ASSERT_GT(reader->GetTableProperties()->num_data_blocks, 1000U);
+
+          // The model is only built for the bytewise comparator
+          if (index_type == BlockBasedTableOptions::kBinarySearch) {
+            binary_search_usage = reader->ApproximateMemoryUsage();
+          } else if (user_comparator == BytewiseComparator()) {
+            ASSERT_GT(reader->ApproximateMemoryUsage(), binary_search_usage);
+          } else {
+            ASSERT_EQ(reader->ApproximateMemoryUsage(), binary_search_usage);
+          }
+
+          unique_ptr<Iterator> iter(reader->NewIterator(ReadOptions()));
+          for (const auto& target : targets) {
+            iter->Seek(target);
+            auto expected = std::lower_bound(
+                keys.begin(), keys.end(), target,
+                [&](const std::string& a, const std::string& b) {
+                  return ikc.Compare(a, b) < 0;
+                });
+            if (expected == keys.end()) {
+              ASSERT_TRUE(!iter->Valid());
+            } else {
+              ASSERT_TRUE(iter->Valid());
+              ASSERT_EQ(*expected, iter->key().ToString());
+            }
+          }
+          ASSERT_OK(iter->status());
+        }
+      }
+    }
+  }
+}
+
 TEST(BlockBasedTableTest, NumBlockStat) {
   Random rnd(test::RandomSeed());
   TableConstructor c(BytewiseComparator());
@@ -1747,12 +1992,12 @@ TEST(BlockBasedTableTest, FilterBlockInBlockCache) {
   ASSERT_OK(c3.Reopen(ioptions4));
   reader = dynamic_cast<BlockBasedTable*>(c3.GetTableReader());
   ASSERT_TRUE(!reader->TEST_filter_block_preloaded());
-  std::string value;
+  PinnableSlice value;
   GetContext get_context(options.comparator, nullptr, nullptr, nullptr,
                          GetContext::kNotFound, user_key, &value,
                          nullptr, nullptr);
   ASSERT_OK(reader->Get(ReadOptions(), user_key, &get_context));
-  ASSERT_EQ(value, "hello");
+  ASSERT_EQ(value.ToString(), "hello");
   BlockCachePropertiesSnapshot props(options.statistics.get());
   props.AssertFilterBlockStat(0, 0);
 }
@@ -1812,6 +2057,286 @@ TEST(BlockBasedTableTest, BlockCacheLeak) {
   }
 }
 
+TEST(BlockBasedTableTest, IteratorReadahead) {
+  // Sequential scans read data blocks in ever larger windows.
+  Options opt;
+  unique_ptr<InternalKeyComparator> ikc;
+  ikc.reset(new test::PlainInternalKeyComparator(opt.comparator));
+  opt.compression = kNoCompression;
+  BlockBasedTableOptions table_options;
+  table_options.block_size = 1024;
+  table_options.no_block_cache = true;
+  opt.table_factory.reset(NewBlockBasedTableFactory(table_options));
+
+  TableConstructor c(BytewiseComparator());
+  Random rnd(301);
+  const int kNumKeys = 2000;
+  for (int i = 0; i < kNumKeys; i++) {
+    char key[10];
+    snprintf(key, sizeof(key), "k%05d", i);
+    c.Add(key, RandomString(&rnd, 200));
+  }
+  std::vector<std::string> keys;
+  KVMap kvmap;
+  const ImmutableCFOptions ioptions(opt);
+  c.Finish(opt, ioptions, table_options, *ikc, &keys, &kvmap);
+
+  int reads_before = c.GetTableSource()->total_reads();
+  unique_ptr<Iterator> iter(c.NewIterator());
+  auto kv = kvmap.begin();
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next(), kv++) {
+    ASSERT_TRUE(kv != kvmap.end());
+    ASSERT_EQ(kv->first, iter->key().ToString());
+    ASSERT_EQ(kv->second, iter->value().ToString());
+  }
+  ASSERT_OK(iter->status());
+  ASSERT_TRUE(kv == kvmap.end());
+  // About 400 data blocks are read with a few dozen file reads
+  int scan_reads = c.GetTableSource()->total_reads() - reads_before;
+  ASSERT_LT(scan_reads, kNumKeys / 40);
+
+  // Seeks reset the readahead and still see the right data
+  for (int i = 0; i < 100; i++) {
+    auto it = kvmap.begin();
+    std::advance(it, rnd.Uniform(kNumKeys));
+    iter->Seek(it->first);
+    for (int j = 0; j < 20 && it != kvmap.end(); j++, it++) {
+      ASSERT_TRUE(iter->Valid());
+      ASSERT_EQ(it->first, iter->key().ToString());
+      ASSERT_EQ(it->second, iter->value().ToString());
+      iter->Next();
+    }
+  }
+  ASSERT_OK(iter->status());
+
+  // Compactions have compaction_readahead_size instead, so their iterators
+  // read one block at a time
+  reads_before = c.GetTableSource()->total_reads();
+  iter.reset(c.GetTableReader()->NewIterator(ReadOptions(), nullptr,
+                                             true /* for_compaction */));
+  int num_keys = 0;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    num_keys++;
+  }
+  ASSERT_OK(iter->status());
+  ASSERT_EQ(kNumKeys, num_keys);
+  ASSERT_GT(c.GetTableSource()->total_reads() - reads_before, kNumKeys / 10);
+
+  // As do all iterators without max_auto_readahead_size
+  iter.reset();
+  table_options.max_auto_readahead_size = 0;
+  opt.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  const ImmutableCFOptions ioptions1(opt);
+  ASSERT_OK(c.Reopen(ioptions1));
+  reads_before = c.GetTableSource()->total_reads();
+  iter.reset(c.NewIterator());
+  num_keys = 0;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    num_keys++;
+  }
+  ASSERT_OK(iter->status());
+  ASSERT_EQ(kNumKeys, num_keys);
+  ASSERT_GT(c.GetTableSource()->total_reads() - reads_before, kNumKeys / 10);
+}
+
+TEST(BlockBasedTableTest, PersistentCache) {
+  // Blocks evicted from the block cache are served from the persistent cache
+  // instead of the table file.
+  std::string path = test::TmpDir() + "/table_test_persistent_cache";
+  Env* env = Env::Default();
+  std::vector<std::string> children;
+  env->GetChildren(path, &children);
+  for (const auto& child : children) {
+    env->DeleteFile(path + "/" + child);
+  }
+
+  Options opt;
+  unique_ptr<InternalKeyComparator> ikc;
+  ikc.reset(new test::PlainInternalKeyComparator(opt.comparator));
+  opt.compression = kNoCompression;
+  opt.statistics = CreateDBStatistics();
+  BlockBasedTableOptions table_options;
+  table_options.block_size = 1024;
+  table_options.block_cache = NewLRUCache(16 * 1024 * 1024);
+  ASSERT_OK(NewPersistentCache(env, path, 16 * 1024 * 1024, nullptr,
+                               &table_options.persistent_cache));
+  opt.table_factory.reset(NewBlockBasedTableFactory(table_options));
+
+  TableConstructor c(BytewiseComparator());
+  Random rnd(301);
+  for (int i = 0; i < 100; i++) {
+    char key[10];
+    snprintf(key, sizeof(key), "k%04d", i);
+    c.Add(key, RandomString(&rnd, 200));
+  }
+  std::vector<std::string> keys;
+  KVMap kvmap;
+  const ImmutableCFOptions ioptions(opt);
+  c.Finish(opt, ioptions, table_options, *ikc, &keys, &kvmap);
+
+  auto ReadAll = [&]() {
+    unique_ptr<Iterator> iter(c.NewIterator());
+    auto kv = kvmap.begin();
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next(), kv++) {
+      ASSERT_TRUE(kv != kvmap.end());
+      ASSERT_EQ(kv->second, iter->value().ToString());
+    }
+    ASSERT_OK(iter->status());
+    ASSERT_TRUE(kv == kvmap.end());
+  };
+  ReadAll();
+  ASSERT_EQ(0U, opt.statistics->getTickerCount(PERSISTENT_CACHE_HIT));
+  uint64_t misses = opt.statistics->getTickerCount(PERSISTENT_CACHE_MISS);
+  ASSERT_GT(misses, 0U);
+
+  // Dropping the block cache admits its blocks to the persistent cache.
+  table_options.block_cache = NewLRUCache(16 * 1024 * 1024);
+  opt.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  const ImmutableCFOptions ioptions1(opt);
+  ASSERT_OK(c.Reopen(ioptions1));
+  ReadAll();
+  ASSERT_EQ(misses, opt.statistics->getTickerCount(PERSISTENT_CACHE_HIT));
+  ASSERT_EQ(misses, opt.statistics->getTickerCount(PERSISTENT_CACHE_MISS));
+
+  // Blocks are now in the new block cache again.
+  auto table_reader = dynamic_cast<BlockBasedTable*>(c.GetTableReader());
+  for (const std::string& key : keys) {
+    ASSERT_TRUE(table_reader->TEST_KeyInCache(ReadOptions(), key));
+  }
+}
+
+TEST(BlockBasedTableTest, CompressionDictionary) {
+  std::vector<CompressionType> compression_types;
+  if (ZlibCompressionSupported()) {
+    compression_types.push_back(kZlibCompression);
+  }
+  if (ZSTDCompressionSupported()) {
+    compression_types.push_back(kZSTD);
+  }
+
+  for (auto compression_type : compression_types) {
+    // The values repeat across the whole table but hardly within a single
+    // block, so only a dictionary lets the blocks share them.
+    Random rnd(301);
+    std::vector<std::string> phrases;
+    for (int i = 0; i < 32; i++) {
+      phrases.push_back(RandomString(&rnd, 100));
+    }
+    KVMap kvmap;
+    uint64_t data_size[2];
+    for (int with_dict = 0; with_dict < 2; with_dict++) {
+      Options opt;
+      opt.compression = compression_type;
+      opt.compression_opts.max_dict_bytes = with_dict ? 8 * 1024 : 0;
+      BlockBasedTableOptions table_options;
+      table_options.block_size = 1024;
+      table_options.filter_policy.reset(NewBloomFilterPolicy(10));
+      table_options.block_cache = NewLRUCache(16 * 1024 * 1024);
+      table_options.block_cache_compressed = NewLRUCache(16 * 1024 * 1024);
+      opt.table_factory.reset(NewBlockBasedTableFactory(table_options));
+
+      TableConstructor c(BytewiseComparator(), true);
+      Random value_rnd(301);
+      for (int i = 0; i < 5000; i++) {
+        char key[10];
+        snprintf(key, sizeof(key), "k%06d", i);
+        c.Add(key, phrases[value_rnd.Uniform(32)] +
+                       phrases[value_rnd.Uniform(32)]);
+      }
+      std::vector<std::string> keys;
+      const ImmutableCFOptions ioptions(opt);
+      test::PlainInternalKeyComparator ikc(opt.comparator);
+      c.Finish(opt, ioptions, table_options, ikc, &keys, &kvmap);
+      data_size[with_dict] =
+          c.GetTableReader()->GetTableProperties()->data_size;
+
+      // Read everything twice, the second time the data blocks come from
+      // the compressed block cache.
+      for (int pass = 0; pass < 2; pass++) {
+        if (pass == 1) {
+          table_options.block_cache = NewLRUCache(16 * 1024 * 1024);
+          opt.table_factory.reset(NewBlockBasedTableFactory(table_options));
+          const ImmutableCFOptions ioptions1(opt);
+          ASSERT_OK(c.Reopen(ioptions1));
+        }
+        unique_ptr<Iterator> iter(c.NewIterator());
+        auto kv = kvmap.begin();
+        for (iter->SeekToFirst(); iter->Valid(); iter->Next(), kv++) {
+          ASSERT_TRUE(kv != kvmap.end());
+          ASSERT_EQ(kv->first, iter->key().ToString());
+          ASSERT_EQ(kv->second, iter->value().ToString());
+        }
+        ASSERT_OK(iter->status());
+        ASSERT_TRUE(kv == kvmap.end());
+      }
+    }
+    ASSERT_LT(data_size[1], data_size[0]);
+  }
+}
+
+TEST(BlockBasedTableTest, ParallelCompression) {
+  std::vector<CompressionType> compression_types;
+  if (ZlibCompressionSupported()) {
+    compression_types.push_back(kZlibCompression);
+  }
+  if (ZSTDCompressionSupported()) {
+    compression_types.push_back(kZSTD);
+  }
+
+  Random rnd(301);
+  std::vector<std::pair<std::string, std::string>> kvs;
+  for (int i = 0; i < 3000; i++) {
+    char key[10];
+    snprintf(key, sizeof(key), "k%06d", i);
+    std::string value;
+    test::CompressibleString(&rnd, 0.5, 300, &value);
+    kvs.emplace_back(key, value);
+  }
+
+  for (auto compression_type : compression_types) {
+    for (uint32_t max_dict_bytes : {0, 4096}) {
+      // The file written with several compression threads must be the same
+      // as the one written by a single thread.
+      std::string expected;
+      for (uint32_t threads : {1, 4}) {
+        Options opt;
+        opt.compression = compression_type;
+        opt.compression_opts.max_dict_bytes = max_dict_bytes;
+        opt.compression_opts.parallel_threads = threads;
+        BlockBasedTableOptions table_options;
+        table_options.block_size = 1024;
+        table_options.filter_policy.reset(NewBloomFilterPolicy(10));
+        opt.table_factory.reset(NewBlockBasedTableFactory(table_options));
+
+        TableConstructor c(BytewiseComparator(), true);
+        for (const auto& kv : kvs) {
+          c.Add(kv.first, kv.second);
+        }
+        std::vector<std::string> keys;
+        KVMap kvmap;
+        const ImmutableCFOptions ioptions(opt);
+        test::PlainInternalKeyComparator ikc(opt.comparator);
+        c.Finish(opt, ioptions, table_options, ikc, &keys, &kvmap);
+        if (threads == 1) {
+          expected = c.GetFileContents();
+          continue;
+        }
+        ASSERT_TRUE(expected == c.GetFileContents());
+
+        unique_ptr<Iterator> iter(c.NewIterator());
+        auto kv = kvmap.begin();
+        for (iter->SeekToFirst(); iter->Valid(); iter->Next(), kv++) {
+          ASSERT_TRUE(kv != kvmap.end());
+          ASSERT_EQ(kv->first, iter->key().ToString());
+          ASSERT_EQ(kv->second, iter->value().ToString());
+        }
+        ASSERT_OK(iter->status());
+        ASSERT_TRUE(kv == kvmap.end());
+      }
+    }
+  }
+}
+
 TEST(PlainTableTest, BasicPlainTableProperties) {
   PlainTableOptions plain_table_options;
   plain_table_options.user_key_len = 8;
@@ -1946,6 +2471,12 @@ TEST(GeneralTableTest, ApproximateOffsetOfCompressed) {
     compression_state.push_back(kLZ4HCCompression);
   }
 
+  if (!ZSTDCompressionSupported()) {
+    fprintf(stderr, "skipping zstd compression tests\n");
+  } else {
+    compression_state.push_back(kZSTD);
+  }
+
   for (auto state : compression_state) {
     DoCompressionTest(state);
   }
@@ -9,6 +9,8 @@
 
 #include "table/two_level_iterator.h"
 
+#include <vector>
+
 #include "rocksdb/options.h"
 #include "rocksdb/table.h"
 #include "table/block.h"
@@ -27,6 +29,9 @@ class TwoLevelIterator: public Iterator {
   virtual ~TwoLevelIterator() {
     first_level_iter_.DeleteIter(false);
     second_level_iter_.DeleteIter(false);
+    for (auto iter : pinned_iters_) {
+      delete iter;
+    }
   }
 
   virtual void Seek(const Slice& target) override;
@@ -44,6 +49,10 @@ class TwoLevelIterator: public Iterator {
     assert(Valid());
     return second_level_iter_.value();
   }
+  virtual bool IsKeyPinned() const override {
+    assert(Valid());
+    return state_->pin_data && second_level_iter_.iter()->IsKeyPinned();
+  }
   virtual Status status() const override {
     // It'd be nice if status() returned a const Status& instead of a Status
     if (!first_level_iter_.status().ok()) {
@@ -60,8 +69,18 @@ class TwoLevelIterator: public Iterator {
   void SaveError(const Status& s) {
     if (status_.ok() && !s.ok()) status_ = s;
   }
-  void SkipEmptyDataBlocksForward();
-  void SkipEmptyDataBlocksBackward();
+  // Blocks that could not be read because of the read tier or the deadline
+  // are not skipped: the entries of the blocks after them would hide that
+  // some keys were not read, and the newer versions of those keys. The
+  // iterator stops there instead, keeping the status.
+  static bool IsUnreadBlock(const Status& s) {
+    return s.IsIncomplete() || s.IsTimedOut();
+  }
+  // check_bound: stop at a first level entry beyond the iterate bounds. Only
+  // used when stepping; after a Seek(), MergingIterator takes an invalid
+  // child to have no keys at or after the target.
+  void SkipEmptyDataBlocksForward(bool check_bound = false);
+  void SkipEmptyDataBlocksBackward(bool check_bound = false);
   void SetSecondLevelIterator(Iterator* iter);
   void InitDataBlock();
 
@@ -72,6 +91,8 @@ class TwoLevelIterator: public Iterator {
   // If second_level_iter is non-nullptr, then "data_block_handle_" holds the
   // "index_value" passed to block_function_ to create the second_level_iter.
   std::string data_block_handle_;
+  // Secondary iterators kept alive with state_->pin_data
+  std::vector<Iterator*> pinned_iters_;
 };
 
 TwoLevelIterator::TwoLevelIterator(TwoLevelIteratorState* state,
@@ -114,22 +135,24 @@ void TwoLevelIterator::SeekToLast() {
 void TwoLevelIterator::Next() {
   assert(Valid());
   second_level_iter_.Next();
-  SkipEmptyDataBlocksForward();
+  SkipEmptyDataBlocksForward(true /* check_bound */);
 }
 
 void TwoLevelIterator::Prev() {
   assert(Valid());
   second_level_iter_.Prev();
-  SkipEmptyDataBlocksBackward();
+  SkipEmptyDataBlocksBackward(true /* check_bound */);
 }
 
 
-void TwoLevelIterator::SkipEmptyDataBlocksForward() {
+void TwoLevelIterator::SkipEmptyDataBlocksForward(bool check_bound) {
   while (second_level_iter_.iter() == nullptr ||
          (!second_level_iter_.Valid() &&
-         !second_level_iter_.status().IsIncomplete())) {
+         !IsUnreadBlock(second_level_iter_.status()))) {
     // Move to next block
-    if (!first_level_iter_.Valid()) {
+    if (!first_level_iter_.Valid() ||
+        (check_bound &&
+         state_->KeyReachesUpperBound(first_level_iter_.key()))) {
       SetSecondLevelIterator(nullptr);
       return;
     }
@@ -141,16 +164,21 @@ void TwoLevelIterator::SkipEmptyDataBlocksForward() {
   }
 }
 
-void TwoLevelIterator::SkipEmptyDataBlocksBackward() {
+void TwoLevelIterator::SkipEmptyDataBlocksBackward(bool check_bound) {
   while (second_level_iter_.iter() == nullptr ||
          (!second_level_iter_.Valid() &&
-         !second_level_iter_.status().IsIncomplete())) {
+         !IsUnreadBlock(second_level_iter_.status()))) {
     // Move to next block
     if (!first_level_iter_.Valid()) {
       SetSecondLevelIterator(nullptr);
       return;
     }
     first_level_iter_.Prev();
+    if (check_bound && first_level_iter_.Valid() &&
+        state_->KeyBelowLowerBound(first_level_iter_.key())) {
+      SetSecondLevelIterator(nullptr);
+      return;
+    }
     InitDataBlock();
     if (second_level_iter_.iter() != nullptr) {
       second_level_iter_.SeekToLast();
@@ -161,6 +189,9 @@ void TwoLevelIterator::SkipEmptyDataBlocksBackward() {
 void TwoLevelIterator::SetSecondLevelIterator(Iterator* iter) {
   if (second_level_iter_.iter() != nullptr) {
     SaveError(second_level_iter_.status());
+    if (state_->pin_data) {
+      pinned_iters_.push_back(second_level_iter_.Release());
+    }
   }
   second_level_iter_.Set(iter);
 }
@@ -171,7 +202,7 @@ void TwoLevelIterator::InitDataBlock() {
   } else {
     Slice handle = first_level_iter_.value();
     if (second_level_iter_.iter() != nullptr &&
-        !second_level_iter_.status().IsIncomplete() &&
+        !IsUnreadBlock(second_level_iter_.status()) &&
         handle.compare(data_block_handle_) == 0) {
       // second_level_iter is already constructed with this iterator, so
       // no need to change anything
@@ -19,15 +19,31 @@ class InternalKeyComparator;
 class Arena;
 
 struct TwoLevelIteratorState {
-  explicit TwoLevelIteratorState(bool _check_prefix_may_match)
-      : check_prefix_may_match(_check_prefix_may_match) {}
+  explicit TwoLevelIteratorState(bool _check_prefix_may_match,
+                                 bool _pin_data = false)
+      : check_prefix_may_match(_check_prefix_may_match),
+        pin_data(_pin_data) {}
 
   virtual ~TwoLevelIteratorState() {}
   virtual Iterator* NewSecondaryIterator(const Slice& handle) = 0;
   virtual bool PrefixMayMatch(const Slice& internal_key) = 0;
 
+  // Return true if all keys of the entries that follow (precede) the first
+  // level entry with key first_level_key are at or past
+  // ReadOptions::iterate_upper_bound (before iterate_lower_bound), so that
+  // Next() (Prev()) can stop there without opening them.
+  virtual bool KeyReachesUpperBound(const Slice& first_level_key) {
+    return false;
+  }
+  virtual bool KeyBelowLowerBound(const Slice& first_level_key) {
+    return false;
+  }
+
   // If call PrefixMayMatch()
   bool check_prefix_may_match;
+  // If keep the secondary iterators, and so the blocks or files they pin,
+  // until the two level iterator is deleted. See ReadOptions::pin_data.
+  bool pin_data;
 };
 
 
@@ -149,6 +149,156 @@ inline void FullFilterBitsBuilder::AddHash(uint32_t h, char* data,
   }
 }
 
+// Format version 1 of the full filter. All probes of a key go to a single
+// 64-byte line, chosen by the upper half of a 64-bit hash. Within the line,
+// probe i sets the bit given by the top 9 bits of
+//   lower + i * delta + i * (i - 1) / 2 * kBlockedBloomSpread
+// where lower is the lower half of the hash and delta the upper half
+// rotated by 16 bits, so that its top bits do not depend on the line. The
+// last term spreads the probes of keys with a small delta. The probes need
+// neither a division nor anything from each other, not even the previous
+// probe's position.
+//
+// The metadata is appended to the lines; the marker byte takes the place
+// of num_probes in version 0, where it is at most 30:
+// +----------------------------------------------------------------+
+// |              filter data with length num_lines * 64            |
+// +----------------------------------------------------------------+
+// | marker (-1) : 1 byte | version (1) : 1 byte |                  |
+// | num_probes : 1 byte  | reserved : 2 bytes   |                  |
+// +----------------------------------------------------------------+
+const uint32_t kBlockedBloomLineBytes = 64;
+const uint32_t kBlockedBloomLineShift = 32 - 9;  // log2(64 * 8) == 9
+const uint32_t kBlockedBloomSpread = 0x2545f491;
+const char kFilterFormatMarker = -1;
+const char kBlockedBloomFormat = 1;
+const uint32_t kFilterMetaSize = 5;
+
+inline uint32_t BlockedBloomLine(uint64_t hash, uint32_t num_lines) {
+  // Maps the upper half of the hash to [0, num_lines) without a division
+  return static_cast<uint32_t>(((hash >> 32) * num_lines) >> 32);
+}
+
+inline uint32_t BlockedBloomDelta(uint64_t hash) {
+  const uint32_t upper = static_cast<uint32_t>(hash >> 32);
+  return (upper << 16) | (upper >> 16);
+}
+
+// Position of probe i within the line
+inline uint32_t BlockedBloomBit(uint32_t lower, uint32_t delta, uint32_t i) {
+  return (lower + i * delta + i * (i - 1) / 2 * kBlockedBloomSpread) >>
+         kBlockedBloomLineShift;
+}
+
+class BlockedBloomBitsBuilder : public FilterBitsBuilder {
+ public:
+  explicit BlockedBloomBitsBuilder(const size_t bits_per_key,
+                                   const size_t num_probes)
+      : bits_per_key_(bits_per_key),
+        num_probes_(num_probes) {
+    assert(bits_per_key_);
+  }
+
+  virtual void AddKey(const Slice& key) override {
+    uint64_t hash = BloomHash64(key);
+    if (hash_entries_.size() == 0 || hash != hash_entries_.back()) {
+      hash_entries_.push_back(hash);
+    }
+  }
+
+  virtual Slice Finish(std::unique_ptr<const char[]>* buf) override {
+    const uint64_t total_bits =
+        static_cast<uint64_t>(hash_entries_.size()) * bits_per_key_;
+    const uint32_t line_bits = kBlockedBloomLineBytes * 8;
+    const uint32_t num_lines =
+        static_cast<uint32_t>((total_bits + line_bits - 1) / line_bits);
+    const uint32_t len = num_lines * kBlockedBloomLineBytes;
+
+    char* data = new char[len + kFilterMetaSize];
+    memset(data, 0, len + kFilterMetaSize);
+    if (num_lines != 0) {
+      for (auto h : hash_entries_) {
+        AddHash(h, data, num_lines);
+      }
+    }
+    data[len] = kFilterFormatMarker;
+    data[len + 1] = kBlockedBloomFormat;
+    data[len + 2] = static_cast<char>(num_probes_);
+
+    buf->reset(data);
+    hash_entries_.clear();
+    return Slice(data, len + kFilterMetaSize);
+  }
+
+ private:
+  size_t bits_per_key_;
+  size_t num_probes_;
+  std::vector<uint64_t> hash_entries_;
+
+  void AddHash(uint64_t h, char* data, uint32_t num_lines) {
+    char* line = data + BlockedBloomLine(h, num_lines) * kBlockedBloomLineBytes;
+    const uint32_t lower = static_cast<uint32_t>(h);
+    const uint32_t delta = BlockedBloomDelta(h);
+    for (uint32_t i = 0; i < num_probes_; ++i) {
+      const uint32_t bitpos = BlockedBloomBit(lower, delta, i);
+      line[bitpos / 8] |= static_cast<char>(1 << (bitpos % 8));
+    }
+  }
+
+  // No Copy allowed
+  BlockedBloomBitsBuilder(const BlockedBloomBitsBuilder&);
+  void operator=(const BlockedBloomBitsBuilder&);
+};
+
+class BlockedBloomBitsReader : public FilterBitsReader {
+ public:
+  // REQUIRES: contents ends with metadata that starts with the marker
+  explicit BlockedBloomBitsReader(const Slice& contents)
+      : data_(contents.data()),
+        num_lines_(0),
+        num_probes_(0) {
+    assert(contents.size() >= kFilterMetaSize);
+    const size_t len = contents.size() - kFilterMetaSize;
+    // num_probes_ stays 0 for a broken filter or a format version from the
+    // future, which then matches everything
+    if (contents.data()[len + 1] == kBlockedBloomFormat &&
+        len % kBlockedBloomLineBytes == 0) {
+      num_lines_ = static_cast<uint32_t>(len / kBlockedBloomLineBytes);
+      num_probes_ = static_cast<unsigned char>(contents.data()[len + 2]);
+    }
+  }
+
+  virtual bool MayMatch(const Slice& entry) override {
+    if (num_probes_ == 0) {
+      return true;   // broken filter
+    }
+    if (num_lines_ == 0) {
+      return false;  // empty filter
+    }
+    const uint64_t h = BloomHash64(entry);
+    const char* line =
+        data_ + BlockedBloomLine(h, num_lines_) * kBlockedBloomLineBytes;
+    const uint32_t lower = static_cast<uint32_t>(h);
+    const uint32_t delta = BlockedBloomDelta(h);
+    for (uint32_t i = 0; i < num_probes_; ++i) {
+      const uint32_t bitpos = BlockedBloomBit(lower, delta, i);
+      if ((line[bitpos / 8] & (1 << (bitpos % 8))) == 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+ private:
+  const char* data_;
+  uint32_t num_lines_;
+  uint32_t num_probes_;
+
+  // No Copy allowed
+  BlockedBloomBitsReader(const BlockedBloomBitsReader&);
+  void operator=(const BlockedBloomBitsReader&);
+};
+
 class FullFilterBitsReader : public FilterBitsReader {
  public:
   explicit FullFilterBitsReader(const Slice& contents)
@@ -257,9 +407,11 @@ bool FullFilterBitsReader::HashMayMatch(const uint32_t& hash,
 // An implementation of filter policy
 class BloomFilterPolicy : public FilterPolicy {
  public:
-  explicit BloomFilterPolicy(int bits_per_key, bool use_block_based_builder)
+  explicit BloomFilterPolicy(int bits_per_key, bool use_block_based_builder,
+                             int full_filter_format_version)
       : bits_per_key_(bits_per_key), hash_func_(BloomHash),
-        use_block_based_builder_(use_block_based_builder) {
+        use_block_based_builder_(use_block_based_builder),
+        full_filter_format_version_(full_filter_format_version) {
     initialize();
   }
 
@@ -331,11 +483,21 @@ class BloomFilterPolicy : public FilterPolicy {
       return nullptr;
     }
 
+    if (full_filter_format_version_ >= 1) {
+      return new BlockedBloomBitsBuilder(bits_per_key_, num_probes_);
+    }
     return new FullFilterBitsBuilder(bits_per_key_, num_probes_);
   }
 
+  // Reads filters of all format versions, independent of the version
+  // this policy builds.
   virtual FilterBitsReader* GetFilterBitsReader(const Slice& contents)
       const override {
+    if (contents.size() >= kFilterMetaSize &&
+        contents.data()[contents.size() - kFilterMetaSize] ==
+            kFilterFormatMarker) {
+      return new BlockedBloomBitsReader(contents);
+    }
     return new FullFilterBitsReader(contents);
   }
 
@@ -348,6 +510,7 @@ class BloomFilterPolicy : public FilterPolicy {
   uint32_t (*hash_func_)(const Slice& key);
 
   const bool use_block_based_builder_;
+  const int full_filter_format_version_;
 
   void initialize() {
     // We intentionally round down to reduce probing cost a little bit
@@ -360,8 +523,10 @@ class BloomFilterPolicy : public FilterPolicy {
 }  // namespace
 
 const FilterPolicy* NewBloomFilterPolicy(int bits_per_key,
-                                         bool use_block_based_builder) {
-  return new BloomFilterPolicy(bits_per_key, use_block_based_builder);
+                                         bool use_block_based_builder,
+                                         int full_filter_format_version) {
+  return new BloomFilterPolicy(bits_per_key, use_block_based_builder,
+                               full_filter_format_version);
 }
 
 }  // namespace rocksdb
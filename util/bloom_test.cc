@@ -175,7 +175,7 @@ TEST(BloomTest, VaryingLengths) {
 // Different bits-per-byte
 
 class FullBloomTest {
- private:
+ protected:
   const FilterPolicy* policy_;
   std::unique_ptr<FilterBitsBuilder> bits_builder_;
   std::unique_ptr<FilterBitsReader> bits_reader_;
@@ -289,6 +289,111 @@ TEST(FullBloomTest, FullVaryingLengths) {
   ASSERT_LE(mediocre_filters, good_filters/5);
 }
 
+// Full filters with all probes of a key in one cache line (format version 1)
+class BlockedBloomTest : public FullBloomTest {
+ public:
+  BlockedBloomTest() {
+    delete policy_;
+    policy_ = NewBloomFilterPolicy(FLAGS_bits_per_key, false, 1);
+    Reset();
+  }
+};
+
+TEST(BlockedBloomTest, BlockedEmptyFilter) {
+  ASSERT_TRUE(!Matches("hello"));
+  ASSERT_TRUE(!Matches("world"));
+}
+
+TEST(BlockedBloomTest, BlockedSmall) {
+  Add("hello");
+  Add("world");
+  ASSERT_TRUE(Matches("hello"));
+  ASSERT_TRUE(Matches("world"));
+  ASSERT_TRUE(!Matches("x"));
+  ASSERT_TRUE(!Matches("foo"));
+  // One cache line plus the metadata
+  ASSERT_EQ(64U + 5U, FilterSize());
+}
+
+TEST(BlockedBloomTest, BlockedVaryingLengths) {
+  char buffer[sizeof(int)];
+
+  int mediocre_filters = 0;
+  int good_filters = 0;
+
+  for (int length = 1; length <= 10000; length = NextLength(length)) {
+    Reset();
+    for (int i = 0; i < length; i++) {
+      Add(Key(i, buffer));
+    }
+    Build();
+
+    ASSERT_LE(FilterSize(), (size_t)((length * 10 / 8) + 64 + 5)) << length;
+
+    for (int i = 0; i < length; i++) {
+      ASSERT_TRUE(Matches(Key(i, buffer)))
+          << "Length " << length << "; key " << i;
+    }
+
+    double rate = FalsePositiveRate();
+    if (kVerbose >= 1) {
+      fprintf(stderr, "False positives: %5.2f%% @ length = %6d ; bytes = %6d\n",
+              rate*100.0, length, static_cast<int>(FilterSize()));
+    }
+    // Must not be over 2%
+    ASSERT_LE(rate, 0.02);
+    if (rate > 0.0125)
+      mediocre_filters++;
+    else
+      good_filters++;
+  }
+  if (kVerbose >= 1) {
+    fprintf(stderr, "Filters: %d good, %d mediocre\n",
+            good_filters, mediocre_filters);
+  }
+  ASSERT_LE(mediocre_filters, good_filters/5);
+}
+
+TEST(BlockedBloomTest, ReadAllFormats) {
+  char buffer[sizeof(int)];
+  for (int version = 0; version <= 1; version++) {
+    std::unique_ptr<const FilterPolicy> writer(
+        NewBloomFilterPolicy(FLAGS_bits_per_key, false, version));
+    std::unique_ptr<FilterBitsBuilder> builder(
+        writer->GetFilterBitsBuilder());
+    for (int i = 0; i < 1000; i++) {
+      builder->AddKey(Key(i, buffer));
+    }
+    std::unique_ptr<const char[]> buf;
+    Slice filter = builder->Finish(&buf);
+
+    // Policies of either version read filters of both versions
+    for (int reader_version = 0; reader_version <= 1; reader_version++) {
+      std::unique_ptr<const FilterPolicy> reader_policy(
+          NewBloomFilterPolicy(FLAGS_bits_per_key, false, reader_version));
+      std::unique_ptr<FilterBitsReader> reader(
+          reader_policy->GetFilterBitsReader(filter));
+      int false_positives = 0;
+      for (int i = 0; i < 1000; i++) {
+        ASSERT_TRUE(reader->MayMatch(Key(i, buffer)));
+        if (reader->MayMatch(Key(i + 1000000000, buffer))) {
+          false_positives++;
+        }
+      }
+      ASSERT_LE(false_positives, 20);
+    }
+  }
+
+  // Unknown future versions match everything
+  std::string future(64, '\0');
+  future.push_back(static_cast<char>(-1));
+  future.push_back(static_cast<char>(2));
+  future.append(3, '\0');
+  std::unique_ptr<FilterBitsReader> reader(
+      policy_->GetFilterBitsReader(future));
+  ASSERT_TRUE(reader->MayMatch("hello"));
+}
+
 }  // namespace rocksdb
 
 int main(int argc, char** argv) {
@@ -34,6 +34,10 @@ DEFINE_int32(threads, 16, "Number of concurrent threads to run.");
 DEFINE_int64(cache_size, 8 * KB * KB,
              "Number of bytes to use as a cache of uncompressed data.");
 DEFINE_int32(num_shard_bits, 4, "shard_bits.");
+DEFINE_bool(use_clock_cache, false,
+            "Use the lock-free CLOCK cache instead of the LRU cache.");
+DEFINE_int32(charge, 1, "Charge of every entry inserted into the cache. "
+             "Also used to size the hash tables of the CLOCK cache.");
 
 DEFINE_int64(max_key, 1 * KB * KB * KB, "Max number of key to place in cache");
 DEFINE_uint64(ops_per_thread, 1200000, "Number of operations per thread.");
@@ -130,7 +134,10 @@ struct ThreadState {
 class CacheBench {
  public:
   CacheBench() :
-      cache_(NewLRUCache(FLAGS_cache_size, FLAGS_num_shard_bits)),
+      cache_(FLAGS_use_clock_cache
+                 ? NewClockCache(FLAGS_cache_size, FLAGS_num_shard_bits,
+                                 FLAGS_charge)
+                 : NewLRUCache(FLAGS_cache_size, FLAGS_num_shard_bits)),
       num_threads_(FLAGS_threads) {}
 
   ~CacheBench() {}
@@ -142,7 +149,7 @@ class CacheBench {
       // Cast uint64* to be char*, data would be copied to cache
       Slice key(reinterpret_cast<char*>(&rand_key), 8);
       // do insert
-      auto handle = cache_->Insert(key, new char[10], 1, &deleter);
+      auto handle = cache_->Insert(key, new char[10], FLAGS_charge, &deleter);
       cache_->Release(handle);
     }
   }
@@ -219,19 +226,19 @@ class CacheBench {
       // Cast uint64* to be char*, data would be copied to cache
       Slice key(reinterpret_cast<char*>(&rand_key), 8);
       int32_t prob_op = thread->rnd.Uniform(100);
-      if (prob_op >= 0 && prob_op < FLAGS_insert_percent) {
+      if (prob_op < FLAGS_insert_percent) {
         // do insert
-        auto handle = cache_->Insert(key, new char[10], 1, &deleter);
+        auto handle = cache_->Insert(key, new char[10], FLAGS_charge,
+                                     &deleter);
         cache_->Release(handle);
-      } else if (prob_op -= FLAGS_insert_percent &&
-                 prob_op < FLAGS_lookup_percent) {
+      } else if (prob_op < FLAGS_insert_percent + FLAGS_lookup_percent) {
         // do lookup
         auto handle = cache_->Lookup(key);
         if (handle) {
           cache_->Release(handle);
         }
-      } else if (prob_op -= FLAGS_lookup_percent &&
-                 prob_op < FLAGS_erase_percent) {
+      } else if (prob_op < FLAGS_insert_percent + FLAGS_lookup_percent +
+                               FLAGS_erase_percent) {
         // do erase
         cache_->Erase(key);
       }
@@ -244,6 +251,9 @@ class CacheBench {
     printf("Ops per thread      : %" PRIu64 "\n", FLAGS_ops_per_thread);
     printf("Cache size          : %" PRIu64 "\n", FLAGS_cache_size);
     printf("Num shard bits      : %d\n", FLAGS_num_shard_bits);
+    printf("Cache type          : %s\n",
+           FLAGS_use_clock_cache ? "clock" : "lru");
+    printf("Entry charge        : %d\n", FLAGS_charge);
     printf("Max key             : %" PRIu64 "\n", FLAGS_max_key);
     printf("Populate cache      : %d\n", FLAGS_populate_cache);
     printf("Insert percentage   : %d%%\n", FLAGS_insert_percent);
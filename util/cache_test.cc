@@ -12,6 +12,8 @@
 #include <vector>
 #include <string>
 #include <iostream>
+#include <atomic>
+#include "rocksdb/env.h"
 #include "util/coding.h"
 #include "util/testharness.h"
 
@@ -396,6 +398,130 @@ TEST(CacheTest, OverCapacity) {
   }
 }
 
+TEST(CacheTest, ClockHitAndMiss) {
+  auto cache = NewClockCache(kCacheSize, kNumShardBits, 1);
+  ASSERT_EQ(-1, Lookup(cache, 100));
+
+  Insert(cache, 100, 101);
+  ASSERT_EQ(101, Lookup(cache, 100));
+  ASSERT_EQ(-1, Lookup(cache, 200));
+
+  Insert(cache, 200, 201);
+  Insert(cache, 100, 102);
+  ASSERT_EQ(102, Lookup(cache, 100));
+  ASSERT_EQ(201, Lookup(cache, 200));
+  ASSERT_EQ(2U, cache->GetUsage());
+
+  ASSERT_EQ(1U, deleted_keys_.size());
+  ASSERT_EQ(100, deleted_keys_[0]);
+  ASSERT_EQ(101, deleted_values_[0]);
+
+  Erase(cache, 100);
+  ASSERT_EQ(-1, Lookup(cache, 100));
+  ASSERT_EQ(201, Lookup(cache, 200));
+  ASSERT_EQ(2U, deleted_keys_.size());
+  ASSERT_EQ(1U, cache->GetUsage());
+}
+
+TEST(CacheTest, ClockEntriesArePinned) {
+  auto cache = NewClockCache(kCacheSize, kNumShardBits, 1);
+  Insert(cache, 100, 101);
+  Cache::Handle* h1 = cache->Lookup(EncodeKey(100));
+  ASSERT_EQ(101, DecodeValue(cache->Value(h1)));
+
+  Insert(cache, 100, 102);
+  Cache::Handle* h2 = cache->Lookup(EncodeKey(100));
+  ASSERT_EQ(102, DecodeValue(cache->Value(h2)));
+  ASSERT_EQ(0U, deleted_keys_.size());
+  ASSERT_EQ(2U, cache->GetUsage());
+
+  cache->Release(h1);
+  ASSERT_EQ(1U, deleted_keys_.size());
+  ASSERT_EQ(101, deleted_values_[0]);
+  ASSERT_EQ(1U, cache->GetUsage());
+
+  Erase(cache, 100);
+  ASSERT_EQ(-1, Lookup(cache, 100));
+  ASSERT_EQ(1U, deleted_keys_.size());
+
+  cache->Release(h2);
+  ASSERT_EQ(2U, deleted_keys_.size());
+  ASSERT_EQ(102, deleted_values_[1]);
+  ASSERT_EQ(0U, cache->GetUsage());
+}
+
+TEST(CacheTest, ClockEvictionPolicy) {
+  auto cache = NewClockCache(kCacheSize2, 0, 1);
+  Cache::Handle* pinned = cache->Insert(EncodeKey(50), EncodeValue(51), 1,
+                                        &CacheTest::Deleter);
+  Insert(cache, 100, 101);
+
+  // Frequently used entry must be kept around, pinned entry is never evicted
+  for (int i = 0; i < kCacheSize2 * 10; i++) {
+    Insert(cache, 1000 + i, 2000 + i);
+    ASSERT_EQ(101, Lookup(cache, 100));
+  }
+  ASSERT_EQ(101, Lookup(cache, 100));
+  ASSERT_EQ(51, Lookup(cache, 50));
+  ASSERT_LE(cache->GetUsage(), static_cast<size_t>(kCacheSize2));
+  cache->Release(pinned);
+}
+
+TEST(CacheTest, ClockOverCapacity) {
+  // A single shard with a table of 16 slots, all of them pinned
+  auto cache = NewClockCache(10, 0, 1);
+  std::vector<Cache::Handle*> handles;
+  for (int i = 0; i < 32; i++) {
+    handles.push_back(cache->Insert(EncodeKey(i), EncodeValue(i), 1,
+                                    &CacheTest::Deleter));
+    ASSERT_EQ(i, DecodeValue(cache->Value(handles.back())));
+  }
+  ASSERT_EQ(32U, cache->GetUsage());
+  ASSERT_EQ(0U, deleted_keys_.size());
+  for (auto h : handles) {
+    cache->Release(h);
+  }
+  // Entries that did not fit into the table are freed on release
+  ASSERT_GT(deleted_keys_.size(), 0U);
+  Insert(cache, 100, 101);
+  ASSERT_LE(cache->GetUsage(), 10U);
+  ASSERT_EQ(101, Lookup(cache, 100));
+}
+
+TEST(CacheTest, ClockConcurrentLookups) {
+  auto cache = NewClockCache(kCacheSize, kNumShardBits, 1);
+  struct Arg {
+    std::shared_ptr<Cache> cache;
+    std::atomic<int> done;
+  } arg;
+  arg.cache = cache;
+  arg.done = 0;
+  const int kThreads = 4;
+  for (int t = 0; t < kThreads; t++) {
+    Env::Default()->StartThread([](void* v) {
+      Arg* a = reinterpret_cast<Arg*>(v);
+      for (int i = 0; i < 20000; i++) {
+        std::string key = EncodeKey(i % 2000);
+        Cache::Handle* h = a->cache->Lookup(key);
+        if (h == nullptr) {
+          h = a->cache->Insert(key, EncodeValue(i % 2000), 1, &dumbDeleter);
+        }
+        ASSERT_EQ(i % 2000, DecodeValue(a->cache->Value(h)));
+        a->cache->Release(h);
+        if (i % 7 == 0) {
+          a->cache->Erase(key);
+        }
+      }
+      a->done++;
+    }, &arg);
+  }
+  Env::Default()->WaitForJoin();
+  ASSERT_EQ(kThreads, arg.done.load());
+  // Capacity is rounded up to a multiple of the number of shards
+  ASSERT_LE(cache->GetUsage(),
+            static_cast<size_t>(kCacheSize + (1 << kNumShardBits)));
+}
+
 namespace {
 std::vector<std::pair<int, int>> callback_state;
 void callback(void* entry, size_t charge) {
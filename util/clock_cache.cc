@@ -0,0 +1,481 @@
+//  Copyright (c) 2013, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+
+#include "rocksdb/cache.h"
+#include "port/port.h"
+#include "util/autovector.h"
+#include "util/hash.h"
+#include "util/mutexlock.h"
+
+namespace rocksdb {
+
+namespace {
+
+// CLOCK cache implementation
+//
+// Each shard keeps its entries directly in a fixed-size open-addressing
+// table. A slot is described by a single atomic word ("meta") holding
+// the reference count of the entry, a flag telling whether the entry is
+// visible to lookups and the CLOCK usage bit. Lookup() and Release()
+// only ever touch that word with atomic operations, so cache hits never
+// take a lock. Insert(), Erase() and eviction are serialized by a
+// per-shard mutex.
+//
+// A slot goes through these states:
+// 1. Empty (meta == 0). The slot was never used; probing stops here.
+// 2. In cache (kInCache set). Lookups can take references to the entry.
+// 3. Zombie (kInCache cleared, refs > 0). The entry was erased, evicted
+// or replaced, but there are outstanding handles to it.
+// 4. Tombstone (meta == kTombstone). The entry was freed and the slot
+// can be reused by Insert(); probing continues past it.
+//
+// Whoever drops the last reference of an entry that is not in the cache
+// claims the slot by moving meta to a single reference (which nobody
+// else can acquire), copies the entry out, marks the slot as a tombstone
+// and frees the entry outside of the mutex.
+//
+// Since slots are reused, Lookup() verifies the key only after it has
+// pinned a slot; a pinned slot can never be recycled underneath it.
+
+const uint32_t kInCache = 1 << 0;    // entry is visible to Lookup()
+const uint32_t kUsage = 1 << 1;      // CLOCK reference bit
+const uint32_t kTombstone = 1 << 2;  // slot is free but was used before
+const uint32_t kDetached = 1 << 3;   // handle lives outside of the table
+const int kRefShift = 8;
+const uint32_t kOneRef = 1 << kRefShift;
+
+inline uint32_t Refs(uint32_t meta) { return meta >> kRefShift; }
+
+// Target ratio of occupied slots to table size.
+const double kLoadFactor = 0.7;
+// Occupancy above which Insert() evicts, regardless of charge.
+const double kStrictLoadFactor = 0.84;
+
+struct ClockEntry {
+  void* value;
+  void (*deleter)(const Slice&, void* value);
+  char* key_data;
+  size_t key_length;
+  size_t charge;
+
+  Slice key() const { return Slice(key_data, key_length); }
+
+  void Free() {
+    (*deleter)(key(), value);
+    delete[] key_data;
+  }
+};
+
+struct ClockHandle {
+  std::atomic<uint32_t> meta;
+  std::atomic<uint32_t> hash;
+  ClockEntry entry;
+
+  ClockHandle() : meta(0), hash(0) {}
+};
+
+// A single shard of sharded cache.
+class ClockCache {
+ public:
+  ClockCache();
+  ~ClockCache();
+
+  // Separate from constructor so caller can easily make an array of
+  // ClockCache
+  void Init(size_t capacity, size_t estimated_entry_charge);
+
+  // Like Cache methods, but with an extra "hash" parameter.
+  Cache::Handle* Insert(const Slice& key, uint32_t hash,
+                        void* value, size_t charge,
+                        void (*deleter)(const Slice& key, void* value));
+  Cache::Handle* Lookup(const Slice& key, uint32_t hash);
+  void Release(Cache::Handle* handle);
+  void Erase(const Slice& key, uint32_t hash);
+
+  size_t GetUsage() const { return usage_.load(std::memory_order_relaxed); }
+
+  void ApplyToAllCacheEntries(void (*callback)(void*, size_t),
+                              bool thread_safe);
+
+ private:
+  // Drop one reference to "h". Return true if that was the last reference
+  // to an entry that is no longer in the cache; the caller then owns the
+  // slot and has to recycle it.
+  bool Unref(ClockHandle* h);
+  // Copy the entry out of a slot owned by the caller and make the slot
+  // available for reuse.
+  ClockEntry Recycle(ClockHandle* h);
+  // Advance the clock hand by one slot, evicting the entry under it if it
+  // is unpinned and was not used since the hand last passed by.
+  // REQUIRES: mutex_ held
+  bool EvictOne(autovector<ClockEntry>* evicted);
+  // REQUIRES: mutex_ held
+  void EraseLocked(const Slice& key, uint32_t hash,
+                   autovector<ClockEntry>* evicted);
+
+  // Initialized before use.
+  size_t capacity_;
+  uint32_t length_;
+  uint32_t max_occupancy_;
+  ClockHandle* table_;
+
+  std::atomic<size_t> usage_;
+  std::atomic<uint32_t> occupancy_;
+  // Longest distance of an entry from its home slot, bounds Lookup()
+  // probing when the table is full of tombstones.
+  std::atomic<uint32_t> max_probe_;
+
+  // mutex_ serializes writers (Insert, Erase and eviction).
+  port::Mutex mutex_;
+  uint32_t clock_hand_;
+};
+
+ClockCache::ClockCache()
+    : capacity_(0),
+      length_(0),
+      max_occupancy_(0),
+      table_(nullptr),
+      usage_(0),
+      occupancy_(0),
+      max_probe_(0),
+      clock_hand_(0) {}
+
+ClockCache::~ClockCache() {
+  for (uint32_t i = 0; i < length_; i++) {
+    uint32_t meta = table_[i].meta.load(std::memory_order_relaxed);
+    if (meta & kInCache) {
+      assert(Refs(meta) == 0);
+      table_[i].entry.Free();
+    }
+  }
+  delete[] table_;
+}
+
+void ClockCache::Init(size_t capacity, size_t estimated_entry_charge) {
+  assert(table_ == nullptr);
+  capacity_ = capacity;
+  size_t entries = capacity / std::max<size_t>(estimated_entry_charge, 1);
+  uint32_t length = 16;
+  while (length < (1U << 30) && length * kLoadFactor < entries) {
+    length *= 2;
+  }
+  length_ = length;
+  max_occupancy_ = static_cast<uint32_t>(length * kStrictLoadFactor);
+  table_ = new ClockHandle[length_];
+}
+
+bool ClockCache::Unref(ClockHandle* h) {
+  uint32_t meta = h->meta.fetch_sub(kOneRef, std::memory_order_acq_rel);
+  assert(Refs(meta) > 0);
+  meta -= kOneRef;
+  return Refs(meta) == 0 && (meta & kInCache) == 0 &&
+         h->meta.compare_exchange_strong(meta, kOneRef | (meta & kDetached),
+                                         std::memory_order_acq_rel);
+}
+
+ClockEntry ClockCache::Recycle(ClockHandle* h) {
+  ClockEntry e = h->entry;
+  usage_.fetch_sub(e.charge, std::memory_order_relaxed);
+  if (h->meta.load(std::memory_order_relaxed) & kDetached) {
+    delete h;
+  } else {
+    occupancy_.fetch_sub(1, std::memory_order_relaxed);
+    h->meta.store(kTombstone, std::memory_order_release);
+  }
+  return e;
+}
+
+void ClockCache::ApplyToAllCacheEntries(void (*callback)(void*, size_t),
+                                        bool thread_safe) {
+  if (thread_safe) {
+    mutex_.Lock();
+  }
+  for (uint32_t i = 0; i < length_; i++) {
+    if (table_[i].meta.load(std::memory_order_acquire) & kInCache) {
+      callback(table_[i].entry.value, table_[i].entry.charge);
+    }
+  }
+  if (thread_safe) {
+    mutex_.Unlock();
+  }
+}
+
+Cache::Handle* ClockCache::Lookup(const Slice& key, uint32_t hash) {
+  const uint32_t max_probe = max_probe_.load(std::memory_order_acquire);
+  uint32_t idx = hash & (length_ - 1);
+  for (uint32_t probe = 0; probe <= max_probe; probe++) {
+    ClockHandle* h = &table_[idx];
+    idx = (idx + 1) & (length_ - 1);
+    uint32_t meta = h->meta.load(std::memory_order_acquire);
+    if (meta == 0) {
+      // Never used, so no entry was ever placed past it.
+      break;
+    }
+    if ((meta & kInCache) == 0 ||
+        h->hash.load(std::memory_order_relaxed) != hash) {
+      continue;
+    }
+    // Pin the slot before looking at its key.
+    while ((meta & kInCache) != 0 &&
+           !h->meta.compare_exchange_weak(meta, (meta + kOneRef) | kUsage,
+                                          std::memory_order_acquire)) {
+    }
+    if ((meta & kInCache) == 0) {
+      continue;
+    }
+    if (h->entry.key() == key) {
+      return reinterpret_cast<Cache::Handle*>(h);
+    }
+    // The slot was reused for another key since we read its hash.
+    Release(reinterpret_cast<Cache::Handle*>(h));
+  }
+  return nullptr;
+}
+
+void ClockCache::Release(Cache::Handle* handle) {
+  ClockHandle* h = reinterpret_cast<ClockHandle*>(handle);
+  if (Unref(h)) {
+    // Entries erased while pinned are freed by their last user. Unlike the
+    // LRU cache we do not evict on Release() when over capacity since that
+    // would require the mutex; the next Insert() catches up.
+    Recycle(h).Free();
+  }
+}
+
+bool ClockCache::EvictOne(autovector<ClockEntry>* evicted) {
+  ClockHandle* h = &table_[clock_hand_];
+  clock_hand_ = (clock_hand_ + 1) & (length_ - 1);
+  uint32_t meta = h->meta.load(std::memory_order_relaxed);
+  while ((meta & kInCache) != 0 && Refs(meta) == 0) {
+    if (meta & kUsage) {
+      // Second chance
+      if (h->meta.compare_exchange_weak(meta, meta & ~kUsage,
+                                        std::memory_order_relaxed)) {
+        return false;
+      }
+    } else if (h->meta.compare_exchange_weak(meta, kOneRef,
+                                             std::memory_order_acquire)) {
+      evicted->push_back(Recycle(h));
+      return true;
+    }
+  }
+  return false;
+}
+
+void ClockCache::EraseLocked(const Slice& key, uint32_t hash,
+                             autovector<ClockEntry>* evicted) {
+  const uint32_t max_probe = max_probe_.load(std::memory_order_relaxed);
+  uint32_t idx = hash & (length_ - 1);
+  for (uint32_t probe = 0; probe <= max_probe; probe++) {
+    ClockHandle* h = &table_[idx];
+    idx = (idx + 1) & (length_ - 1);
+    uint32_t meta = h->meta.load(std::memory_order_relaxed);
+    if (meta == 0) {
+      break;
+    }
+    // Only writers clear kInCache, so the key of an entry in cache is
+    // stable while we hold the mutex.
+    if ((meta & kInCache) == 0 ||
+        h->hash.load(std::memory_order_relaxed) != hash ||
+        h->entry.key() != key) {
+      continue;
+    }
+    uint32_t new_meta;
+    do {
+      new_meta = Refs(meta) == 0 ? kOneRef : meta & ~(kInCache | kUsage);
+    } while (!h->meta.compare_exchange_weak(meta, new_meta,
+                                            std::memory_order_acq_rel));
+    if (Refs(meta) == 0) {
+      evicted->push_back(Recycle(h));
+    }
+    return;
+  }
+}
+
+Cache::Handle* ClockCache::Insert(
+    const Slice& key, uint32_t hash, void* value, size_t charge,
+    void (*deleter)(const Slice& key, void* value)) {
+  ClockEntry e;
+  e.value = value;
+  e.deleter = deleter;
+  e.key_data = new char[key.size()];
+  e.key_length = key.size();
+  e.charge = charge;
+  memcpy(e.key_data, key.data(), key.size());
+
+  autovector<ClockEntry> evicted;
+  ClockHandle* h = nullptr;
+  {
+    MutexLock l(&mutex_);
+    EraseLocked(key, hash, &evicted);
+
+    // Sweep at most twice around the clock: the first pass may only clear
+    // usage bits.
+    for (uint32_t step = 0;
+         step < 2 * length_ &&
+         (usage_.load(std::memory_order_relaxed) + charge > capacity_ ||
+          occupancy_.load(std::memory_order_relaxed) >= max_occupancy_);
+         step++) {
+      EvictOne(&evicted);
+    }
+
+    // Note that the cache might get larger than its capacity if not
+    // enough space was freed.
+    if (occupancy_.load(std::memory_order_relaxed) < max_occupancy_) {
+      uint32_t idx = hash & (length_ - 1);
+      for (uint32_t probe = 0; probe < length_; probe++) {
+        ClockHandle* slot = &table_[idx];
+        uint32_t meta = slot->meta.load(std::memory_order_acquire);
+        if (meta == 0 || meta == kTombstone) {
+          h = slot;
+          h->hash.store(hash, std::memory_order_relaxed);
+          h->entry = e;
+          usage_.fetch_add(charge, std::memory_order_relaxed);
+          occupancy_.fetch_add(1, std::memory_order_relaxed);
+          if (probe > max_probe_.load(std::memory_order_relaxed)) {
+            max_probe_.store(probe, std::memory_order_release);
+          }
+          h->meta.store(kInCache | kOneRef, std::memory_order_release);
+          break;
+        }
+        idx = (idx + 1) & (length_ - 1);
+      }
+    }
+  }
+
+  // we free the entries here outside of mutex for
+  // performance reasons
+  for (auto& entry : evicted) {
+    entry.Free();
+  }
+
+  if (h == nullptr) {
+    // Every slot is pinned. Hand out an entry that lives outside of the
+    // table and is freed on its last Release().
+    h = new ClockHandle();
+    h->hash.store(hash, std::memory_order_relaxed);
+    h->entry = e;
+    usage_.fetch_add(charge, std::memory_order_relaxed);
+    h->meta.store(kDetached | kOneRef, std::memory_order_release);
+  }
+  return reinterpret_cast<Cache::Handle*>(h);
+}
+
+void ClockCache::Erase(const Slice& key, uint32_t hash) {
+  autovector<ClockEntry> evicted;
+  {
+    MutexLock l(&mutex_);
+    EraseLocked(key, hash, &evicted);
+  }
+  // mutex not held here
+  for (auto& entry : evicted) {
+    entry.Free();
+  }
+}
+
+static int kNumShardBits = 4;  // default values, can be overridden
+static size_t kEstimatedEntryCharge = 4096;
+
+class ShardedClockCache : public Cache {
+ private:
+  ClockCache* shards_;
+  port::Mutex id_mutex_;
+  uint64_t last_id_;
+  int num_shard_bits_;
+  size_t capacity_;
+
+  static inline uint32_t HashSlice(const Slice& s) {
+    return Hash(s.data(), s.size(), 0);
+  }
+
+  uint32_t Shard(uint32_t hash) {
+    // Note, hash >> 32 yields hash in gcc, not the zero we expect!
+    return (num_shard_bits_ > 0) ? (hash >> (32 - num_shard_bits_)) : 0;
+  }
+
+ public:
+  ShardedClockCache(size_t capacity, int num_shard_bits,
+                    size_t estimated_entry_charge)
+      : last_id_(0), num_shard_bits_(num_shard_bits), capacity_(capacity) {
+    int num_shards = 1 << num_shard_bits_;
+    shards_ = new ClockCache[num_shards];
+    const size_t per_shard = (capacity + (num_shards - 1)) / num_shards;
+    for (int s = 0; s < num_shards; s++) {
+      shards_[s].Init(per_shard, estimated_entry_charge);
+    }
+  }
+  virtual ~ShardedClockCache() {
+    delete[] shards_;
+  }
+  virtual Handle* Insert(const Slice& key, void* value, size_t charge,
+                         void (*deleter)(const Slice& key,
+                                         void* value)) override {
+    const uint32_t hash = HashSlice(key);
+    return shards_[Shard(hash)].Insert(key, hash, value, charge, deleter);
+  }
+  virtual Handle* Lookup(const Slice& key) override {
+    const uint32_t hash = HashSlice(key);
+    return shards_[Shard(hash)].Lookup(key, hash);
+  }
+  virtual void Release(Handle* handle) override {
+    ClockHandle* h = reinterpret_cast<ClockHandle*>(handle);
+    shards_[Shard(h->hash.load(std::memory_order_relaxed))].Release(handle);
+  }
+  virtual void Erase(const Slice& key) override {
+    const uint32_t hash = HashSlice(key);
+    shards_[Shard(hash)].Erase(key, hash);
+  }
+  virtual void* Value(Handle* handle) override {
+    return reinterpret_cast<ClockHandle*>(handle)->entry.value;
+  }
+  virtual uint64_t NewId() override {
+    MutexLock l(&id_mutex_);
+    return ++(last_id_);
+  }
+  virtual size_t GetCapacity() const override { return capacity_; }
+
+  virtual size_t GetUsage() const override {
+    int num_shards = 1 << num_shard_bits_;
+    size_t usage = 0;
+    for (int s = 0; s < num_shards; s++) {
+      usage += shards_[s].GetUsage();
+    }
+    return usage;
+  }
+
+  virtual void DisownData() override { shards_ = nullptr; }
+
+  virtual void ApplyToAllCacheEntries(void (*callback)(void*, size_t),
+                                      bool thread_safe) override {
+    int num_shards = 1 << num_shard_bits_;
+    for (int s = 0; s < num_shards; s++) {
+      shards_[s].ApplyToAllCacheEntries(callback, thread_safe);
+    }
+  }
+};
+
+}  // end anonymous namespace
+
+shared_ptr<Cache> NewClockCache(size_t capacity) {
+  return NewClockCache(capacity, kNumShardBits, kEstimatedEntryCharge);
+}
+
+shared_ptr<Cache> NewClockCache(size_t capacity, int num_shard_bits,
+                                size_t estimated_entry_charge) {
+  if (num_shard_bits >= 20) {
+    return nullptr;  // the cache cannot be sharded into too many fine pieces
+  }
+  return std::make_shared<ShardedClockCache>(capacity, num_shard_bits,
+                                             estimated_entry_charge);
+}
+
+}  // namespace rocksdb
@@ -11,8 +11,11 @@
 
 #include <algorithm>
 #include <limits>
+#include <string>
+#include <vector>
 
 #include "rocksdb/options.h"
+#include "rocksdb/slice.h"
 #include "util/coding.h"
 
 #ifdef SNAPPY
@@ -32,6 +35,11 @@
 #include <lz4hc.h>
 #endif
 
+#ifdef ZSTD
+#include <zstd.h>
+#include <zdict.h>
+#endif
+
 namespace rocksdb {
 
 // compress_format_version can have two values:
@@ -97,10 +105,12 @@ inline bool GetDecompressedSizeInfo(const char** input_data,
 // block header
 // compress_format_version == 2 -- decompressed size is included in the block
 // header in varint32 format
+// A block compressed with compression_dict can only be uncompressed with it.
 inline bool Zlib_Compress(const CompressionOptions& opts,
                           uint32_t compress_format_version,
                           const char* input, size_t length,
-                          ::std::string* output) {
+                          ::std::string* output,
+                          const Slice& compression_dict = Slice()) {
 #ifdef ZLIB
   if (length > std::numeric_limits<uint32_t>::max()) {
     // Can't compress more than 4GB
@@ -130,6 +140,17 @@ inline bool Zlib_Compress(const CompressionOptions& opts,
     return false;
   }
 
+  if (compression_dict.size()) {
+    // Initialize the compression library's dictionary
+    st = deflateSetDictionary(
+        &_stream, reinterpret_cast<const Bytef*>(compression_dict.data()),
+        static_cast<unsigned int>(compression_dict.size()));
+    if (st != Z_OK) {
+      deflateEnd(&_stream);
+      return false;
+    }
+  }
+
   // Compress the input, and put compressed data in output.
   _stream.next_in = (Bytef *)input;
   _stream.avail_in = static_cast<unsigned int>(length);
@@ -170,6 +191,7 @@ inline bool Zlib_Compress(const CompressionOptions& opts,
 inline char* Zlib_Uncompress(const char* input_data, size_t input_length,
                              int* decompress_size,
                              uint32_t compress_format_version,
+                             const Slice& compression_dict = Slice(),
                              int windowBits = -14) {
 #ifdef ZLIB
   uint32_t output_len = 0;
@@ -199,6 +221,17 @@ inline char* Zlib_Uncompress(const char* input_data, size_t input_length,
     return nullptr;
   }
 
+  if (compression_dict.size()) {
+    // Initialize the compression library's dictionary
+    st = inflateSetDictionary(
+        &_stream, reinterpret_cast<const Bytef*>(compression_dict.data()),
+        static_cast<unsigned int>(compression_dict.size()));
+    if (st != Z_OK) {
+      inflateEnd(&_stream);
+      return nullptr;
+    }
+  }
+
   _stream.next_in = (Bytef *)input_data;
   _stream.avail_in = static_cast<unsigned int>(input_length);
 
@@ -522,4 +555,84 @@ inline bool LZ4HC_Compress(const CompressionOptions& opts,
   return false;
 }
 
+// The decompressed size is included in the block header in varint32 format.
+// A block compressed with compression_dict can only be uncompressed with it.
+inline bool ZSTD_Compress(const CompressionOptions& opts, const char* input,
+                          size_t length, ::std::string* output,
+                          const Slice& compression_dict = Slice()) {
+#ifdef ZSTD
+  if (length > std::numeric_limits<uint32_t>::max()) {
+    // Can't compress more than 4GB
+    return false;
+  }
+
+  size_t output_header_len = compression::PutDecompressedSizeInfo(
+      output, static_cast<uint32_t>(length));
+
+  size_t compressBound = ZSTD_compressBound(length);
+  output->resize(static_cast<size_t>(output_header_len + compressBound));
+  // The default level of CompressionOptions is the one of zlib
+  int level = opts.level == -1 ? 3 : opts.level;
+  ZSTD_CCtx* context = ZSTD_createCCtx();
+  size_t outlen = ZSTD_compress_usingDict(
+      context, &(*output)[output_header_len], compressBound, input, length,
+      compression_dict.data(), compression_dict.size(), level);
+  ZSTD_freeCCtx(context);
+  if (ZSTD_isError(outlen) || outlen == 0) {
+    return false;
+  }
+  output->resize(output_header_len + outlen);
+  return true;
+#endif
+  return false;
+}
+
+// The decompressed size is included in the block header in varint32 format.
+inline char* ZSTD_Uncompress(const char* input_data, size_t input_length,
+                             int* decompress_size,
+                             const Slice& compression_dict = Slice()) {
+#ifdef ZSTD
+  uint32_t output_len = 0;
+  if (!compression::GetDecompressedSizeInfo(&input_data, &input_length,
+                                            &output_len)) {
+    return nullptr;
+  }
+
+  char* output = new char[output_len];
+  ZSTD_DCtx* context = ZSTD_createDCtx();
+  size_t actual_output_length = ZSTD_decompress_usingDict(
+      context, output, output_len, input_data, input_length,
+      compression_dict.data(), compression_dict.size());
+  ZSTD_freeDCtx(context);
+  if (ZSTD_isError(actual_output_length) ||
+      actual_output_length != output_len) {
+    delete[] output;
+    return nullptr;
+  }
+  *decompress_size = static_cast<int>(actual_output_length);
+  return output;
+#endif
+  return nullptr;
+}
+
+// Train a ZSTD dictionary of at most max_dict_bytes from samples, the
+// concatenation of samples of the sizes in sample_lens. Returns an empty
+// string if ZSTD is not supported or the training failed.
+inline std::string ZSTD_TrainDictionary(const std::string& samples,
+                                        const std::vector<size_t>& sample_lens,
+                                        size_t max_dict_bytes) {
+#ifdef ZSTD
+  std::string dict_data(max_dict_bytes, '\0');
+  size_t dict_len = ZDICT_trainFromBuffer(
+      &dict_data[0], max_dict_bytes, samples.data(), sample_lens.data(),
+      static_cast<unsigned>(sample_lens.size()));
+  if (ZDICT_isError(dict_len)) {
+    return "";
+  }
+  dict_data.resize(dict_len);
+  return dict_data;
+#endif
+  return "";
+}
+
 }  // namespace rocksdb
@@ -8,7 +8,9 @@
 // found in the LICENSE file. See the AUTHORS file for names of contributors.
 //
 // A portable implementation of crc32c, optimized to handle
-// four bytes at a time.
+// four bytes at a time. With SSE 4.2, eight bytes at a time are handled with
+// the crc32 instruction, and with PCLMULQDQ as well, large buffers are split
+// into three streams so that three crc32 instructions are in flight at once.
 
 #include "util/crc32c.h"
 
@@ -16,6 +18,10 @@
 #ifdef __SSE4_2__
 #include <nmmintrin.h>
 #endif
+#if defined(__SSE4_2__) && defined(__PCLMUL__)
+#include <wmmintrin.h>
+#define CRC32C_PCLMUL
+#endif
 #include "util/coding.h"
 
 namespace rocksdb {
@@ -365,21 +371,115 @@ uint32_t ExtendImpl(uint32_t crc, const char* buf, size_t size) {
   return static_cast<uint32_t>(l ^ 0xffffffffu);
 }
 
-// Detect if SS42 or not.
-static bool isSSE42() {
+#ifdef CRC32C_PCLMUL
+// Bytes per stream of the two block sizes handled three streams at a time
+static const size_t kLongBlock = 2048;
+static const size_t kShortBlock = 256;
+
+// The factor that shifts a crc over n bytes in ShiftCRC32(), x^(8n-33) mod P
+// in bit-reflected form. Multiplying the reflected crc by it with a carryless
+// multiply gives crc * x^(8n-33) * x, and crc32 of that product multiplies by
+// the remaining x^32.
+static uint32_t ShiftFactor(size_t n) {
+  uint32_t k = 0x80000000u;  // x^0
+  for (size_t i = 0; i < 8 * n - 33; i++) {
+    k = (k >> 1) ^ ((k & 1) ? 0x82f63b78u : 0);
+  }
+  return k;
+}
+
+// Set by Choose_Extend() if ExtendPCLMUL is used
+static uint32_t long_shift1, long_shift2;
+static uint32_t short_shift1, short_shift2;
+
+// Return crc * x^(8n) mod P, the crc of crc followed by n zero bytes, with
+// the ShiftFactor() of n
+static inline uint64_t ShiftCRC32(uint64_t crc, uint32_t factor) {
+  __m128i product = _mm_clmulepi64_si128(
+      _mm_cvtsi64_si128(static_cast<int64_t>(crc)), _mm_cvtsi32_si128(factor),
+      0);
+  return _mm_crc32_u64(0, static_cast<uint64_t>(_mm_cvtsi128_si64(product)));
+}
+
+// Process three consecutive blocks of kBlockSize bytes as independent
+// streams, the last two starting from a zero crc, and combine the results:
+// crc(A B C) = crc(A) * x^(16 kBlockSize) ^ crc(B) * x^(8 kBlockSize) ^ crc(C)
+template <size_t kBlockSize>
+static inline void Triplet_CRC32(uint64_t* l, uint8_t const** p,
+                                 uint32_t shift1, uint32_t shift2) {
+  const uint8_t* p0 = *p;
+  const uint8_t* p1 = p0 + kBlockSize;
+  const uint8_t* p2 = p1 + kBlockSize;
+  uint64_t crc0 = *l;
+  uint64_t crc1 = 0;
+  uint64_t crc2 = 0;
+  for (size_t i = 0; i < kBlockSize / 8; i++) {
+    crc0 = _mm_crc32_u64(crc0, LE_LOAD64(p0));
+    crc1 = _mm_crc32_u64(crc1, LE_LOAD64(p1));
+    crc2 = _mm_crc32_u64(crc2, LE_LOAD64(p2));
+    p0 += 8;
+    p1 += 8;
+    p2 += 8;
+  }
+  *l = ShiftCRC32(crc0, shift2) ^ ShiftCRC32(crc1, shift1) ^ crc2;
+  *p = p2;
+}
+
+static uint32_t ExtendPCLMUL(uint32_t crc, const char* buf, size_t size) {
+  const uint8_t *p = reinterpret_cast<const uint8_t *>(buf);
+  const uint8_t *e = p + size;
+  uint64_t l = crc ^ 0xffffffffu;
+  while (static_cast<size_t>(e - p) >= 3 * kLongBlock) {
+    Triplet_CRC32<kLongBlock>(&l, &p, long_shift1, long_shift2);
+  }
+  while (static_cast<size_t>(e - p) >= 3 * kShortBlock) {
+    Triplet_CRC32<kShortBlock>(&l, &p, short_shift1, short_shift2);
+  }
+  // The rest is shorter than three short blocks
+  return ExtendImpl<Fast_CRC32>(static_cast<uint32_t>(l ^ 0xffffffffu),
+                                reinterpret_cast<const char*>(p), e - p);
+}
+#endif  // CRC32C_PCLMUL
+
+// The ecx feature flags of cpuid leaf 1. cpuid overwrites eax, so it is
+// declared as an output as well; otherwise a second call could be compiled
+// to reuse a clobbered eax as the leaf.
+static uint32_t cpuidFeatureFlags() {
 #if defined(__GNUC__) && defined(__x86_64__) && !defined(IOS_CROSS_COMPILE)
-  uint32_t c_;
+  uint32_t a_ = 1;
+  uint32_t c_ = 0;
   uint32_t d_;
-  __asm__("cpuid" : "=c"(c_), "=d"(d_) : "a"(1) : "ebx");
-  return c_ & (1U << 20);  // copied from CpuId.h in Folly.
+  __asm__("cpuid" : "+a"(a_), "+c"(c_), "=d"(d_) : : "ebx");
+  return c_;
 #else
-  return false;
+  return 0;
 #endif
 }
 
+// Detect if SS42 or not.
+static bool isSSE42() {
+  return cpuidFeatureFlags() & (1U << 20);  // copied from CpuId.h in Folly.
+}
+
+#ifdef CRC32C_PCLMUL
+// Detect if PCLMULQDQ or not.
+static bool isPCLMULQDQ() {
+  return cpuidFeatureFlags() & (1U << 1);
+}
+#endif  // CRC32C_PCLMUL
+
 typedef uint32_t (*Function)(uint32_t, const char*, size_t);
 
 static inline Function Choose_Extend() {
+#ifdef CRC32C_PCLMUL
+  if (isSSE42() && isPCLMULQDQ()) {
+    long_shift1 = ShiftFactor(kLongBlock);
+    long_shift2 = ShiftFactor(2 * kLongBlock);
+    short_shift1 = ShiftFactor(kShortBlock);
+    short_shift2 = ShiftFactor(2 * kShortBlock);
+    return ExtendPCLMUL;
+  }
+#endif
   return isSSE42() ? ExtendImpl<Fast_CRC32> : ExtendImpl<Slow_CRC32>;
 }
 
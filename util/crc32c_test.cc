@@ -8,7 +8,9 @@
 // found in the LICENSE file. See the AUTHORS file for names of contributors.
 
 #include "util/crc32c.h"
+#include "util/random.h"
 #include "util/testharness.h"
+#include "util/testutil.h"
 
 namespace rocksdb {
 namespace crc32c {
@@ -52,6 +54,25 @@ TEST(CRC, StandardResults) {
   ASSERT_EQ(0xd9963a56, Value(reinterpret_cast<char*>(data), sizeof(data)));
 }
 
+TEST(CRC, LargeBuffers) {
+  // Cover the sizes around the blocks that are processed as three streams,
+  // at all alignments, against a byte at a time crc
+  std::string data;
+  Random rnd(301);
+  test::RandomString(&rnd, 20000, &data);
+  const size_t sizes[] = {0,   1,   7,   8,    767,  768,  769,
+                          800, 1536, 6143, 6144, 6145, 13000, 19992};
+  for (size_t size : sizes) {
+    for (size_t offset = 0; offset < 8; offset++) {
+      uint32_t expected = 0;
+      for (size_t i = 0; i < size; i++) {
+        expected = Extend(expected, data.data() + offset + i, 1);
+      }
+      ASSERT_EQ(expected, Value(data.data() + offset, size));
+    }
+  }
+}
+
 TEST(CRC, Values) {
   ASSERT_NE(Value("a", 1), Value("foo", 3));
 }
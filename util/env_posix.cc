@@ -32,11 +32,14 @@
 #endif
 #include <signal.h>
 #include <algorithm>
+#include <mutex>
+#include <thread>
 #include "rocksdb/env.h"
 #include "rocksdb/slice.h"
 #include "port/port.h"
 #include "util/coding.h"
 #include "util/logging.h"
+#include "util/mutexlock.h"
 #include "util/posix_logger.h"
 #include "util/random.h"
 #include "util/iostats_context_imp.h"
@@ -100,6 +103,47 @@ static Status IOError(const std::string& context, int err_number) {
   return Status::IOError(context, strerror(err_number));
 }
 
+// Open a file so that its reads and writes bypass the OS page cache. They
+// must then be aligned in memory, file offset and size.
+static int OpenDirect(const std::string& fname, int flags, mode_t mode) {
+#if defined(O_DIRECT)
+  flags |= O_DIRECT;
+#elif !defined(F_NOCACHE)
+  errno = ENOTSUP;
+  return -1;
+#endif
+  int fd = -1;
+  do {
+    fd = open(fname.c_str(), flags, mode);
+  } while (fd < 0 && errno == EINTR);
+#if !defined(O_DIRECT) && defined(F_NOCACHE)
+  if (fd >= 0 && fcntl(fd, F_NOCACHE, 1) == -1) {
+    const int saved_errno = errno;
+    close(fd);
+    errno = saved_errno;
+    fd = -1;
+  }
+#endif
+  return fd;
+}
+
+struct AlignedBufferDeleter {
+  void operator()(char* p) const { free(p); }
+};
+typedef std::unique_ptr<char[], AlignedBufferDeleter> AlignedBuffer;
+
+static AlignedBuffer NewAlignedBuffer(size_t alignment, size_t size) {
+  void* p = nullptr;
+  if (posix_memalign(&p, alignment, size) != 0) {
+    throw std::bad_alloc();
+  }
+  return AlignedBuffer(static_cast<char*>(p));
+}
+
+static inline size_t Roundup(size_t x, size_t alignment) {
+  return ((x + alignment - 1) / alignment) * alignment;
+}
+
 #ifdef NDEBUG
 // empty in release build
 #define TEST_KILL_RANDOM(rocksdb_kill_odds)
@@ -232,17 +276,34 @@ class PosixRandomAccessFile: public RandomAccessFile {
   std::string filename_;
   int fd_;
   bool use_os_buffer_;
+  // The file was opened with O_DIRECT and reads must be aligned to this
+  const bool use_direct_io_;
+  const size_t alignment_;
+  // Buffer for direct reads that are not aligned, kept for the next read.
+  // A read that finds it in use by another thread allocates its own.
+  mutable std::mutex direct_buffer_mutex_;
+  mutable AlignedBuffer direct_buffer_;
+  mutable size_t direct_buffer_size_;
 
  public:
   PosixRandomAccessFile(const std::string& fname, int fd,
-                        const EnvOptions& options)
-      : filename_(fname), fd_(fd), use_os_buffer_(options.use_os_buffer) {
-    assert(!options.use_mmap_reads || sizeof(void*) < 8);
+                        const EnvOptions& options, size_t alignment)
+      : filename_(fname),
+        fd_(fd),
+        use_os_buffer_(options.use_os_buffer),
+        use_direct_io_(options.use_direct_reads),
+        alignment_(alignment),
+        direct_buffer_size_(0) {
+    assert(!options.use_mmap_reads || options.use_direct_reads ||
+           sizeof(void*) < 8);
   }
   virtual ~PosixRandomAccessFile() { close(fd_); }
 
   virtual Status Read(uint64_t offset, size_t n, Slice* result,
                       char* scratch) const override {
+    if (use_direct_io_) {
+      return DirectRead(offset, n, result, scratch);
+    }
     Status s;
     ssize_t r = -1;
     size_t left = n;
@@ -274,6 +335,62 @@ class PosixRandomAccessFile: public RandomAccessFile {
     return s;
   }
 
+  // Read the aligned range that covers the request into a buffer of our
+  // own and copy the requested bytes to scratch. An aligned request is read
+  // into scratch directly.
+  Status DirectRead(uint64_t offset, size_t n, Slice* result,
+                    char* scratch) const {
+    const uint64_t aligned_offset = offset - offset % alignment_;
+    const size_t skip = static_cast<size_t>(offset - aligned_offset);
+    const size_t size = Roundup(skip + n, alignment_);
+    const bool aligned =
+        skip == 0 && size == n &&
+        reinterpret_cast<uintptr_t>(scratch) % alignment_ == 0;
+
+    char* buf = scratch;
+    AlignedBuffer own_buf;
+    std::unique_lock<std::mutex> lock(direct_buffer_mutex_, std::defer_lock);
+    if (!aligned) {
+      if (lock.try_lock()) {
+        if (direct_buffer_size_ < size) {
+          direct_buffer_ = NewAlignedBuffer(alignment_, size);
+          direct_buffer_size_ = size;
+        }
+        buf = direct_buffer_.get();
+      } else {
+        own_buf = NewAlignedBuffer(alignment_, size);
+        buf = own_buf.get();
+      }
+    }
+
+    Status s;
+    size_t done = 0;
+    while (done < size) {
+      ssize_t r = pread(fd_, buf + done, size - done,
+                        static_cast<off_t>(aligned_offset + done));
+      if (r < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        s = IOError(filename_, errno);
+        break;
+      }
+      done += r;
+      if (r == 0 || done % alignment_ != 0) {
+        // End of file
+        break;
+      }
+    }
+
+    IOSTATS_ADD_IF_POSITIVE(bytes_read, done);
+    const size_t copied = (done > skip) ? std::min(n, done - skip) : 0;
+    if (!aligned) {
+      memcpy(scratch, buf + skip, copied);
+    }
+    *result = Slice(scratch, copied);
+    return s;
+  }
+
 #ifdef OS_LINUX
   virtual size_t GetUniqueId(char* id, size_t max_size) const override {
     return GetUniqueIdFromFile(fd_, id, max_size);
@@ -885,6 +1002,304 @@ class PosixWritableFile : public WritableFile {
   }
 };
 
+// Writes to a file opened with O_DIRECT. Appended data is collected in one
+// of two aligned buffers. Once a buffer is full, a writer thread of the file
+// writes it out while Append() fills the other one, so that the caller only
+// waits for the device when it produces data faster than the device takes
+// it. Sync() and Close() write the last, partial page padded with zeros,
+// and Close() cuts the padding off.
+class PosixDirectWritableFile : public WritableFile {
+ private:
+  const std::string filename_;
+  int fd_;
+  const size_t alignment_;
+  const size_t capacity_;      // size of each buffer
+  AlignedBuffer buffers_[2];
+  int active_;                 // the buffer that Append() fills
+  size_t cursize_;             // size of the data in the active buffer
+  uint64_t buffer_offset_;     // file offset of the active buffer
+  uint64_t filesize_;
+  bool pending_sync_;
+  bool pending_fsync_;
+#ifdef ROCKSDB_FALLOCATE_PRESENT
+  bool fallocate_with_keep_size_;
+#endif
+  RateLimiter* rate_limiter_;
+
+  // State shared with the writer thread
+  port::Mutex mu_;
+  port::CondVar cv_;
+  std::thread writer_;
+  bool write_pending_;         // the other buffer is being written
+  uint64_t pending_offset_;
+  Env::IOPriority pending_io_priority_;
+  bool closing_;
+  Status write_status_;        // the first error of the writer thread
+
+ public:
+  PosixDirectWritableFile(const std::string& fname, int fd, size_t alignment,
+                          size_t capacity, const EnvOptions& options)
+      : filename_(fname),
+        fd_(fd),
+        alignment_(alignment),
+        capacity_(Roundup(capacity, alignment)),
+        active_(0),
+        cursize_(0),
+        buffer_offset_(0),
+        filesize_(0),
+        pending_sync_(false),
+        pending_fsync_(false),
+        rate_limiter_(options.rate_limiter),
+        cv_(&mu_),
+        write_pending_(false),
+        pending_offset_(0),
+        pending_io_priority_(Env::IO_TOTAL),
+        closing_(false) {
+#ifdef ROCKSDB_FALLOCATE_PRESENT
+    fallocate_with_keep_size_ = options.fallocate_with_keep_size;
+#endif
+    assert(options.use_direct_writes);
+    buffers_[0] = NewAlignedBuffer(alignment_, capacity_);
+    buffers_[1] = NewAlignedBuffer(alignment_, capacity_);
+  }
+
+  ~PosixDirectWritableFile() {
+    if (fd_ >= 0) {
+      PosixDirectWritableFile::Close();
+    }
+  }
+
+  virtual Status Append(const Slice& data) override {
+    const char* src = data.data();
+    size_t left = data.size();
+    pending_sync_ = true;
+    pending_fsync_ = true;
+
+    TEST_KILL_RANDOM(rocksdb_kill_odds * REDUCE_ODDS2);
+
+    PrepareWrite(static_cast<size_t>(GetFileSize()), left);
+    while (left > 0) {
+      const size_t n = std::min(left, capacity_ - cursize_);
+      memcpy(buffers_[active_].get() + cursize_, src, n);
+      cursize_ += n;
+      src += n;
+      left -= n;
+      if (cursize_ == capacity_) {
+        Status s = SubmitActiveBuffer();
+        if (!s.ok()) {
+          return s;
+        }
+      }
+    }
+    filesize_ += data.size();
+    return Status::OK();
+  }
+
+  virtual Status Close() override {
+    Status s = WriteTail();
+    {
+      MutexLock l(&mu_);
+      closing_ = true;
+      cv_.SignalAll();
+    }
+    if (writer_.joinable()) {
+      writer_.join();
+    }
+
+    TEST_KILL_RANDOM(rocksdb_kill_odds);
+
+    // cut off the padding of the last page
+    if (s.ok() && ftruncate(fd_, filesize_) < 0) {
+      s = IOError(filename_, errno);
+    }
+#ifdef ROCKSDB_FALLOCATE_PRESENT
+    size_t block_size;
+    size_t last_allocated_block;
+    GetPreallocationStatus(&block_size, &last_allocated_block);
+    if (last_allocated_block > 0) {
+      // release the blocks preallocated past the end of the file, see
+      // PosixWritableFile::Close()
+      fallocate(fd_, FALLOC_FL_KEEP_SIZE | FALLOC_FL_PUNCH_HOLE, filesize_,
+                block_size * last_allocated_block - filesize_);
+    }
+#endif
+
+    if (close(fd_) < 0 && s.ok()) {
+      s = IOError(filename_, errno);
+    }
+    fd_ = -1;
+    return s;
+  }
+
+  // The data stays in the buffers until they are full or the file is synced
+  // or closed
+  virtual Status Flush() override {
+    MutexLock l(&mu_);
+    return write_status_;
+  }
+
+  virtual Status Sync() override {
+    Status s = WriteTail();
+    if (!s.ok()) {
+      return s;
+    }
+    TEST_KILL_RANDOM(rocksdb_kill_odds);
+    if (pending_sync_ && fdatasync(fd_) < 0) {
+      return IOError(filename_, errno);
+    }
+    TEST_KILL_RANDOM(rocksdb_kill_odds);
+    pending_sync_ = false;
+    return Status::OK();
+  }
+
+  virtual Status Fsync() override {
+    Status s = WriteTail();
+    if (!s.ok()) {
+      return s;
+    }
+    TEST_KILL_RANDOM(rocksdb_kill_odds);
+    if (pending_fsync_ && fsync(fd_) < 0) {
+      return IOError(filename_, errno);
+    }
+    TEST_KILL_RANDOM(rocksdb_kill_odds);
+    pending_fsync_ = false;
+    pending_sync_ = false;
+    return Status::OK();
+  }
+
+  virtual uint64_t GetFileSize() override { return filesize_; }
+
+  // No page of the file is in the OS cache
+  virtual Status InvalidateCache(size_t offset, size_t length) override {
+    return Status::OK();
+  }
+
+#ifdef ROCKSDB_FALLOCATE_PRESENT
+  virtual Status Allocate(off_t offset, off_t len) override {
+    TEST_KILL_RANDOM(rocksdb_kill_odds);
+    int alloc_status = fallocate(
+        fd_, fallocate_with_keep_size_ ? FALLOC_FL_KEEP_SIZE : 0, offset, len);
+    if (alloc_status == 0) {
+      return Status::OK();
+    } else {
+      return IOError(filename_, errno);
+    }
+  }
+
+  virtual size_t GetUniqueId(char* id, size_t max_size) const override {
+    return GetUniqueIdFromFile(fd_, id, max_size);
+  }
+#endif
+
+ private:
+  // Wait until the writer thread is done with the other buffer and return
+  // its status
+  Status WaitForWriter() {
+    MutexLock l(&mu_);
+    while (write_pending_) {
+      cv_.Wait();
+    }
+    return write_status_;
+  }
+
+  // Hand the full active buffer to the writer thread and continue with the
+  // other one
+  Status SubmitActiveBuffer() {
+    assert(cursize_ == capacity_);
+    MutexLock l(&mu_);
+    while (write_pending_) {
+      cv_.Wait();
+    }
+    if (!write_status_.ok()) {
+      return write_status_;
+    }
+    if (!writer_.joinable()) {
+      writer_ = std::thread(&PosixDirectWritableFile::BGWriter, this);
+    }
+    write_pending_ = true;
+    pending_offset_ = buffer_offset_;
+    pending_io_priority_ = io_priority_;
+    cv_.SignalAll();
+
+    active_ = 1 - active_;
+    cursize_ = 0;
+    buffer_offset_ += capacity_;
+    return Status::OK();
+  }
+
+  void BGWriter() {
+    MutexLock l(&mu_);
+    while (true) {
+      while (!write_pending_ && !closing_) {
+        cv_.Wait();
+      }
+      if (!write_pending_) {
+        break;
+      }
+      // Append() does not touch the submitted buffer until write_pending_
+      // is cleared
+      const char* buf = buffers_[1 - active_].get();
+      const uint64_t offset = pending_offset_;
+      const Env::IOPriority io_priority = pending_io_priority_;
+      mu_.Unlock();
+      Status s = WriteAligned(buf, capacity_, offset, io_priority);
+      mu_.Lock();
+      if (!s.ok() && write_status_.ok()) {
+        write_status_ = s;
+      }
+      write_pending_ = false;
+      cv_.SignalAll();
+    }
+  }
+
+  // Write the data appended since the last full buffer, padded to the
+  // alignment. It stays in the active buffer and is written again when the
+  // buffer is full or at the next Sync().
+  Status WriteTail() {
+    Status s = WaitForWriter();
+    if (!s.ok() || cursize_ == 0) {
+      return s;
+    }
+    const size_t size = Roundup(cursize_, alignment_);
+    memset(buffers_[active_].get() + cursize_, 0, size - cursize_);
+    return WriteAligned(buffers_[active_].get(), size, buffer_offset_,
+                        io_priority_);
+  }
+
+  Status WriteAligned(const char* src, size_t left, uint64_t offset,
+                      Env::IOPriority io_priority) {
+    assert(left % alignment_ == 0 && offset % alignment_ == 0);
+    while (left != 0) {
+      ssize_t done = pwrite(fd_, src, RequestToken(left, io_priority),
+                            static_cast<off_t>(offset));
+      if (done < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return IOError(filename_, errno);
+      }
+      IOSTATS_ADD(bytes_written, done);
+      TEST_KILL_RANDOM(rocksdb_kill_odds * REDUCE_ODDS2);
+      left -= done;
+      src += done;
+      offset += done;
+    }
+    return Status::OK();
+  }
+
+  // Like PosixWritableFile::RequestToken(), but keeps requests aligned
+  size_t RequestToken(size_t bytes, Env::IOPriority io_priority) {
+    if (rate_limiter_ && io_priority < Env::IO_TOTAL) {
+      size_t burst =
+          static_cast<size_t>(rate_limiter_->GetSingleBurstBytes());
+      burst = std::max(burst - burst % alignment_, alignment_);
+      bytes = std::min(bytes, burst);
+      rate_limiter_->Request(bytes, io_priority);
+    }
+    return bytes;
+  }
+};
+
 class PosixRandomRWFile : public RandomRWFile {
  private:
   const std::string filename_;
@@ -1119,10 +1534,13 @@ class PosixEnv : public Env {
                                      const EnvOptions& options) override {
     result->reset();
     Status s;
-    int fd = open(fname.c_str(), O_RDONLY);
+    int fd = options.use_direct_reads ? OpenDirect(fname, O_RDONLY, 0)
+                                      : open(fname.c_str(), O_RDONLY);
     SetFD_CLOEXEC(fd, &options);
     if (fd < 0) {
       s = IOError(fname, errno);
+    } else if (options.use_direct_reads) {
+      result->reset(new PosixRandomAccessFile(fname, fd, options, page_size_));
     } else if (options.use_mmap_reads && sizeof(void*) >= 8) {
       // Use of mmap for random reads has been removed because it
       // kills performance when storage is fast.
@@ -1140,7 +1558,7 @@ class PosixEnv : public Env {
       }
       close(fd);
     } else {
-      result->reset(new PosixRandomAccessFile(fname, fd, options));
+      result->reset(new PosixRandomAccessFile(fname, fd, options, page_size_));
     }
     return s;
   }
@@ -1151,6 +1569,17 @@ class PosixEnv : public Env {
     result->reset();
     Status s;
     int fd = -1;
+    if (options.use_direct_writes) {
+      fd = OpenDirect(fname, O_CREAT | O_RDWR | O_TRUNC, 0644);
+      if (fd < 0) {
+        s = IOError(fname, errno);
+      } else {
+        SetFD_CLOEXEC(fd, &options);
+        result->reset(new PosixDirectWritableFile(fname, fd, page_size_,
+                                                  1 << 20, options));
+      }
+      return s;
+    }
     do {
       fd = open(fname.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
     } while (fd < 0 && errno == EINTR);
@@ -1500,6 +1929,7 @@ class PosixEnv : public Env {
   EnvOptions OptimizeForLogWrite(const EnvOptions& env_options) const override {
     EnvOptions optimized = env_options;
     optimized.use_mmap_writes = false;
+    optimized.use_direct_writes = false;
     // TODO(icanadi) it's faster if fallocate_with_keep_size is false, but it
     // breaks TransactionLogIteratorStallAtLastRecord unit test. Fix the unit
     // test and make this false
@@ -1511,6 +1941,7 @@ class PosixEnv : public Env {
       const EnvOptions& env_options) const override {
     EnvOptions optimized = env_options;
     optimized.use_mmap_writes = false;
+    optimized.use_direct_writes = false;
     optimized.fallocate_with_keep_size = true;
     return optimized;
   }
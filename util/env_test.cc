@@ -28,7 +28,9 @@
 #include "util/coding.h"
 #include "util/log_buffer.h"
 #include "util/mutexlock.h"
+#include "util/random.h"
 #include "util/testharness.h"
+#include "util/testutil.h"
 
 namespace rocksdb {
 
@@ -872,6 +874,69 @@ TEST(EnvPosixTest, Preallocation) {
   ASSERT_EQ(last_allocated_block, 7UL);
 }
 
+TEST(EnvPosixTest, DirectIO) {
+  const std::string fname = test::TmpDir() + "/" + "testfile";
+  EnvOptions soptions;
+  soptions.use_direct_writes = true;
+  unique_ptr<WritableFile> wfile;
+  Status s = env_->NewWritableFile(fname, &wfile, soptions);
+  if (!s.ok()) {
+    fprintf(stderr, "Skipped, O_DIRECT is not supported here: %s\n",
+            s.ToString().c_str());
+    return;
+  }
+
+  // Appends of all sizes, more than two buffers in total, with syncs of
+  // partial pages in between
+  Random rnd(301);
+  std::string data;
+  for (int i = 0; i < 300; i++) {
+    std::string chunk;
+    test::RandomString(&rnd, rnd.Uniform(i % 10 == 0 ? 100000 : 5000),
+                       &chunk);
+    ASSERT_OK(wfile->Append(chunk));
+    data.append(chunk);
+    if (i % 50 == 0) {
+      ASSERT_OK(wfile->Sync());
+    }
+  }
+  ASSERT_EQ(data.size(), wfile->GetFileSize());
+  ASSERT_OK(wfile->Close());
+  uint64_t file_size;
+  ASSERT_OK(env_->GetFileSize(fname, &file_size));
+  ASSERT_EQ(data.size(), file_size);
+
+  soptions.use_direct_reads = true;
+  unique_ptr<RandomAccessFile> file;
+  ASSERT_OK(env_->NewRandomAccessFile(fname, &file, soptions));
+  std::string scratch(10000, '\0');
+  Slice result;
+  for (int i = 0; i < 1000; i++) {
+    uint64_t offset = rnd.Uniform(static_cast<int>(data.size()));
+    size_t n = rnd.Uniform(static_cast<int>(scratch.size()));
+    ASSERT_OK(file->Read(offset, n, &result, &scratch[0]));
+    ASSERT_EQ(data.substr(offset, n), result.ToString());
+  }
+  // Short at the end of the file
+  ASSERT_OK(file->Read(data.size() - 10, 100, &result, &scratch[0]));
+  ASSERT_EQ(data.substr(data.size() - 10), result.ToString());
+  ASSERT_OK(file->Read(data.size() + 10, 100, &result, &scratch[0]));
+  ASSERT_EQ(0U, result.size());
+
+  // Aligned reads into an aligned buffer go to it directly
+  const size_t kPage = 4096;
+  std::string aligned_scratch(4 * kPage + kPage, '\0');
+  char* aligned = &aligned_scratch[0] +
+                  (kPage - reinterpret_cast<uintptr_t>(&aligned_scratch[0]) %
+                               kPage) % kPage;
+  for (uint64_t offset = 0; offset < data.size(); offset += 3 * kPage) {
+    ASSERT_OK(file->Read(offset, 4 * kPage, &result, aligned));
+    ASSERT_TRUE(result.data() == aligned);
+    ASSERT_EQ(data.substr(offset, 4 * kPage), result.ToString());
+  }
+  ASSERT_OK(env_->DeleteFile(fname));
+}
+
 }  // namespace rocksdb
 
 int main(int argc, char** argv) {
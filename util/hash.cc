@@ -58,4 +58,54 @@ uint32_t Hash(const char* data, size_t n, uint32_t seed) {
   return h;
 }
 
+uint64_t Hash64(const char* data, size_t n, uint64_t seed) {
+  // MurmurHash64A, reading the input as little-endian words
+  const uint64_t m = 0xc6a4a7935bd1e995ULL;
+  const int r = 47;
+  const char* limit = data + n;
+  uint64_t h = seed ^ (n * m);
+
+  // Pick up eight bytes at a time
+  while (data + 8 <= limit) {
+    uint64_t k = DecodeFixed64(data);
+    data += 8;
+    k *= m;
+    k ^= k >> r;
+    k *= m;
+    h ^= k;
+    h *= m;
+  }
+
+  // Pick up remaining bytes
+  switch (limit - data) {
+    case 7:
+      h ^= static_cast<uint64_t>(static_cast<unsigned char>(data[6])) << 48;
+    // fall through
+    case 6:
+      h ^= static_cast<uint64_t>(static_cast<unsigned char>(data[5])) << 40;
+    // fall through
+    case 5:
+      h ^= static_cast<uint64_t>(static_cast<unsigned char>(data[4])) << 32;
+    // fall through
+    case 4:
+      h ^= static_cast<uint64_t>(static_cast<unsigned char>(data[3])) << 24;
+    // fall through
+    case 3:
+      h ^= static_cast<uint64_t>(static_cast<unsigned char>(data[2])) << 16;
+    // fall through
+    case 2:
+      h ^= static_cast<uint64_t>(static_cast<unsigned char>(data[1])) << 8;
+    // fall through
+    case 1:
+      h ^= static_cast<uint64_t>(static_cast<unsigned char>(data[0]));
+      h *= m;
+      break;
+  }
+
+  h ^= h >> r;
+  h *= m;
+  h ^= h >> r;
+  return h;
+}
+
 }  // namespace rocksdb
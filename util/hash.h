@@ -17,10 +17,18 @@ namespace rocksdb {
 
 extern uint32_t Hash(const char* data, size_t n, uint32_t seed);
 
+// 64-bit hash that consumes eight bytes per step. Unlike MurmurHash(),
+// the result is the same on all platforms, so it can be persisted.
+extern uint64_t Hash64(const char* data, size_t n, uint64_t seed);
+
 inline uint32_t BloomHash(const Slice& key) {
   return Hash(key.data(), key.size(), 0xbc9f1d34);
 }
 
+inline uint64_t BloomHash64(const Slice& key) {
+  return Hash64(key.data(), key.size(), 0xbc9f1d34);
+}
+
 inline uint32_t GetSliceHash(const Slice& s) {
   return Hash(s.data(), s.size(), 397);
 }
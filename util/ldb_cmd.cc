@@ -275,6 +275,8 @@ Options LDBCommand::PrepareOptionsForOpenDB() {
       opt.compression = kLZ4Compression;
     } else if (comp == "lz4hc") {
       opt.compression = kLZ4HCCompression;
+    } else if (comp == "zstd") {
+      opt.compression = kZSTD;
     } else {
       // Unknown compression.
       exec_state_ = LDBCommandExecuteResult::FAILED(
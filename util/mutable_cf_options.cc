@@ -74,6 +74,8 @@ void MutableCFOptions::Dump(Logger* log) const {
       memtable_prefix_bloom_huge_page_tlb_size);
   Log(log, "                    max_successive_merges: %zu",
       max_successive_merges);
+  Log(log, "               merge_write_back_threshold: %zu",
+      merge_write_back_threshold);
   Log(log, "                           filter_deletes: %d",
       filter_deletes);
   Log(log, "                 disable_auto_compactions: %d",
@@ -21,6 +21,7 @@ struct MutableCFOptions {
       memtable_prefix_bloom_huge_page_tlb_size(
           options.memtable_prefix_bloom_huge_page_tlb_size),
       max_successive_merges(options.max_successive_merges),
+      merge_write_back_threshold(options.merge_write_back_threshold),
       filter_deletes(options.filter_deletes),
       inplace_update_num_locks(options.inplace_update_num_locks),
       disable_auto_compactions(options.disable_auto_compactions),
@@ -54,6 +55,7 @@ struct MutableCFOptions {
       memtable_prefix_bloom_probes(0),
       memtable_prefix_bloom_huge_page_tlb_size(0),
       max_successive_merges(0),
+      merge_write_back_threshold(0),
       filter_deletes(false),
       inplace_update_num_locks(0),
       disable_auto_compactions(false),
@@ -95,6 +97,7 @@ struct MutableCFOptions {
   uint32_t memtable_prefix_bloom_probes;
   size_t memtable_prefix_bloom_huge_page_tlb_size;
   size_t max_successive_merges;
+  size_t merge_write_back_threshold;
   bool filter_deletes;
   size_t inplace_update_num_locks;
 
@@ -34,6 +34,17 @@
 
 namespace rocksdb {
 
+namespace {
+std::vector<TableFactory*> GetTableFactoryPointers(
+    const std::vector<std::shared_ptr<TableFactory>>& table_factories) {
+  std::vector<TableFactory*> result;
+  for (const auto& table_factory : table_factories) {
+    result.push_back(table_factory.get());
+  }
+  return result;
+}
+}  // namespace
+
 ImmutableCFOptions::ImmutableCFOptions(const Options& options)
     : compaction_style(options.compaction_style),
       compaction_options_universal(options.compaction_options_universal),
@@ -54,6 +65,8 @@ ImmutableCFOptions::ImmutableCFOptions(const Options& options)
       db_paths(options.db_paths),
       memtable_factory(options.memtable_factory.get()),
       table_factory(options.table_factory.get()),
+      table_factory_per_level(
+          GetTableFactoryPointers(options.table_factory_per_level)),
       table_properties_collector_factories(
           options.table_properties_collector_factories),
       advise_random_on_open(options.advise_random_on_open),
@@ -68,8 +81,11 @@ ImmutableCFOptions::ImmutableCFOptions(const Options& options)
       level_compaction_dynamic_level_bytes(
           options.level_compaction_dynamic_level_bytes),
       access_hint_on_compaction_start(options.access_hint_on_compaction_start),
+      compaction_readahead_size(options.compaction_readahead_size),
       num_levels(options.num_levels),
-      optimize_filters_for_hits(options.optimize_filters_for_hits)
+      optimize_filters_for_hits(options.optimize_filters_for_hits),
+      min_blob_size(options.min_blob_size),
+      blob_gc_discard_ratio(options.blob_gc_discard_ratio)
 #ifndef ROCKSDB_LITE
       ,
       listeners(options.listeners) {
@@ -126,8 +142,11 @@ ColumnFamilyOptions::ColumnFamilyOptions()
       memtable_prefix_bloom_huge_page_tlb_size(0),
       bloom_locality(0),
       max_successive_merges(0),
+      merge_write_back_threshold(0),
       min_partial_merge_operands(2),
-      optimize_filters_for_hits(false)
+      optimize_filters_for_hits(false),
+      min_blob_size(0),
+      blob_gc_discard_ratio(0.5)
 #ifndef ROCKSDB_LITE
       ,
       listeners() {
@@ -184,6 +203,7 @@ ColumnFamilyOptions::ColumnFamilyOptions(const Options& options)
           options.max_sequential_skip_in_iterations),
       memtable_factory(options.memtable_factory),
       table_factory(options.table_factory),
+      table_factory_per_level(options.table_factory_per_level),
       table_properties_collector_factories(
           options.table_properties_collector_factories),
       inplace_update_support(options.inplace_update_support),
@@ -195,8 +215,11 @@ ColumnFamilyOptions::ColumnFamilyOptions(const Options& options)
           options.memtable_prefix_bloom_huge_page_tlb_size),
       bloom_locality(options.bloom_locality),
       max_successive_merges(options.max_successive_merges),
+      merge_write_back_threshold(options.merge_write_back_threshold),
       min_partial_merge_operands(options.min_partial_merge_operands),
-      optimize_filters_for_hits(options.optimize_filters_for_hits)
+      optimize_filters_for_hits(options.optimize_filters_for_hits),
+      min_blob_size(options.min_blob_size),
+      blob_gc_discard_ratio(options.blob_gc_discard_ratio)
 #ifndef ROCKSDB_LITE
       ,
       listeners(options.listeners) {
@@ -245,12 +268,15 @@ DBOptions::DBOptions()
       allow_os_buffer(true),
       allow_mmap_reads(false),
       allow_mmap_writes(false),
+      use_direct_reads(false),
+      use_direct_io_for_flush_and_compaction(false),
       is_fd_close_on_exec(true),
       skip_log_error_on_recovery(false),
       stats_dump_period_sec(3600),
       advise_random_on_open(true),
       db_write_buffer_size(0),
       access_hint_on_compaction_start(NORMAL),
+      compaction_readahead_size(0),
       use_adaptive_mutex(false),
       bytes_per_sync(0),
       enable_thread_tracking(false) {
@@ -290,12 +316,16 @@ DBOptions::DBOptions(const Options& options)
       allow_os_buffer(options.allow_os_buffer),
       allow_mmap_reads(options.allow_mmap_reads),
       allow_mmap_writes(options.allow_mmap_writes),
+      use_direct_reads(options.use_direct_reads),
+      use_direct_io_for_flush_and_compaction(
+          options.use_direct_io_for_flush_and_compaction),
       is_fd_close_on_exec(options.is_fd_close_on_exec),
       skip_log_error_on_recovery(options.skip_log_error_on_recovery),
       stats_dump_period_sec(options.stats_dump_period_sec),
       advise_random_on_open(options.advise_random_on_open),
       db_write_buffer_size(options.db_write_buffer_size),
       access_hint_on_compaction_start(options.access_hint_on_compaction_start),
+      compaction_readahead_size(options.compaction_readahead_size),
       use_adaptive_mutex(options.use_adaptive_mutex),
       bytes_per_sync(options.bytes_per_sync),
       enable_thread_tracking(options.enable_thread_tracking) {}
@@ -350,6 +380,10 @@ void DBOptions::Dump(Logger* log) const {
         allow_mmap_reads);
     Log(log, "                       Options.allow_mmap_writes: %d",
         allow_mmap_writes);
+    Log(log, "                        Options.use_direct_reads: %d",
+        use_direct_reads);
+    Log(log, "  Options.use_direct_io_for_flush_and_compaction: %d",
+        use_direct_io_for_flush_and_compaction);
     Log(log, "                     Options.is_fd_close_on_exec: %d",
         is_fd_close_on_exec);
     Log(log, "                   Options.stats_dump_period_sec: %u",
@@ -360,6 +394,8 @@ void DBOptions::Dump(Logger* log) const {
         db_write_buffer_size);
     Log(log, "         Options.access_hint_on_compaction_start: %s",
         access_hints[access_hint_on_compaction_start]);
+    Log(log, "               Options.compaction_readahead_size: %zd",
+        compaction_readahead_size);
     Log(log, "                      Options.use_adaptive_mutex: %d",
         use_adaptive_mutex);
     Log(log, "                            Options.rate_limiter: %p",
@@ -384,6 +420,12 @@ void ColumnFamilyOptions::Dump(Logger* log) const {
   Log(log, "           Options.table_factory: %s", table_factory->Name());
   Log(log, "           table_factory options: %s",
       table_factory->GetPrintableTableOptions().c_str());
+  for (size_t i = 0; i < table_factory_per_level.size(); i++) {
+    if (table_factory_per_level[i] != nullptr) {
+      Log(log, "        Options.table_factory[%zu]: %s", i,
+          table_factory_per_level[i]->Name());
+    }
+  }
   Log(log, "       Options.write_buffer_size: %zd", write_buffer_size);
   Log(log, " Options.max_write_buffer_number: %d", max_write_buffer_number);
     if (!compression_per_level.empty()) {
@@ -407,6 +449,10 @@ void ColumnFamilyOptions::Dump(Logger* log) const {
         compression_opts.level);
     Log(log,"              Options.compression_opts.strategy: %d",
         compression_opts.strategy);
+    Log(log,"        Options.compression_opts.max_dict_bytes: %" PRIu32,
+        compression_opts.max_dict_bytes);
+    Log(log,"      Options.compression_opts.parallel_threads: %" PRIu32,
+        compression_opts.parallel_threads);
     Log(log,"     Options.level0_file_num_compaction_trigger: %d",
         level0_file_num_compaction_trigger);
     Log(log,"         Options.level0_slowdown_writes_trigger: %d",
@@ -493,8 +539,14 @@ void ColumnFamilyOptions::Dump(Logger* log) const {
         bloom_locality);
     Log(log, "                   Options.max_successive_merges: %zd",
         max_successive_merges);
+    Log(log, "              Options.merge_write_back_threshold: %zd",
+        merge_write_back_threshold);
     Log(log, "               Options.optimize_fllters_for_hits: %d",
         optimize_filters_for_hits);
+    Log(log, "                           Options.min_blob_size: %" PRIu64,
+        min_blob_size);
+    Log(log, "                   Options.blob_gc_discard_ratio: %f",
+        blob_gc_discard_ratio);
 }  // ColumnFamilyOptions::Dump
 
 void Options::Dump(Logger* log) const {
@@ -621,10 +673,14 @@ ReadOptions::ReadOptions()
       fill_cache(true),
       snapshot(nullptr),
       iterate_upper_bound(nullptr),
+      iterate_lower_bound(nullptr),
       read_tier(kReadAllTier),
       tailing(false),
       managed(false),
-      total_order_seek(false) {
+      total_order_seek(false),
+      pin_data(false),
+      deadline(0),
+      io_timeout(0) {
   XFUNC_TEST("", "managed_options", managed_options, xf_manage_options,
              reinterpret_cast<ReadOptions*>(this));
 }
@@ -634,10 +690,14 @@ ReadOptions::ReadOptions(bool cksum, bool cache)
       fill_cache(cache),
       snapshot(nullptr),
       iterate_upper_bound(nullptr),
+      iterate_lower_bound(nullptr),
       read_tier(kReadAllTier),
       tailing(false),
       managed(false),
-      total_order_seek(false) {
+      total_order_seek(false),
+      pin_data(false),
+      deadline(0),
+      io_timeout(0) {
   XFUNC_TEST("", "managed_options", managed_options, xf_manage_options,
              reinterpret_cast<ReadOptions*>(this));
 }
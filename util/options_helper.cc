@@ -34,6 +34,8 @@ CompressionType ParseCompressionType(const std::string& type) {
     return kLZ4Compression;
   } else if (type == "kLZ4HCCompression") {
     return kLZ4HCCompression;
+  } else if (type == "kZSTD") {
+    return kZSTD;
   } else {
     throw std::invalid_argument("Unknown compression type: " + type);
   }
@@ -46,10 +48,22 @@ BlockBasedTableOptions::IndexType ParseBlockBasedTableIndexType(
     return BlockBasedTableOptions::kBinarySearch;
   } else if (type == "kHashSearch") {
     return BlockBasedTableOptions::kHashSearch;
+  } else if (type == "kLearnedSearch") {
+    return BlockBasedTableOptions::kLearnedSearch;
   }
   throw std::invalid_argument("Unknown index type: " + type);
 }
 
+BlockBasedTableOptions::DataBlockIndexType ParseDataBlockIndexType(
+    const std::string& type) {
+  if (type == "kDataBlockBinarySearch") {
+    return BlockBasedTableOptions::kDataBlockBinarySearch;
+  } else if (type == "kDataBlockBinaryAndHash") {
+    return BlockBasedTableOptions::kDataBlockBinaryAndHash;
+  }
+  throw std::invalid_argument("Unknown data block index type: " + type);
+}
+
 ChecksumType ParseBlockBasedTableChecksumType(
     const std::string& type) {
   if (type == "kNoChecksum") {
@@ -154,6 +168,8 @@ bool ParseMemtableOptions(const std::string& name, const std::string& value,
       ParseSizeT(value);
   } else if (name == "max_successive_merges") {
     new_options->max_successive_merges = ParseSizeT(value);
+  } else if (name == "merge_write_back_threshold") {
+    new_options->merge_write_back_threshold = ParseSizeT(value);
   } else if (name == "filter_deletes") {
     new_options->filter_deletes = ParseBoolean(name, value);
   } else if (name == "max_write_buffer_number") {
@@ -407,8 +423,33 @@ bool ParseColumnFamilyOption(const std::string& name, const std::string& value,
       if (start >= value.size()) {
         return false;
       }
+      // The dictionary size and the number of threads are optional
+      end = value.find(':', start);
+      if (end == std::string::npos) {
+        end = value.size();
+      }
       new_options->compression_opts.strategy =
-          ParseInt(value.substr(start, value.size() - start));
+          ParseInt(value.substr(start, end - start));
+      if (end < value.size()) {
+        start = end + 1;
+        if (start >= value.size()) {
+          return false;
+        }
+        end = value.find(':', start);
+        if (end == std::string::npos) {
+          end = value.size();
+        }
+        new_options->compression_opts.max_dict_bytes =
+            ParseUint32(value.substr(start, end - start));
+      }
+      if (end < value.size()) {
+        start = end + 1;
+        if (start >= value.size()) {
+          return false;
+        }
+        new_options->compression_opts.parallel_threads =
+            ParseUint32(value.substr(start, value.size() - start));
+      }
     } else if (name == "num_levels") {
       new_options->num_levels = ParseInt(value);
     } else if (name == "level_compaction_dynamic_level_bytes") {
@@ -453,6 +494,10 @@ bool ParseColumnFamilyOption(const std::string& name, const std::string& value,
       }
     } else if (name == "optimize_filters_for_hits") {
       new_options->optimize_filters_for_hits = ParseBoolean(name, value);
+    } else if (name == "min_blob_size") {
+      new_options->min_blob_size = ParseUint64(value);
+    } else if (name == "blob_gc_discard_ratio") {
+      new_options->blob_gc_discard_ratio = ParseDouble(value);
     } else {
       return false;
     }
@@ -523,6 +568,11 @@ bool ParseDBOption(const std::string& name, const std::string& value,
       new_options->allow_mmap_reads = ParseBoolean(name, value);
     } else if (name == "allow_mmap_writes") {
       new_options->allow_mmap_writes = ParseBoolean(name, value);
+    } else if (name == "use_direct_reads") {
+      new_options->use_direct_reads = ParseBoolean(name, value);
+    } else if (name == "use_direct_io_for_flush_and_compaction") {
+      new_options->use_direct_io_for_flush_and_compaction =
+          ParseBoolean(name, value);
     } else if (name == "is_fd_close_on_exec") {
       new_options->is_fd_close_on_exec = ParseBoolean(name, value);
     } else if (name == "skip_log_error_on_recovery") {
@@ -533,6 +583,8 @@ bool ParseDBOption(const std::string& name, const std::string& value,
       new_options->advise_random_on_open = ParseBoolean(name, value);
     } else if (name == "db_write_buffer_size") {
       new_options->db_write_buffer_size = ParseUint64(value);
+    } else if (name == "compaction_readahead_size") {
+      new_options->compaction_readahead_size = ParseSizeT(value);
     } else if (name == "use_adaptive_mutex") {
       new_options->use_adaptive_mutex = ParseBoolean(name, value);
     } else if (name == "bytes_per_sync") {
@@ -564,6 +616,12 @@ Status GetBlockBasedTableOptionsFromMap(
       } else if (o.first == "hash_index_allow_collision") {
         new_table_options->hash_index_allow_collision =
           ParseBoolean(o.first, o.second);
+      } else if (o.first == "data_block_index_type") {
+        new_table_options->data_block_index_type =
+          ParseDataBlockIndexType(o.second);
+      } else if (o.first == "data_block_hash_table_util_ratio") {
+        new_table_options->data_block_hash_table_util_ratio =
+          ParseDouble(o.second);
       } else if (o.first == "checksum") {
         new_table_options->checksum =
           ParseBlockBasedTableChecksumType(o.second);
@@ -580,9 +638,16 @@ Status GetBlockBasedTableOptionsFromMap(
         new_table_options->block_size_deviation = ParseInt(o.second);
       } else if (o.first == "block_restart_interval") {
         new_table_options->block_restart_interval = ParseInt(o.second);
+      } else if (o.first == "index_block_restart_interval") {
+        new_table_options->index_block_restart_interval = ParseInt(o.second);
+      } else if (o.first == "max_auto_readahead_size") {
+        new_table_options->max_auto_readahead_size = ParseSizeT(o.second);
+      } else if (o.first == "use_delta_encoding") {
+        new_table_options->use_delta_encoding =
+          ParseBoolean(o.first, o.second);
       } else if (o.first == "filter_policy") {
         // Expect the following format
-        // bloomfilter:int:bool
+        // bloomfilter:int:bool[:int]
         const std::string kName = "bloomfilter:";
         if (o.second.compare(0, kName.size(), kName) != 0) {
           return Status::InvalidArgument("Invalid filter policy name");
@@ -594,11 +659,18 @@ Status GetBlockBasedTableOptionsFromMap(
         }
         int bits_per_key = ParseInt(
             trim(o.second.substr(kName.size(), pos - kName.size())));
+        size_t version_pos = o.second.find(':', pos + 1);
         bool use_block_based_builder =
           ParseBoolean("use_block_based_builder",
-                       trim(o.second.substr(pos + 1)));
+                       trim(o.second.substr(pos + 1, version_pos - pos - 1)));
+        int full_filter_format_version = 0;
+        if (version_pos != std::string::npos) {
+          full_filter_format_version =
+              ParseInt(trim(o.second.substr(version_pos + 1)));
+        }
         new_table_options->filter_policy.reset(
-            NewBloomFilterPolicy(bits_per_key, use_block_based_builder));
+            NewBloomFilterPolicy(bits_per_key, use_block_based_builder,
+                                 full_filter_format_version));
       } else if (o.first == "whole_key_filtering") {
         new_table_options->whole_key_filtering =
           ParseBoolean(o.first, o.second);
@@ -102,8 +102,9 @@ TEST(OptionsTest, GetOptionsFromMapTest) {
        "kZlibCompression:"
        "kBZip2Compression:"
        "kLZ4Compression:"
-       "kLZ4HCCompression"},
-      {"compression_opts", "4:5:6"},
+       "kLZ4HCCompression:"
+       "kZSTD"},
+      {"compression_opts", "4:5:6:7:8"},
       {"num_levels", "7"},
       {"level0_file_num_compaction_trigger", "8"},
       {"level0_slowdown_writes_trigger", "9"},
@@ -135,9 +136,12 @@ TEST(OptionsTest, GetOptionsFromMapTest) {
       {"memtable_prefix_bloom_huge_page_tlb_size", "28"},
       {"bloom_locality", "29"},
       {"max_successive_merges", "30"},
+      {"merge_write_back_threshold", "8"},
       {"min_partial_merge_operands", "31"},
       {"prefix_extractor", "fixed:31"},
       {"optimize_filters_for_hits", "true"},
+      {"min_blob_size", "32"},
+      {"blob_gc_discard_ratio", "0.25"},
   };
 
   std::unordered_map<std::string, std::string> db_options_map = {
@@ -166,10 +170,13 @@ TEST(OptionsTest, GetOptionsFromMapTest) {
     {"allow_os_buffer", "false"},
     {"allow_mmap_reads", "true"},
     {"allow_mmap_writes", "false"},
+    {"use_direct_reads", "false"},
+    {"use_direct_io_for_flush_and_compaction", "true"},
     {"is_fd_close_on_exec", "true"},
     {"skip_log_error_on_recovery", "false"},
     {"stats_dump_period_sec", "46"},
     {"advise_random_on_open", "true"},
+    {"compaction_readahead_size", "2097152"},
     {"use_adaptive_mutex", "false"},
     {"bytes_per_sync", "47"},
   };
@@ -182,16 +189,19 @@ TEST(OptionsTest, GetOptionsFromMapTest) {
   ASSERT_EQ(new_cf_opt.max_write_buffer_number, 2);
   ASSERT_EQ(new_cf_opt.min_write_buffer_number_to_merge, 3);
   ASSERT_EQ(new_cf_opt.compression, kSnappyCompression);
-  ASSERT_EQ(new_cf_opt.compression_per_level.size(), 6U);
+  ASSERT_EQ(new_cf_opt.compression_per_level.size(), 7U);
   ASSERT_EQ(new_cf_opt.compression_per_level[0], kNoCompression);
   ASSERT_EQ(new_cf_opt.compression_per_level[1], kSnappyCompression);
   ASSERT_EQ(new_cf_opt.compression_per_level[2], kZlibCompression);
   ASSERT_EQ(new_cf_opt.compression_per_level[3], kBZip2Compression);
   ASSERT_EQ(new_cf_opt.compression_per_level[4], kLZ4Compression);
   ASSERT_EQ(new_cf_opt.compression_per_level[5], kLZ4HCCompression);
+  ASSERT_EQ(new_cf_opt.compression_per_level[6], kZSTD);
   ASSERT_EQ(new_cf_opt.compression_opts.window_bits, 4);
   ASSERT_EQ(new_cf_opt.compression_opts.level, 5);
   ASSERT_EQ(new_cf_opt.compression_opts.strategy, 6);
+  ASSERT_EQ(new_cf_opt.compression_opts.max_dict_bytes, 7U);
+  ASSERT_EQ(new_cf_opt.compression_opts.parallel_threads, 8U);
   ASSERT_EQ(new_cf_opt.num_levels, 7);
   ASSERT_EQ(new_cf_opt.level0_file_num_compaction_trigger, 8);
   ASSERT_EQ(new_cf_opt.level0_slowdown_writes_trigger, 9);
@@ -228,9 +238,12 @@ TEST(OptionsTest, GetOptionsFromMapTest) {
   ASSERT_EQ(new_cf_opt.memtable_prefix_bloom_huge_page_tlb_size, 28U);
   ASSERT_EQ(new_cf_opt.bloom_locality, 29U);
   ASSERT_EQ(new_cf_opt.max_successive_merges, 30U);
+  ASSERT_EQ(new_cf_opt.merge_write_back_threshold, 8U);
   ASSERT_EQ(new_cf_opt.min_partial_merge_operands, 31U);
   ASSERT_TRUE(new_cf_opt.prefix_extractor != nullptr);
   ASSERT_EQ(new_cf_opt.optimize_filters_for_hits, true);
+  ASSERT_EQ(new_cf_opt.min_blob_size, 32U);
+  ASSERT_EQ(new_cf_opt.blob_gc_discard_ratio, 0.25);
   ASSERT_EQ(std::string(new_cf_opt.prefix_extractor->Name()),
             "rocksdb.FixedPrefix.31");
 
@@ -273,10 +286,13 @@ TEST(OptionsTest, GetOptionsFromMapTest) {
   ASSERT_EQ(new_db_opt.allow_os_buffer, false);
   ASSERT_EQ(new_db_opt.allow_mmap_reads, true);
   ASSERT_EQ(new_db_opt.allow_mmap_writes, false);
+  ASSERT_EQ(new_db_opt.use_direct_reads, false);
+  ASSERT_EQ(new_db_opt.use_direct_io_for_flush_and_compaction, true);
   ASSERT_EQ(new_db_opt.is_fd_close_on_exec, true);
   ASSERT_EQ(new_db_opt.skip_log_error_on_recovery, false);
   ASSERT_EQ(new_db_opt.stats_dump_period_sec, 46U);
   ASSERT_EQ(new_db_opt.advise_random_on_open, true);
+  ASSERT_EQ(new_db_opt.compaction_readahead_size, 2097152U);
   ASSERT_EQ(new_db_opt.use_adaptive_mutex, false);
   ASSERT_EQ(new_db_opt.bytes_per_sync, static_cast<uint64_t>(47));
 }
@@ -422,6 +438,8 @@ TEST(OptionsTest, GetBlockBasedTableOptionsFromString) {
             "checksum=kxxHash;hash_index_allow_collision=1;no_block_cache=1;"
             "block_cache=1M;block_cache_compressed=1k;block_size=1024;"
             "block_size_deviation=8;block_restart_interval=4;"
+            "use_delta_encoding=0;index_block_restart_interval=8;"
+            "max_auto_readahead_size=0;"
             "filter_policy=bloomfilter:4:true;whole_key_filtering=1",
             &new_opt));
   ASSERT_TRUE(new_opt.cache_index_and_filter_blocks);
@@ -436,6 +454,9 @@ TEST(OptionsTest, GetBlockBasedTableOptionsFromString) {
   ASSERT_EQ(new_opt.block_size, 1024UL);
   ASSERT_EQ(new_opt.block_size_deviation, 8);
   ASSERT_EQ(new_opt.block_restart_interval, 4);
+  ASSERT_TRUE(!new_opt.use_delta_encoding);
+  ASSERT_EQ(new_opt.index_block_restart_interval, 8);
+  ASSERT_EQ(new_opt.max_auto_readahead_size, 0U);
   ASSERT_TRUE(new_opt.filter_policy != nullptr);
 
   // unknown option
@@ -444,6 +465,10 @@ TEST(OptionsTest, GetBlockBasedTableOptionsFromString) {
              "bad_option=1",
              &new_opt));
 
+  ASSERT_OK(GetBlockBasedTableOptionsFromString(table_opt,
+            "index_type=kLearnedSearch", &new_opt));
+  ASSERT_EQ(new_opt.index_type, BlockBasedTableOptions::kLearnedSearch);
+
   // unrecognized index type
   ASSERT_NOK(GetBlockBasedTableOptionsFromString(table_opt,
              "cache_index_and_filter_blocks=1;index_type=kBinarySearchXX",
@@ -464,6 +489,11 @@ TEST(OptionsTest, GetBlockBasedTableOptionsFromString) {
              "cache_index_and_filter_blocks=1;"
              "filter_policy=bloomfilter:4",
              &new_opt));
+  // full filter format version
+  new_opt.filter_policy.reset();
+  ASSERT_OK(GetBlockBasedTableOptionsFromString(table_opt,
+            "filter_policy=bloomfilter:10:false:1", &new_opt));
+  ASSERT_TRUE(new_opt.filter_policy != nullptr);
 }
 #endif  // !ROCKSDB_LITE
 
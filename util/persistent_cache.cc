@@ -0,0 +1,623 @@
+//  Copyright (c) 2013, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include "rocksdb/persistent_cache.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "rocksdb/env.h"
+#include "port/port.h"
+#include "util/coding.h"
+#include "util/crc32c.h"
+#include "util/logging.h"
+#include "util/mutexlock.h"
+
+namespace rocksdb {
+
+namespace {
+
+// Every cache file is a sequence of records:
+//
+//    checksum: fixed32  (masked crc32c of the rest of the record)
+//    key size: fixed32
+//    value size: fixed32
+//    key: char[key size]
+//    value: char[value size]
+//
+// Records are only ever appended. A record that was torn by a crash fails
+// its checksum; everything from there to the end of that file is ignored
+// when the cache is reopened.
+const size_t kRecordHeaderSize = 12;
+const char* kCacheFileSuffix = ".pcache";
+
+// Records waiting for the background writer are kept in memory, up to this
+// many bytes. Inserts beyond that are dropped.
+const uint64_t kMaxPendingBytes = 4 << 20;
+
+std::string CacheFileName(const std::string& path, uint64_t number) {
+  char buf[100];
+  snprintf(buf, sizeof(buf), "/%06" PRIu64 "%s", number, kCacheFileSuffix);
+  return path + buf;
+}
+
+bool ParseCacheFileName(const std::string& fname, uint64_t* number) {
+  const std::string suffix(kCacheFileSuffix);
+  if (fname.size() <= suffix.size() ||
+      fname.compare(fname.size() - suffix.size(), suffix.size(), suffix) !=
+          0) {
+    return false;
+  }
+  Slice rest(fname.data(), fname.size() - suffix.size());
+  uint64_t num = 0;
+  if (!ConsumeDecimalNumber(&rest, &num) || !rest.empty()) {
+    return false;
+  }
+  *number = num;
+  return true;
+}
+
+// Check the record in "record" and return its key and value on success.
+bool DecodeRecord(const Slice& record, Slice* key, Slice* value) {
+  if (record.size() < kRecordHeaderSize) {
+    return false;
+  }
+  const char* p = record.data();
+  const uint32_t key_size = DecodeFixed32(p + 4);
+  const uint32_t value_size = DecodeFixed32(p + 8);
+  if (record.size() - kRecordHeaderSize <
+      static_cast<uint64_t>(key_size) + value_size) {
+    return false;
+  }
+  const size_t payload = kRecordHeaderSize - 4 + key_size + value_size;
+  if (crc32c::Unmask(DecodeFixed32(p)) != crc32c::Value(p + 4, payload)) {
+    return false;
+  }
+  *key = Slice(p + kRecordHeaderSize, key_size);
+  *value = Slice(p + kRecordHeaderSize + key_size, value_size);
+  return true;
+}
+
+// Insert() only queues the record; a job in the LOW priority pool of the
+// Env appends queued records to the current cache file, so neither the
+// thread that evicted the block nor Lookup() waits for the device. Records
+// become visible in the index once they are flushed, and are served from
+// the queue until then.
+//
+// The job holds a reference to the cache, since it may only run after the
+// cache was closed, in which case it does nothing.
+class PersistentCacheImpl
+    : public PersistentCache,
+      public std::enable_shared_from_this<PersistentCacheImpl> {
+ public:
+  PersistentCacheImpl(Env* env, const std::string& path, uint64_t capacity,
+                      const std::shared_ptr<Logger>& info_log)
+      : env_(env),
+        path_(path),
+        capacity_(capacity),
+        // Eviction drops a whole file, so keep files small compared to the
+        // capacity.
+        max_file_size_(std::max<uint64_t>(capacity / 16, 4096)),
+        info_log_(info_log),
+        bg_cv_(&mutex_),
+        next_file_number_(1),
+        usage_(0),
+        pending_bytes_(0),
+        bg_scheduled_(false),
+        bg_running_(false),
+        closing_(false),
+        writer_size_(0),
+        writer_number_(0) {
+    env_options_.use_mmap_writes = false;
+  }
+
+  // Rebuild the index from the cache files found under path_.
+  Status Recover();
+
+  // Write the queued records and sync the current file. Nothing is written
+  // after this.
+  void Close();
+
+  virtual Status Insert(const Slice& key, const char* data,
+                        const size_t size) override;
+
+  virtual Status Lookup(const Slice& key, std::unique_ptr<char[]>* data,
+                        size_t* size) override;
+
+  virtual uint64_t GetCapacity() const override { return capacity_; }
+
+  virtual uint64_t GetUsage() const override {
+    MutexLock l(&mutex_);
+    return usage_;
+  }
+
+ private:
+  struct Location {
+    uint64_t file_number;
+    uint64_t offset;
+    uint64_t size;  // size of the whole record
+  };
+
+  struct CacheFile {
+    uint64_t size = 0;
+    std::shared_ptr<RandomAccessFile> reader;
+    // Keys of the records in the file, used to clean up the index when
+    // the file is evicted.
+    std::vector<std::string> keys;
+  };
+
+  static void BGWorkWrite(void* arg);
+  void BackgroundWrite();
+  // Append the queued records to the cache files and add them to the
+  // index, until the queue is empty. Releases mutex_ while writing.
+  // REQUIRES: mutex_ held, and no other thread in WritePending()
+  void WritePending();
+  // Sync and close the file being written, if any. Called without mutex_,
+  // by the only thread that writes.
+  Status FinishCacheFile();
+
+  Status ScanFile(uint64_t number, CacheFile* file);
+  // Start a new file for subsequent writes.
+  // REQUIRES: mutex_ held
+  Status NewCacheFile();
+  // Drop the oldest files until the usage is within the capacity.
+  // REQUIRES: mutex_ held
+  void EvictFiles();
+  // REQUIRES: mutex_ held
+  void EvictFile(std::map<uint64_t, CacheFile>::iterator file);
+
+  Env* const env_;
+  const std::string path_;
+  const uint64_t capacity_;
+  const uint64_t max_file_size_;
+  std::shared_ptr<Logger> info_log_;
+  EnvOptions env_options_;
+
+  // mutex_ protects the following state.
+  mutable port::Mutex mutex_;
+  port::CondVar bg_cv_;
+  std::unordered_map<std::string, Location> index_;
+  // Ordered by file number, so the first one is the oldest. The last one is
+  // the file written by writer_, if there is one.
+  std::map<uint64_t, CacheFile> files_;
+  uint64_t next_file_number_;
+  uint64_t usage_;
+  // Records not written yet, by key, and their keys in insertion order
+  std::unordered_map<std::string, std::string> pending_;
+  std::deque<std::string> queue_;
+  uint64_t pending_bytes_;
+  bool bg_scheduled_;
+  bool bg_running_;
+  bool closing_;
+
+  // Only used by the thread in WritePending(), without mutex_
+  std::unique_ptr<WritableFile> writer_;
+  uint64_t writer_size_;
+  // The file written by writer_, 0 if none. Also read by EvictFiles().
+  uint64_t writer_number_;
+};
+
+Status PersistentCacheImpl::ScanFile(uint64_t number, CacheFile* file) {
+  const std::string fname = CacheFileName(path_, number);
+  uint64_t file_size = 0;
+  Status s = env_->GetFileSize(fname, &file_size);
+  unique_ptr<RandomAccessFile> reader;
+  if (s.ok()) {
+    s = env_->NewRandomAccessFile(fname, &reader, env_options_);
+  }
+  if (!s.ok()) {
+    return s;
+  }
+
+  std::string buf;
+  uint64_t offset = 0;
+  while (offset + kRecordHeaderSize <= file_size) {
+    char header[kRecordHeaderSize];
+    Slice result;
+    s = reader->Read(offset, kRecordHeaderSize, &result, header);
+    if (!s.ok() || result.size() != kRecordHeaderSize) {
+      break;
+    }
+    const uint64_t record_size = kRecordHeaderSize +
+                                 DecodeFixed32(result.data() + 4) +
+                                 DecodeFixed32(result.data() + 8);
+    if (offset + record_size > file_size) {
+      break;
+    }
+    buf.resize(record_size);
+    s = reader->Read(offset, record_size, &result, &buf[0]);
+    Slice key, value;
+    if (!s.ok() || result.size() != record_size ||
+        !DecodeRecord(result, &key, &value)) {
+      break;
+    }
+    // Later records win; the same key can be written again after a torn
+    // record was dropped.
+    auto old = index_.find(key.ToString());
+    if (old != index_.end()) {
+      old->second = {number, offset, record_size};
+    } else {
+      index_.insert({key.ToString(), {number, offset, record_size}});
+    }
+    file->keys.push_back(key.ToString());
+    offset += record_size;
+  }
+  if (offset < file_size) {
+    Log(InfoLogLevel::WARN_LEVEL, info_log_,
+        "Persistent cache file %s: ignoring %" PRIu64
+        " bytes of torn or corrupted records",
+        fname.c_str(), file_size - offset);
+  }
+  file->size = file_size;
+  file->reader.reset(reader.release());
+  return Status::OK();
+}
+
+Status PersistentCacheImpl::Recover() {
+  MutexLock l(&mutex_);
+  Status s = env_->CreateDirIfMissing(path_);
+  if (!s.ok()) {
+    return s;
+  }
+  std::vector<std::string> children;
+  s = env_->GetChildren(path_, &children);
+  if (!s.ok()) {
+    return s;
+  }
+  std::vector<uint64_t> numbers;
+  for (const auto& child : children) {
+    uint64_t number;
+    if (ParseCacheFileName(child, &number)) {
+      numbers.push_back(number);
+    }
+  }
+  std::sort(numbers.begin(), numbers.end());
+  for (uint64_t number : numbers) {
+    CacheFile file;
+    s = ScanFile(number, &file);
+    if (!s.ok()) {
+      return s;
+    }
+    usage_ += file.size;
+    files_[number] = std::move(file);
+    next_file_number_ = number + 1;
+  }
+  EvictFiles();
+  Log(InfoLogLevel::INFO_LEVEL, info_log_,
+      "Opened persistent cache %s: %" PRIu64 " files, %" PRIu64
+      " entries, %" PRIu64 " bytes",
+      path_.c_str(), static_cast<uint64_t>(files_.size()),
+      static_cast<uint64_t>(index_.size()), usage_);
+  return Status::OK();
+}
+
+void PersistentCacheImpl::Close() {
+  MutexLock l(&mutex_);
+  closing_ = true;
+  while (bg_running_) {
+    bg_cv_.Wait();
+  }
+  WritePending();
+  mutex_.Unlock();
+  Status s = FinishCacheFile();
+  mutex_.Lock();
+  if (!s.ok()) {
+    Log(InfoLogLevel::WARN_LEVEL, info_log_,
+        "Persistent cache: closing the last file failed: %s",
+        s.ToString().c_str());
+  }
+  writer_number_ = 0;
+}
+
+Status PersistentCacheImpl::FinishCacheFile() {
+  if (!writer_) {
+    return Status::OK();
+  }
+  // Sync, so that a file that is not written any more survives a crash
+  // completely
+  Status s = writer_->Sync();
+  if (s.ok()) {
+    s = writer_->Close();
+  }
+  writer_.reset();
+  return s;
+}
+
+Status PersistentCacheImpl::NewCacheFile() {
+  const uint64_t number = next_file_number_++;
+  const std::string fname = CacheFileName(path_, number);
+  unique_ptr<WritableFile> writer;
+  Status s = env_->NewWritableFile(fname, &writer, env_options_);
+  unique_ptr<RandomAccessFile> reader;
+  if (s.ok()) {
+    s = env_->NewRandomAccessFile(fname, &reader, env_options_);
+  }
+  if (!s.ok()) {
+    return s;
+  }
+  writer_ = std::move(writer);
+  writer_size_ = 0;
+  writer_number_ = number;
+  files_[number].reader.reset(reader.release());
+  return Status::OK();
+}
+
+void PersistentCacheImpl::EvictFile(
+    std::map<uint64_t, CacheFile>::iterator file) {
+  for (const auto& key : file->second.keys) {
+    auto it = index_.find(key);
+    if (it != index_.end() && it->second.file_number == file->first) {
+      index_.erase(it);
+    }
+  }
+  usage_ -= file->second.size;
+  // Readers that picked up the file before keep their own handle to it.
+  env_->DeleteFile(CacheFileName(path_, file->first));
+  files_.erase(file);
+}
+
+void PersistentCacheImpl::EvictFiles() {
+  while (usage_ > capacity_ && !files_.empty()) {
+    auto oldest = files_.begin();
+    if (oldest->first == writer_number_) {
+      // Never evict the file that is being written.
+      break;
+    }
+    EvictFile(oldest);
+  }
+}
+
+void PersistentCacheImpl::BGWorkWrite(void* arg) {
+  std::unique_ptr<std::shared_ptr<PersistentCacheImpl>> cache(
+      reinterpret_cast<std::shared_ptr<PersistentCacheImpl>*>(arg));
+  (*cache)->BackgroundWrite();
+}
+
+void PersistentCacheImpl::BackgroundWrite() {
+  MutexLock l(&mutex_);
+  bg_scheduled_ = false;
+  if (closing_) {
+    // Close() wrote the queue
+    return;
+  }
+  bg_running_ = true;
+  WritePending();
+  bg_running_ = false;
+  bg_cv_.SignalAll();
+}
+
+void PersistentCacheImpl::WritePending() {
+  mutex_.AssertHeld();
+  while (!queue_.empty()) {
+    // Elements of pending_ stay where they are while other keys are
+    // inserted, and only this thread removes them.
+    std::vector<std::pair<const std::string*, const std::string*>> batch;
+    for (const auto& key : queue_) {
+      auto it = pending_.find(key);
+      batch.emplace_back(&it->first, &it->second);
+    }
+    queue_.clear();
+
+    std::vector<Location> written;
+    Status s;
+    for (const auto& entry : batch) {
+      const std::string& record = *entry.second;
+      if (!writer_ || writer_size_ + record.size() > max_file_size_) {
+        mutex_.Unlock();
+        s = FinishCacheFile();
+        mutex_.Lock();
+        writer_number_ = 0;
+        if (s.ok()) {
+          s = NewCacheFile();
+        }
+        if (!s.ok()) {
+          break;
+        }
+      }
+      mutex_.Unlock();
+      s = writer_->Append(record);
+      mutex_.Lock();
+      if (!s.ok()) {
+        // The file may now end with a partial record; stop writing to it.
+        writer_.reset();
+        writer_number_ = 0;
+        break;
+      }
+      written.push_back({writer_number_, writer_size_, record.size()});
+      writer_size_ += record.size();
+    }
+    if (s.ok() && writer_) {
+      mutex_.Unlock();
+      s = writer_->Flush();
+      mutex_.Lock();
+    }
+    if (!s.ok()) {
+      Log(InfoLogLevel::WARN_LEVEL, info_log_,
+          "Persistent cache: writing blocks failed: %s",
+          s.ToString().c_str());
+      written.clear();
+    }
+
+    for (size_t i = 0; i < batch.size(); i++) {
+      const std::string& key = *batch[i].first;
+      if (i < written.size()) {
+        const Location& loc = written[i];
+        CacheFile& file = files_[loc.file_number];
+        index_[key] = loc;
+        file.keys.push_back(key);
+        file.size += loc.size;
+        usage_ += loc.size;
+      }
+      pending_bytes_ -= batch[i].second->size();
+      pending_.erase(key);
+    }
+    EvictFiles();
+  }
+}
+
+Status PersistentCacheImpl::Insert(const Slice& key, const char* data,
+                                   const size_t size) {
+  const uint64_t record_size = kRecordHeaderSize + key.size() + size;
+  if (record_size > max_file_size_) {
+    return Status::InvalidArgument("Entry too large for persistent cache");
+  }
+  std::string record;
+  record.reserve(record_size);
+  PutFixed32(&record, 0);
+  PutFixed32(&record, static_cast<uint32_t>(key.size()));
+  PutFixed32(&record, static_cast<uint32_t>(size));
+  record.append(key.data(), key.size());
+  record.append(data, size);
+  EncodeFixed32(&record[0], crc32c::Mask(crc32c::Value(
+                                record.data() + 4, record.size() - 4)));
+
+  std::string key_str = key.ToString();
+  MutexLock l(&mutex_);
+  if (index_.find(key_str) != index_.end() ||
+      pending_.find(key_str) != pending_.end()) {
+    return Status::OK();
+  }
+  if (pending_bytes_ > 0 && pending_bytes_ + record_size > kMaxPendingBytes) {
+    // The device does not keep up; the block is simply not cached.
+    return Status::Incomplete("Persistent cache write queue is full");
+  }
+  pending_.insert({key_str, std::move(record)});
+  queue_.push_back(std::move(key_str));
+  pending_bytes_ += record_size;
+  if (!bg_scheduled_ && !bg_running_) {
+    bg_scheduled_ = true;
+    env_->Schedule(&PersistentCacheImpl::BGWorkWrite,
+                   new std::shared_ptr<PersistentCacheImpl>(shared_from_this()),
+                   Env::LOW);
+  }
+  return Status::OK();
+}
+
+Status PersistentCacheImpl::Lookup(const Slice& key,
+                                   std::unique_ptr<char[]>* data,
+                                   size_t* size) {
+  Location loc;
+  std::shared_ptr<RandomAccessFile> reader;
+  {
+    MutexLock l(&mutex_);
+    const std::string key_str = key.ToString();
+    auto pending = pending_.find(key_str);
+    if (pending != pending_.end()) {
+      const size_t value_offset = kRecordHeaderSize + key.size();
+      *size = pending->second.size() - value_offset;
+      data->reset(new char[*size]);
+      memcpy(data->get(), pending->second.data() + value_offset, *size);
+      return Status::OK();
+    }
+    auto it = index_.find(key_str);
+    if (it == index_.end()) {
+      return Status::NotFound("");
+    }
+    loc = it->second;
+    reader = files_[loc.file_number].reader;
+  }
+
+  // Read the header and the key, then the value into the returned buffer
+  const size_t value_offset = kRecordHeaderSize + key.size();
+  const size_t value_size =
+      static_cast<size_t>(loc.size - std::min<uint64_t>(loc.size, value_offset));
+  std::string head(value_offset, '\0');
+  std::unique_ptr<char[]> value(new char[value_size]);
+  Slice head_result, value_result;
+  Status s = reader->Read(loc.offset, value_offset, &head_result, &head[0]);
+  if (s.ok() && value_size > 0) {
+    s = reader->Read(loc.offset + value_offset, value_size, &value_result,
+                     value.get());
+  }
+  if (s.ok()) {
+    const char* p = head_result.data();
+    if (head_result.size() != value_offset ||
+        value_result.size() != value_size ||
+        DecodeFixed32(p + 4) != key.size() ||
+        DecodeFixed32(p + 8) != value_size ||
+        Slice(p + kRecordHeaderSize, key.size()) != key ||
+        crc32c::Unmask(DecodeFixed32(p)) !=
+            crc32c::Extend(crc32c::Value(p + 4, value_offset - 4),
+                           value_result.data(), value_size)) {
+      s = Status::Corruption("Persistent cache record mismatch");
+    }
+  }
+  if (!s.ok()) {
+    Log(InfoLogLevel::WARN_LEVEL, info_log_,
+        "Persistent cache lookup failed: %s", s.ToString().c_str());
+    MutexLock l(&mutex_);
+    auto it = index_.find(key.ToString());
+    if (it != index_.end() && it->second.file_number == loc.file_number &&
+        it->second.offset == loc.offset) {
+      index_.erase(it);
+    }
+    return s;
+  }
+
+  if (value_result.data() != value.get()) {
+    // e.g. mmap reads, which do not use the scratch buffer
+    memcpy(value.get(), value_result.data(), value_size);
+  }
+  *data = std::move(value);
+  *size = value_size;
+  return Status::OK();
+}
+
+// What NewPersistentCache() returns. Closes the cache when the last user
+// is done with it, while a queued write job may still hold the cache.
+class PersistentCacheHandle : public PersistentCache {
+ public:
+  explicit PersistentCacheHandle(
+      const std::shared_ptr<PersistentCacheImpl>& impl)
+      : impl_(impl) {}
+
+  virtual ~PersistentCacheHandle() { impl_->Close(); }
+
+  virtual Status Insert(const Slice& key, const char* data,
+                        const size_t size) override {
+    return impl_->Insert(key, data, size);
+  }
+
+  virtual Status Lookup(const Slice& key, std::unique_ptr<char[]>* data,
+                        size_t* size) override {
+    return impl_->Lookup(key, data, size);
+  }
+
+  virtual uint64_t GetCapacity() const override {
+    return impl_->GetCapacity();
+  }
+
+  virtual uint64_t GetUsage() const override { return impl_->GetUsage(); }
+
+ private:
+  std::shared_ptr<PersistentCacheImpl> impl_;
+};
+
+}  // namespace
+
+Status NewPersistentCache(Env* env, const std::string& path, uint64_t size,
+                          const std::shared_ptr<Logger>& info_log,
+                          std::shared_ptr<PersistentCache>* cache) {
+  std::shared_ptr<PersistentCacheImpl> impl(
+      new PersistentCacheImpl(env, path, size, info_log));
+  Status s = impl->Recover();
+  if (s.ok()) {
+    cache->reset(new PersistentCacheHandle(impl));
+  }
+  return s;
+}
+
+}  // namespace rocksdb
@@ -0,0 +1,232 @@
+//  Copyright (c) 2013, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "rocksdb/persistent_cache.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rocksdb/env.h"
+#include "util/testharness.h"
+#include "util/testutil.h"
+
+namespace rocksdb {
+
+// Holds the jobs the cache schedules until the test runs them.
+class ManualScheduleEnv : public EnvWrapper {
+ public:
+  explicit ManualScheduleEnv(Env* base) : EnvWrapper(base) {}
+
+  virtual void Schedule(void (*function)(void*), void* arg,
+                        Priority pri) override {
+    jobs_.push_back(std::make_pair(function, arg));
+  }
+
+  size_t NumScheduled() const { return jobs_.size(); }
+
+  void RunScheduled() {
+    std::vector<std::pair<void (*)(void*), void*>> jobs;
+    jobs.swap(jobs_);
+    for (const auto& job : jobs) {
+      job.first(job.second);
+    }
+  }
+
+ private:
+  std::vector<std::pair<void (*)(void*), void*>> jobs_;
+};
+
+class PersistentCacheTest {
+ public:
+  Env* env_;
+  std::string path_;
+  std::shared_ptr<PersistentCache> cache_;
+
+  PersistentCacheTest() : env_(Env::Default()) {
+    path_ = test::TmpDir() + "/persistent_cache_test";
+    Destroy();
+  }
+
+  ~PersistentCacheTest() {
+    cache_.reset();
+    Destroy();
+  }
+
+  void Destroy() {
+    std::vector<std::string> children;
+    env_->GetChildren(path_, &children);
+    for (const auto& child : children) {
+      env_->DeleteFile(path_ + "/" + child);
+    }
+    env_->DeleteDir(path_);
+  }
+
+  void Open(uint64_t size) {
+    cache_.reset();
+    ASSERT_OK(NewPersistentCache(env_, path_, size, nullptr, &cache_));
+  }
+
+  Status Insert(const std::string& key, const std::string& value) {
+    return cache_->Insert(key, value.data(), value.size());
+  }
+
+  std::string Lookup(const std::string& key) {
+    std::unique_ptr<char[]> data;
+    size_t size = 0;
+    Status s = cache_->Lookup(key, &data, &size);
+    if (s.IsNotFound()) {
+      return "NOT_FOUND";
+    }
+    if (!s.ok()) {
+      return s.ToString();
+    }
+    return std::string(data.get(), size);
+  }
+
+  std::string Value(int i, size_t size) {
+    Random rnd(i);
+    std::string value;
+    test::RandomString(&rnd, static_cast<int>(size), &value);
+    return value;
+  }
+};
+
+TEST(PersistentCacheTest, InsertAndLookup) {
+  Open(1 << 20);
+  ASSERT_EQ("NOT_FOUND", Lookup("a"));
+  ASSERT_OK(Insert("a", "va"));
+  ASSERT_OK(Insert("b", ""));
+  ASSERT_EQ("va", Lookup("a"));
+  ASSERT_EQ("", Lookup("b"));
+
+  // Inserting an existing key keeps the first value.
+  ASSERT_OK(Insert("a", "va2"));
+  ASSERT_EQ("va", Lookup("a"));
+  ASSERT_EQ(1U << 20, cache_->GetCapacity());
+
+  // Entries larger than a cache file are refused.
+  ASSERT_TRUE(Insert("big", Value(0, 1 << 20)).IsInvalidArgument());
+  ASSERT_EQ("NOT_FOUND", Lookup("big"));
+}
+
+TEST(PersistentCacheTest, Recovery) {
+  Open(1 << 20);
+  for (int i = 0; i < 100; i++) {
+    ASSERT_OK(Insert(std::to_string(i), Value(i, 1000)));
+  }
+  // Closing the cache writes what is still queued.
+  Open(1 << 20);
+  uint64_t usage = cache_->GetUsage();
+  ASSERT_GT(usage, 0U);
+
+  Open(1 << 20);
+  ASSERT_EQ(usage, cache_->GetUsage());
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ(Value(i, 1000), Lookup(std::to_string(i)));
+  }
+  // New entries go to a new file next to the recovered ones.
+  ASSERT_OK(Insert("new", "value"));
+  Open(1 << 20);
+  ASSERT_EQ("value", Lookup("new"));
+  ASSERT_EQ(Value(7, 1000), Lookup("7"));
+}
+
+TEST(PersistentCacheTest, Eviction) {
+  const uint64_t kCapacity = 64 << 10;
+  Open(kCapacity);
+  const int kNumEntries = 1000;
+  for (int i = 0; i < kNumEntries; i++) {
+    ASSERT_OK(Insert(std::to_string(i), Value(i, 500)));
+    // Usage can exceed the capacity by no more than the file being written.
+    ASSERT_LE(cache_->GetUsage(), kCapacity + kCapacity / 16);
+  }
+  ASSERT_EQ(Value(kNumEntries - 1, 500),
+            Lookup(std::to_string(kNumEntries - 1)));
+
+  // Oldest entries are gone once everything is written, newest ones are
+  // still there.
+  Open(kCapacity);
+  ASSERT_LE(cache_->GetUsage(), kCapacity + kCapacity / 16);
+  ASSERT_EQ("NOT_FOUND", Lookup("0"));
+  ASSERT_EQ(Value(kNumEntries - 1, 500),
+            Lookup(std::to_string(kNumEntries - 1)));
+}
+
+TEST(PersistentCacheTest, TornRecord) {
+  Open(1 << 20);
+  ASSERT_OK(Insert("a", "va"));
+  ASSERT_OK(Insert("b", "vb"));
+  cache_.reset();
+
+  // Chop the last record in half, as a crash in the middle of a write would.
+  std::vector<std::string> children;
+  ASSERT_OK(env_->GetChildren(path_, &children));
+  std::string fname;
+  for (const auto& child : children) {
+    if (child != "." && child != "..") {
+      fname = path_ + "/" + child;
+    }
+  }
+  ASSERT_TRUE(!fname.empty());
+  uint64_t file_size = 0;
+  ASSERT_OK(env_->GetFileSize(fname, &file_size));
+  std::string contents;
+  ASSERT_OK(ReadFileToString(env_, fname, &contents));
+  contents.resize(static_cast<size_t>(file_size - 3));
+  ASSERT_OK(WriteStringToFile(env_, contents, fname));
+
+  Open(1 << 20);
+  ASSERT_EQ("va", Lookup("a"));
+  ASSERT_EQ("NOT_FOUND", Lookup("b"));
+  ASSERT_OK(Insert("b", "vb"));
+  ASSERT_EQ("vb", Lookup("b"));
+}
+
+TEST(PersistentCacheTest, WriteQueue) {
+  ManualScheduleEnv env(env_);
+  cache_.reset();
+  ASSERT_OK(NewPersistentCache(&env, path_, 64 << 20, nullptr, &cache_));
+
+  // Queued entries are served from memory before they are written, by a
+  // single job.
+  ASSERT_OK(Insert("a", "va"));
+  ASSERT_OK(Insert("b", "vb"));
+  ASSERT_EQ(1U, env.NumScheduled());
+  ASSERT_EQ("va", Lookup("a"));
+  ASSERT_EQ(0U, cache_->GetUsage());
+
+  // The queue is bounded; entries that do not fit are dropped.
+  int i = 0;
+  for (;; i++) {
+    Status s = Insert(std::to_string(i), Value(i, 64 << 10));
+    if (!s.ok()) {
+      ASSERT_TRUE(s.IsIncomplete());
+      break;
+    }
+  }
+  ASSERT_GT(i, 0);
+  ASSERT_EQ("NOT_FOUND", Lookup(std::to_string(i)));
+
+  env.RunScheduled();
+  ASSERT_GT(cache_->GetUsage(), 0U);
+  ASSERT_EQ("vb", Lookup("b"));
+  ASSERT_EQ(Value(i - 1, 64 << 10), Lookup(std::to_string(i - 1)));
+  ASSERT_OK(Insert(std::to_string(i), Value(i, 64 << 10)));
+
+  // Closing the cache writes the queue; the job that is still scheduled
+  // does nothing when it runs afterwards.
+  ASSERT_EQ(1U, env.NumScheduled());
+  cache_.reset();
+  env.RunScheduled();
+  Open(64 << 20);
+  ASSERT_EQ(Value(i, 64 << 10), Lookup(std::to_string(i)));
+}
+
+}  // namespace rocksdb
+
+int main(int argc, char** argv) {
+  return rocksdb::test::RunAllTests();
+}
@@ -0,0 +1,105 @@
+//  Copyright (c) 2013, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "util/readahead_file.h"
+
+#include <string.h>
+#include <algorithm>
+
+namespace rocksdb {
+
+ReadaheadRandomAccessFile::ReadaheadRandomAccessFile(
+    RandomAccessFile* file, uint64_t file_size, size_t init_readahead_size,
+    size_t max_readahead_size, int num_sequential_reads)
+    : file_(file),
+      init_readahead_size_(std::min(init_readahead_size, max_readahead_size)),
+      max_readahead_size_(max_readahead_size),
+      num_sequential_reads_for_readahead_(num_sequential_reads),
+      readahead_limit_(file_size),
+      buffer_capacity_(0),
+      buffer_offset_(0),
+      buffer_len_(0),
+      prev_end_(0),
+      num_sequential_reads_(0),
+      readahead_size_(init_readahead_size_) {}
+
+Status ReadaheadRandomAccessFile::Read(uint64_t offset, size_t n,
+                                       Slice* result, char* scratch) const {
+  if (scratch == nullptr) {
+    // The file returns its own memory, nothing to copy into
+    return file_->Read(offset, n, result, scratch);
+  }
+  if (offset >= buffer_offset_ && offset + n <= buffer_offset_ + buffer_len_) {
+    memcpy(scratch, buffer_.get() + (offset - buffer_offset_), n);
+    *result = Slice(scratch, n);
+    prev_end_ = offset + n;
+    return Status::OK();
+  }
+
+  if (offset == prev_end_) {
+    num_sequential_reads_++;
+  } else {
+    num_sequential_reads_ = 0;
+    readahead_size_ = init_readahead_size_;
+  }
+  prev_end_ = offset + n;
+  size_t read_size = 0;
+  if (num_sequential_reads_ >= num_sequential_reads_for_readahead_ &&
+      offset < readahead_limit_) {
+    read_size = static_cast<size_t>(
+        std::min<uint64_t>(readahead_size_, readahead_limit_ - offset));
+  }
+  if (n >= read_size) {
+    // Nothing to gain from the buffer
+    return file_->Read(offset, n, result, scratch);
+  }
+
+  if (read_size > buffer_capacity_) {
+    buffer_.reset(new char[read_size]);
+    buffer_capacity_ = read_size;
+  }
+  buffer_len_ = 0;
+  Slice data;
+  Status s = file_->Read(offset, read_size, &data, buffer_.get());
+  if (!s.ok()) {
+    return s;
+  }
+  if (data.data() != buffer_.get()) {
+    memcpy(buffer_.get(), data.data(), data.size());
+  }
+  buffer_offset_ = offset;
+  buffer_len_ = data.size();
+  readahead_size_ = std::min(readahead_size_ * 2, max_readahead_size_);
+
+  n = std::min(n, buffer_len_);
+  memcpy(scratch, buffer_.get(), n);
+  *result = Slice(scratch, n);
+  return Status::OK();
+}
+
+namespace {
+
+class OwningReadaheadRandomAccessFile : public ReadaheadRandomAccessFile {
+ public:
+  OwningReadaheadRandomAccessFile(std::unique_ptr<RandomAccessFile>&& file,
+                                  uint64_t file_size, size_t readahead_size)
+      : ReadaheadRandomAccessFile(file.get(), file_size, readahead_size,
+                                  readahead_size, 0),
+        owned_file_(std::move(file)) {}
+
+ private:
+  std::unique_ptr<RandomAccessFile> owned_file_;
+};
+
+}  // namespace
+
+std::unique_ptr<RandomAccessFile> NewReadaheadRandomAccessFile(
+    std::unique_ptr<RandomAccessFile>&& file, uint64_t file_size,
+    size_t readahead_size) {
+  return std::unique_ptr<RandomAccessFile>(new OwningReadaheadRandomAccessFile(
+      std::move(file), file_size, readahead_size));
+}
+
+}  // namespace rocksdb
@@ -0,0 +1,71 @@
+//  Copyright (c) 2013, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#pragma once
+#include <stdint.h>
+#include <memory>
+
+#include "rocksdb/env.h"
+
+namespace rocksdb {
+
+// Wraps a file that is read front to back. Once num_sequential_reads reads
+// in a row each started where the previous one ended, a read that is not
+// served from the buffer reads a window starting at its offset into the
+// buffer, from which the following reads are copied. The window starts at
+// init_readahead_size and doubles on every refill up to max_readahead_size;
+// a read elsewhere in the file, e.g. after a Seek(), resets it. Reads never
+// go past file_size, and reads without a scratch buffer (of mmaped files)
+// and reads as large as the window go to the file directly. Since the
+// buffer is our own, this does not depend on the OS page cache. Not thread
+// safe.
+class ReadaheadRandomAccessFile : public RandomAccessFile {
+ public:
+  // Does not take ownership of file
+  ReadaheadRandomAccessFile(RandomAccessFile* file, uint64_t file_size,
+                            size_t init_readahead_size,
+                            size_t max_readahead_size,
+                            int num_sequential_reads);
+
+  virtual Status Read(uint64_t offset, size_t n, Slice* result,
+                      char* scratch) const override;
+
+  virtual size_t GetUniqueId(char* id, size_t max_size) const override {
+    return file_->GetUniqueId(id, max_size);
+  }
+
+  virtual void Hint(AccessPattern pattern) override { file_->Hint(pattern); }
+
+  virtual Status InvalidateCache(size_t offset, size_t length) override {
+    return file_->InvalidateCache(offset, length);
+  }
+
+  // Read ahead no further than offset, e.g. the end of the data block that
+  // holds ReadOptions::iterate_upper_bound.
+  void SetReadaheadLimit(uint64_t offset) { readahead_limit_ = offset; }
+
+ private:
+  RandomAccessFile* file_;
+  const size_t init_readahead_size_;
+  const size_t max_readahead_size_;
+  const int num_sequential_reads_for_readahead_;
+  uint64_t readahead_limit_;
+  mutable std::unique_ptr<char[]> buffer_;
+  mutable size_t buffer_capacity_;
+  mutable uint64_t buffer_offset_;
+  mutable size_t buffer_len_;
+  mutable uint64_t prev_end_;
+  mutable int num_sequential_reads_;
+  mutable size_t readahead_size_;
+};
+
+// Wrap "file", of file_size bytes, so that every read that is not served
+// from the buffer reads readahead_size bytes starting at its offset. Meant
+// for a single user that goes through the whole file, e.g. a compaction.
+extern std::unique_ptr<RandomAccessFile> NewReadaheadRandomAccessFile(
+    std::unique_ptr<RandomAccessFile>&& file, uint64_t file_size,
+    size_t readahead_size);
+
+}  // namespace rocksdb
@@ -547,21 +547,22 @@ Status BackupEngineImpl::CreateNewBackup(DB* db, bool flush_before_backup) {
       assert(false);
       return Status::Corruption("Can't parse file name. This is very bad");
     }
-    // we should only get sst, manifest and current files here
-    assert(type == kTableFile || type == kDescriptorFile ||
-           type == kCurrentFile);
+    // we should only get sst, blob, manifest and current files here
+    assert(type == kTableFile || type == kBlobFile ||
+           type == kDescriptorFile || type == kCurrentFile);
 
     // rules:
-    // * if it's kTableFile, then it's shared
+    // * if it's kTableFile or kBlobFile, then it's shared
     // * if it's kDescriptorFile, limit the size to manifest_file_size
+    const bool table_or_blob = (type == kTableFile || type == kBlobFile);
     s = BackupFile(new_backup_id,
                    new_backup.get(),
-                   options_.share_table_files && type == kTableFile,
+                   options_.share_table_files && table_or_blob,
                    db->GetName(),            /* src_dir */
                    live_files[i],            /* src_fname */
                    rate_limiter.get(),
                    (type == kDescriptorFile) ? manifest_file_size : 0,
-                   options_.share_files_with_checksum && type == kTableFile);
+                   options_.share_files_with_checksum && table_or_blob);
   }
 
   // copy WAL files
@@ -93,17 +93,18 @@ Status CheckpointImpl::CreateCheckpoint(const std::string& checkpoint_dir) {
       s = Status::Corruption("Can't parse file name. This is very bad");
       break;
     }
-    // we should only get sst, manifest and current files here
-    assert(type == kTableFile || type == kDescriptorFile ||
-           type == kCurrentFile);
+    // we should only get sst, blob, manifest and current files here
+    assert(type == kTableFile || type == kBlobFile ||
+           type == kDescriptorFile || type == kCurrentFile);
     assert(live_files[i].size() > 0 && live_files[i][0] == '/');
     std::string src_fname = live_files[i];
 
     // rules:
-    // * if it's kTableFile, then it's shared
+    // * if it's kTableFile or kBlobFile, then it's shared
     // * if it's kDescriptorFile, limit the size to manifest_file_size
     // * always copy if cross-device link
-    if ((type == kTableFile) && same_fs) {
+    const bool shared = (type == kTableFile || type == kBlobFile);
+    if (shared && same_fs) {
       Log(db_->GetOptions().info_log, "Hard Linking %s", src_fname.c_str());
       s = db_->GetEnv()->LinkFile(db_->GetName() + src_fname,
                                   full_private_path + src_fname);
@@ -112,7 +113,7 @@ Status CheckpointImpl::CreateCheckpoint(const std::string& checkpoint_dir) {
         s = Status::OK();
       }
     }
-    if ((type != kTableFile) || (!same_fs)) {
+    if (!shared || !same_fs) {
       Log(db_->GetOptions().info_log, "Copying %s", src_fname.c_str());
       s = CopyFile(db_->GetEnv(), db_->GetName() + src_fname,
                    full_private_path + src_fname,
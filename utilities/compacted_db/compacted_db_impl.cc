@@ -5,9 +5,11 @@
 
 #ifndef ROCKSDB_LITE
 #include "utilities/compacted_db/compacted_db_impl.h"
+#include <algorithm>
 #include "db/db_impl.h"
 #include "db/version_set.h"
 #include "table/get_context.h"
+#include "rocksdb/comparator.h"
 
 namespace rocksdb {
 
@@ -23,9 +25,35 @@ CompactedDBImpl::CompactedDBImpl(
 CompactedDBImpl::~CompactedDBImpl() {
 }
 
+namespace {
+const size_t kFileLookupBuckets = 1 << 16;
+
+// The bucket of a key is made of the first two bytes of suffix, the key
+// without common_prefix_. Missing bytes count as zero, so the buckets of
+// keys are in the same order as the keys.
+inline size_t FileLookupBucket(const Slice& suffix) {
+  size_t bucket = 0;
+  if (suffix.size() > 0) {
+    bucket = static_cast<size_t>(static_cast<unsigned char>(suffix[0])) << 8;
+  }
+  if (suffix.size() > 1) {
+    bucket |= static_cast<unsigned char>(suffix[1]);
+  }
+  return bucket;
+}
+}  // namespace
+
 size_t CompactedDBImpl::FindFile(const Slice& key) {
   size_t left = 0;
   size_t right = files_.num_files - 1;
+  if (!file_lookup_.empty() && key.starts_with(common_prefix_)) {
+    size_t bucket = FileLookupBucket(
+        Slice(key.data() + common_prefix_.size(),
+              key.size() - common_prefix_.size()));
+    // Usually a single file, which then needs no key comparisons
+    left = std::min<size_t>(file_lookup_[bucket], right);
+    right = std::min<size_t>(file_lookup_[bucket + 1], right);
+  }
   while (left < right) {
     size_t mid = (left + right) >> 1;
     const FdWithKeyRange& f = files_.files[mid];
@@ -43,9 +71,22 @@ size_t CompactedDBImpl::FindFile(const Slice& key) {
 }
 
 Status CompactedDBImpl::Get(const ReadOptions& options,
-     ColumnFamilyHandle*, const Slice& key, std::string* value) {
+     ColumnFamilyHandle* column_family, const Slice& key, std::string* value) {
+  PinnableSlice pinnable_val(value);
+  Status s = Get(options, column_family, key, &pinnable_val);
+  if (s.ok() && pinnable_val.IsPinned()) {
+    value->assign(pinnable_val.data(), pinnable_val.size());
+  }
+  return s;
+}
+
+Status CompactedDBImpl::Get(const ReadOptions& options,
+     ColumnFamilyHandle*, const Slice& key, PinnableSlice* value) {
+  value->Reset();
+  BlobFetcher blob_fetcher(cfd_->blob_file_cache(), options);
   GetContext get_context(user_comparator_, nullptr, nullptr, nullptr,
-                         GetContext::kNotFound, key, value, nullptr, nullptr);
+                         GetContext::kNotFound, key, value, nullptr, nullptr,
+                         &blob_fetcher);
   LookupKey lkey(key, kMaxSequenceNumber);
   files_.files[FindFile(key)].fd.table_reader->Get(
       options, lkey.internal_key(), &get_context);
@@ -71,16 +112,21 @@ std::vector<Status> CompactedDBImpl::MultiGet(const ReadOptions& options,
   }
   std::vector<Status> statuses(keys.size(), Status::NotFound());
   values->resize(keys.size());
+  BlobFetcher blob_fetcher(cfd_->blob_file_cache(), options);
   int idx = 0;
   for (auto* r : reader_list) {
     if (r != nullptr) {
+      PinnableSlice pinnable_val(&(*values)[idx]);
       GetContext get_context(user_comparator_, nullptr, nullptr, nullptr,
-                             GetContext::kNotFound, keys[idx], &(*values)[idx],
-                             nullptr, nullptr);
+                             GetContext::kNotFound, keys[idx], &pinnable_val,
+                             nullptr, nullptr, &blob_fetcher);
       LookupKey lkey(keys[idx], kMaxSequenceNumber);
       r->Get(options, lkey.internal_key(), &get_context);
       if (get_context.State() == GetContext::kFound) {
         statuses[idx] = Status::OK();
+        if (pinnable_val.IsPinned()) {
+          (*values)[idx].assign(pinnable_val.data(), pinnable_val.size());
+        }
       }
     }
     ++idx;
@@ -116,6 +162,7 @@ Status CompactedDBImpl::Init(const Options& options) {
       return Status::NotSupported("Both L0 and other level contain files");
     }
     files_ = l0;
+    BuildFileLookup();
     return Status::OK();
   }
 
@@ -128,11 +175,43 @@ Status CompactedDBImpl::Init(const Options& options) {
   int level = vstorage->num_non_empty_levels() - 1;
   if (vstorage->LevelFilesBrief(level).num_files > 0) {
     files_ = vstorage->LevelFilesBrief(level);
+    BuildFileLookup();
     return Status::OK();
   }
   return Status::NotSupported("no file exists");
 }
 
+void CompactedDBImpl::BuildFileLookup() {
+  if (files_.num_files < 2 || user_comparator_ != BytewiseComparator()) {
+    return;
+  }
+  // All keys between the smallest and the largest key share their prefix
+  Slice smallest = ExtractUserKey(files_.files[0].smallest_key);
+  Slice largest =
+      ExtractUserKey(files_.files[files_.num_files - 1].largest_key);
+  size_t prefix_len = 0;
+  while (prefix_len < smallest.size() && prefix_len < largest.size() &&
+         smallest[prefix_len] == largest[prefix_len]) {
+    prefix_len++;
+  }
+  common_prefix_.assign(smallest.data(), prefix_len);
+
+  std::vector<size_t> largest_buckets;
+  for (size_t i = 0; i < files_.num_files; i++) {
+    Slice file_largest = ExtractUserKey(files_.files[i].largest_key);
+    file_largest.remove_prefix(prefix_len);
+    largest_buckets.push_back(FileLookupBucket(file_largest));
+  }
+  file_lookup_.resize(kFileLookupBuckets + 1);
+  size_t file = 0;
+  for (size_t bucket = 0; bucket <= kFileLookupBuckets; bucket++) {
+    while (file < files_.num_files && largest_buckets[file] < bucket) {
+      file++;
+    }
+    file_lookup_[bucket] = static_cast<uint32_t>(file);
+  }
+}
+
 Status CompactedDBImpl::Open(const Options& options,
                              const std::string& dbname, DB** dbptr) {
   *dbptr = nullptr;
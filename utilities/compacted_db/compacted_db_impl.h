@@ -24,12 +24,30 @@ class CompactedDBImpl : public DBImpl {
   virtual Status Get(const ReadOptions& options,
                      ColumnFamilyHandle* column_family, const Slice& key,
                      std::string* value) override;
+  virtual Status Get(const ReadOptions& options,
+                     ColumnFamilyHandle* column_family, const Slice& key,
+                     PinnableSlice* value) override;
   using DB::MultiGet;
   virtual std::vector<Status> MultiGet(
       const ReadOptions& options,
       const std::vector<ColumnFamilyHandle*>&,
       const std::vector<Slice>& keys, std::vector<std::string>* values)
     override;
+  virtual std::vector<Status> MultiGet(
+      const ReadOptions& options,
+      const std::vector<ColumnFamilyHandle*>& column_family,
+      const std::vector<Slice>& keys, PinnableSlice* values) override {
+    return DB::MultiGet(options, column_family, keys, values);
+  }
+  using DBImpl::GetMergeOperands;
+  virtual Status GetMergeOperands(const ReadOptions& options,
+                                  ColumnFamilyHandle* column_family,
+                                  const Slice& key,
+                                  PinnableSlice* merge_operands,
+                                  int max_operands,
+                                  int* num_operands) override {
+    return Status::NotSupported("Not supported in compacted db mode.");
+  }
 
   using DBImpl::Put;
   virtual Status Put(const WriteOptions& options,
@@ -82,11 +100,19 @@ class CompactedDBImpl : public DBImpl {
   friend class DB;
   inline size_t FindFile(const Slice& key);
   Status Init(const Options& options);
+  void BuildFileLookup();
 
   ColumnFamilyData* cfd_;
   Version* version_;
   const Comparator* user_comparator_;
   LevelFilesBrief files_;
+  // Prefix shared by all keys in the db
+  std::string common_prefix_;
+  // For bytewise ordered keys, the keys are put in buckets by the two bytes
+  // after common_prefix_, and file_lookup_[b] is the first file whose largest
+  // key is in bucket b or after it. The keys of bucket b can then only be in
+  // files file_lookup_[b] to file_lookup_[b + 1]. Empty if not used.
+  std::vector<uint32_t> file_lookup_;
 
   // No copying allowed
   CompactedDBImpl(const CompactedDBImpl&);
@@ -1037,6 +1037,7 @@ class DocumentDBImpl : public DocumentDB {
   }
 
   // RocksDB functions
+  using DocumentDB::Get;
   virtual Status Get(const ReadOptions& options,
                      ColumnFamilyHandle* column_family, const Slice& key,
                      std::string* value) override {